@@ -0,0 +1,15 @@
+#ifndef INSTANCING_INCLUDED
+#define INSTANCING_INCLUDED
+
+// object to world matrices of every batched draw in the frame, uploaded by the scene sort node
+// instanced draws use firstInstance as the offset of their batch so gl_InstanceIndex indexes the buffer directly
+layout(std430, set = SET_GLOBAL, binding = 21) readonly buffer InstanceTransforms
+{
+    mat4 objectToWorld[];
+} instances;
+
+mat4 GetObjectToWorld()
+{
+    return instances.objectToWorld[gl_InstanceIndex];
+}
+#endif
@@ -6,6 +6,7 @@
 #include "EditorState.hpp"
 #include "GfxDriver/GfxDriver.hpp"
 #include "Inspectors/Inspector.hpp"
+#include "Physics/MeshShapeCache.hpp"
 #include "Platform/FileExplore.hpp"
 #include "Rendering/SurfelGI/GIScene.hpp"
 #include "Rendering/Tools/BRDFResponseGeneration.hpp"
@@ -178,6 +179,23 @@ static void ProfileTree(const ProfileScope& scope, int id)
     ImGui::PopID();
 }
 
+// counters are ring buffers indexed by frame, plot them oldest frame first like the frame profiles
+static std::vector<float> UnrollCounter(Profiler& profiler, const std::vector<float>& counter)
+{
+    std::vector<float> values(Profiler::MAX_FRAME_TRACKED, 0);
+    int oldestFrameIndex = (profiler.GetLatestFrameIndex() + 1) % Profiler::MAX_FRAME_TRACKED;
+    if (profiler.GetTrackCycles() == 0)
+    {
+        std::copy(counter.begin(), counter.begin() + oldestFrameIndex, values.begin());
+    }
+    else
+    {
+        for (int i = 0; i < Profiler::MAX_FRAME_TRACKED; i++)
+            values[i] = counter[(oldestFrameIndex + i) % Profiler::MAX_FRAME_TRACKED];
+    }
+    return values;
+}
+
 void GameEditor::GameProfiler(Profiler& profiler)
 {
     auto& frameProfiles = profiler.GetFrameProfiles();
@@ -238,6 +256,74 @@ void GameEditor::GameProfiler(Profiler& profiler)
         ImPlot::EndPlot();
     }
 
+    auto& counters = profiler.GetCounters();
+    ImPlot::SetNextAxisLimits(ImAxis_X1, 0, Profiler::MAX_FRAME_TRACKED);
+    if (!counters.empty() && ImPlot::BeginPlot("Counters", ImVec2(-1, 200)))
+    {
+        ImPlotAxisFlags xAxesFlags = ImPlotAxisFlags_Lock | ImPlotAxisFlags_NoGridLines;
+        ImPlot::SetupAxes(nullptr, nullptr, xAxesFlags, ImPlotAxisFlags_AutoFit);
+        for (auto& [name, counter] : counters)
+        {
+            auto values = UnrollCounter(profiler, counter);
+            ImPlot::PlotLine(name.c_str(), values.data(), values.size(), 1, 0);
+        }
+        ImPlot::EndPlot();
+    }
+
+    ImGui::Text("GPU Memory:");
+    auto memoryStats = GetGfxDriver()->GetGPUMemoryStats();
+    for (size_t c = 0; c < (size_t)Gfx::GPUMemoryCategory::Count; ++c)
+    {
+        ImGui::Text(
+            "%s: %.1f MB, %u allocations",
+            Gfx::GPUMemoryCategoryToString((Gfx::GPUMemoryCategory)c),
+            memoryStats.bytes[c] / (1024.0f * 1024.0f),
+            memoryStats.allocations[c]
+        );
+    }
+    for (size_t i = 0; i < memoryStats.heaps.size(); ++i)
+    {
+        auto& heap = memoryStats.heaps[i];
+        ImGui::Text(
+            "heap %zu%s: %.1f / %.1f MB",
+            i,
+            heap.deviceLocal ? " (device local)" : "",
+            heap.usage / (1024.0f * 1024.0f),
+            heap.budget / (1024.0f * 1024.0f)
+        );
+    }
+    if (ImGui::Button("Copy GPU Memory Json"))
+    {
+        ImGui::SetClipboardText(GetGfxDriver()->DumpGPUMemory().c_str());
+    }
+
+    auto compileStats = GetGfxDriver()->GetPipelineCompileStats();
+    ImGui::Text(
+        "Pipelines: %u pending, %u async, %u blocking compiles, %u skipped draws",
+        compileStats.pendingCompiles,
+        compileStats.asyncCompiles,
+        compileStats.stutterEvents,
+        compileStats.skippedDraws
+    );
+
+    auto scheduleStats = GetGfxDriver()->GetFrameScheduleStats();
+    ImGui::Text(
+        "Frame schedule: %.2f ms, %u replayed plans, %u rebuilt plans",
+        scheduleStats.scheduleMs,
+        scheduleStats.reusedPlans,
+        scheduleStats.rebuiltPlans
+    );
+
+    auto shapeStats = MeshShapeCache::GetSingleton().GetStats();
+    ImGui::Text(
+        "Physics mesh shapes: %u cooked (%.1f ms), %u restored (%.1f ms), %u shared",
+        shapeStats.cooked,
+        shapeStats.cookMs,
+        shapeStats.restored,
+        shapeStats.restoreMs,
+        shapeStats.shared
+    );
+
     if (profiler.IsPaused())
     {
         if (ImGui::Button("Resume"))
@@ -1,6 +1,7 @@
 #include "../EditorState.hpp"
 #include "AssetDatabase/AssetDatabase.hpp"
 #include "Core/Texture.hpp"
+#include "Core/TextureStreaming.hpp"
 #include "Inspector.hpp"
 namespace Editor
 {
@@ -13,6 +14,7 @@ public:
 
         layer = 0;
         mip = 0;
+        imageVersion = target->GetImageVersion();
         if (!target->GetDescription().img.isCubemap)
         {
             imageViewInUse = &target->GetGfxImage()->GetDefaultImageView();
@@ -51,6 +53,11 @@ public:
         {
             AssetDatabase::Singleton()->LoadAssetByID(target->GetUUID(), true);
         }
+        // streaming replaced the image, the view we hold belongs to the old one
+        else if (imageVersion != target->GetImageVersion())
+        {
+            OnEnable(*target);
+        }
 
         ImGui::NewLine();
         ImGui::Text("Preview");
@@ -64,6 +71,30 @@ public:
         ImGui::Text("size: %d x %d", width, height);
         ImGui::Text("memory size (without mip): %f Mb", mb);
         ImGui::Text("format %s", Gfx::MapImageFormatToString(target->GetDescription().img.format));
+        if (target->IsStreamed())
+        {
+            auto& streaming = TextureStreaming::GetSingleton();
+            auto stats = streaming.GetStats();
+            ImGui::Text(
+                "resident mip: %u, wanted mip: %u, mip count: %u",
+                target->GetResidentMip(),
+                streaming.GetWantedMip(*target),
+                target->GetMipCount()
+            );
+            ImGui::Text(
+                "streaming: %.2f / %.2f Mb resident, %.2f Mb requested, %u textures pending",
+                stats.residentBytes / 1024.0f / 1024.0f,
+                stats.budgetBytes / 1024.0f / 1024.0f,
+                stats.requestedBytes / 1024.0f / 1024.0f,
+                stats.pendingTextures
+            );
+            ImGui::Text("streaming source data in ram: %.2f Mb", stats.sourceBytes / 1024.0f / 1024.0f);
+        }
+        else if (target->IsTranscoding())
+        {
+            auto stats = TextureStreaming::GetSingleton().GetStats();
+            ImGui::Text("transcoding, %u textures left", stats.transcodingTextures);
+        }
 
         // show and update meta
         ImGui::NewLine();
@@ -72,28 +103,78 @@ public:
         bool linearFormat = options.value("linearFormat", false);
         bool generateMipmap = options.value("generateMipmap", false);
         bool convertToIrradianceCubemap = options.value("convertToIrradianceCubemap", false);
+        bool irradianceSH = options.value("irradianceSH", false);
         bool converToCubemap = options.value("convertToCubemap", false);
         bool convertToReflectanceCubemap = options.value("convertToReflectanceCubemap", false);
+        bool streaming = options.value("streaming", false);
+        const char* usages[] = {"color", "normal", "data"};
+        const char* compressions[] = {"none", "auto", "uastc", "etc1s"};
+        const char* mipFilters[] = {"box", "kaiser", "lanczos"};
+        const char* mipEdgeModes[] = {"clamp", "wrap"};
+        auto indexOf = [](const char* const* items, int count, const std::string& value)
+        {
+            for (int i = 0; i < count; ++i)
+            {
+                if (value == items[i])
+                    return i;
+            }
+            return 0;
+        };
+        int usage = indexOf(usages, IM_ARRAYSIZE(usages), options.value("usage", "color"));
+        int compression = indexOf(compressions, IM_ARRAYSIZE(compressions), options.value("compression", "none"));
+        int mipFilter = indexOf(mipFilters, IM_ARRAYSIZE(mipFilters), options.value("mipFilter", "box"));
+        int mipEdgeMode = indexOf(mipEdgeModes, IM_ARRAYSIZE(mipEdgeModes), options.value("mipEdgeMode", "clamp"));
 
         ImGui::Text("Import Options");
         ImGui::Separator();
         bool metaChanged = false;
         metaChanged |= ImGui::Checkbox("linearFormat", &linearFormat);
         metaChanged |= ImGui::Checkbox("generateMipmap", &generateMipmap);
+        if (generateMipmap)
+        {
+            metaChanged |= ImGui::Combo("mipFilter", &mipFilter, mipFilters, IM_ARRAYSIZE(mipFilters));
+            metaChanged |= ImGui::Combo("mipEdgeMode", &mipEdgeMode, mipEdgeModes, IM_ARRAYSIZE(mipEdgeModes));
+        }
         metaChanged |= ImGui::Checkbox("convertToCubemap", &converToCubemap);
         metaChanged |= ImGui::Checkbox("convertToIrradianceCubemap", &convertToIrradianceCubemap);
+        if (convertToIrradianceCubemap)
+            metaChanged |= ImGui::Checkbox("irradianceSH", &irradianceSH);
         metaChanged |= ImGui::Checkbox("convertToReflectanceCubemap", &convertToReflectanceCubemap);
+        metaChanged |= ImGui::Combo("usage", &usage, usages, IM_ARRAYSIZE(usages));
+        metaChanged |= ImGui::Combo("compression", &compression, compressions, IM_ARRAYSIZE(compressions));
+        metaChanged |= ImGui::Checkbox("streaming", &streaming);
         if (metaChanged)
         {
+            meta["importOption"]["usage"] = usages[usage];
+            meta["importOption"]["compression"] = compressions[compression];
+            meta["importOption"]["mipFilter"] = mipFilters[mipFilter];
+            meta["importOption"]["mipEdgeMode"] = mipEdgeModes[mipEdgeMode];
             meta["importOption"]["generateMipmap"] = generateMipmap;
             meta["importOption"]["convertToCubemap"] = converToCubemap;
             meta["importOption"]["convertToIrradianceCubemap"] = convertToIrradianceCubemap;
+            meta["importOption"]["irradianceSH"] = irradianceSH;
             meta["importOption"]["convertToReflectanceCubemap"] = convertToReflectanceCubemap;
             meta["importOption"]["linearFormat"] = linearFormat;
+            meta["importOption"]["streaming"] = streaming;
         }
         if (metaChanged)
             AssetDatabase::Singleton()->SetAssetMeta(*target, meta);
 
+        if (meta.contains("importReport"))
+        {
+            auto& report = meta["importReport"];
+            ImGui::Text("imported format %s", report.value("format", "").c_str());
+            ImGui::Text(
+                "imported size: %.2f Mb (%.2fx)",
+                report.value("fileByteSize", 0ull) / 1024.0f / 1024.0f,
+                report.value("compressionRatio", 1.0f)
+            );
+            if (report["psnr"].is_number())
+                ImGui::Text("psnr: %.2f dB", report["psnr"].get<float>());
+            else
+                ImGui::Text("psnr: lossless");
+        }
+
         // import button
         if (ImGui::Button("Reimport"))
         {
@@ -107,6 +188,7 @@ private:
     std::unique_ptr<Gfx::ImageView> imageView;
     uint32_t layer = 0;
     uint32_t mip = 0;
+    uint64_t imageVersion = 0;
     bool reimport = false;
 
     glm::vec2 ResizeKeepRatio(float width, float height, float contentWidth, float contentHeight)
@@ -141,7 +223,7 @@ private:
         if (reimport || changeImageView)
         {
             if (reimport || ((layer_i >= 0 && layer_i != layer && layer_i < target->GetDescription().img.GetLayer()) ||
-                             (mip_i >= 0 && mip_i != mip && mip_i < target->GetDescription().img.mipLevels)))
+                             (mip_i >= 0 && mip_i != mip && mip_i < target->GetGfxImage()->GetDescription().mipLevels)))
             {
                 reimport = false;
                 layer = layer_i;
@@ -2,11 +2,13 @@
 
 #include "Core/Component/Camera.hpp"
 #include "Core/Component/MeshRenderer.hpp"
+#include "Core/Component/PhysicsBody.hpp"
 #include "Core/EngineState.hpp"
 #include "Core/Gizmo.hpp"
 #include "Core/Time.hpp"
 #include "EditorState.hpp"
 #include "GameEditor.hpp"
+#include "Libs/JobSystem.hpp"
 #include "Physics/JoltDebugRenderer.hpp"
 #include "ThirdParty/imgui/ImGuizmo.h"
 #include "ThirdParty/imgui/imgui.h"
@@ -147,117 +149,81 @@ void GameView::Init()
     ChangeGameScreenResolution({256, 256});
 }
 
-static bool IsRayObjectIntersect(glm::vec3 ori, glm::vec3 dir, GameObject* obj, float& distance)
+// slab test, true if the ray enters the box before maxDistance
+static bool IsRayAABBIntersect(glm::vec3 ori, glm::vec3 invDir, const AABB& aabb)
+{
+    glm::vec3 t0 = (aabb.min - ori) * invDir;
+    glm::vec3 t1 = (aabb.max - ori) * invDir;
+    glm::vec3 tMin = glm::min(t0, t1);
+    glm::vec3 tMax = glm::max(t0, t1);
+    float enter = glm::max(glm::max(tMin.x, tMin.y), tMin.z);
+    float exit = glm::min(glm::min(tMax.x, tMax.y), tMax.z);
+    return exit >= glm::max(enter, 0.0f);
+}
+
+static bool IsRayObjectIntersect(glm::vec3 ori, glm::vec3 dir, MeshRenderer* mr, float& distance)
 {
     distance = std::numeric_limits<float>::max();
-    auto mr = obj->GetComponent<MeshRenderer>();
-    if (mr)
-    {
-        auto model = obj->GetWorldMatrix();
-        auto mesh = mr->GetMesh();
-        if (mesh)
-        {
-            for (const Submesh& submesh : mesh->GetSubmeshes())
-            {
-                auto& indices = submesh.GetIndices();
-                auto& positions = submesh.GetPositions();
+    auto mesh = mr->GetMesh();
+    if (mesh == nullptr)
+        return false;
 
-                // I just assume binding zero is a vec3 position, this is not robust
-                for (int i = 0; i < submesh.GetIndexCount(); i += 3)
-                {
-                    int j = i + 1;
-                    int k = i + 2;
+    auto model = mr->GetGameObject()->GetWorldMatrix();
+    glm::vec3 invDir = 1.0f / dir;
+    for (int i = 0; i < mesh->GetSubmeshes().size(); ++i)
+    {
+        Submesh* submesh = mesh->GetSubmesh(i);
 
-                    glm::vec3 v0, v1, v2;
-                    v0 = model * glm::vec4(positions[indices[i]], 1.0);
-                    v1 = model * glm::vec4(positions[indices[j]], 1.0);
-                    v2 = model * glm::vec4(positions[indices[k]], 1.0);
+        // most objects are nowhere near the ray
+        AABB aabb = submesh->GetAABB();
+        aabb.Transform(glm::mat3(model), model[3]);
+        if (!IsRayAABBIntersect(ori, invDir, aabb))
+            continue;
 
-                    glm::vec2 bary;
-                    float newDistance = -1;
-                    if (glm::intersectRayTriangle(ori, dir, v0, v1, v2, bary, newDistance))
-                    {
-                        distance = glm::min(distance, newDistance);
-                    }
-                }
-            }
+        float newDistance;
+        if (RayMeshIntersection(Ray{ori, dir}, submesh, model, newDistance))
+        {
+            distance = glm::min(distance, newDistance);
         }
     }
 
-    return distance > 0;
+    return distance != std::numeric_limits<float>::max();
 }
 
-struct PickGameObjectFromScene
+// objects with a physics body are picked by a raycast on the physics scene. Mesh renderers without one are tested on
+// the job system, their submesh bounds reject most of them before any triangle is touched
+static void PickGameObjectFromScene(Scene& scene, const Ray& ray, std::vector<Intersected>& intersected)
 {
-    // main thread populates pending vectors, while worker threads process the pending. workers takes the target
-    // GameObject using the `consumerIndex`, each process of a GameObject appends an `Intersected` in `results` if it's
-    // intersected with the GameObject. `consumerIndex` is incrementally increased by 1 each time the worker takes a
-    // GameObject to process
-private:
-    std::vector<GameObject*> pending;
-    std::atomic<int> consumerIndex{0};
-
-public:
-    std::vector<Intersected> results;
-
-    void operator()(Scene& scene, const Ray& ray, glm::vec2 screenUV, std::vector<Intersected>& intersected)
-    {
-        pending = scene.GetAllGameObjects();
-        std::vector<std::thread> threads;
-        std::mutex m;
-        int maxThreads = std::max(1.0f, std::thread::hardware_concurrency() - 2.0f);
-        for (int i = 0; i < maxThreads; ++i)
-        {
-            threads.push_back(std::thread(
-                [this, &m, &intersected, &ray]()
-                {
-                    while (consumerIndex < pending.size())
-                    {
-                        int index = consumerIndex.fetch_add(1);
-
-                        GameObject* obj = pending[index];
-                        if (obj == nullptr || !obj->IsEnabled())
-                            continue;
+    RaycastHit hit = scene.GetPhysicsScene().Raycast(RaycastQuery{ray.origin, ray.direction, 10000.0f});
+    if (hit.body)
+        intersected.push_back(Intersected{hit.body->GetGameObject(), hit.distance});
+
+    // the jobs read world transforms, they have to be up to date before
+    scene.UpdateTransforms();
+    auto renderers = scene.GetComponentsOfType<MeshRenderer>();
+    std::mutex m;
+    JobSystem::GetSingleton().ParallelFor(
+        renderers.size(),
+        64,
+        [&](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; ++i)
+            {
+                MeshRenderer* mr = renderers[i];
+                PhysicsBody* body = mr->GetGameObject()->GetComponent<PhysicsBody>();
+                if (body && body->IsEnabled() && body->GetBody())
+                    continue;
 
-                        auto ori = ray.origin;
-                        auto dir = ray.direction;
-                        float distance = std::numeric_limits<float>::max();
-                        if (IsRayObjectIntersect(ori, dir, obj, distance))
-                        {
-                            std::scoped_lock lock(m);
-                            intersected.push_back(Intersected{obj, distance});
-                        }
-                    };
+                float distance;
+                if (IsRayObjectIntersect(ray.origin, ray.direction, mr, distance))
+                {
+                    std::scoped_lock lock(m);
+                    intersected.push_back(Intersected{mr->GetGameObject(), distance});
                 }
-            ));
+            }
         }
-
-        for (auto& t : threads)
-            t.join();
-    }
-};
-
-// static void PickGameObjectFromScene(const Ray& ray, glm::vec2 screenUV, std::vector<Intersected>& intersected)
-// {
-//     if (Scene* scene = EditorState::activeScene)
-//     {
-//         auto objs = scene->GetAllGameObjects();
-//
-//         auto ori = ray.origin;
-//         auto dir = ray.direction;
-//         for (auto obj : objs)
-//         {
-//             if (obj == nullptr || !obj->IsEnabled())
-//                 continue;
-//
-//             float distance = std::numeric_limits<float>::max();
-//             if (IsRayObjectIntersect(ori, dir, obj, distance))
-//             {
-//                 intersected.push_back(Intersected{obj, distance});
-//             }
-//         }
-//     }
-// }
+    );
+}
 
 void GameView::EditorCameraWalkAround(Camera& editorCamera, float& editorCameraSpeed)
 {
@@ -385,7 +351,10 @@ void GameView::Render(
                     {
                         cmd.BindVertexBuffer(draw.vertexBufferBinding, 0);
                         cmd.BindIndexBuffer(draw.indexBuffer, 0, draw.indexBufferType);
-                        cmd.SetPushConstant(draw.shader->GetShaderProgram(0, 0), (void*)&draw.pushConstant);
+                        cmd.SetPushConstant(
+                            outlineRawColorPassShader->GetDefaultShaderProgram(),
+                            (void*)&draw.pushConstant
+                        );
                         cmd.DrawIndexed(draw.indexCount, 1, 0, 0, 0);
                     }
                 }
@@ -663,7 +632,7 @@ bool GameView::Tick()
                     {
                         if (EditorState::activeScene)
                         {
-                            PickGameObjectFromScene()(*EditorState::activeScene, ray, screenUV, intersected);
+                            PickGameObjectFromScene(*EditorState::activeScene, ray, intersected);
                         }
                     }
                     else
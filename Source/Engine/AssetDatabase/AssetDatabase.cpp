@@ -2,6 +2,7 @@
 #include "AssetDatabase/Importers/AssetLoader.hpp"
 #include "Core/Scene/Scene.hpp"
 #include "Importers.hpp"
+#include "Libs/JobSystem.hpp"
 #include "Libs/Profiler.hpp"
 #include <future>
 #include <iostream>
@@ -80,6 +81,7 @@ std::vector<Asset*> AssetDatabase::LoadAssets(std::span<std::filesystem::path> p
         std::filesystem::path absoluteAssetPath;
         AssetData* assetData = nullptr;
         std::unique_ptr<Asset> newAsset = nullptr;
+        std::unique_ptr<AssetLoader> loader = nullptr;
         std::future<void> import;
         std::unique_ptr<SerializeReferenceResolveMap> resolveMap = nullptr;
         std::unique_ptr<JsonSerializer> ser = nullptr;
@@ -122,11 +124,36 @@ std::vector<Asset*> AssetDatabase::LoadAssets(std::span<std::filesystem::path> p
             if (asyncImport[i].newAsset->IsExternalAsset())
             {
                 asyncImport[i].stateTrack = 3;
-                asyncImport[i].import = std::async(
-                    std::launch::async,
-                    [asyncImport = &asyncImport[i]]()
-                    { asyncImport->newAsset->LoadFromFile(asyncImport->absoluteAssetPath.string().c_str()); }
-                );
+                asyncImport[i].loader = AssetLoaderRegistry::CreateAssetLoaderByExtension(ext.string());
+                if (asyncImport[i].loader)
+                {
+                    nlohmann::json meta = nlohmann::json::object();
+                    if (asyncImport[i].assetData)
+                        meta = asyncImport[i].assetData->GetMeta();
+                    asyncImport[i].loader->Setup(importDatabase, asyncImport[i].absoluteAssetPath, meta);
+
+                    // imports run in parallel, only the assets whose import key changed and that no earlier import
+                    // left an artifact for run their importer. The rest go straight to loading
+                    asyncImport[i].import = JobSystem::GetSingleton().Schedule(
+                        [asyncImport = &asyncImport[i]]()
+                        {
+                            auto& loader = *asyncImport->loader;
+                            asyncImport->newAsset = nullptr;
+                            if (loader.ImportNeeded() && !loader.AdoptArtifact())
+                                loader.Import();
+                            loader.Load();
+                            asyncImport->newAsset = loader.RetrieveAsset();
+                        }
+                    );
+                }
+                else
+                {
+                    asyncImport[i].import = std::async(
+                        std::launch::async,
+                        [asyncImport = &asyncImport[i]]()
+                        { asyncImport->newAsset->LoadFromFile(asyncImport->absoluteAssetPath.string().c_str()); }
+                    );
+                }
             }
             else
             {
@@ -158,16 +185,27 @@ std::vector<Asset*> AssetDatabase::LoadAssets(std::span<std::filesystem::path> p
         if (asyncImport[i].stateTrack == 3 || asyncImport[i].stateTrack == 4)
         {
             asyncImport[i].import.wait();
+
+            // the loader failed
+            if (asyncImport[i].newAsset == nullptr)
+                continue;
+
             results[i] = asyncImport[i].newAsset.get();
             if (asyncImport[i].assetData)
             {
+                if (asyncImport[i].loader)
+                    asyncImport[i].assetData->SetMeta(asyncImport[i].loader->GetMeta());
                 asyncImport[i].assetData->SetAsset(std::move(asyncImport[i].newAsset));
+                if (asyncImport[i].loader)
+                    asyncImport[i].assetData->SaveToDisk(projectRoot);
             }
             // a new asset needs to be recored/imported in assetDatabase
             else
             {
                 std::unique_ptr<AssetData> ad =
                     std::make_unique<AssetData>(std::move(asyncImport[i].newAsset), pathes[i], projectRoot);
+                if (asyncImport[i].loader)
+                    ad->SetMeta(asyncImport[i].loader->GetMeta());
                 ad->SaveToDisk(projectRoot);
 
                 assets.Add(std::move(ad));
@@ -629,10 +667,13 @@ void AssetDatabase::RefreshShader()
                 {
                     try
                     {
-                        loader->Import();
+                        // refreshing all shaders recompiles them even if an artifact exists
+                        if (requestShaderRefreshAll || !loader->AdoptArtifact())
+                            loader->Import();
                         SPDLOG_INFO("Shader reloaded: {}", d->GetAssetPath().string());
                         loader->Load();
                         s->Reload(std::move(*loader->RetrieveAsset()));
+                        d->SetMeta(loader->GetMeta());
                         d->UpdateAssetUUIDs();
                         d->UpdateLastWriteTime();
                     }
@@ -755,7 +796,9 @@ Asset* AssetDatabase::LoadAsset(std::filesystem::path path, bool forceReimport)
     bool importNeeded = forceReimport || loader->ImportNeeded();
     if (importNeeded)
     {
-        loader->Import();
+        // the same source and options may have been imported before, on another machine or branch
+        if (forceReimport || !loader->AdoptArtifact())
+            loader->Import();
     }
 
     Asset* asset = assetData ? assetData->GetAsset() : nullptr;
@@ -69,6 +69,12 @@ public:
         return projectRoot;
     }
 
+    // for systems that keep derived data of assets next to the import artifacts
+    ImportDatabase& GetImportDatabase()
+    {
+        return importDatabase;
+    }
+
     nlohmann::json GetAssetMeta(Asset& asset)
     {
         AssetData* data = assets.GetAssetData(asset.GetUUID());
@@ -1,12 +1,93 @@
 #include "KtxExporter.hpp"
 #include <GfxDriver/Vulkan/Internal/VKEnumMapper.hpp>
+#include <cmath>
+#include <cstring>
+#include <fstream>
 #include <glm/glm.hpp>
 #include <ktx.h>
+#include <limits>
 #include <spdlog/spdlog.h>
+#include <thread>
 
 namespace Exporters
 {
-void KtxExporter::Export(
+namespace
+{
+// formats the basis encoders accept
+bool IsBasisEncodable(Gfx::ImageFormat format)
+{
+    switch (format)
+    {
+        case Gfx::ImageFormat::R8_UNorm:
+        case Gfx::ImageFormat::R8_SRGB:
+        case Gfx::ImageFormat::R8G8_UNorm:
+        case Gfx::ImageFormat::R8G8_SRGB:
+        case Gfx::ImageFormat::R8G8B8_SRGB:
+        case Gfx::ImageFormat::R8G8B8A8_UNorm:
+        case Gfx::ImageFormat::R8G8B8A8_SRGB: return true;
+        default: return false;
+    }
+}
+
+// decodes the written file the same way the runtime does and compares it with the source, src is laid out as
+// [level [layer [face]]] like in Export. Normal maps only keep xy
+float ComputePSNR(uint8_t* fileData, size_t fileByteSize, uint8_t* src, uint32_t channels, bool normalMap)
+{
+    ktxTexture2* decoded;
+    if (ktxTexture2_CreateFromMemory(fileData, fileByteSize, KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT, &decoded) !=
+        KTX_SUCCESS)
+        return 0;
+
+    if (ktxTexture2_NeedsTranscoding(decoded) && ktxTexture2_TranscodeBasis(decoded, KTX_TTF_RGBA32, 0) != KTX_SUCCESS)
+    {
+        ktxTexture_Destroy(ktxTexture(decoded));
+        return 0;
+    }
+
+    // basis textures always transcode to RGBA. Two channel sources and normal maps are stored as RRRG, their second
+    // channel comes back in alpha
+    const uint32_t decodedChannels = 4;
+    const uint32_t decodedChannel[4] = {0, channels == 2 || normalMap ? 3u : 1u, 2, 3};
+    const uint32_t comparedChannels = normalMap ? glm::min(channels, 2u) : channels;
+    ktx_uint8_t* data = ktxTexture_GetData(ktxTexture(decoded));
+    double squaredError = 0;
+    size_t sampleCount = 0;
+    size_t srcOffset = 0;
+    for (uint32_t level = 0; level < decoded->numLevels; ++level)
+    {
+        size_t texelCount =
+            size_t(glm::max(decoded->baseWidth >> level, 1u)) * glm::max(decoded->baseHeight >> level, 1u);
+        for (uint32_t layer = 0; layer < decoded->numLayers; ++layer)
+        {
+            for (uint32_t face = 0; face < decoded->numFaces; ++face)
+            {
+                ktx_size_t offset = 0;
+                ktxTexture_GetImageOffset(ktxTexture(decoded), level, layer, face, &offset);
+                for (size_t t = 0; t < texelCount; ++t)
+                {
+                    for (uint32_t c = 0; c < comparedChannels; ++c)
+                    {
+                        double diff = double(data[offset + t * decodedChannels + decodedChannel[c]]) -
+                                      src[srcOffset + t * channels + c];
+                        squaredError += diff * diff;
+                    }
+                }
+                sampleCount += texelCount * comparedChannels;
+                srcOffset += texelCount * channels;
+            }
+        }
+    }
+    ktxTexture_Destroy(ktxTexture(decoded));
+
+    if (squaredError == 0 || sampleCount == 0)
+        return std::numeric_limits<float>::infinity();
+
+    double mse = squaredError / sampleCount;
+    return 10 * std::log10(255.0 * 255.0 / mse);
+}
+} // namespace
+
+bool KtxExporter::Export(
     const char* path,
     uint8_t* src,
     uint32_t width,
@@ -18,7 +99,8 @@ void KtxExporter::Export(
     bool isArray,
     bool isCubemap,
     Gfx::ImageFormat format,
-    bool enableCompression
+    const KtxCompression& compression,
+    KtxExportReport* report
 )
 {
     ktxTexture2* texture;
@@ -42,7 +124,7 @@ void KtxExporter::Export(
     if (result != KTX_SUCCESS)
     {
         spdlog::error(ktxErrorString(result));
-        return;
+        return false;
     }
 
     size_t offset = 0;
@@ -60,7 +142,8 @@ void KtxExporter::Export(
                 if (result != KTX_SUCCESS)
                 {
                     spdlog::error(ktxErrorString(result));
-                    return;
+                    ktxTexture_Destroy(ktxTexture(texture));
+                    return false;
                 }
 
                 offset += mipSize;
@@ -70,28 +153,90 @@ void KtxExporter::Export(
         lw *= 0.5;
         lh *= 0.5;
     }
+    const size_t uncompressedByteSize = offset;
+
+    KtxCompression::Mode mode = compression.mode;
+    if (mode != KtxCompression::Mode::None && !IsBasisEncodable(format))
+    {
+        SPDLOG_WARN("{} can't be block compressed, only Zstd is applied", Gfx::MapImageFormatToString(format));
+        mode = KtxCompression::Mode::None;
+    }
 
-    if (enableCompression)
+    if (mode != KtxCompression::Mode::None)
     {
-        // ktxBasisParams params = {0};
-        // params.structSize = sizeof(params);
-        //// For BasisLZ/ETC1S
-        // params.compressionLevel = KTX_ETC1S_DEFAULT_COMPRESSION_LEVEL;
-        //// For UASTC
-        // params.uastc = KTX_TRUE;
-        //// Set other BasisLZ/ETC1S or UASTC params to change default quality settings.
-        result = ktxTexture2_CompressBasis(texture, 200);
+        ktxBasisParams params{};
+        params.structSize = sizeof(params);
+        // the encoders split the image into blocks and spread them over these threads
+        params.threadCount = glm::max(std::thread::hardware_concurrency(), 1u);
+        params.normalMap = compression.normalMap;
+        // x in rgb and y in alpha, where the BC5 transcoder takes its two channels from
+        if (compression.normalMap)
+            memcpy(params.inputSwizzle, "rrrg", sizeof(params.inputSwizzle));
+        if (mode == KtxCompression::Mode::UASTC)
+        {
+            params.uastc = KTX_TRUE;
+            params.uastcFlags = glm::min(compression.uastcLevel, (uint32_t)KTX_PACK_UASTC_MAX_LEVEL);
+        }
+        else
+        {
+            params.uastc = KTX_FALSE;
+            params.compressionLevel = KTX_ETC1S_DEFAULT_COMPRESSION_LEVEL;
+            params.qualityLevel = glm::clamp(compression.etc1sLevel, 1u, 255u);
+        }
+
+        result = ktxTexture2_CompressBasisEx(texture, &params);
         if (result != KTX_SUCCESS)
         {
             spdlog::error(ktxErrorString(result));
-            return;
+            ktxTexture_Destroy(ktxTexture(texture));
+            return false;
         }
-        char writer[100];
-        snprintf(writer, sizeof(writer), "%s version %s", "WeilanEngine", 0);
-        ktxHashList_AddKVPair(&texture->kvDataHead, KTX_WRITER_KEY, (ktx_uint32_t)strlen(writer) + 1, writer);
     }
 
-    ktxTexture_WriteToNamedFile(ktxTexture(texture), path);
+    if (compression.zstdLevel != 0 && mode != KtxCompression::Mode::ETC1S)
+    {
+        result = ktxTexture2_DeflateZstd(texture, glm::min(compression.zstdLevel, 22u));
+        if (result != KTX_SUCCESS)
+        {
+            spdlog::error(ktxErrorString(result));
+            ktxTexture_Destroy(ktxTexture(texture));
+            return false;
+        }
+    }
+
+    if (compression.normalMap)
+    {
+        const char value[] = "1";
+        ktxHashList_AddKVPair(&texture->kvDataHead, normalMapKey, sizeof(value), value);
+    }
+
+    const char writer[] = "WeilanEngine";
+    ktxHashList_AddKVPair(&texture->kvDataHead, KTX_WRITER_KEY, sizeof(writer), writer);
+
+    ktx_uint8_t* fileData = nullptr;
+    ktx_size_t fileByteSize = 0;
+    result = ktxTexture_WriteToMemory(ktxTexture(texture), &fileData, &fileByteSize);
     ktxTexture_Destroy(ktxTexture(texture));
+    if (result != KTX_SUCCESS)
+    {
+        spdlog::error(ktxErrorString(result));
+        return false;
+    }
+
+    std::ofstream f(path, std::ios::binary | std::ios::trunc);
+    f.write((const char*)fileData, fileByteSize);
+    bool written = f.good();
+
+    if (report)
+    {
+        report->uncompressedByteSize = uncompressedByteSize;
+        report->fileByteSize = fileByteSize;
+        report->psnr = mode == KtxCompression::Mode::None
+                           ? std::numeric_limits<float>::infinity()
+                           : ComputePSNR(fileData, fileByteSize, src, formatByteSize, compression.normalMap);
+    }
+
+    free(fileData);
+    return written;
 }
 } // namespace Exporters
@@ -6,11 +6,44 @@
 
 namespace Exporters
 {
+struct KtxCompression
+{
+    enum class Mode
+    {
+        None,
+        // transcoded to BC7 (or BC5 for normal maps) when loaded
+        UASTC,
+        // smaller than UASTC but lower quality, transcoded to BC3 (or BC5 for normal maps)
+        ETC1S
+    };
+
+    Mode mode = Mode::None;
+    // tunes the encoder for normal maps, stores x in rgb and y in alpha and tags the file so the loader transcodes it
+    // to BC5. z isn't kept, shaders rebuild it from xy
+    bool normalMap = false;
+    // 0 (fastest) to 4 (best quality)
+    uint32_t uastcLevel = 2;
+    // 1 (fastest) to 255 (best quality)
+    uint32_t etc1sLevel = 128;
+    // Zstd supercompression of the payload, 0 disables it. Not used with ETC1S which is already supercompressed
+    uint32_t zstdLevel = 0;
+};
+
+struct KtxExportReport
+{
+    size_t uncompressedByteSize = 0;
+    size_t fileByteSize = 0;
+    // of the decoded texture against the source over all channels (xy of normal maps) and levels, infinity when
+    // lossless
+    float psnr = 0;
+};
+
 class KtxExporter : Exporter
 {
 public:
     // [layer [face [mip]]]
-    static void Export(
+    // compression other than Zstd only applies to 8 bit formats
+    static bool Export(
         const char* path,
         uint8_t* src,
         uint32_t width,
@@ -22,7 +55,11 @@ public:
         bool isArray,
         bool isCubemap,
         Gfx::ImageFormat format,
-        bool enableCompression = false
+        const KtxCompression& compression = {},
+        KtxExportReport* report = nullptr
     );
+
+    // key of the metadata that marks normal maps
+    static constexpr const char* normalMapKey = "WeilanEngine.normalMap";
 };
 } // namespace Exporters
@@ -1,4 +1,6 @@
 #include "AssetLoader.hpp"
+#include "ThirdParty/xxHash/xxhash.h"
+#include <fmt/format.h>
 #include <fstream>
 
 std::vector<uint8_t> ImportDatabase::ReadFile(const std::string& filename)
@@ -23,6 +25,149 @@ std::filesystem::path ImportDatabase::GetImportAssetPath(const std::string& file
     return importDatabaseRoot / filename;
 }
 
+uint64_t ImportDatabase::HashFile(const std::filesystem::path& path)
+{
+    std::error_code ec;
+    long long writeTime = std::filesystem::last_write_time(path, ec).time_since_epoch().count();
+    uintmax_t size = std::filesystem::file_size(path, ec);
+    if (ec)
+        return 0;
+
+    {
+        std::scoped_lock lock(hashCacheMutex);
+        auto iter = hashCache.find(path.string());
+        if (iter != hashCache.end() && iter->second.writeTime == writeTime && iter->second.size == size)
+            return iter->second.hash;
+    }
+
+    std::ifstream f(path, std::ios::binary);
+    if (!f.is_open())
+        return 0;
+
+    // large sources are hashed in chunks instead of being read whole
+    XXH3_state_t* state = XXH3_createState();
+    XXH3_64bits_reset(state);
+    std::vector<char> chunk(1024 * 1024);
+    while (f)
+    {
+        f.read(chunk.data(), chunk.size());
+        XXH3_64bits_update(state, chunk.data(), f.gcount());
+    }
+    uint64_t hash = XXH3_64bits_digest(state);
+    XXH3_freeState(state);
+
+    std::scoped_lock lock(hashCacheMutex);
+    hashCache[path.string()] = FileHash{writeTime, size, hash};
+    return hash;
+}
+
+bool ImportDatabase::ReadArtifactMeta(uint64_t importKey, nlohmann::json& artifactMeta)
+{
+    std::ifstream f(GetImportAssetPath(KeyToString(importKey) + ".json"));
+    if (!f.is_open())
+        return false;
+
+    artifactMeta = nlohmann::json::parse(f, nullptr, false);
+    if (artifactMeta.is_discarded())
+        return false;
+
+    for (auto& file : artifactMeta.value("files", nlohmann::json::array()))
+    {
+        if (!std::filesystem::exists(GetImportAssetPath(file.get<std::string>())))
+            return false;
+    }
+    return true;
+}
+
+void ImportDatabase::WriteArtifactMeta(uint64_t importKey, const nlohmann::json& artifactMeta)
+{
+    std::ofstream f(GetImportAssetPath(KeyToString(importKey) + ".json"), std::ios::trunc);
+    f << artifactMeta.dump(4);
+}
+
+std::string ImportDatabase::KeyToString(uint64_t importKey)
+{
+    return fmt::format("{:016x}", importKey);
+}
+
+uint64_t AssetLoader::GetImportKey()
+{
+    // the asset's own hash is kept in its meta so that startup doesn't read every source file again
+    std::error_code ec;
+    long long writeTime = std::filesystem::last_write_time(absoluteAssetPath, ec).time_since_epoch().count();
+    uintmax_t size = std::filesystem::file_size(absoluteAssetPath, ec);
+    nlohmann::json cached = meta.value("sourceHash", nlohmann::json::object());
+    uint64_t sourceHash;
+    if (!ec && cached.value("writeTime", 0ll) == writeTime && cached.value("size", uintmax_t(0)) == size &&
+        cached.contains("hash"))
+    {
+        sourceHash = cached["hash"];
+    }
+    else
+    {
+        sourceHash = importDatabase->HashFile(absoluteAssetPath);
+        meta["sourceHash"] = {{"writeTime", writeTime}, {"size", size}, {"hash", sourceHash}};
+    }
+
+    std::vector<uint64_t> hashes = {sourceHash};
+    for (auto& dependency : GetImportDependencies())
+    {
+        hashes.push_back(importDatabase->HashFile(dependency));
+    }
+
+    // json objects are ordered by key, the dump is the same for the same options. The extension picks the importer
+    nlohmann::json importOption = meta.value("importOption", nlohmann::json::object());
+    for (auto& loadOption : GetLoadOptions())
+        importOption.erase(loadOption);
+    std::string options = importOption.dump();
+    std::string importer = fmt::format("{}:{}", absoluteAssetPath.extension().string(), GetImporterVersion());
+    hashes.push_back(XXH3_64bits(options.data(), options.size()));
+    hashes.push_back(XXH3_64bits(importer.data(), importer.size()));
+
+    return XXH3_64bits(hashes.data(), hashes.size() * sizeof(uint64_t));
+}
+
+std::string AssetLoader::GetArtifactName(const std::string& suffix)
+{
+    return ImportDatabase::KeyToString(GetImportKey()) + suffix;
+}
+
+bool AssetLoader::IsImportUpToDate()
+{
+    uint64_t key = GetImportKey();
+    if (meta.value("importKey", "") != ImportDatabase::KeyToString(key))
+        return false;
+
+    nlohmann::json artifactMeta;
+    return importDatabase->ReadArtifactMeta(key, artifactMeta);
+}
+
+bool AssetLoader::AdoptArtifact()
+{
+    uint64_t key = GetImportKey();
+    nlohmann::json artifactMeta;
+    if (!importDatabase->ReadArtifactMeta(key, artifactMeta))
+        return false;
+
+    meta.update(artifactMeta.value("meta", nlohmann::json::object()));
+    meta["importKey"] = ImportDatabase::KeyToString(key);
+    return true;
+}
+
+void AssetLoader::StoreArtifact(const std::vector<std::string>& producedMetaKeys, const std::vector<std::string>& files)
+{
+    nlohmann::json produced = nlohmann::json::object();
+    for (auto& key : producedMetaKeys)
+    {
+        if (meta.contains(key))
+            produced[key] = meta[key];
+    }
+
+    uint64_t key = GetImportKey();
+    importDatabase->WriteArtifactMeta(key, {{"meta", produced}, {"files", files}});
+    meta["importKey"] = ImportDatabase::KeyToString(key);
+}
+
 std::unique_ptr<AssetLoader> AssetLoaderRegistry::CreateAssetLoaderByExtension(const Extension& id)
 {
     auto iter = GetAssetLoaderExtensionRegistry()->find(id);
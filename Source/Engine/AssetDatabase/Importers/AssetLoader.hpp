@@ -2,8 +2,10 @@
 #include "Core/Asset.hpp"
 #include "Libs/Serialization/Serializer.hpp"
 #include <filesystem>
+#include <mutex>
 #include <nlohmann/json.hpp>
 #include <typeindex>
+#include <unordered_map>
 
 class ImportDatabase
 {
@@ -16,8 +18,28 @@ public:
 
     std::filesystem::path GetImportAssetPath(const std::string& filename);
 
+    // xxHash3 of the file's bytes, only read again when the file's write time or size changes
+    uint64_t HashFile(const std::filesystem::path& path);
+
+    // artifacts are named after their import key, the key's <key>.json records the meta the import produced and the
+    // files it wrote. Nothing in them depends on the machine so they can be shared between machines and branches.
+    // Reading fails if any of the files is missing
+    bool ReadArtifactMeta(uint64_t importKey, nlohmann::json& artifactMeta);
+    void WriteArtifactMeta(uint64_t importKey, const nlohmann::json& artifactMeta);
+    static std::string KeyToString(uint64_t importKey);
+
 private:
+    struct FileHash
+    {
+        long long writeTime;
+        uintmax_t size;
+        uint64_t hash;
+    };
+
     std::filesystem::path importDatabaseRoot;
+    // loaders import in parallel
+    std::mutex hashCacheMutex;
+    std::unordered_map<std::string, FileHash> hashCache;
 };
 
 class AssetLoader
@@ -34,6 +56,10 @@ public:
     virtual void Import() = 0;
     virtual void Load() = 0;
 
+    // restores the result of an earlier import with the same import key instead of importing again, false if the
+    // import database doesn't have it
+    bool AdoptArtifact();
+
     // no need to override if this data import doesn't need reference resolving
     virtual void GetReferenceResolveData(Serializer*& serializer, SerializeReferenceResolveMap*& resolveMap)
     {
@@ -54,6 +80,37 @@ protected:
     nlohmann::json meta;
     ImportDatabase* importDatabase;
 
+    // bump when an importer's output changes, artifacts of older versions are not reused
+    virtual uint32_t GetImporterVersion()
+    {
+        return 1;
+    }
+
+    // files other than the asset that the import reads, e.g. shader includes
+    virtual std::vector<std::filesystem::path> GetImportDependencies()
+    {
+        return {};
+    }
+
+    // import options that only change how the artifact is loaded, toggling them reuses the artifact
+    virtual std::vector<std::string> GetLoadOptions()
+    {
+        return {};
+    }
+
+    // hash of the asset's bytes, its dependencies, the import options and the importer version. Write times don't
+    // take part, touching or checking out an unchanged file keeps its key
+    uint64_t GetImportKey();
+
+    // artifact file names derived from the import key
+    std::string GetArtifactName(const std::string& suffix);
+
+    // true if meta holds the import of the current key and its artifacts are in the import database
+    bool IsImportUpToDate();
+
+    // called at the end of a successful import, records the listed meta entries and artifact files under the import key
+    void StoreArtifact(const std::vector<std::string>& producedMetaKeys, const std::vector<std::string>& files);
+
     static std::vector<std::string> GenerateExtensions(const std::string& exts, char delimiter)
     {
         auto tokens = Utils::SplitString(exts, ',');
@@ -7,6 +7,35 @@
 
 DEFINE_ASSET_LOADER(ShaderLoader, "shad,comp")
 
+namespace
+{
+// resolved like ShaderCompiler::ShaderIncluder: relative to the including file first, then to the shader root.
+// Includes inside inactive #if blocks are listed too
+void ScanIncludes(const std::filesystem::path& file, std::set<std::filesystem::path>& includes)
+{
+    static const std::regex includeReg("^\\s*#\\s*include\\s*[\"<]([^\">]+)[\">]");
+    std::ifstream f(file);
+    std::string line;
+    std::smatch match;
+    while (std::getline(f, line))
+    {
+        if (!std::regex_search(line, match, includeReg))
+            continue;
+
+        std::filesystem::path requested = match.str(1);
+        std::filesystem::path path = file.parent_path() / requested;
+        if (!std::filesystem::exists(path))
+            path = std::filesystem::path("Assets/Shaders/") / requested;
+        if (!std::filesystem::exists(path))
+            continue;
+
+        path = std::filesystem::absolute(path).lexically_normal();
+        if (includes.insert(path).second)
+            ScanIncludes(path, includes);
+    }
+}
+} // namespace
+
 const std::vector<std::type_index>& ShaderLoader::GetImportTypes()
 {
     static std::vector<std::type_index> types = {typeid(Shader), typeid(ComputeShader)};
@@ -15,27 +44,18 @@ const std::vector<std::type_index>& ShaderLoader::GetImportTypes()
 
 bool ShaderLoader::ImportNeeded()
 {
-    if (!meta.contains("shaderFileLastWriteTime"))
-        return true;
-
-    if (meta["shaderFileLastWriteTime"] <
-        std::filesystem::last_write_time(absoluteAssetPath).time_since_epoch().count())
-        return true;
-
-    if (!meta.contains("includedFiles"))
-        return true;
-
-    nlohmann::json includedFiles = meta.value("includedFiles", nlohmann::json::array_t());
-
-    for (int i = 0; i < includedFiles.size(); i++)
-    {
-        if (!std::filesystem::exists(includedFiles[i]["path"]) || includedFiles[i]["lastWriteTime"] <
-            std::filesystem::last_write_time(includedFiles[i]["path"]).time_since_epoch().count())
-            return true;
-    }
+    return !IsImportUpToDate();
+}
 
-    return false;
+std::vector<std::filesystem::path> ShaderLoader::GetImportDependencies()
+{
+    // scanned from the sources instead of taken from the last import's meta, the key has to be the same before and
+    // after an import for the artifact to be found again
+    std::set<std::filesystem::path> includes;
+    ScanIncludes(absoluteAssetPath, includes);
+    return {includes.begin(), includes.end()};
 }
+
 void ShaderLoader::Import()
 {
     struct PassCompiledData
@@ -170,13 +190,12 @@ void ShaderLoader::Import()
         passCompiledData.shaderConfig = compiler.GetConfig()->ToJson();
         compiledData.push_back(passCompiledData);
     }
-    meta["shaderFileLastWriteTime"] = std::filesystem::last_write_time(absoluteAssetPath).time_since_epoch().count();
+    // relative to the shader so that the meta stays valid in other checkouts
     meta["includedFiles"] = nlohmann::json::array_t();
     for (auto includedFile : includedFilesSet)
     {
         nlohmann::json::object_t includedFileJson;
-        includedFileJson["path"] = includedFile.string();
-        includedFileJson["lastWriteTime"] = std::filesystem::last_write_time(includedFile).time_since_epoch().count();
+        includedFileJson["path"] = std::filesystem::relative(includedFile, absoluteAssetPath.parent_path()).string();
         meta["includedFiles"].push_back(includedFileJson);
     }
 
@@ -245,14 +264,16 @@ void ShaderLoader::Import()
         meta["compiledShaderPasses"].push_back(passj);
     }
 
-    std::string compiledSpvGUID = UUID().ToString();
-    auto importName = fmt::format("{}_{}", "shader", compiledSpvGUID);
+    auto importName = GetArtifactName(".spv");
     meta["importedBinaryFileName"] = importName;
 
     auto importAssetPath = importDatabase->GetImportAssetPath(importName);
     std::fstream output;
     output.open(importAssetPath, std::ios_base::out | std::ios_base::binary);
     output.write((char*)binaryData.data(), binaryData.size());
+    output.close();
+
+    StoreArtifact({"includedFiles", "compiledShaderPasses", "importedBinaryFileName"}, {importName});
 }
 void ShaderLoader::Load()
 {
@@ -16,6 +16,9 @@ public:
 
     static const std::vector<std::type_index>& GetImportTypes();
 
+protected:
+    std::vector<std::filesystem::path> GetImportDependencies() override;
+
 private:
     std::unique_ptr<Asset> asset;
 };
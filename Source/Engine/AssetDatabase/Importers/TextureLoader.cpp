@@ -6,6 +6,7 @@
 #include "GfxDriver/Vulkan/Internal/VKEnumMapper.hpp"
 #include "Libs/Image/ImageProcessing.hpp"
 #include "ThirdParty/stb/stb_image.h"
+#include <cmath>
 #include <fstream>
 #include <ktx.h>
 #include <ktxvulkan.h>
@@ -20,30 +21,27 @@ const std::vector<std::type_index>& TextureLoader::GetImportTypes()
 
 bool TextureLoader::ImportNeeded()
 {
-    size_t oldLastWriteTime = meta.value("lastImportedWriteTime", 0ll);
-    size_t lastWriteTime = std::filesystem::last_write_time(absoluteAssetPath).time_since_epoch().count();
-    bool reimport = lastWriteTime > oldLastWriteTime;
-
-    // meta file validation
-    if (meta.contains("importedKtxFile"))
-    {
-        reimport = reimport || !std::filesystem::exists(meta["importedKtxFile"]);
-    }
-    else
-        reimport = true;
-
-    return reimport;
+    return !IsImportUpToDate();
 }
 
 void TextureLoader::Import()
 {
-    std::string importFileUUID = meta.value("importFileUUID", UUID().ToString());
     nlohmann::json option = meta.value("importOption", nlohmann::json::object_t{});
     bool generateMipmap = option.value("generateMipmap", false);
     bool converToIrradianceCubemap = option.value("convertToIrradianceCubemap", false);
     bool convertToReflectanceCubemap = option.value("convertToReflectanceCubemap", false);
     bool linearFormat = option.value("linearFormat", false);
     bool convertToCubemap = option.value("convertToCubemap", false);
+    // color, normal or data. Picks the compressed format when compression is auto
+    std::string usage = option.value("usage", "color");
+    // none, auto, uastc or etc1s
+    std::string compression = option.value("compression", "none");
+    // box, kaiser or lanczos
+    std::string mipFilter = option.value("mipFilter", "box");
+    // clamp or wrap, what the mip filters sample past the image border
+    std::string mipEdgeMode = option.value("mipEdgeMode", "clamp");
+    if (usage != "color")
+        linearFormat = true;
     if (convertToCubemap)
     {
         converToIrradianceCubemap = false;
@@ -55,7 +53,18 @@ void TextureLoader::Import()
         generateMipmap = false;
     }
 
-    auto importedAssetPath = importDatabase->GetImportAssetPath(importFileUUID).replace_extension(".ktx");
+    // stores the irradiance as spherical harmonics instead of a cubemap
+    bool irradianceSH = converToIrradianceCubemap && option.value("irradianceSH", false);
+    if (irradianceSH)
+    {
+        converToIrradianceCubemap = false;
+        generateMipmap = false;
+    }
+
+    // textures with the same content and options share one ktx file
+    std::string importedFile = GetArtifactName(".ktx");
+    auto importedAssetPath = importDatabase->GetImportAssetPath(importedFile);
+    bool imported = false;
 
     std::fstream f;
     f.open(absoluteAssetPath, std::ios::binary | std::ios_base::in);
@@ -80,6 +89,11 @@ void TextureLoader::Import()
             bool isHDR = stbi_is_hdr_from_memory(data, byteSize);
             if (isHDR || is16Bit)
                 linearFormat = true;
+            Libs::Image::ChannelType channelType = Libs::Image::ChannelType::UInt8;
+            if (isHDR)
+                channelType = Libs::Image::ChannelType::Float;
+            else if (is16Bit)
+                channelType = Libs::Image::ChannelType::UInt16;
             int mipLevels = generateMipmap ? glm::floor(glm::log2((float)glm::min(width, height))) + 1 : 1;
 
             uint8_t* loaded = nullptr;
@@ -88,11 +102,41 @@ void TextureLoader::Import()
                 loaded =
                     (stbi_uc*)stbi_loadf_from_memory(data, (int)byteSize, &width, &height, &channels, desiredChannels);
             }
+            else if (is16Bit)
+            {
+                loaded = (stbi_uc*)stbi_load_16_from_memory(
+                    data,
+                    (int)byteSize,
+                    &width,
+                    &height,
+                    &channels,
+                    desiredChannels
+                );
+            }
             else
             {
                 loaded = stbi_load_from_memory(data, (int)byteSize, &width, &height, &channels, desiredChannels);
             }
 
+            if (irradianceSH)
+            {
+                // a 9x1 texture, texel i holds coefficient i
+                Libs::Image::IrradianceSH sh = Libs::Image::ComputeIrradianceSH((float*)loaded, width, height);
+                glm::vec4* output = new glm::vec4[9];
+                nlohmann::json coefficients = nlohmann::json::array();
+                for (int i = 0; i < 9; ++i)
+                {
+                    glm::vec3 c = sh.coefficients[i];
+                    output[i] = glm::vec4(c, 0);
+                    coefficients.push_back({c.x, c.y, c.z});
+                }
+                meta["irradianceSH"] = coefficients;
+                delete[] loaded;
+                loaded = (uint8_t*)output;
+                width = 9;
+                height = 1;
+            }
+
             if (converToIrradianceCubemap)
             {
                 uint8_t* output;
@@ -108,7 +152,7 @@ void TextureLoader::Import()
             {
                 uint8_t* output;
                 int cubemapSize = 1024;
-                Libs::Image::ConverToCubemap((float*)loaded, width, height, cubemapSize, desiredChannels, output);
+                Libs::Image::ConverToCubemap(loaded, width, height, cubemapSize, desiredChannels, channelType, output);
                 delete[] loaded;
                 loaded = output;
                 width = cubemapSize;
@@ -130,40 +174,33 @@ void TextureLoader::Import()
             {
                 size_t mippedDataByteSize = 0;
                 uint8_t* mippedData = nullptr;
-                if (isHDR)
-                {
-                    Libs::Image::GenerateBoxFilteredMipmap<float>(
-                        loaded,
-                        width,
-                        height,
-                        layers,
-                        mipLevels,
-                        desiredChannels,
-                        mippedData,
-                        mippedDataByteSize
-                    );
-                    stbi_image_free(loaded);
-                    loaded = mippedData;
-                }
-                else if (is16Bit)
-                {
-                    throw std::exception("Not implemented");
-                }
-                else
-                {
-                    Libs::Image::GenerateBoxFilteredMipmap<uint8_t>(
-                        loaded,
-                        width,
-                        height,
-                        layers,
-                        mipLevels,
-                        desiredChannels,
-                        mippedData,
-                        mippedDataByteSize
-                    );
-                    stbi_image_free(loaded);
-                    loaded = mippedData;
-                }
+
+                Libs::Image::MipFilter filter = Libs::Image::MipFilter::Box;
+                if (mipFilter == "kaiser")
+                    filter = Libs::Image::MipFilter::Kaiser;
+                else if (mipFilter == "lanczos")
+                    filter = Libs::Image::MipFilter::Lanczos;
+
+                // cubemap faces don't wrap onto themselves
+                Libs::Image::EdgeMode edgeMode = mipEdgeMode == "wrap" && !isCubemap ? Libs::Image::EdgeMode::Wrap
+                                                                                     : Libs::Image::EdgeMode::Clamp;
+
+                Libs::Image::GenerateFilteredMipmap(
+                    loaded,
+                    width,
+                    height,
+                    layers,
+                    mipLevels,
+                    desiredChannels,
+                    channelType,
+                    !linearFormat,
+                    filter,
+                    edgeMode,
+                    mippedData,
+                    mippedDataByteSize
+                );
+                stbi_image_free(loaded);
+                loaded = mippedData;
             }
 
             auto filename = absoluteAssetPath.filename().string();
@@ -175,10 +212,29 @@ void TextureLoader::Import()
 
             Gfx::ImageFormat format = Gfx::GetImageFormat(bits, desiredChannels, linearFormat);
 
+            // auto and uastc textures are transcoded to BC7 at load time, normal maps to BC5. etc1s is opt in, it
+            // makes roughly half as large files but transcodes to BC3 with visible block artifacts. There is no HDR
+            // block encoder (BC6H) available, HDR and 16 bit textures only get Zstd supercompression
+            Exporters::KtxCompression ktxCompression;
+            if (compression != "none")
+            {
+                bool blockCompressible = bits == 8;
+                bool etc1s = compression == "etc1s";
+                if (etc1s && blockCompressible)
+                    ktxCompression.mode = Exporters::KtxCompression::Mode::ETC1S;
+                else if (blockCompressible)
+                    ktxCompression.mode = Exporters::KtxCompression::Mode::UASTC;
+                ktxCompression.normalMap = usage == "normal";
+                ktxCompression.uastcLevel = option.value("uastcLevel", 2);
+                ktxCompression.etc1sLevel = option.value("etc1sLevel", 128);
+                ktxCompression.zstdLevel = option.value("zstdLevel", 18);
+            }
+
             //
             // note: this "converToCube ? 1 : layers" prevents creating array of cubeMaps, but ktx separate the
             // concept of face and layer, that's why I need to manually convert layer to face
-            Exporters::KtxExporter::Export(
+            Exporters::KtxExportReport report;
+            bool exported = Exporters::KtxExporter::Export(
                 importedAssetPath.string().c_str(),
                 loaded,
                 width,
@@ -189,10 +245,38 @@ void TextureLoader::Import()
                 mipLevels,
                 false,
                 isCubemap,
-                format
+                format,
+                ktxCompression,
+                &report
             );
 
             delete[] loaded;
+
+            if (exported)
+            {
+                imported = true;
+                float ratio = report.uncompressedByteSize / (float)glm::max(report.fileByteSize, size_t(1));
+                meta["importReport"] = {
+                    {"format", Gfx::MapImageFormatToString(format)},
+                    {"compression", compression},
+                    {"uncompressedByteSize", report.uncompressedByteSize},
+                    {"fileByteSize", report.fileByteSize},
+                    {"compressionRatio", ratio},
+                    // json has no infinity, lossless imports store null
+                    {"psnr", std::isinf(report.psnr) ? nlohmann::json() : nlohmann::json(report.psnr)},
+                };
+                SPDLOG_INFO(
+                    "TextureLoader: imported {} ({}), {:.2f}x smaller, PSNR {:.2f} dB",
+                    filename,
+                    compression,
+                    ratio,
+                    report.psnr
+                );
+            }
+            else
+            {
+                SPDLOG_ERROR("TextureLoader: failed to export {}", filename);
+            }
         }
         else
         {
@@ -201,12 +285,16 @@ void TextureLoader::Import()
             if (outf.good() && f.is_open())
             {
                 outf << f.rdbuf();
+                imported = true;
             }
         }
     }
-    meta["lastImportedWriteTime"] = std::filesystem::last_write_time(absoluteAssetPath).time_since_epoch().count();
-    meta["importedKtxFile"] = importedAssetPath.string();
-    meta["importFileUUID"] = importFileUUID;
+
+    if (imported)
+    {
+        meta["importedKtxFile"] = importedFile;
+        StoreArtifact({"importedKtxFile", "importReport", "irradianceSH"}, {importedFile});
+    }
 }
 
 bool TextureLoader::IsKTX2File(ktx_uint8_t* imageData)
@@ -231,6 +319,9 @@ void TextureLoader::Load()
     uint8_t* sourceBinary = sourceBinaryVec.data();
     size_t binarySize = sourceBinaryVec.size();
 
-    this->texture = std::make_unique<Texture>(KtxTexture{sourceBinary, binarySize});
+    nlohmann::json option = meta.value("importOption", nlohmann::json::object_t{});
+    bool streaming = option.value("streaming", false);
+
+    this->texture = std::make_unique<Texture>(KtxTexture{sourceBinary, binarySize, streaming});
     this->texture->SetName(absoluteAssetPath.filename().string());
 }
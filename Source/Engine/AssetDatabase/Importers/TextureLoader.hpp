@@ -5,6 +5,16 @@
 /**
  * importOption : {
  *     generateMipmap : bool
+ *     mipFilter : "box" | "kaiser" | "lanczos"
+ *     mipEdgeMode : "clamp" | "wrap"
+ *     convertToIrradianceCubemap : bool
+ *     irradianceSH : bool, with convertToIrradianceCubemap outputs a 9x1 texture of SH9 coefficients
+ *     usage : "color" | "normal" | "data"
+ *     compression : "none" | "auto" | "uastc" | "etc1s", auto is uastc
+ *     uastcLevel : int (0-4)
+ *     etc1sLevel : int (1-255)
+ *     zstdLevel : int (1-22)
+ *     streaming : bool, only the smallest mips stay resident until the texture is drawn large enough
  * }
  */
 class TextureLoader : public AssetLoader
@@ -21,6 +31,12 @@ public:
     }
     static const std::vector<std::type_index>& GetImportTypes();
 
+protected:
+    std::vector<std::string> GetLoadOptions() override
+    {
+        return {"streaming"};
+    }
+
 private:
     void LoadStbSupoprtedTexture(uint8_t* data, size_t byteSize);
     std::unique_ptr<Asset> texture;
@@ -1,9 +1,15 @@
 #include "Component.hpp"
 #include "Core/GameObject.hpp"
+#include "Core/Scene/Scene.hpp"
 
 Component::Component(GameObject* gameObject) : gameObject(gameObject) {}
 
-Component::~Component() {}
+Component::~Component()
+{
+    // components destroyed without being disabled first, e.g. together with their game object
+    if (registeredScene)
+        registeredScene->UnregisterComponent(this);
+}
 
 GameObject* Component::GetGameObject()
 {
@@ -17,6 +23,12 @@ Scene* Component::GetScene()
     return nullptr;
 }
 
+void Component::NotifyScene()
+{
+    if (Scene* scene = GetScene())
+        scene->ComponentStateChanged(this);
+}
+
 void Component::Serialize(Serializer* s) const
 {
     s->Serialize("uuid", uuid);
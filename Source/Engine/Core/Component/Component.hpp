@@ -1,20 +1,50 @@
 #pragma once
 #include "Core/Asset.hpp"
 #include "Core/Gizmo.hpp"
+#include "Libs/EnumFlags.hpp"
 #include "Libs/Ptr.hpp"
 #include <functional>
 #include <string>
 #include <string_view>
 #include <unordered_map>
+#include <vector>
 class GameObject;
 class Scene;
+
+ENUM_FLAGS(UpdatePhase, uint32_t){
+    None = 0,
+    // before every fixed physics step
+    PrePhysics = 1 << 0,
+    Update = 1 << 1,
+    // after every component finished Update, e.g. cameras following a moved object
+    LateUpdate = 1 << 2,
+};
+
 class Component : public Object, public Serializable
 {
 public:
     Component(GameObject* gameObject);
     virtual ~Component();
+
+    // Scene batches components by concrete type, every instance of a type has to return the same phases
+    virtual UpdatePhaseFlags GetUpdatePhases()
+    {
+        return UpdatePhase::None;
+    }
+
+    // components of a thread safe type are ticked in parallel chunks on the job system. They may only touch their
+    // own state and read transforms. They must not move, add, remove, enable or disable components or game objects
+    virtual bool IsTickThreadSafe()
+    {
+        return false;
+    }
+
+    // UpdatePhase::Update
     virtual void Tick() {};
+    // UpdatePhase::PrePhysics
     virtual void PrePhysicsTick() {};
+    // UpdatePhase::LateUpdate
+    virtual void LateTick() {};
 
     virtual const std::string& GetName() = 0;
     virtual std::unique_ptr<Component> Clone(GameObject& owner) = 0;
@@ -31,6 +61,7 @@ public:
         {
             enabled = true;
             EnableImple();
+            NotifyScene();
         }
     };
 
@@ -40,6 +71,7 @@ public:
         {
             enabled = false;
             DisableImple();
+            NotifyScene();
         }
     }
 
@@ -61,5 +93,14 @@ protected:
     // editor only
     virtual void TransformChanged() {}
 
+private:
+    // set while the component is in a scene's registry, see Scene::GetComponentsOfType
+    Scene* registeredScene = nullptr;
+    std::vector<Component*>* registry = nullptr;
+    size_t registryIndex = 0;
+
+    void NotifyScene();
+
     friend class GameObject;
+    friend class Scene;
 };
@@ -127,6 +127,17 @@ public:
         return shadowCache.targetFrames;
     }
 
+    // only touches the shadow cache counter
+    UpdatePhaseFlags GetUpdatePhases() override
+    {
+        return UpdatePhase::Update;
+    }
+
+    bool IsTickThreadSafe() override
+    {
+        return true;
+    }
+
     void Tick() override
     {
         if (shadowCache.isEnabled)
@@ -17,6 +17,10 @@ public:
     void RefLuaClass(const char* luaClass);
     void Construct();
     void Destruct();
+    UpdatePhaseFlags GetUpdatePhases() override
+    {
+        return UpdatePhase::Update;
+    }
     void Tick() override;
 
     std::unique_ptr<Component> Clone(GameObject& owner) override
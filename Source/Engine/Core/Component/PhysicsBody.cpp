@@ -2,6 +2,7 @@
 #include "Core/Component/MeshRenderer.hpp"
 #include "Core/GameObject.hpp"
 #include "Core/Scene/Scene.hpp"
+#include "Physics/MeshShapeCache.hpp"
 
 using namespace JPH;
 using namespace JPH::literals;
@@ -70,6 +71,13 @@ void PhysicsBody::EnableImple()
     {
         Init();
     }
+    else
+    {
+        // Disable took the body out of the scene's queries and simulation
+        auto& physicsScene = scene->GetPhysicsScene();
+        physicsScene.AddPhysicsBody(*this);
+        physicsScene.GetBodyInterface().ActivateBody(body->GetID());
+    }
 
     TransformChanged();
 }
@@ -108,61 +116,71 @@ bool PhysicsBody::SetShape(JPH::ShapeSettings& shape)
 {
     auto result = shape.Create();
     if (result.IsValid())
+        return SetShape(result.Get());
+    return false;
+}
+
+bool PhysicsBody::SetShape(const JPH::Ref<JPH::Shape>& shape)
+{
+    shapeRef = shape;
+    if (body)
     {
-        shapeRef = result.Get();
-        if (body)
-        {
-            if (result.IsValid())
-            {
-                if (auto interface = GetBodyInterface())
-                {
-                    interface->SetShape(
-                        body->GetID(),
-                        result.Get(),
-                        true,
-                        (static_cast<int>(layer) & static_cast<int>(PhysicsLayer::Moving)) == 1
-                            ? EActivation::Activate
-                            : EActivation::DontActivate
-                    );
-                }
-            }
-        }
-        else
+        if (auto interface = GetBodyInterface())
         {
-            glm::vec3 position = gameObject->GetPosition();
-            glm::quat rot = gameObject->GetRotation();
-            BodyCreationSettings bodyCreationSettings(
-                shapeRef,
-                RVec3{position.x, position.y, position.z},
-                Quat{rot.x, rot.y, rot.z, rot.w},
-                motionType,
-                static_cast<ObjectLayer>(layer)
+            interface->SetShape(
+                body->GetID(),
+                shape,
+                true,
+                (static_cast<int>(layer) & static_cast<int>(PhysicsLayer::Moving)) == 1
+                    ? EActivation::Activate
+                    : EActivation::DontActivate
             );
+        }
+    }
+    else
+    {
+        glm::vec3 position = gameObject->GetPosition();
+        glm::quat rot = gameObject->GetRotation();
+        BodyCreationSettings bodyCreationSettings(
+            shapeRef,
+            RVec3{position.x, position.y, position.z},
+            Quat{rot.x, rot.y, rot.z, rot.w},
+            motionType,
+            static_cast<ObjectLayer>(layer)
+        );
+
+        // wasting space, maybe split class to static(Collider) and dynamic(RigidBody)? or a body creation is needed
+        // if set this to false
+        bodyCreationSettings.mAllowDynamicOrKinematic = true;
+
+        auto& physicsWorld = GetScene()->GetPhysicsScene();
+        auto& bodyInterface = physicsWorld.GetBodyInterface();
 
-            // wasting space, maybe split class to static(Collider) and dynamic(RigidBody)? or a body creation is needed
-            // if set this to false
-            bodyCreationSettings.mAllowDynamicOrKinematic = true;
-
-            auto& physicsWorld = GetScene()->GetPhysicsScene();
-            auto& bodyInterface = physicsWorld.GetBodyInterface();
-
-            if (body != nullptr)
-            {
-                bodyInterface.RemoveBody(body->GetID());
-                bodyInterface.DestroyBody(body->GetID());
-            }
-
-            body = bodyInterface.CreateBody(bodyCreationSettings);
-            bodyInterface.AddBody(body->GetID(), EActivation::DontActivate);
-            SetGravityFactor(gravityFactor);
-            body->SetUserData(reinterpret_cast<std::intptr_t>(this));
+        if (body != nullptr)
+        {
+            bodyInterface.RemoveBody(body->GetID());
+            bodyInterface.DestroyBody(body->GetID());
+        }
 
-            auto& physicsScene = GetScene()->GetPhysicsScene();
-            physicsScene.AddPhysicsBody(*this);
-            physicsScene.GetBodyInterface().ActivateBody(body->GetID());
+        body = bodyInterface.CreateBody(bodyCreationSettings);
+        if (body == nullptr)
+        {
+            spdlog::error(
+                "PhysicsBody: can't create a body for {}, the scene is limited to {} bodies",
+                gameObject->GetName(),
+                physicsWorld.GetSettings().maxBodies
+            );
+            return false;
         }
+        bodyInterface.AddBody(body->GetID(), EActivation::DontActivate);
+        SetGravityFactor(gravityFactor);
+        body->SetUserData(reinterpret_cast<std::intptr_t>(this));
+
+        auto& physicsScene = GetScene()->GetPhysicsScene();
+        physicsScene.AddPhysicsBody(*this);
+        physicsScene.GetBodyInterface().ActivateBody(body->GetID());
     }
-    return false;
+    return true;
 }
 
 PhysicsBody::~PhysicsBody()
@@ -175,9 +193,9 @@ PhysicsBody::~PhysicsBody()
     {
         auto& physicsWorld = scene->GetPhysicsScene();
         auto& bodyInterface = physicsWorld.GetBodyInterface();
+        physicsWorld.RemovePhysicsBody(*this);
         bodyInterface.RemoveBody(body->GetID());
         bodyInterface.DestroyBody(body->GetID());
-        shapeRef->Release();
     }
 }
 
@@ -214,18 +232,38 @@ void PhysicsBody::SetGravityFactor(float f)
     }
 }
 
-void PhysicsBody::UpdateGameObject()
+void PhysicsBody::StorePose(uint64_t step)
+{
+    if (body == nullptr || syncedStep == step)
+        return;
+
+    previousPosition = currentPosition;
+    previousRotation = currentRotation;
+
+    auto newPos = body->GetPosition();
+    currentPosition = {newPos.GetX(), newPos.GetY(), newPos.GetZ()};
+    auto newRot = body->GetRotation();
+    currentRotation = {newRot.GetW(), newRot.GetX(), newRot.GetY(), newRot.GetZ()};
+    syncedStep = step;
+}
+
+void PhysicsBody::UpdateGameObject(float alpha)
 {
     if (body)
     {
-        auto newPos = body->GetPosition();
-        gameObject->SetPosition({newPos.GetX(), newPos.GetY(), newPos.GetZ()});
-
-        auto newRot = body->GetRotation();
-        gameObject->SetRotation({newRot.GetW(), newRot.GetX(), newRot.GetY(), newRot.GetZ()});
+        syncingFromBody = true;
+        gameObject->SetPosition(glm::mix(previousPosition, currentPosition, alpha));
+        gameObject->SetRotation(glm::slerp(previousRotation, currentRotation, alpha));
+        syncingFromBody = false;
     }
 }
 
+void PhysicsBody::WaitForSimulation()
+{
+    if (auto physicsScene = GetPhysicsScene())
+        physicsScene->WaitForSimulation();
+}
+
 bool PhysicsBody::SetAsSphere(float radius)
 {
     if (radius <= 0)
@@ -273,6 +311,10 @@ void PhysicsBody::Awake() {}
 
 void PhysicsBody::TransformChanged()
 {
+    // the body is already where the game object is
+    if (syncingFromBody)
+        return;
+
     if (recreateShape)
         recreateShape();
 }
@@ -287,17 +329,20 @@ void PhysicsBody::SetLinearVelocity(const glm::vec3& velocity)
 
 void PhysicsBody::AddForce(const glm::vec3& force)
 {
+    WaitForSimulation();
     body->AddForce({force.x, force.y, force.z});
 }
 
 glm::vec3 PhysicsBody::GetLinearVelocity()
 {
+    WaitForSimulation();
     auto v = body->GetLinearVelocity();
     return {v.GetX(), v.GetY(), v.GetZ()};
 }
 
 void PhysicsBody::AddImpulse(const glm::vec3& impulse)
 {
+    WaitForSimulation();
     body->AddImpulse({impulse.x, impulse.y, impulse.z});
 }
 
@@ -318,6 +363,9 @@ void PhysicsBody::UpdateBodyPositionAndRotation()
         {
             auto pos = gameObject->GetPosition();
             auto rot = gameObject->GetRotation();
+            // a teleport, don't interpolate from the old pose
+            previousPosition = currentPosition = pos;
+            previousRotation = currentRotation = rot;
             i->SetPositionAndRotation(
                 body->GetID(),
                 {pos.x, pos.y, pos.z},
@@ -332,56 +380,24 @@ bool PhysicsBody::SetAsMeshRenderer()
 {
     recreateShape = [this]()
     {
-        JPH::Array<JPH::Triangle> triangles;
-        bool createFromMeshRenderer = GenerateTrianglesFromMeshRenderer(triangles);
+        // cooked once per mesh and shared by every body using it
+        auto meshRenderer = gameObject->GetComponent<MeshRenderer>();
+        auto mesh = meshRenderer ? meshRenderer->GetMesh() : nullptr;
+        JPH::Ref<JPH::Shape> shape = mesh ? MeshShapeCache::GetSingleton().GetShape(*mesh, gameObject->GetScale())
+                                          : nullptr;
 
-        if (createFromMeshRenderer)
+        if (shape)
         {
-            JPH::MeshShapeSettings meshShapeSettings(triangles);
-            SetShape(meshShapeSettings);
-
+            SetShape(shape);
             UpdateBodyPositionAndRotation();
         }
 
-        return createFromMeshRenderer;
+        return shape != nullptr;
     };
 
     return recreateShape();
 }
 
-bool PhysicsBody::GenerateTrianglesFromMeshRenderer(JPH::Array<JPH::Triangle>& triangles)
-{
-    bool createFromMeshRenderer = false;
-    auto meshRenderer = gameObject->GetComponent<MeshRenderer>();
-    auto mesh = meshRenderer ? meshRenderer->GetMesh() : nullptr;
-    auto scale = GetGameObject()->GetScale();
-    if (mesh)
-    {
-        auto& submeshes = mesh->GetSubmeshes();
-        for (auto& submesh : submeshes)
-        {
-            auto& indices = submesh.GetIndices();
-            auto& vertexPositions = submesh.GetPositions();
-            for (int i = 0; i < indices.size(); i += 3)
-            {
-                const int i0 = indices[i];
-                const int i1 = indices[i + 1];
-                const int i2 = indices[i + 2];
-                const JPH::Vec3 v0 =
-                    {vertexPositions[i0].x * scale.x, vertexPositions[i0].y * scale.y, vertexPositions[i0].z * scale.z};
-                const JPH::Vec3 v1 =
-                    {vertexPositions[i1].x * scale.x, vertexPositions[i1].y * scale.y, vertexPositions[i1].z * scale.z};
-                const JPH::Vec3 v2 =
-                    {vertexPositions[i2].x * scale.x, vertexPositions[i2].y * scale.y, vertexPositions[i2].z * scale.z};
-                triangles.push_back({v0, v1, v2});
-            }
-        }
-        createFromMeshRenderer = !triangles.empty();
-    }
-
-    return createFromMeshRenderer;
-}
-
 void PhysicsBody::SetShape(PhysicsBodyShapes shape)
 {
     auto scale = gameObject->GetScale();
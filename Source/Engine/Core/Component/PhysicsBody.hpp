@@ -2,6 +2,7 @@
 
 #include "Component.hpp"
 #include "Core/Scene/PhysicsLayer.hpp"
+#include <glm/gtc/quaternion.hpp>
 #include <memory>
 
 // clang-format off
@@ -105,7 +106,15 @@ public:
     std::unique_ptr<Component> Clone(GameObject& owner) override;
     const std::string& GetName() override;
 
-    void UpdateGameObject();
+    // called by the physics simulation job after a step, keeps the poses of the last two steps
+    void StorePose(uint64_t step);
+    uint64_t GetSyncedStep() const
+    {
+        return syncedStep;
+    }
+
+    // writes the pose interpolated between the last two steps to the game object, alpha 1 is the latest step
+    void UpdateGameObject(float alpha = 1.0f);
 
     // set this to true, the physics scene will try to draw this physics body in this frame
     bool debugDrawRequest = false;
@@ -134,17 +143,26 @@ private:
     PhysicsBodyShapes shapeType = PhysicsBodyShapes::Mesh;
 
     std::function<bool()> recreateShape = nullptr;
+    // set while UpdateGameObject writes the simulated transform, so it isn't sent back to the body
+    bool syncingFromBody = false;
+
+    glm::vec3 previousPosition = glm::vec3(0);
+    glm::quat previousRotation = glm::quat(1, 0, 0, 0);
+    glm::vec3 currentPosition = glm::vec3(0);
+    glm::quat currentRotation = glm::quat(1, 0, 0, 0);
+    uint64_t syncedStep = 0;
     std::vector<ContactAddedEventCallbackType> contactAddedCallbacks = {};
     std::vector<ContactRemovedEventCallbackType> contactRemovedCallbacks = {};
 
     void EnableImple() override;
     void DisableImple() override;
     bool SetShape(JPH::ShapeSettings& shape);
+    bool SetShape(const JPH::Ref<JPH::Shape>& shape);
     void TransformChanged() override;
     void UpdateBodyPositionAndRotation();
+    void WaitForSimulation();
     JPH::BodyInterface* GetBodyInterface();
     void Init();
-    bool GenerateTrianglesFromMeshRenderer(JPH::Array<JPH::Triangle>& triangles);
     bool SetAsSphere(float radius);
     bool SetAsMeshRenderer();
     bool SetAsBox(glm::vec3 extent);
@@ -14,16 +14,6 @@ GameLoop::GameLoop()
 
 GameLoop::~GameLoop() {}
 
-static void TickGameObject(GameObject* go)
-{
-    go->Tick();
-
-    for (auto chil : go->GetChildren())
-    {
-        TickGameObject(chil);
-    }
-}
-
 const void GameLoop::Tick(
     Gfx::Image& outputImage,
     const Gfx::RG::ImageIdentifier*& outGraphOutputImage,
@@ -40,15 +30,18 @@ const void GameLoop::Tick(
     if (isPlaying)
     {
         scene->GetPhysicsScene().Tick();
-
-        for (auto go : scene->GetRootObjects())
-        {
-            TickGameObject(go);
-        }
+        scene->Tick();
+        scene->LateTick();
+        // overlaps with rendering
+        scene->GetPhysicsScene().StartSimulation();
     }
     scene->GetPhysicsScene().DebugDraw();
     ENGINE_END_PROFILE
 
+    ENGINE_BEGIN_PROFILE("Update Transforms")
+    scene->UpdateTransforms();
+    ENGINE_END_PROFILE
+
     // render
     ENGINE_BEGIN_PROFILE("FrameGraph")
     Rendering::FrameGraph::Graph* graph = camera ? camera->GetFrameGraph() : nullptr;
@@ -85,7 +78,9 @@ void GameLoop::Play()
 
     isPlaying = true;
 
-    auto gos = scene->GetAllGameObjects();
+    // Awake may create game objects, which invalidates the cached span
+    auto all = scene->GetAllGameObjects();
+    std::vector<GameObject*> gos(all.begin(), all.end());
     for (auto go : gos)
     {
         go->Awake();
@@ -11,24 +11,45 @@ GameObject::GameObject() : gameScene(nullptr)
 }
 
 GameObject::GameObject(GameObject&& other)
-    : components(std::move(other.components)), gameScene(std::exchange(other.gameScene, nullptr))
+    : transformSystem(std::exchange(other.transformSystem, nullptr)), transformSlot(other.transformSlot),
+      components(std::move(other.components)), gameScene(std::exchange(other.gameScene, nullptr))
 {
+    if (transformSystem)
+        transformSystem->SetOwner(transformSlot, this);
     SetName(other.GetName());
+    RebuildComponentIndex();
     ResetTransform();
 }
 
 GameObject::GameObject(Scene* gameScene) : gameScene(gameScene)
 {
     name = "New GameObject";
+    if (gameScene)
+        AttachTransform(&gameScene->GetTransformSystem());
     ResetTransform();
 }
 
 void GameObject::ResetTransform()
 {
-    position = glm::vec3(0);
-    scale = glm::vec3(1);
-    rotation = glm::identity<glm::quat>();
+    GetLocalTransform() = LocalTransform();
     eulerAngles = glm::vec3(0, 0, 0);
+    TransformChanged();
+}
+
+void GameObject::AttachTransform(TransformSystem* system)
+{
+    if (transformSystem == system)
+        return;
+
+    LocalTransform local = GetLocalTransform();
+    if (transformSystem)
+        transformSystem->Remove(transformSlot);
+
+    transformSystem = system;
+    if (transformSystem)
+        transformSlot = transformSystem->Add(this, local);
+    else
+        detachedTransform = local;
 }
 
 std::unique_ptr<Asset> GameObject::Clone()
@@ -40,9 +61,7 @@ std::unique_ptr<Asset> GameObject::Clone()
 GameObject::GameObject(const GameObject& other)
 {
     SetName(other.GetName());
-    position = other.position;
-    scale = other.scale;
-    rotation = other.rotation;
+    detachedTransform = other.GetLocalTransform();
     eulerAngles = other.eulerAngles;
     wantsToBeEnabled = other.enabled;
     gameScene = nullptr;
@@ -52,6 +71,7 @@ GameObject::GameObject(const GameObject& other)
     {
         components.push_back(c->Clone(*this));
     }
+    RebuildComponentIndex();
 
     for (GameObject* child : other.children)
     {
@@ -63,6 +83,8 @@ GameObject::GameObject(const GameObject& other)
 GameObject::~GameObject()
 {
     components.clear();
+    if (transformSystem)
+        transformSystem->Remove(transformSlot);
 }
 
 void GameObject::Tick()
@@ -81,6 +103,16 @@ void GameObject::PrePhysicsTick()
     }
 }
 
+void GameObject::RebuildComponentIndex()
+{
+    componentIndex.clear();
+    for (auto& c : components)
+    {
+        if (c)
+            componentIndex.emplace_back(typeid(*c), c.get());
+    }
+}
+
 std::vector<std::unique_ptr<Component>>& GameObject::GetComponents()
 {
     return components;
@@ -95,9 +127,10 @@ void GameObject::Serialize(Serializer* s) const
 {
     Asset::Serialize(s);
     s->Serialize("components", components);
-    s->Serialize("rotation", rotation);
-    s->Serialize("position", position);
-    s->Serialize("scale", scale);
+    auto& local = GetLocalTransform();
+    s->Serialize("rotation", local.rotation);
+    s->Serialize("position", local.position);
+    s->Serialize("scale", local.scale);
     s->Serialize("parent", parent);
     s->Serialize("children", children);
     s->Serialize("enabled", enabled);
@@ -126,11 +159,16 @@ void GameObject::Deserialize(Serializer* s)
     s->Deserialize("enabled", enabled);
     s->Deserialize("children", children);
     s->Deserialize("parent", parent);
-    s->Deserialize("scale", scale);
-    s->Deserialize("position", position);
-    s->Deserialize("rotation", rotation);
-    eulerAngles = glm::eulerAngles(rotation);
+    auto& local = GetLocalTransform();
+    s->Deserialize("scale", local.scale);
+    s->Deserialize("position", local.position);
+    s->Deserialize("rotation", local.rotation);
+    eulerAngles = glm::eulerAngles(local.rotation);
+    // not TransformChanged, components are references that may not be resolved yet
+    if (transformSystem)
+        transformSystem->MarkDirty(transformSlot);
     s->Deserialize("components", components);
+    RebuildComponentIndex();
     // gameScene is set by Scene when it's deserializing
 }
 
@@ -140,6 +178,7 @@ void GameObject::OnLoadingFinished()
     {
         c->gameObject = this;
     }
+    RebuildComponentIndex();
 }
 
 void GameObject::RemoveChild(GameObject* child)
@@ -199,13 +238,17 @@ void GameObject::SetParent(GameObject* parent)
     this->parent = parent;
     if (parent)
         parent->children.push_back(this);
+
+    if (gameScene)
+        gameScene->HierarchyChanged();
 }
 
 void GameObject::SetScene(Scene* scene)
 {
     if (this->gameScene != scene)
     {
-        if (this->gameScene != nullptr)
+        Scene* oldScene = this->gameScene;
+        if (oldScene != nullptr)
         {
             for (auto& c : components)
             {
@@ -214,11 +257,16 @@ void GameObject::SetScene(Scene* scene)
             }
         }
 
+        AttachTransform(scene ? &scene->GetTransformSystem() : nullptr);
         this->gameScene = scene;
         for (auto& c : components)
         {
+            if (oldScene)
+                oldScene->ComponentStateChanged(c.get());
             if (c->IsEnabled() && enabled)
                 c->EnableImple();
+            if (scene)
+                scene->ComponentStateChanged(c.get());
         }
 
         for (auto child : children)
@@ -263,6 +311,10 @@ void GameObject::SetEnable(bool isEnabled)
     }
 
     enabled = isEnabled;
+    for (auto& c : components)
+    {
+        gameScene->ComponentStateChanged(c.get());
+    }
 }
 
 void GameObject::SetScale(const glm::vec3& s)
@@ -272,29 +324,24 @@ void GameObject::SetScale(const glm::vec3& s)
 
 glm::mat4 GameObject::GetWorldMatrix() const
 {
-    if (updateLocalMatrix)
-    {
-        localMatrix =
-            glm::translate(glm::mat4(1), position) * glm::mat4_cast(rotation) * glm::scale(glm::mat4(1), scale);
-        updateLocalMatrix = false;
-    }
+    if (transformSystem && !transformSystem->IsOrderStale())
+        return transformSystem->GetWorldMatrix(transformSlot);
 
-    auto finalMatrix = localMatrix;
+    // detached objects and hierarchies that changed since the last update walk up the parents
+    glm::mat4 matrix = GetLocalTransform().ToMatrix();
     if (parent != nullptr)
-    {
-        finalMatrix = parent->GetWorldMatrix() * localMatrix;
-    }
-
-    return finalMatrix;
+        matrix = parent->GetWorldMatrix() * matrix;
+    return matrix;
 }
 
 glm::quat GameObject::GetRotation() const
 {
-    glm::quat r = rotation;
+    if (transformSystem && !transformSystem->IsOrderStale())
+        return transformSystem->GetWorldRotation(transformSlot);
+
+    glm::quat r = GetLocalTransform().rotation;
     if (parent != nullptr)
-    {
         r = r * parent->GetRotation();
-    }
     return r;
 }
 
@@ -306,21 +353,21 @@ void GameObject::SetPosition(const glm::vec3& position)
         pos = position - parent->GetPosition();
     }
 
-    if (pos != this->position)
+    auto& local = GetLocalTransform();
+    if (pos != local.position)
     {
-        this->position = pos;
-        this->updateLocalMatrix = true;
+        local.position = pos;
         TransformChanged();
     }
 };
 
 void GameObject::SetLocalRotation(const glm::quat& rotation)
 {
-    if (rotation == this->rotation)
+    auto& local = GetLocalTransform();
+    if (rotation == local.rotation)
         return;
 
-    this->rotation = rotation;
-    updateLocalMatrix = true;
+    local.rotation = rotation;
 
     TransformChanged();
 }
@@ -343,22 +390,22 @@ void GameObject::SetRotation(const glm::quat& rotation)
 
 void GameObject::SetLocalPosition(const glm::vec3& localPosition)
 {
-    if (position == localPosition)
+    auto& local = GetLocalTransform();
+    if (local.position == localPosition)
     {
         return;
     }
-    this->position = localPosition;
-    this->updateLocalMatrix = true;
+    local.position = localPosition;
 
     TransformChanged();
 }
 
 void GameObject::SetLocalScale(const glm::vec3& scale)
 {
-    if (this->scale != scale)
+    auto& local = GetLocalTransform();
+    if (local.scale != scale)
     {
-        this->scale = scale;
-        updateLocalMatrix = true;
+        local.scale = scale;
         TransformChanged();
     }
 }
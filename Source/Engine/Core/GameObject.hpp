@@ -3,10 +3,12 @@
 #include "Asset.hpp"
 #include "Component/Component.hpp"
 #include "EngineState.hpp"
+#include "Scene/TransformSystem.hpp"
 #include <glm/glm.hpp>
 #include <glm/gtc/quaternion.hpp>
 #include <glm/gtx/euler_angles.hpp>
 #include <memory>
+#include <typeindex>
 #include <vector>
 
 class Scene;
@@ -21,6 +23,7 @@ enum class RotationCoordinate
 class GameObject : public Asset
 {
     DECLARE_ASSET();
+    friend class TransformSystem;
 
 public:
     GameObject(Scene* gameScene);
@@ -41,9 +44,11 @@ public:
             std::unique_ptr<Component>& comp = *iter;
             comp->Disable();
             components.erase(iter);
+            RebuildComponentIndex();
         }
     }
 
+    // O(components) only when T isn't the concrete type of a component, e.g. a base class or a missing component
     template <class T>
     T* GetComponent();
 
@@ -96,10 +101,10 @@ public:
 
     void Rotate(float angle, glm::vec3 axis, RotationCoordinate coord)
     {
-        updateLocalMatrix = true;
         if (coord == RotationCoordinate::Self)
         {
-            rotation = glm::rotate(rotation, angle, axis);
+            auto& local = GetLocalTransform();
+            local.rotation = glm::rotate(local.rotation, angle, axis);
         }
         else if (coord == RotationCoordinate::Parent && parent != nullptr)
         {}
@@ -126,8 +131,7 @@ public:
         if (translate == glm::vec3{0, 0, 0})
             return;
 
-        updateLocalMatrix = true;
-        this->position += translate;
+        GetLocalTransform().position += translate;
 
         for (GameObject* child : children)
         {
@@ -144,12 +148,17 @@ public:
 
     glm::vec3 GetLocalPosition() const
     {
-        return position;
+        return GetLocalTransform().position;
+    }
+
+    glm::quat GetLocalRotation() const
+    {
+        return GetLocalTransform().rotation;
     }
 
     glm::vec3 GetScale() const
     {
-        return scale;
+        return GetLocalTransform().scale;
     }
 
     glm::vec3 GetForward() const
@@ -182,6 +191,8 @@ public:
         SetLocalRotation(rotation);
     }
 
+    // cached by the scene's TransformSystem until this object or one of its ancestors changes. Refreshing the cache
+    // writes to the TransformSystem, call these from the main thread or a thread safe tick (see Component)
     glm::mat4 GetWorldMatrix() const;
 
     glm::quat GetRotation() const;
@@ -213,23 +224,23 @@ public:
     void OnLoadingFinished() override;
 
 private:
-    glm::vec3 position = glm::vec3(0);
-    glm::vec3 scale = glm::vec3(1, 1, 1);
-    glm::quat rotation = glm::quat(1, 0, 0, 0);
+    // transforms live in the scene's TransformSystem, objects that aren't in a scene keep theirs here
+    LocalTransform detachedTransform;
+    TransformSystem* transformSystem = nullptr;
+    uint32_t transformSlot = 0;
     // euler angle is defined as X * Y * Z (pitch yaw row), which coresponds to glm::quat(eulerAngles)
     glm::vec3 eulerAngles = glm::vec3(0, 0, 0);
-    mutable glm::mat4 localMatrix;
 
     // when GameObject is being copied or deattached from a scene, it can't be enabled immediately
     // wantsToBeEnabled will be set to true whth enabled is false in that case
     bool enabled = false;
     bool wantsToBeEnabled = false;
 
-    mutable bool updateLocalMatrix = true;
-
     std::vector<GameObject*> children;
     std::vector<std::unique_ptr<GameObject>> owningChildren;
     std::vector<std::unique_ptr<Component>> components;
+    // concrete type of every component, rebuilt whenever components changes so lookups never write
+    std::vector<std::pair<std::type_index, Component*>> componentIndex;
     GameObject* parent = nullptr;
     Scene* gameScene = nullptr;
 
@@ -238,8 +249,25 @@ private:
         return glm::abs(v.x) < compareEpsilon && glm::abs(v.y) < compareEpsilon && glm::abs(v.z) < compareEpsilon;
     }
 
+    LocalTransform& GetLocalTransform()
+    {
+        return transformSystem ? transformSystem->GetLocal(transformSlot) : detachedTransform;
+    }
+
+    const LocalTransform& GetLocalTransform() const
+    {
+        return transformSystem ? transformSystem->GetLocal(transformSlot) : detachedTransform;
+    }
+
+    void RebuildComponentIndex();
+
+    // moves the transform into system, or out of the scene when system is nullptr
+    void AttachTransform(TransformSystem* system);
+
     void TransformChanged()
     {
+        if (transformSystem)
+            transformSystem->MarkDirty(transformSlot);
         if (!EngineState::GetSingleton().isPlaying)
         {
             for (auto& c : components)
@@ -256,6 +284,7 @@ T* GameObject::AddComponent(Args&&... args)
     auto p = std::make_unique<T>(this, args...);
     T* temp = p.get();
     components.push_back(std::move(p));
+    componentIndex.emplace_back(typeid(T), temp);
     temp->Enable();
     return temp;
 }
@@ -263,6 +292,12 @@ T* GameObject::AddComponent(Args&&... args)
 template <class T>
 T* GameObject::GetComponent()
 {
+    for (auto& [type, c] : componentIndex)
+    {
+        if (type == typeid(T))
+            return static_cast<T*>(c);
+    }
+
     for (auto& p : components)
     {
         T* cast = dynamic_cast<T*>(p.get());
@@ -1,6 +1,7 @@
 #include "Mesh.hpp"
 #include "GfxDriver/GfxDriver.hpp"
 #include "Libs/GLB.hpp"
+#include "ThirdParty/xxHash/xxhash.h"
 #include <filesystem>
 
 DEFINE_ASSET(Mesh, "8D66F112-935C-47B1-B62F-728CBEA20CBD", "mesh");
@@ -69,23 +70,27 @@ Submesh::Submesh(
 void Submesh::SetIndices(std::vector<uint32_t>&& indices)
 {
     this->indices = std::move(indices);
-    indexCount = indices.size();
+    indexCount = this->indices.size();
+    GeometryChanged();
 }
 
 void Submesh::SetIndices(const std::vector<uint32_t>& indices)
 {
     this->indices = indices;
     indexCount = indices.size();
+    GeometryChanged();
 }
 
 void Submesh::SetPositions(std::vector<glm::vec3>&& positions)
 {
     this->positions = std::move(positions);
+    GeometryChanged();
 }
 
 void Submesh::SetPositions(const std::vector<glm::vec3>& positions)
 {
     this->positions = positions;
+    GeometryChanged();
 }
 
 void Submesh::SetVertexAttribute(VertexAttribute&& vertAttributes)
@@ -189,6 +194,78 @@ void Submesh::SetAABB(const AABB& aabb)
     this->aabb = aabb;
 }
 
+bool Submesh::GetTriangle(size_t triangle, glm::vec3& p0, glm::vec3& p1, glm::vec3& p2) const
+{
+    size_t first = triangle * 3;
+    if (indexCount < 0 || first + 2 >= (size_t)indexCount)
+        return false;
+
+    uint32_t i[3];
+    const glm::vec3* vertices;
+    size_t vertexCount;
+    if (!indices.empty())
+    {
+        i[0] = indices[first];
+        i[1] = indices[first + 1];
+        i[2] = indices[first + 2];
+        vertices = positions.data();
+        vertexCount = positions.size();
+    }
+    else if (indexBuffer != nullptr && vertexBuffer != nullptr && !bindings.empty())
+    {
+        // v0.1 meshes only keep the raw buffers, positions are the first binding
+        for (int k = 0; k < 3; ++k)
+        {
+            i[k] = indexBufferType == Gfx::IndexBufferType::UInt16 ? ((const uint16_t*)indexBuffer.get())[first + k]
+                                                                    : ((const uint32_t*)indexBuffer.get())[first + k];
+        }
+        vertices = (const glm::vec3*)(vertexBuffer.get() + bindings[0].byteOffset);
+        vertexCount = bindings[0].byteSize / sizeof(glm::vec3);
+    }
+    else
+        return false;
+
+    if (i[0] >= vertexCount || i[1] >= vertexCount || i[2] >= vertexCount)
+        return false;
+
+    p0 = vertices[i[0]];
+    p1 = vertices[i[1]];
+    p2 = vertices[i[2]];
+    return true;
+}
+
+std::vector<glm::vec3> Submesh::GetTriangleVertices() const
+{
+    std::vector<glm::vec3> vertices;
+    size_t triangleCount = indexCount / 3;
+    vertices.reserve(triangleCount * 3);
+    glm::vec3 p0, p1, p2;
+    for (size_t triangle = 0; triangle < triangleCount; ++triangle)
+    {
+        // a broken triangle still takes its slot, triangle indices of the BVH have to match GetTriangle
+        if (!GetTriangle(triangle, p0, p1, p2))
+            p0 = p1 = p2 = glm::vec3(0);
+
+        vertices.push_back(p0);
+        vertices.push_back(p1);
+        vertices.push_back(p2);
+    }
+    return vertices;
+}
+
+const TriangleBVH& Submesh::GetBVH() const
+{
+    std::call_once(*bvhOnce, [this]() { bvh = std::make_unique<TriangleBVH>(GetTriangleVertices()); });
+    return *bvh;
+}
+
+void Submesh::GeometryChanged()
+{
+    geometryVersion += 1;
+    bvh = nullptr;
+    bvhOnce = std::make_unique<std::once_flag>();
+}
+
 const std::vector<uint32_t>& Submesh::GetIndices() const
 {
     return indices;
@@ -214,6 +291,7 @@ bool Mesh::LoadFromFile(const char* path)
     if (!meshes.empty())
     {
         submeshes = std::move(meshes[0]->submeshes);
+        geometryHash = 0;
         SetName(meshes[0]->GetName());
     }
     else
@@ -228,3 +306,33 @@ const AABB& Mesh::GetAABB() const
 }
 
 Mesh::~Mesh() {}
+
+uint64_t Mesh::GetGeometryHash()
+{
+    // submeshes can be edited through GetSubmesh, their versions only grow so any edit changes the sum
+    uint64_t version = 0;
+    for (auto& submesh : submeshes)
+        version += submesh.GetGeometryVersion();
+    if (geometryHash != 0 && version == hashedGeometryVersion)
+        return geometryHash;
+    hashedGeometryVersion = version;
+
+    XXH3_state_t* state = XXH3_createState();
+    XXH3_64bits_reset(state);
+    for (auto& submesh : submeshes)
+    {
+        auto& positions = submesh.GetPositions();
+        auto& indices = submesh.GetIndices();
+        uint64_t sizes[2] = {positions.size(), indices.size()};
+        XXH3_64bits_update(state, sizes, sizeof(sizes));
+        XXH3_64bits_update(state, positions.data(), positions.size() * sizeof(glm::vec3));
+        XXH3_64bits_update(state, indices.data(), indices.size() * sizeof(uint32_t));
+    }
+    geometryHash = XXH3_64bits_digest(state);
+    XXH3_freeState(state);
+
+    // 0 means not computed
+    if (geometryHash == 0)
+        geometryHash = 1;
+    return geometryHash;
+}
@@ -1,11 +1,14 @@
 #pragma once
 #include "Core/Asset.hpp"
+#include "Core/Math/BVH.hpp"
 #include "GfxDriver/Buffer.hpp"
 #include "GfxDriver/VertexBufferBinding.hpp"
 #include "Libs/Ptr.hpp"
 #include "Rendering/Structs.hpp"
 #include <glm/glm.hpp>
 #include <iterator>
+#include <memory>
+#include <mutex>
 #include <string_view>
 #include <vector>
 
@@ -107,6 +110,20 @@ public:
         return gfxBindings;
     }
 
+    // local positions of a triangle, reads the v0.2 arrays or the v0.1 buffers with either index width. False if the
+    // triangle is out of range
+    bool GetTriangle(size_t triangle, glm::vec3& p0, glm::vec3& p1, glm::vec3& p2) const;
+    // three positions per triangle
+    std::vector<glm::vec3> GetTriangleVertices() const;
+    // built on first use and kept until the indices or positions change, in local space
+    const TriangleBVH& GetBVH() const;
+
+    // changes every time the indices or positions are set
+    uint64_t GetGeometryVersion() const
+    {
+        return geometryVersion;
+    }
+
 private:
     std::unique_ptr<Gfx::Buffer> gfxVertexBuffer = nullptr;
     std::unique_ptr<Gfx::Buffer> gfxIndexBuffer = nullptr;
@@ -116,6 +133,13 @@ private:
     AABB aabb;
     int indexCount = 0;
     std::string name;
+    mutable std::unique_ptr<TriangleBVH> bvh = nullptr;
+    // behind a pointer so that Submesh stays movable
+    mutable std::unique_ptr<std::once_flag> bvhOnce = std::make_unique<std::once_flag>();
+    uint64_t geometryVersion = 0;
+
+    // drops the BVH and bumps the geometry version
+    void GeometryChanged();
 
     // v0.2 API
 public:
@@ -206,9 +230,13 @@ public:
         return nullptr;
     };
 
+    // xxHash3 of the positions and indices of every submesh, meshes with the same geometry have the same hash
+    uint64_t GetGeometryHash();
+
     void SetSubmeshes(std::vector<Submesh>&& submeshes)
     {
         this->submeshes = std::move(submeshes);
+        geometryHash = 0;
 
         glm::vec3 min =
             {std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max()};
@@ -232,4 +260,8 @@ public:
 private:
     std::vector<Submesh> submeshes;
     AABB aabb;
+    // 0 until GetGeometryHash computes it
+    uint64_t geometryHash = 0;
+    // sum of the submeshes' geometry versions when geometryHash was computed
+    uint64_t hashedGeometryVersion = 0;
 };
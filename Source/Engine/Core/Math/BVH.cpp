@@ -0,0 +1,378 @@
+#include "BVH.hpp"
+#include <algorithm>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define BVH_SSE2
+#endif
+
+namespace
+{
+const float NoHit = std::numeric_limits<float>::max();
+const glm::vec3 Infinity = glm::vec3(std::numeric_limits<float>::infinity());
+// deeper subtrees become one leaf, so traversal fits in a fixed stack
+const uint32_t MaxDepth = 48;
+
+float HalfArea(const glm::vec3& min, const glm::vec3& max)
+{
+    glm::vec3 d = max - min;
+    return d.x * d.y + d.y * d.z + d.z * d.x;
+}
+
+// distance at which the ray enters the box, NoHit if it misses or enters beyond maxDistance. invDir is +inf on the
+// axes the ray is parallel to
+template <bool AxisParallel>
+float RayBoxEntry(
+    const glm::vec3& origin, const glm::vec3& invDir, const glm::vec3& min, const glm::vec3& max, float maxDistance
+)
+{
+    glm::vec3 t0 = (min - origin) * invDir;
+    glm::vec3 t1 = (max - origin) * invDir;
+    if constexpr (AxisParallel)
+    {
+        // 0 * inf is NaN when the ray starts on one of the box's planes, it's inside that slab for its whole length
+        t0 = glm::mix(t0, -Infinity, glm::isnan(t0));
+        t1 = glm::mix(t1, Infinity, glm::isnan(t1));
+    }
+    glm::vec3 tMin = glm::min(t0, t1);
+    glm::vec3 tMax = glm::max(t0, t1);
+    float enter = glm::max(glm::max(tMin.x, tMin.y), glm::max(tMin.z, 0.0f));
+    float exit = glm::min(glm::min(tMax.x, tMax.y), tMax.z);
+    return exit >= enter && enter < maxDistance ? enter : NoHit;
+}
+} // namespace
+
+TriangleBVH::TriangleBVH(std::span<const glm::vec3> triangleVertices)
+{
+    triangleCount = triangleVertices.size() / 3;
+    if (triangleCount == 0)
+        return;
+
+    std::vector<BuildTriangle> triangles(triangleCount);
+    for (uint32_t i = 0; i < triangleCount; ++i)
+    {
+        const glm::vec3& v0 = triangleVertices[i * 3];
+        const glm::vec3& v1 = triangleVertices[i * 3 + 1];
+        const glm::vec3& v2 = triangleVertices[i * 3 + 2];
+        BuildTriangle& t = triangles[i];
+        t.min = glm::min(v0, glm::min(v1, v2));
+        t.max = glm::max(v0, glm::max(v1, v2));
+        t.centroid = (t.min + t.max) * 0.5f;
+        t.index = i;
+    }
+
+    nodes.reserve(triangleCount / 2 + 1);
+    packets.reserve(triangleCount / 3 + 1);
+    nodes.emplace_back();
+    Build(0, 0, triangles, triangleVertices);
+}
+
+void TriangleBVH::Build(
+    uint32_t nodeIndex,
+    uint32_t depth,
+    std::span<BuildTriangle> triangles,
+    std::span<const glm::vec3> triangleVertices
+)
+{
+    glm::vec3 min(NoHit), max(-NoHit), centroidMin(NoHit), centroidMax(-NoHit);
+    for (const BuildTriangle& t : triangles)
+    {
+        min = glm::min(min, t.min);
+        max = glm::max(max, t.max);
+        centroidMin = glm::min(centroidMin, t.centroid);
+        centroidMax = glm::max(centroidMax, t.centroid);
+    }
+    nodes[nodeIndex].min = min;
+    nodes[nodeIndex].max = max;
+
+    // a single packet is tested as fast as one triangle
+    if (triangles.size() <= 4 || depth >= MaxDepth)
+    {
+        MakeLeaf(nodeIndex, triangles, triangleVertices);
+        return;
+    }
+
+    // binned SAH: cost of a split is the area of each side times its triangle count
+    struct Bin
+    {
+        glm::vec3 min = glm::vec3(NoHit);
+        glm::vec3 max = glm::vec3(-NoHit);
+        uint32_t count = 0;
+    };
+
+    float bestCost = NoHit;
+    int bestAxis = -1;
+    uint32_t bestBin = 0;
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        float extent = centroidMax[axis] - centroidMin[axis];
+        if (extent <= 0)
+            continue;
+
+        Bin bins[BinCount];
+        float scale = BinCount / extent;
+        for (const BuildTriangle& t : triangles)
+        {
+            uint32_t b = std::min(uint32_t((t.centroid[axis] - centroidMin[axis]) * scale), BinCount - 1);
+            bins[b].min = glm::min(bins[b].min, t.min);
+            bins[b].max = glm::max(bins[b].max, t.max);
+            bins[b].count += 1;
+        }
+
+        // cost of everything right of each split, then sweep from the left
+        float rightCost[BinCount];
+        Bin right;
+        for (uint32_t b = BinCount - 1; b > 0; --b)
+        {
+            right.min = glm::min(right.min, bins[b].min);
+            right.max = glm::max(right.max, bins[b].max);
+            right.count += bins[b].count;
+            rightCost[b] = right.count ? HalfArea(right.min, right.max) * right.count : 0;
+        }
+
+        Bin left;
+        for (uint32_t b = 0; b < BinCount - 1; ++b)
+        {
+            left.min = glm::min(left.min, bins[b].min);
+            left.max = glm::max(left.max, bins[b].max);
+            left.count += bins[b].count;
+            if (left.count == 0 || left.count == triangles.size())
+                continue;
+
+            float cost = HalfArea(left.min, left.max) * left.count + rightCost[b + 1];
+            if (cost < bestCost)
+            {
+                bestCost = cost;
+                bestAxis = axis;
+                bestBin = b;
+            }
+        }
+    }
+
+    size_t mid = triangles.size() / 2;
+    if (bestAxis != -1)
+    {
+        // splitting has to be cheaper than testing every triangle here, traversing a node costs about one triangle
+        float splitCost = 1.0f + bestCost / HalfArea(min, max);
+        if (splitCost >= triangles.size() && triangles.size() <= MaxLeafTriangles)
+        {
+            MakeLeaf(nodeIndex, triangles, triangleVertices);
+            return;
+        }
+
+        float axisMin = centroidMin[bestAxis];
+        float scale = BinCount / (centroidMax[bestAxis] - axisMin);
+        auto iter = std::partition(
+            triangles.begin(),
+            triangles.end(),
+            [=](const BuildTriangle& t)
+            { return std::min(uint32_t((t.centroid[bestAxis] - axisMin) * scale), BinCount - 1) <= bestBin; }
+        );
+        mid = iter - triangles.begin();
+    }
+    // else every centroid is at the same point, any split is as good as another
+
+    uint32_t leftIndex = nodes.size();
+    nodes.emplace_back();
+    Build(leftIndex, depth + 1, triangles.subspan(0, mid), triangleVertices);
+
+    uint32_t rightIndex = nodes.size();
+    nodes.emplace_back();
+    nodes[nodeIndex].index = rightIndex;
+    nodes[nodeIndex].packetCount = 0;
+    Build(rightIndex, depth + 1, triangles.subspan(mid), triangleVertices);
+}
+
+void TriangleBVH::MakeLeaf(
+    uint32_t nodeIndex, std::span<BuildTriangle> triangles, std::span<const glm::vec3> triangleVertices
+)
+{
+    nodes[nodeIndex].index = packets.size();
+    nodes[nodeIndex].packetCount = (triangles.size() + 3) / 4;
+
+    for (size_t first = 0; first < triangles.size(); first += 4)
+    {
+        TrianglePacket& packet = packets.emplace_back();
+        packet = {};
+        for (size_t lane = 0; lane < 4; ++lane)
+        {
+            if (first + lane >= triangles.size())
+            {
+                packet.triangles[lane] = UINT32_MAX;
+                continue;
+            }
+
+            uint32_t index = triangles[first + lane].index;
+            glm::vec3 v0 = triangleVertices[index * 3];
+            glm::vec3 e1 = triangleVertices[index * 3 + 1] - v0;
+            glm::vec3 e2 = triangleVertices[index * 3 + 2] - v0;
+            for (int c = 0; c < 3; ++c)
+            {
+                packet.v0[c][lane] = v0[c];
+                packet.e1[c][lane] = e1[c];
+                packet.e2[c][lane] = e2[c];
+            }
+            packet.triangles[lane] = index;
+        }
+    }
+}
+
+bool TriangleBVH::Intersect(const glm::vec3& origin, const glm::vec3& dir, float& distance, uint32_t& triangle) const
+{
+    if (triangleCount == 0)
+        return false;
+
+    // adding 0 turns -0 into +0, so invDir is +inf on every axis the ray is parallel to
+    glm::vec3 invDir = 1.0f / (dir + 0.0f);
+    // only axis parallel rays can produce NaN in the box test, the others skip the check
+    if (dir.x == 0 || dir.y == 0 || dir.z == 0)
+        return Intersect<true>(origin, dir, invDir, distance, triangle);
+    return Intersect<false>(origin, dir, invDir, distance, triangle);
+}
+
+template <bool AxisParallel>
+bool TriangleBVH::Intersect(
+    const glm::vec3& origin, const glm::vec3& dir, const glm::vec3& invDir, float& distance, uint32_t& triangle
+) const
+{
+    float best = NoHit;
+    if (RayBoxEntry<AxisParallel>(origin, invDir, nodes[0].min, nodes[0].max, best) == NoHit)
+        return false;
+
+    // nodes to visit and the distance their box was entered at, skipped if a closer hit was found since
+    struct Entry
+    {
+        uint32_t node;
+        float distance;
+    } stack[MaxDepth + 1];
+    int stackSize = 0;
+    uint32_t current = 0;
+    bool hit = false;
+    while (true)
+    {
+        const Node& node = nodes[current];
+        if (node.packetCount == 0)
+        {
+            // nearer child first, windows.h defines near and far
+            uint32_t first = current + 1;
+            uint32_t second = node.index;
+            float firstDistance = RayBoxEntry<AxisParallel>(origin, invDir, nodes[first].min, nodes[first].max, best);
+            float secondDistance =
+                RayBoxEntry<AxisParallel>(origin, invDir, nodes[second].min, nodes[second].max, best);
+            if (secondDistance < firstDistance)
+            {
+                std::swap(first, second);
+                std::swap(firstDistance, secondDistance);
+            }
+
+            if (firstDistance != NoHit)
+            {
+                if (secondDistance != NoHit)
+                    stack[stackSize++] = {second, secondDistance};
+                current = first;
+                continue;
+            }
+        }
+        else
+        {
+            for (uint32_t p = node.index; p < node.index + node.packetCount; ++p)
+            {
+                hit |= IntersectPacket(packets[p], origin, dir, best, triangle);
+            }
+        }
+
+        // subtrees whose box starts behind the closest hit so far can't contain a closer one
+        while (stackSize > 0 && stack[stackSize - 1].distance >= best)
+            stackSize -= 1;
+        if (stackSize == 0)
+            break;
+        current = stack[--stackSize].node;
+    }
+
+    if (hit)
+        distance = best;
+    return hit;
+}
+
+// Moller-Trumbore on the four triangles of a packet, two sided
+bool TriangleBVH::IntersectPacket(
+    const TrianglePacket& packet, const glm::vec3& origin, const glm::vec3& dir, float& distance, uint32_t& triangle
+) const
+{
+    // rejects parallel rays and the empty lanes of a packet
+    const float minDet = 1e-30f;
+    float t[4];
+    int hits = 0;
+
+#if defined(BVH_SSE2)
+    __m128 dx = _mm_set1_ps(dir.x), dy = _mm_set1_ps(dir.y), dz = _mm_set1_ps(dir.z);
+    __m128 e1x = _mm_loadu_ps(packet.e1[0]), e1y = _mm_loadu_ps(packet.e1[1]), e1z = _mm_loadu_ps(packet.e1[2]);
+    __m128 e2x = _mm_loadu_ps(packet.e2[0]), e2y = _mm_loadu_ps(packet.e2[1]), e2z = _mm_loadu_ps(packet.e2[2]);
+
+    // p = dir x e2
+    __m128 px = _mm_sub_ps(_mm_mul_ps(dy, e2z), _mm_mul_ps(dz, e2y));
+    __m128 py = _mm_sub_ps(_mm_mul_ps(dz, e2x), _mm_mul_ps(dx, e2z));
+    __m128 pz = _mm_sub_ps(_mm_mul_ps(dx, e2y), _mm_mul_ps(dy, e2x));
+    __m128 det = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x, px), _mm_mul_ps(e1y, py)), _mm_mul_ps(e1z, pz));
+    __m128 invDet = _mm_div_ps(_mm_set1_ps(1.0f), det);
+
+    // s = origin - v0
+    __m128 sx = _mm_sub_ps(_mm_set1_ps(origin.x), _mm_loadu_ps(packet.v0[0]));
+    __m128 sy = _mm_sub_ps(_mm_set1_ps(origin.y), _mm_loadu_ps(packet.v0[1]));
+    __m128 sz = _mm_sub_ps(_mm_set1_ps(origin.z), _mm_loadu_ps(packet.v0[2]));
+    __m128 u = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(sx, px), _mm_mul_ps(sy, py)), _mm_mul_ps(sz, pz)), invDet);
+
+    // q = s x e1
+    __m128 qx = _mm_sub_ps(_mm_mul_ps(sy, e1z), _mm_mul_ps(sz, e1y));
+    __m128 qy = _mm_sub_ps(_mm_mul_ps(sz, e1x), _mm_mul_ps(sx, e1z));
+    __m128 qz = _mm_sub_ps(_mm_mul_ps(sx, e1y), _mm_mul_ps(sy, e1x));
+    __m128 v = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, qx), _mm_mul_ps(dy, qy)), _mm_mul_ps(dz, qz)), invDet);
+    __m128 tt =
+        _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(e2x, qx), _mm_mul_ps(e2y, qy)), _mm_mul_ps(e2z, qz)), invDet);
+
+    __m128 zero = _mm_setzero_ps();
+    __m128 absDet = _mm_andnot_ps(_mm_set1_ps(-0.0f), det);
+    __m128 mask = _mm_cmpgt_ps(absDet, _mm_set1_ps(minDet));
+    mask = _mm_and_ps(mask, _mm_cmpge_ps(u, zero));
+    mask = _mm_and_ps(mask, _mm_cmpge_ps(v, zero));
+    mask = _mm_and_ps(mask, _mm_cmple_ps(_mm_add_ps(u, v), _mm_set1_ps(1.0f)));
+    mask = _mm_and_ps(mask, _mm_cmpgt_ps(tt, zero));
+    mask = _mm_and_ps(mask, _mm_cmplt_ps(tt, _mm_set1_ps(distance)));
+    hits = _mm_movemask_ps(mask);
+    if (hits == 0)
+        return false;
+    _mm_storeu_ps(t, tt);
+#else
+    for (int lane = 0; lane < 4; ++lane)
+    {
+        glm::vec3 e1(packet.e1[0][lane], packet.e1[1][lane], packet.e1[2][lane]);
+        glm::vec3 e2(packet.e2[0][lane], packet.e2[1][lane], packet.e2[2][lane]);
+        glm::vec3 p = glm::cross(dir, e2);
+        float det = glm::dot(e1, p);
+        if (glm::abs(det) <= minDet)
+            continue;
+
+        float invDet = 1.0f / det;
+        glm::vec3 s = origin - glm::vec3(packet.v0[0][lane], packet.v0[1][lane], packet.v0[2][lane]);
+        float u = glm::dot(s, p) * invDet;
+        glm::vec3 q = glm::cross(s, e1);
+        float v = glm::dot(dir, q) * invDet;
+        t[lane] = glm::dot(e2, q) * invDet;
+        if (u >= 0 && v >= 0 && u + v <= 1 && t[lane] > 0 && t[lane] < distance)
+            hits |= 1 << lane;
+    }
+    if (hits == 0)
+        return false;
+#endif
+
+    for (int lane = 0; lane < 4; ++lane)
+    {
+        if ((hits & (1 << lane)) && t[lane] < distance)
+        {
+            distance = t[lane];
+            triangle = packet.triangles[lane];
+        }
+    }
+    return true;
+}
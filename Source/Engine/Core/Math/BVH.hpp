@@ -0,0 +1,74 @@
+#pragma once
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <span>
+#include <vector>
+
+// bounding volume hierarchy over the triangles of a mesh. Built top down with the binned surface area heuristic and
+// stored as a flat node array in depth first order, the left child of an inner node directly follows it. Leaf
+// triangles are kept in packets of four in SoA layout, the ray test checks a whole packet with SIMD
+class TriangleBVH
+{
+public:
+    // three positions per triangle
+    TriangleBVH(std::span<const glm::vec3> triangleVertices);
+
+    // closest hit along the ray. distance is in units of dir's length, triangle is the index of the hit triangle in
+    // the vertices the BVH was built from
+    bool Intersect(const glm::vec3& origin, const glm::vec3& dir, float& distance, uint32_t& triangle) const;
+
+    size_t GetTriangleCount() const
+    {
+        return triangleCount;
+    }
+
+private:
+    static const uint32_t MaxLeafTriangles = 8;
+    static const uint32_t BinCount = 12;
+
+    struct Node
+    {
+        glm::vec3 min;
+        // inner nodes: index of the right child, leaves: first packet
+        uint32_t index;
+        glm::vec3 max;
+        // 0 for inner nodes
+        uint32_t packetCount;
+    };
+
+    // v0 and the two edges of four triangles, unused lanes have zero edges and never hit
+    struct TrianglePacket
+    {
+        float v0[3][4];
+        float e1[3][4];
+        float e2[3][4];
+        uint32_t triangles[4];
+    };
+
+    struct BuildTriangle
+    {
+        glm::vec3 min;
+        glm::vec3 max;
+        glm::vec3 centroid;
+        uint32_t index;
+    };
+
+    std::vector<Node> nodes;
+    std::vector<TrianglePacket> packets;
+    size_t triangleCount = 0;
+
+    void Build(
+        uint32_t nodeIndex,
+        uint32_t depth,
+        std::span<BuildTriangle> triangles,
+        std::span<const glm::vec3> triangleVertices
+    );
+    void MakeLeaf(uint32_t nodeIndex, std::span<BuildTriangle> triangles, std::span<const glm::vec3> triangleVertices);
+    template <bool AxisParallel>
+    bool Intersect(
+        const glm::vec3& origin, const glm::vec3& dir, const glm::vec3& invDir, float& distance, uint32_t& triangle
+    ) const;
+    bool IntersectPacket(
+        const TrianglePacket& packet, const glm::vec3& origin, const glm::vec3& dir, float& distance, uint32_t& triangle
+    ) const;
+};
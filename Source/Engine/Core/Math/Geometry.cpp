@@ -1,33 +1,24 @@
 #include "Geometry.hpp"
-#include <glm/gtx/intersect.hpp>
+
+namespace
+{
+// the BVH is in the submesh's local space, the ray is moved there once instead of moving every triangle. The direction
+// isn't normalized so the hit distance is the same in both spaces
+bool IntersectLocal(
+    const Ray& ray, const Submesh& mesh, const glm::mat4& transform, float& distance, uint32_t& triangle
+)
+{
+    glm::mat4 toLocal = glm::inverse(transform);
+    glm::vec3 origin = toLocal * glm::vec4(ray.origin, 1);
+    glm::vec3 direction = glm::mat3(toLocal) * ray.direction;
+    return mesh.GetBVH().Intersect(origin, direction, distance, triangle);
+}
+} // namespace
 
 bool RayMeshIntersection(Ray ray, RefPtr<Submesh> mesh, glm::mat4 transform, float& distance)
 {
-    glm::vec2 bary;
-    uint16_t* indices = (uint16_t*)mesh->GetIndexBufferData();
-    glm::vec3* positions = (glm::vec3*)mesh->GetVertexBufferData();
-    for (int i = 0; i < mesh->GetIndexCount(); i += 3)
-    {
-        uint32_t i0 = indices[i];
-        uint32_t i1 = indices[i + 1];
-        uint32_t i2 = indices[i + 2];
-        glm::vec4 p0 = transform * glm::vec4(positions[i0], 1);
-        glm::vec4 p1 = transform * glm::vec4(positions[i1], 1);
-        glm::vec4 p2 = transform * glm::vec4(positions[i2], 1);
-        if (glm::intersectRayTriangle(
-                ray.origin,
-                ray.direction,
-                glm::vec3(p0 / p0.w),
-                glm::vec3(p1 / p1.w),
-                glm::vec3(p2 / p2.w),
-                bary,
-                distance
-            ))
-        {
-            return true;
-        }
-    }
-    return false;
+    uint32_t triangle;
+    return IntersectLocal(ray, *mesh, transform, distance, triangle);
 }
 
 bool RayMeshIntersection(
@@ -40,32 +31,9 @@ bool RayMeshIntersection(
     glm::vec3& outP2
 )
 {
-    glm::vec2 bary;
-    uint16_t* indices = (uint16_t*)mesh->GetIndexBufferData();
-    glm::vec3* positions = (glm::vec3*)mesh->GetIndexBufferData();
-    for (int i = 0; i < mesh->GetIndexCount(); i += 3)
-    {
-        uint32_t i0 = indices[i];
-        uint32_t i1 = indices[i + 1];
-        uint32_t i2 = indices[i + 2];
-        glm::vec4 p0 = transform * glm::vec4(positions[i0], 1);
-        glm::vec4 p1 = transform * glm::vec4(positions[i1], 1);
-        glm::vec4 p2 = transform * glm::vec4(positions[i2], 1);
-        if (glm::intersectRayTriangle(
-                ray.origin,
-                ray.direction,
-                glm::vec3(p0 / p0.w),
-                glm::vec3(p1 / p1.w),
-                glm::vec3(p2 / p2.w),
-                bary,
-                distance
-            ))
-        {
-            outP0 = positions[i0];
-            outP1 = positions[i1];
-            outP2 = positions[i2];
-            return true;
-        }
-    }
-    return false;
+    uint32_t triangle;
+    if (!IntersectLocal(ray, *mesh, transform, distance, triangle))
+        return false;
+
+    return mesh->GetTriangle(triangle, outP0, outP1, outP2);
 }
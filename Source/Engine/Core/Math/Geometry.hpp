@@ -7,7 +7,10 @@ struct Ray
     glm::vec3 direction;
 };
 
+// closest hit, distance is in units of the ray's direction. Tested against the submesh's BVH, which the first call
+// builds
 bool RayMeshIntersection(Ray ray, RefPtr<Submesh> mesh, glm::mat4 transform, float& distance);
+// p0, p1 and p2 are the hit triangle in the submesh's local space
 bool RayMeshIntersection(
     Ray ray, RefPtr<Submesh> mesh, glm::mat4 transform, float& distance, glm::vec3& p0, glm::vec3& p1, glm::vec3& p2
 );
@@ -4,32 +4,78 @@
 #include "spdlog/spdlog.h"
 namespace Rendering
 {
-VirtualTexture::VirtualTexture(const std::filesystem::path& vtFolder, uint32_t width, uint32_t height, uint32_t channel)
-    : info(GenInfo(vtFolder, width, height, channel)), vtFolder(vtFolder)
-{}
-
-VirtualTexture::Info VirtualTexture::GenInfo(
-    const std::filesystem::path& vtFolder, uint32_t width, uint32_t height, uint32_t channel
-)
+VirtualTexture::VirtualTexture(const std::filesystem::path& pageFile) : file(pageFile, std::ios::binary)
 {
-    Info info;
+    if (!file.is_open())
+    {
+        SPDLOG_ERROR("VirtualTexture: failed to open {}", pageFile.string());
+        return;
+    }
+
+    file.read((char*)&header, sizeof(header));
+    if (!file.good() || header.magic != Libs::Image::VirtualTexturePageFileHeader::Magic ||
+        header.version != Libs::Image::VirtualTexturePageFileHeader::CurrentVersion)
+    {
+        SPDLOG_ERROR("VirtualTexture: {} is not a page file", pageFile.string());
+        return;
+    }
 
-    info.width = width;
-    info.height = height;
-    info.channel = channel;
-    info.channelByteSize = 1; // no hdr support, just use 1 byte per channel
-    info.pixelCount = width * height;
-    info.byteSize = width * height * channel * info.channelByteSize;
-    return info;
+    entries.resize(header.pageCount);
+    file.read((char*)entries.data(), entries.size() * sizeof(Libs::Image::VirtualTexturePageEntry));
+    valid = file.good();
 }
 
-Libs::Image::LinearImage VirtualTexture::Read(int x, int y, int mip, int desieredChannel)
+Libs::Image::LinearImage VirtualTexture::Read(uint32_t pageID, int desieredChannel)
 {
-    auto file = fmt::format("{}_{}_{}.jpg", mip, x, y);
-    auto path = vtFolder / file;
+    uint32_t extent = header.pageExtent;
+    Libs::Image::LinearImage page(extent, extent, desieredChannel, 1);
+    if (!valid || pageID >= entries.size())
+    {
+        SPDLOG_ERROR("VirtualTexture: page {} doesn't exist", pageID);
+        return page;
+    }
+
+    // only the read is serialized, pages decode in parallel
+    auto& entry = entries[pageID];
+    std::vector<uint8_t> encoded(entry.byteSize);
+    {
+        std::scoped_lock lock(fileMutex);
+        file.seekg(entry.offset);
+        file.read((char*)encoded.data(), encoded.size());
+        if (!file.good())
+        {
+            file.clear();
+            SPDLOG_ERROR("VirtualTexture: failed to read page {}", pageID);
+            return page;
+        }
+    }
+
+    if (header.compression == Libs::Image::VirtualTexturePageCompression::Jpeg)
+    {
+        int w, h, c;
+        unsigned char* data = stbi_load_from_memory(encoded.data(), encoded.size(), &w, &h, &c, desieredChannel);
+        if (data != nullptr && w == (int)extent && h == (int)extent)
+            memcpy(page.GetData(), data, page.GetSize());
+        else
+            SPDLOG_ERROR("VirtualTexture: failed to decode page {}", pageID);
+        stbi_image_free(data);
+    }
+    else if (desieredChannel == (int)header.channels && encoded.size() == page.GetSize())
+    {
+        memcpy(page.GetData(), encoded.data(), encoded.size());
+    }
+    else
+    {
+        // uncompressed pages keep the channel count they were converted with
+        unsigned char* dst = page.GetData();
+        int copied = std::min<int>(desieredChannel, header.channels);
+        for (uint32_t i = 0; i < page.GetPixelCount() && (i + 1) * header.channels <= encoded.size(); ++i)
+        {
+            for (int c = 0; c < desieredChannel; ++c)
+                dst[i * desieredChannel + c] = c < copied ? encoded[i * header.channels + c] : 255;
+        }
+    }
 
-    int w, h, c;
-    unsigned char* data = stbi_load(path.string().c_str(), &w, &h, &c, desieredChannel);
-    return Libs::Image::LinearImage(w, h, 3, 1, data);
+    return page;
 }
 } // namespace Rendering
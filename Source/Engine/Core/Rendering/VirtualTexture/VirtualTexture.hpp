@@ -1,57 +1,89 @@
 #pragma once
 #include "GfxDriver/Image.hpp"
 #include "Libs/Image/LinearImage.hpp"
+#include "Libs/Image/VirtualTextureConverter.hpp"
 #include "Libs/Ptr.hpp"
 #include "Rendering/Structs.hpp"
 #include <cinttypes>
 #include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <vector>
 
 namespace Rendering
 {
 /**
- * capacity
+ * a page file written by Libs::Image::VirtualTextureConverter, pages are read on demand
  */
 class VirtualTexture
 {
 public:
-    VirtualTexture(const std::filesystem::path& vtFolder, uint32_t width, uint32_t height, uint32_t channel);
+    VirtualTexture(const std::filesystem::path& pageFile);
 
+    bool IsValid() const
+    {
+        return valid;
+    }
     uint32_t GetWidth() const
     {
-        return info.width;
+        return header.width;
     }
     uint32_t GetHeight() const
     {
-        return info.height;
+        return header.height;
     }
     uint32_t GetPixelCount() const
     {
-        return info.pixelCount;
+        return header.width * header.height;
     }
     uint32_t GetByteSize() const
     {
-        return info.byteSize;
+        return header.width * header.height * header.channels;
     }
     uint32_t GetChannel() const
     {
-        return info.channel;
+        return header.channels;
     }
-    Libs::Image::LinearImage Read(int x, int y, int mip, int desieredChannel);
-
-private:
-    const struct Info
+    uint32_t GetPageExtent() const
+    {
+        return header.pageExtent;
+    }
+    // pages of mip 0
+    uint32_t GetPageCountX() const
+    {
+        return header.pageCountX;
+    }
+    uint32_t GetPageCountY() const
+    {
+        return header.pageCountY;
+    }
+    uint32_t GetMipCount() const
+    {
+        return header.mipCount;
+    }
+    uint32_t GetPageCount() const
+    {
+        return header.pageCount;
+    }
+    // same as the node id of a MipQuadTree sized to the mip 0 pages
+    uint32_t GetPageID(int x, int y, int mip) const
     {
-        uint32_t width;
-        uint32_t height;
+        return Libs::Image::GetVirtualTexturePageID(header, x, y, mip);
+    }
 
-        uint32_t channel;
-        uint32_t channelByteSize;
-        uint32_t byteSize;
-        uint32_t pixelCount;
-    } info;
+    // reads and decodes one page, can be called from any thread
+    Libs::Image::LinearImage Read(uint32_t pageID, int desiredChannel);
+    Libs::Image::LinearImage Read(int x, int y, int mip, int desiredChannel)
+    {
+        return Read(GetPageID(x, y, mip), desiredChannel);
+    }
 
-    std::filesystem::path vtFolder;
+private:
+    Libs::Image::VirtualTexturePageFileHeader header;
+    std::vector<Libs::Image::VirtualTexturePageEntry> entries;
+    bool valid = false;
 
-    Info GenInfo(const std::filesystem::path& vtFolder, uint32_t width, uint32_t height, uint32_t channel);
+    std::mutex fileMutex;
+    std::ifstream file;
 };
 } // namespace Rendering
@@ -0,0 +1,66 @@
+#include "VirtualTexturePageLoader.hpp"
+#include "VirtualTexture.hpp"
+
+namespace Rendering
+{
+VirtualTexturePageLoader::VirtualTexturePageLoader(VirtualTexture& vt, int channels)
+    : vt(vt), channels(channels), thread(&VirtualTexturePageLoader::Run, this)
+{}
+
+VirtualTexturePageLoader::~VirtualTexturePageLoader()
+{
+    {
+        std::scoped_lock lock(mutex);
+        stop = true;
+    }
+    wake.notify_one();
+    thread.join();
+}
+
+void VirtualTexturePageLoader::Request(uint32_t pageID)
+{
+    {
+        std::scoped_lock lock(mutex);
+        if (!pending.insert(pageID).second)
+            return;
+        queue.push_back(pageID);
+    }
+    wake.notify_one();
+}
+
+void VirtualTexturePageLoader::TakeLoadedPages(std::vector<LoadedPage>& pages)
+{
+    pages.clear();
+    std::scoped_lock lock(mutex);
+    std::swap(pages, loaded);
+}
+
+size_t VirtualTexturePageLoader::GetPendingCount()
+{
+    std::scoped_lock lock(mutex);
+    return pending.size();
+}
+
+void VirtualTexturePageLoader::Run()
+{
+    while (true)
+    {
+        uint32_t pageID;
+        {
+            std::unique_lock lock(mutex);
+            wake.wait(lock, [this] { return stop || !queue.empty(); });
+            if (stop)
+                return;
+
+            pageID = queue.front();
+            queue.pop_front();
+        }
+
+        auto image = vt.Read(pageID, channels);
+
+        std::scoped_lock lock(mutex);
+        loaded.push_back({pageID, std::move(image)});
+        pending.erase(pageID);
+    }
+}
+} // namespace Rendering
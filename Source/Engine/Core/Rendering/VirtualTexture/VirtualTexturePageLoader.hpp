@@ -0,0 +1,47 @@
+#pragma once
+#include "Libs/Image/LinearImage.hpp"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+namespace Rendering
+{
+class VirtualTexture;
+
+// reads and decodes requested pages on its own thread so that page faults never block a frame
+class VirtualTexturePageLoader
+{
+public:
+    struct LoadedPage
+    {
+        uint32_t pageID;
+        Libs::Image::LinearImage image;
+    };
+
+    VirtualTexturePageLoader(VirtualTexture& vt, int channels);
+    ~VirtualTexturePageLoader();
+
+    // pages that are already queued are ignored, coarse pages requested together with fine ones should come first
+    void Request(uint32_t pageID);
+    // pages that finished loading since the last call
+    void TakeLoadedPages(std::vector<LoadedPage>& pages);
+    size_t GetPendingCount();
+
+private:
+    VirtualTexture& vt;
+    int channels;
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<uint32_t> queue;
+    std::unordered_set<uint32_t> pending;
+    std::vector<LoadedPage> loaded;
+    bool stop = false;
+    std::thread thread;
+
+    void Run();
+};
+} // namespace Rendering
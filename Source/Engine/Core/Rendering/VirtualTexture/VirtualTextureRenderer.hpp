@@ -1,91 +1,123 @@
-// #pragma once
-// #include "Core/Rendering/RenderGraph/Nodes/BufferNode.hpp"
-// #include "Core/Rendering/RenderGraph/Nodes/MemoryTransferNode.hpp"
-// #include "Core/Rendering/RenderGraph/RenderGraph.hpp"
-// #include "GfxDriver/Buffer.hpp"
-// #include "GfxDriver/GfxDriver.hpp"
-// #include "Libs/Image/LinearImage.hpp"
-// #include "Rendering/GfxResourceTransfer.hpp"
-// #include "VirtualTexture.hpp"
-//
-// #if defined(_WIN32) || defined(_WIN64)
-// #undef CreateSemaphore
-// #endif
-//
-// namespace Rendering
-//{
-//
-///**
-// * Feedback tex generation:
-// * vt renderer uses the same drawlist as the
-// *
-// * capacity:
-// * page size: 128x128
-// * number of virtual texture: 1
-// * multithreaded: no
-// * maximum virtual texture size: 32k
-// */
-// class VirtualTextureRenderer
-//{
-// public:
-//    VirtualTextureRenderer()
-//    {
-//        queue = GetGfxDriver()->GetQueue(QueueType::Main);
-//        Gfx::CommandPool::CreateInfo createInfo{.queueFamilyIndex = queue->GetFamilyIndex()};
-//        cmdPool = GetGfxDriver()->CreateCommandPool(createInfo);
-//        feedbackCmdBuf = std::move(cmdPool->AllocateCommandBuffers(Gfx::CommandBufferType::Primary, 1)[0]);
-//        feedbackTexPassFence = GetGfxDriver()->CreateFence({false});
-//        feedbackGenerationBeginSemaphore = GetGfxDriver()->CreateSemaphore({false});
-//    }
-//
-//    ~VirtualTextureRenderer();
-//
-//    RefPtr<Gfx::Semaphore> GetFeedbackGenerationBeginSemaphore() { return feedbackGenerationBeginSemaphore; };
-//    void BuildMainGraph(RGraph::RenderGraph& graph, RGraph::Port*& pageTex, RGraph::Port*& indirTex);
-//    void SetVT(RefPtr<VirtualTexture> vt, uint32_t frameTexWidth, uint32_t frameTexheight, uint32_t feedbackTexScale);
-//    void SetVTObjectDrawList(RGraph::DrawList& drawList) { g.feedbackPass->SetDrawList(drawList); }
-//
-//    void RunAnalysis();
-//
-//    // get final cache and indirMap
-//    // return true if they are updated
-//    bool GetFinalTextures(Libs::Image::LinearImage*& cache, Libs::Image::LinearImage*& indirMap);
-//
-// private:
-//    struct Param
-//    {
-//        VirtualTexture* vt;
-//        int pageTexelSize = 128;
-//        int pageTexPageNum = 32; // 4096 * 4096
-//    } param;
-//
-//    class FeedbackAnalyzer;
-//    UniPtr<FeedbackAnalyzer> feedbackAnalyzer;
-//    UniPtr<Libs::Image::LinearImage> feedbackTex;
-//
-//    UniPtr<Gfx::CommandPool> cmdPool;
-//    UniPtr<Gfx::CommandBuffer> feedbackCmdBuf;
-//    UniPtr<Gfx::CommandBuffer> readbackCmdBuf;
-//    UniPtr<Gfx::Semaphore> feedbackGenerationBeginSemaphore;
-//    RefPtr<CommandQueue> queue;
-//    UniPtr<Gfx::Fence> feedbackTexPassFence;
-//
-//    std::unique_ptr<std::thread> analysisThread;
-//
-//    struct
-//    {
-//        RGraph::RenderGraph feedbackTexGraph;
-//        // rgba format rgba8888: rg(vir tex page coord), b(mipmap level), a(virture texture id)
-//        RGraph::ImageNode* feedbackTex;
-//        RGraph::ImageNode* feedbackDepthTex;
-//        RGraph::RenderPassNode* feedbackPass;
-//        RGraph::BufferNode* readbackBuf;
-//    } g;
-//
-//    struct
-//    {
-//        RefPtr<Shader> shader;
-//        UniPtr<Gfx::ShaderResource> resource;
-//    } feedbackPassData;
-//};
-//} // namespace Rendering
+#pragma once
+#include "Libs/Image/LinearImage.hpp"
+#include "Libs/Image/MipQuadTree.hpp"
+#include "VirtualTexture.hpp"
+#include "VirtualTexturePageLoader.hpp"
+#include <chrono>
+#include <glm/glm.hpp>
+#include <list>
+#include <memory>
+
+namespace Rendering
+{
+struct VirtualTextureStats
+{
+    uint32_t physicalPages = 0;
+    uint32_t residentPages = 0;
+    uint32_t loadingPages = 0;
+
+    // counted once per page per frame
+    uint64_t requests = 0;
+    uint64_t hits = 0;
+    uint64_t faults = 0;
+    uint64_t evictions = 0;
+    // loaded pages that found no physical page to evict, they are requested again by the next feedback
+    uint64_t droppedPages = 0;
+
+    // from the first feedback that asked for a page until the update that mapped it into the cache
+    float averageFaultLatencyMs = 0;
+    float maxFaultLatencyMs = 0;
+    float averageFaultLatencyFrames = 0;
+    uint32_t maxFaultLatencyFrames = 0;
+};
+
+/**
+ * Feedback analysis and page caching of a virtual texture
+ *
+ * capacity:
+ * number of virtual texture: 1
+ * physical cache: physicalPageCount x physicalPageCount pages in one image
+ * indirection: one texel per page of mip 0, scale and bias from the virtual uv to the physical uv of the finest
+ * resident page that covers it
+ *
+ * Pages the feedback asks for are loaded by a VirtualTexturePageLoader. The coarsest mip is always resident so every
+ * texel has a page to fall back to, the other physical pages are recycled in least recently used order
+ *
+ * This is the cpu side only, SimulateVirtualTexture is its one user. Nothing renders the feedback buffer, uploads the
+ * cache or samples it yet: there is no terrain material to sample it from, and UploadImageRegions writes whole
+ * subresources while a page update touches a rectangle of the cache. The pass that adds them uploads
+ * GetDirtyPhysicalPages after Update and the whole indirection when Update returns true, docs/roadmap.md tracks it
+ */
+class VirtualTextureRenderer
+{
+public:
+    VirtualTextureRenderer(VirtualTexture& vt, int physicalPageCount = 32);
+    ~VirtualTextureRenderer();
+
+    // feedback texels are rgba16 unorm: u, v, mip / (mip count - 1), texture id + 1. A zero texture id means nothing
+    // virtual textured covers the texel
+    void AnalyzeFeedback(const uint16_t* feedback, size_t texelCount);
+
+    // maps the pages the loader finished into the cache and rebuilds the indirection, returns true if either changed
+    bool Update();
+
+    // get final cache and indirMap
+    // return true if they are updated by the last Update
+    bool GetFinalTextures(Libs::Image::LinearImage*& cache, Libs::Image::LinearImage*& indirMap);
+
+    // physical pages written by the last Update, in page units of the cache
+    const std::vector<glm::ivec2>& GetDirtyPhysicalPages()
+    {
+        return dirtyPhysicalPages;
+    }
+
+    bool IsResident(int x, int y, int mip);
+
+    VirtualTextureStats GetStats();
+
+private:
+    using Clock = std::chrono::steady_clock;
+    using NodeID = int;
+
+    struct PageState
+    {
+        std::list<NodeID>::iterator lru;
+        glm::ivec2 physicalPage = {-1, -1};
+        uint64_t requestedFrame = 0;
+        bool loading = false;
+        // pages of the coarsest mip never leave the cache
+        bool pinned = false;
+
+        Clock::time_point faultTime;
+        uint64_t faultFrame = 0;
+    };
+    using QuadTree = Libs::Image::MipQuadTree<PageState>;
+
+    VirtualTexture& vt;
+    std::unique_ptr<VirtualTexturePageLoader> loader;
+    QuadTree qtree;
+
+    int physicalPageCount;
+    std::unique_ptr<Libs::Image::LinearImage> cache;
+    std::unique_ptr<Libs::Image::LinearImage> indir;
+    std::vector<glm::ivec2> freePhysicalPages;
+    std::vector<glm::ivec2> dirtyPhysicalPages;
+    // front is the most recently used, pinned pages are not in the list
+    std::list<NodeID> lru;
+    std::vector<VirtualTexturePageLoader::LoadedPage> loadedPages;
+
+    uint64_t frame = 1;
+    bool changed = false;
+
+    VirtualTextureStats stats;
+    double totalFaultLatencyMs = 0;
+    uint64_t totalFaultLatencyFrames = 0;
+    uint64_t mappedFaults = 0;
+
+    void Touch(QuadTree::Node& node);
+    void MapPage(QuadTree::Node& node, Libs::Image::LinearImage& page);
+    // only evicts a page that was requested before requestedFrame
+    bool EvictLeastRecentlyUsed(uint64_t requestedFrame);
+    void UpdateIndirTex();
+};
+} // namespace Rendering
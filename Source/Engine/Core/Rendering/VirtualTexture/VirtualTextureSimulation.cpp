@@ -0,0 +1,62 @@
+#include "VirtualTextureSimulation.hpp"
+#include <cmath>
+#include <thread>
+
+namespace Rendering
+{
+VirtualTextureSimulationResult SimulateVirtualTexture(VirtualTexture& vt, const VirtualTextureSimulationInfo& info)
+{
+    using Clock = std::chrono::steady_clock;
+    const float pi = glm::pi<float>();
+    const float maxMip = vt.GetMipCount() - 1;
+    const int width = info.feedbackWidth;
+    const int height = info.feedbackHeight;
+
+    VirtualTextureRenderer renderer(vt, info.physicalPageCount);
+    std::vector<uint16_t> feedback(size_t(width) * height * 4);
+    VirtualTextureSimulationResult result;
+    uint64_t faults = 0;
+    for (int frame = 0; frame < info.frames; ++frame)
+    {
+        auto frameEnd = Clock::now() + std::chrono::duration<float, std::milli>(info.frameMs);
+
+        float t = frame / (float)info.frames;
+        glm::vec2 center = glm::vec2(0.5f) + 0.3f * glm::vec2(std::cos(2 * pi * t), std::sin(2 * pi * t));
+        // how much of the texture the bottom row of the screen spans
+        float viewExtent = glm::mix(0.02f, 0.3f, 0.5f + 0.5f * std::sin(6 * pi * t));
+        for (int j = 0; j < height; ++j)
+        {
+            // rows further up the screen are further away and cover more of the texture
+            float distance = 1.0f + 3.0f * (1.0f - j / float(height - 1));
+            float rowExtent = viewExtent * distance;
+            float texelsPerPixel = rowExtent * vt.GetWidth() / (width * info.feedbackScale);
+            float mip = glm::clamp(std::log2(std::max(texelsPerPixel, 1.0f)), 0.0f, maxMip);
+            float v = center.y + (distance - 1.0f) * viewExtent;
+            for (int i = 0; i < width; ++i)
+            {
+                float u = center.x + (i / float(width - 1) - 0.5f) * rowExtent;
+                uint16_t* texel = &feedback[(size_t(j) * width + i) * 4];
+                texel[0] = (u - std::floor(u)) * 65535.0f;
+                texel[1] = (v - std::floor(v)) * 65535.0f;
+                texel[2] = maxMip > 0 ? mip / maxMip * 65535.0f : 0;
+                texel[3] = 1;
+            }
+        }
+
+        renderer.AnalyzeFeedback(feedback.data(), feedback.size() / 4);
+        renderer.Update();
+
+        uint64_t frameFaults = renderer.GetStats().faults;
+        if (frameFaults != faults)
+            result.framesWithFaults += 1;
+        faults = frameFaults;
+
+        std::this_thread::sleep_until(frameEnd);
+    }
+
+    result.stats = renderer.GetStats();
+    if (result.stats.requests > 0)
+        result.hitRate = result.stats.hits / (float)result.stats.requests;
+    return result;
+}
+} // namespace Rendering
@@ -0,0 +1,30 @@
+#pragma once
+#include "VirtualTextureRenderer.hpp"
+
+namespace Rendering
+{
+struct VirtualTextureSimulationInfo
+{
+    int frames = 300;
+    // the feedback buffer of a screen feedbackScale times larger
+    int feedbackWidth = 160;
+    int feedbackHeight = 90;
+    int feedbackScale = 8;
+    int physicalPageCount = 32;
+    // the page loader works while a frame "renders"
+    float frameMs = 16.0f;
+};
+
+struct VirtualTextureSimulationResult
+{
+    VirtualTextureStats stats;
+    float hitRate = 0;
+    // frames whose feedback asked for pages that weren't resident or loading yet
+    uint32_t framesWithFaults = 0;
+};
+
+// measures page fault latency without a gpu. A camera flies over the virtual texture looking at it at a grazing angle,
+// the view pans along a circle and zooms in and out. The feedback buffer is synthesized from the view and goes through
+// the same analysis, loader thread and cache a rendered one would
+VirtualTextureSimulationResult SimulateVirtualTexture(VirtualTexture& vt, const VirtualTextureSimulationInfo& info);
+} // namespace Rendering
@@ -1,42 +1,72 @@
 #include "PhysicsScene.hpp"
 #include "Core/Component/PhysicsBody.hpp"
 #include "Core/Scene/Scene.hpp"
-#include "Core/Time.hpp"
+#include "Libs/JobSystem.hpp"
+#include <Jolt/Physics/Body/BodyLock.h>
+#include <Jolt/Physics/Collision/CastResult.h>
+#include <Jolt/Physics/Collision/CollideShape.h>
+#include <Jolt/Physics/Collision/CollisionCollectorImpl.h>
+#include <Jolt/Physics/Collision/RayCast.h>
+#include <algorithm>
+#include <cmath>
+#include <optional>
 
-PhysicsScene::PhysicsScene(Scene* scene)
-    : scene(scene), physicsUpdateDeltaAccumulation(0.0f), temp_allocator(10 * 1024 * 1024),
-      job_system(JPH::cMaxPhysicsJobs, JPH::cMaxPhysicsBarriers, JPH::thread::hardware_concurrency()),
-      contact_listener(this)
+namespace
+{
+// object layers and broad phase layers map one to one, the same mask filters both
+class LayerMaskObjectFilter : public JPH::ObjectLayerFilter
 {
+public:
+    LayerMaskObjectFilter(uint32_t mask) : mask(mask) {}
+    bool ShouldCollide(JPH::ObjectLayer layer) const override
+    {
+        return (mask & (1u << layer)) != 0;
+    }
 
-    // This is the max amount of rigid bodies that you can add to the physics system. If you try to add more you'll
-    // get an error. Note: This value is low because this is a simple test. For a real project use something in the
-    // order of 65536.
-    const JPH::uint cMaxBodies = 1024;
+private:
+    uint32_t mask;
+};
 
-    // This determines how many mutexes to allocate to protect rigid bodies from concurrent access. Set it to 0 for
-    // the default settings.
-    const JPH::uint cNumBodyMutexes = 0;
+class LayerMaskBroadPhaseFilter : public JPH::BroadPhaseLayerFilter
+{
+public:
+    LayerMaskBroadPhaseFilter(uint32_t mask) : mask(mask) {}
+    bool ShouldCollide(JPH::BroadPhaseLayer layer) const override
+    {
+        return (mask & (1u << static_cast<JPH::BroadPhaseLayer::Type>(layer))) != 0;
+    }
 
-    // This is the max amount of body pairs that can be queued at any time (the broad phase will detect overlapping
-    // body pairs based on their bounding boxes and will insert them into a queue for the narrowphase). If you make
-    // this buffer too small the queue will fill up and the broad phase jobs will start to do narrow phase work.
-    // This is slightly less efficient. Note: This value is low because this is a simple test. For a real project
-    // use something in the order of 65536.
-    const JPH::uint cMaxBodyPairs = 1024;
+private:
+    uint32_t mask;
+};
 
-    // This is the maximum size of the contact constraint buffer. If more contacts (collisions between bodies) are
-    // detected than this number then these contacts will be ignored and bodies will start interpenetrating / fall
-    // through the world. Note: This value is low because this is a simple test. For a real project use something in
-    // the order of 10240.
-    const JPH::uint cMaxContactConstraints = 1024;
+// disabled PhysicsBodies keep their jolt body, queries skip them
+class EnabledBodyFilter : public JPH::BodyFilter
+{
+public:
+    EnabledBodyFilter(const std::unordered_map<JPH::BodyID, PhysicsBody*>& bodies) : bodies(bodies) {}
+    bool ShouldCollide(const JPH::BodyID& id) const override
+    {
+        return bodies.contains(id);
+    }
+
+private:
+    const std::unordered_map<JPH::BodyID, PhysicsBody*>& bodies;
+};
+} // namespace
 
-    // Now we can create the actual physics system.
+PhysicsScene::PhysicsScene(Scene* scene, const PhysicsSceneSettings& settings)
+    : scene(scene), settings(settings), physicsUpdateDeltaAccumulation(0.0f),
+      temp_allocator(settings.tempAllocatorSize),
+      job_system(JPH::cMaxPhysicsJobs, JPH::cMaxPhysicsBarriers, JPH::thread::hardware_concurrency()),
+      contact_listener(this)
+{
+    // see PhysicsSceneSettings
     physicsSystem.Init(
-        cMaxBodies,
-        cNumBodyMutexes,
-        cMaxBodyPairs,
-        cMaxContactConstraints,
+        settings.maxBodies,
+        settings.numBodyMutexes,
+        settings.maxBodyPairs,
+        settings.maxContactConstraints,
         broad_phase_layer_interface,
         object_vs_broadphase_layer_filter,
         object_vs_object_layer_filter
@@ -50,32 +80,115 @@ PhysicsScene::PhysicsScene(Scene* scene)
     physicsSystem.SetGravity({0, -9.8, 0});
 }
 
-PhysicsScene::~PhysicsScene() {}
+PhysicsScene::~PhysicsScene()
+{
+    WaitForSimulation();
+}
 
-void PhysicsScene::Tick()
+void PhysicsScene::Tick(float deltaTime)
 {
+    if (simulation.valid())
+    {
+        simulation.get();
+        ApplySimulationResults();
+    }
+
     if (optimizeNeeded)
     {
         physicsSystem.OptimizeBroadPhase();
         optimizeNeeded = false;
     }
 
-    physicsUpdateDeltaAccumulation += Time::DeltaTime();
-    while (physicsUpdateDeltaAccumulation >= DeltaTime)
+    // the poses are from the last finished job, interpolated by how far past its steps the frame was when it started
+    float alpha = jobRemainder / DeltaTime;
+    for (PhysicsBody* body : interpolatedBodies)
+    {
+        body->UpdateGameObject(alpha);
+    }
+
+    physicsUpdateDeltaAccumulation += deltaTime;
+    pendingSteps = std::min(static_cast<int>(physicsUpdateDeltaAccumulation / DeltaTime), MaxStepsPerFrame);
+    physicsUpdateDeltaAccumulation -= pendingSteps * DeltaTime;
+    // time that didn't fit in MaxStepsPerFrame is dropped
+    physicsUpdateDeltaAccumulation = std::fmod(physicsUpdateDeltaAccumulation, DeltaTime);
+
+    // the steps run back to back on the worker, so the game logic of every step runs before them
+    for (int i = 0; i < pendingSteps; ++i)
     {
         scene->PrePhysicsTick();
+    }
+}
+
+void PhysicsScene::StartSimulation()
+{
+    // a frame that starts no job doesn't consume any time, the last job is interpolated further along next frame
+    jobRemainder = physicsUpdateDeltaAccumulation;
+    if (pendingSteps == 0)
+        return;
 
+    WaitForSimulation();
+    jobFirstStep = stepIndex + 1;
+    int steps = pendingSteps;
+    pendingSteps = 0;
+    simulation = JobSystem::GetSingleton().Schedule([this, steps]() { Simulate(steps); });
+}
+
+void PhysicsScene::Simulate(int steps)
+{
+    for (int i = 0; i < steps; ++i)
+    {
         physicsSystem.Update(DeltaTime, CollisionSteps, &temp_allocator, &job_system);
-        physicsUpdateDeltaAccumulation -= DeltaTime;
+        stepIndex += 1;
+        SyncActiveBodies();
+    }
 
-        // Step the world
-        for (auto& b : bodies)
-        {
-            b.second->UpdateGameObject();
-        }
+    // a body that fell asleep before the last step didn't move between the last two steps
+    for (PhysicsBody* body : movedBodies)
+    {
+        body->StorePose(stepIndex);
+    }
+}
+
+void PhysicsScene::SyncActiveBodies()
+{
+    // sleeping and static bodies didn't move
+    physicsSystem.GetActiveBodies(activeBodies);
+    {
+        std::scoped_lock lock(body_activation_listener.deactivatedMutex);
+        activeBodies.insert(
+            activeBodies.end(),
+            body_activation_listener.deactivated.begin(),
+            body_activation_listener.deactivated.end()
+        );
+        body_activation_listener.deactivated.clear();
+    }
+
+    for (const JPH::BodyID& id : activeBodies)
+    {
+        auto iter = bodies.find(id);
+        if (iter == bodies.end())
+            continue;
+
+        PhysicsBody* body = iter->second;
+        if (body->GetSyncedStep() < jobFirstStep)
+            movedBodies.push_back(body);
+        body->StorePose(stepIndex);
     }
 }
 
+void PhysicsScene::ApplySimulationResults()
+{
+    // bodies that stopped moving get their final pose once and are left alone until they move again
+    for (PhysicsBody* body : interpolatedBodies)
+    {
+        if (body->GetSyncedStep() < jobFirstStep)
+            body->UpdateGameObject(1.0f);
+    }
+
+    interpolatedBodies.swap(movedBodies);
+    movedBodies.clear();
+}
+
 void PhysicsScene::DebugDraw()
 {
     JPH::BodyManager::DrawSettings drawSettings;
@@ -91,9 +204,138 @@ void PhysicsScene::DebugDraw()
         }
     }
 
+    // drawing reads the bodies, only wait for the simulation when there is something to draw
+    if (bodyDrawFilter.drawRequested.empty())
+        return;
+
+    WaitForSimulation();
     physicsSystem.DrawBodies(drawSettings, JoltDebugRenderer::GetDebugRenderer().get(), &bodyDrawFilter);
 }
 
+void PhysicsScene::Raycast(std::span<const RaycastQuery> queries, std::vector<RaycastHit>& hits)
+{
+    WaitForSimulation();
+    hits.assign(queries.size(), RaycastHit{});
+
+    const JPH::NarrowPhaseQuery& narrowPhase = physicsSystem.GetNarrowPhaseQuery();
+    EnabledBodyFilter bodyFilter(bodies);
+    JobSystem::GetSingleton().ParallelFor(
+        queries.size(),
+        16,
+        [&](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; ++i)
+            {
+                const RaycastQuery& query = queries[i];
+                glm::vec3 ray = query.direction * query.maxDistance;
+                JPH::RRayCast rayCast{
+                    {query.origin.x, query.origin.y, query.origin.z},
+                    {ray.x, ray.y, ray.z}
+                };
+                JPH::RayCastResult result;
+                if (!narrowPhase.CastRay(
+                        rayCast,
+                        result,
+                        LayerMaskBroadPhaseFilter(query.layerMask),
+                        LayerMaskObjectFilter(query.layerMask),
+                        bodyFilter
+                    ))
+                    continue;
+
+                RaycastHit& hit = hits[i];
+                hit.body = bodies.at(result.mBodyID);
+                hit.distance = result.mFraction * query.maxDistance;
+                hit.point = query.origin + query.direction * hit.distance;
+
+                JPH::BodyLockRead lock(physicsSystem.GetBodyLockInterface(), result.mBodyID);
+                if (lock.Succeeded())
+                {
+                    JPH::Vec3 normal = lock.GetBody().GetWorldSpaceSurfaceNormal(
+                        result.mSubShapeID2,
+                        {hit.point.x, hit.point.y, hit.point.z}
+                    );
+                    hit.normal = {normal.GetX(), normal.GetY(), normal.GetZ()};
+                }
+            }
+        }
+    );
+}
+
+RaycastHit PhysicsScene::Raycast(const RaycastQuery& query)
+{
+    std::vector<RaycastHit> hits;
+    Raycast(std::span<const RaycastQuery>(&query, 1), hits);
+    return hits[0];
+}
+
+void PhysicsScene::Overlap(std::span<const OverlapQuery> queries, std::vector<std::vector<PhysicsBody*>>& results)
+{
+    WaitForSimulation();
+    results.resize(queries.size());
+
+    const JPH::NarrowPhaseQuery& narrowPhase = physicsSystem.GetNarrowPhaseQuery();
+    EnabledBodyFilter bodyFilter(bodies);
+    JobSystem::GetSingleton().ParallelFor(
+        queries.size(),
+        8,
+        [&](size_t begin, size_t end)
+        {
+            JPH::CollideShapeSettings settings;
+            JPH::AllHitCollisionCollector<JPH::CollideShapeCollector> collector;
+            for (size_t i = begin; i < end; ++i)
+            {
+                const OverlapQuery& query = queries[i];
+                std::vector<PhysicsBody*>& overlapping = results[i];
+                overlapping.clear();
+
+                // only used for this query, kept on the stack. Only the requested shape is built, the other one may
+                // not be valid for the query's size
+                std::optional<JPH::SphereShape> sphere;
+                std::optional<JPH::BoxShape> box;
+                const JPH::Shape* shape;
+                if (query.shape == OverlapQuery::Shape::Box)
+                {
+                    JPH::Vec3 halfExtent(query.size.x, query.size.y, query.size.z);
+                    // jolt asserts that the convex radius fits in the box
+                    box.emplace(halfExtent, std::min(JPH::cDefaultConvexRadius, halfExtent.ReduceMin()));
+                    box->SetEmbedded();
+                    shape = &*box;
+                }
+                else
+                {
+                    sphere.emplace(query.size.x);
+                    sphere->SetEmbedded();
+                    shape = &*sphere;
+                }
+
+                collector.Reset();
+                narrowPhase.CollideShape(
+                    shape,
+                    JPH::Vec3::sReplicate(1.0f),
+                    JPH::RMat44::sRotationTranslation(
+                        {query.rotation.x, query.rotation.y, query.rotation.z, query.rotation.w},
+                        {query.center.x, query.center.y, query.center.z}
+                    ),
+                    settings,
+                    JPH::RVec3::sZero(),
+                    collector,
+                    LayerMaskBroadPhaseFilter(query.layerMask),
+                    LayerMaskObjectFilter(query.layerMask),
+                    bodyFilter
+                );
+
+                // one hit per touching sub shape, bodies are reported once
+                for (auto& hit : collector.mHits)
+                {
+                    PhysicsBody* body = bodies.at(hit.mBodyID2);
+                    if (std::find(overlapping.begin(), overlapping.end(), body) == overlapping.end())
+                        overlapping.push_back(body);
+                }
+            }
+        }
+    );
+}
+
 void PhysicsContactListener::OnContactAdded(
     const JPH::Body& inBody1,
     const JPH::Body& inBody2,
@@ -134,6 +376,7 @@ void PhysicsScene::AddPhysicsBody(PhysicsBody& body)
     auto jphBody = body.GetBody();
     assert(jphBody != nullptr);
 
+    WaitForSimulation();
     bodies[jphBody->GetID()] = &body;
     optimizeNeeded = true;
 }
@@ -142,6 +385,9 @@ void PhysicsScene::RemovePhysicsBody(PhysicsBody& body)
 {
     auto jphBody = body.GetBody();
     assert(jphBody != nullptr);
+    WaitForSimulation();
     bodies.erase(jphBody->GetID());
+    std::erase(interpolatedBodies, &body);
+    std::erase(movedBodies, &body);
     optimizeNeeded = true;
 }
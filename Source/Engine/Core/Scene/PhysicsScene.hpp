@@ -5,6 +5,7 @@
 #include <Jolt/Core/JobSystemThreadPool.h>
 #include <Jolt/Core/TempAllocator.h>
 // clang-format on
+#include "Core/Time.hpp"
 #include "Physics/JoltDebugRenderer.hpp"
 #include "PhysicsLayer.hpp"
 #include <Jolt/Physics/Body/BodyActivationListener.h>
@@ -15,8 +16,14 @@
 #include <Jolt/Physics/PhysicsSettings.h>
 #include <Jolt/Physics/PhysicsSystem.h>
 #include <Jolt/RegisterTypes.h>
+#include <future>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <mutex>
+#include <span>
 #include <spdlog/spdlog.h>
 #include <unordered_set>
+#include <vector>
 
 class PhysicsBody;
 class PhysicsScene;
@@ -148,7 +155,7 @@ private:
     std::unordered_map<JPH::BodyID, PhysicsBody*> contactingBodies;
 };
 
-// An example activation listener
+// records the bodies that fell asleep during a step, they moved in that step but are no longer in the active list
 class MyBodyActivationListener : public JPH::BodyActivationListener
 {
 public:
@@ -157,10 +164,72 @@ public:
         // spdlog::info("A body got activated");
     }
 
+    // called from the physics jobs
     virtual void OnBodyDeactivated(const JPH::BodyID& inBodyID, JPH::uint64 inBodyUserData) override
     {
-        // spdlog::info("A body went to sleep");
+        std::scoped_lock lock(deactivatedMutex);
+        deactivated.push_back(inBodyID);
     }
+
+    std::mutex deactivatedMutex;
+    JPH::BodyIDVector deactivated;
+};
+
+// capacities of the jolt physics system, they are fixed once the scene is created
+struct PhysicsSceneSettings
+{
+    // adding more bodies than this fails
+    uint32_t maxBodies = 65536;
+
+    // 0 lets jolt pick the number of mutexes protecting the bodies
+    uint32_t numBodyMutexes = 0;
+
+    // body pairs the broad phase can queue for the narrow phase, when it's full the broad phase jobs start doing
+    // narrow phase work
+    uint32_t maxBodyPairs = 65536;
+
+    // contacts above this are ignored and bodies start to interpenetrate
+    uint32_t maxContactConstraints = 10240;
+
+    // per step scratch memory
+    uint32_t tempAllocatorSize = 10 * 1024 * 1024;
+};
+
+// a query hits the layers whose bit (1 << layer) is set
+inline constexpr uint32_t AllPhysicsLayers = ~0u;
+
+struct RaycastQuery
+{
+    glm::vec3 origin = glm::vec3(0);
+    // normalized
+    glm::vec3 direction = glm::vec3(0, 0, 1);
+    float maxDistance = 1000.0f;
+    uint32_t layerMask = AllPhysicsLayers;
+};
+
+struct RaycastHit
+{
+    // nullptr if the ray didn't hit anything
+    PhysicsBody* body = nullptr;
+    float distance = 0;
+    glm::vec3 point = glm::vec3(0);
+    glm::vec3 normal = glm::vec3(0);
+};
+
+struct OverlapQuery
+{
+    enum class Shape
+    {
+        Sphere,
+        Box
+    };
+
+    Shape shape = Shape::Sphere;
+    glm::vec3 center = glm::vec3(0);
+    // radius in x for spheres, half extents for boxes
+    glm::vec3 size = glm::vec3(0.5f);
+    glm::quat rotation = glm::quat(1, 0, 0, 0);
+    uint32_t layerMask = AllPhysicsLayers;
 };
 
 class PhysicsScene
@@ -168,15 +237,19 @@ class PhysicsScene
 public:
     const float DeltaTime = 1.0f / 55.0f;
     const int CollisionSteps = 1;
+    // a long frame runs at most this many steps, the simulation slows down instead of making the next frame longer
+    const int MaxStepsPerFrame = 4;
 
-    PhysicsScene(Scene* scene);
+    PhysicsScene(Scene* scene, const PhysicsSceneSettings& settings = {});
     ~PhysicsScene();
 
     PhysicsScene(const PhysicsScene& other) = delete;
     PhysicsScene(PhysicsScene&& other) = delete;
 
+    // bodies can't be touched while the simulation job steps them, this waits for it
     JPH::BodyInterface& GetBodyInterface()
     {
+        WaitForSimulation();
         return *bodyInterface;
     }
 
@@ -192,22 +265,81 @@ public:
         return nullptr;
     }
 
-    void Tick();
+    // writes the results of the last simulation job back to the game objects, interpolated between the last two steps
+    // by the time that was left in the accumulator when it was started, then runs PrePhysicsTick once for each step
+    // that is due
+    void Tick()
+    {
+        Tick(Time::DeltaTime());
+    }
+    void Tick(float deltaTime);
+
+    // steps the physics system on a worker thread, so the steps overlap with rendering instead of adding to the frame.
+    // Called after the game logic of the frame
+    void StartSimulation();
+
+    void WaitForSimulation()
+    {
+        if (simulation.valid())
+            simulation.wait();
+    }
+
     void DebugDraw();
 
+    // closest hit of each ray against the enabled bodies, hits is resized to the number of queries. Queries go through
+    // jolt's broad phase and narrow phase and are split across the job system
+    void Raycast(std::span<const RaycastQuery> queries, std::vector<RaycastHit>& hits);
+    RaycastHit Raycast(const RaycastQuery& query);
+
+    // enabled bodies touching each shape, results[i] holds the bodies of queries[i]. Reusing results between calls
+    // keeps their allocations
+    void Overlap(std::span<const OverlapQuery> queries, std::vector<std::vector<PhysicsBody*>>& results);
+
+    // waits for the simulation job like GetBodyInterface
     JPH::PhysicsSystem& GetPhysicsSystem()
     {
+        WaitForSimulation();
         return physicsSystem;
     }
 
+    const PhysicsSceneSettings& GetSettings() const
+    {
+        return settings;
+    }
+
+    size_t GetBodyCount() const
+    {
+        return bodies.size();
+    }
+
 private:
     Scene* scene;
+    PhysicsSceneSettings settings;
     JPH::PhysicsSystem physicsSystem;
     JPH::BodyInterface* bodyInterface;
     std::unordered_map<JPH::BodyID, PhysicsBody*> bodies;
     bool optimizeNeeded = false;
     float physicsUpdateDeltaAccumulation;
 
+    std::future<void> simulation;
+    int pendingSteps = 0;
+    // accumulator time left over when the last job was started, set by every StartSimulation
+    float jobRemainder = 0;
+    uint64_t stepIndex = 0;
+    // first step of the last simulation job
+    uint64_t jobFirstStep = 1;
+
+    // reused every step, only bodies that moved store a new pose
+    JPH::BodyIDVector activeBodies;
+    // bodies that moved during the simulation job, written by the job
+    std::vector<PhysicsBody*> movedBodies;
+    // bodies that moved during the last finished job, their game objects are interpolated every frame
+    std::vector<PhysicsBody*> interpolatedBodies;
+
+    void Simulate(int steps);
+    void SyncActiveBodies();
+    void ApplySimulationResults();
+
     class DebugBodyDrawFilter : public JPH::BodyDrawFilter
     {
     public:
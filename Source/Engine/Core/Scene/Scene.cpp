@@ -1,7 +1,18 @@
 #include "Scene.hpp"
+#include "Core/Component/MeshRenderer.hpp"
+#include "Libs/JobSystem.hpp"
+#include "Physics/MeshShapeCache.hpp"
+#include "Rendering/Material.hpp"
+#include <algorithm>
+#include <bit>
+#include <unordered_map>
+#include <unordered_set>
 DEFINE_ASSET(Scene, "BE42FB0F-42FF-4951-8D7D-DBD28439D3E7", "scene");
 
-Scene::Scene() : Asset(), renderingScene(), physicsScene(this)
+Scene::Scene() : Scene(PhysicsSceneSettings{}) {}
+
+Scene::Scene(const PhysicsSceneSettings& physicsSettings)
+    : Asset(), renderingScene(), physicsScene(this, physicsSettings)
 {
     name = "New GameScene";
 }
@@ -9,6 +20,8 @@ Scene::Scene() : Asset(), renderingScene(), physicsScene(this)
 Scene::~Scene()
 {
     gameObjects.clear();
+    // the bodies are destroyed, their mesh shapes may not be used by any other scene
+    MeshShapeCache::GetSingleton().EvictUnused();
 }
 
 GameObject* Scene::CreateGameObject()
@@ -18,6 +31,7 @@ GameObject* Scene::CreateGameObject()
     GameObject* refObj = gameObjects.back().get();
     roots.push_back(refObj);
     refObj->SetEnable(true);
+    HierarchyChanged();
     return refObj;
 }
 
@@ -32,6 +46,7 @@ GameObject* Scene::AddGameObject(std::unique_ptr<GameObject>&& newGameObject)
     {
         roots.push_back(temp);
     }
+    HierarchyChanged();
 
     if (temp->GetWantsTobeEnabledStateAndReset())
     {
@@ -53,25 +68,153 @@ const std::vector<GameObject*>& Scene::GetRootObjects()
 
 void Scene::Tick()
 {
-    for (auto obj : roots)
+    RunUpdatePhase(UpdatePhase::Update, &Component::Tick);
+}
+
+void Scene::PrePhysicsTick()
+{
+    RunUpdatePhase(UpdatePhase::PrePhysics, &Component::PrePhysicsTick);
+}
+
+void Scene::LateTick()
+{
+    RunUpdatePhase(UpdatePhase::LateUpdate, &Component::LateTick);
+}
+
+void Scene::ComponentStateChanged(Component* component)
+{
+    GameObject* go = component->GetGameObject();
+    bool active = go && go->GetScene() == this && go->IsEnabled() && component->IsEnabled();
+    if (active && component->registeredScene == nullptr)
+        RegisterComponent(component);
+    else if (!active && component->registeredScene == this)
+        UnregisterComponent(component);
+}
+
+void Scene::RegisterComponent(Component* component)
+{
+    auto& registry = componentRegistries[typeid(*component)];
+    component->registeredScene = this;
+    component->registry = &registry;
+    component->registryIndex = registry.size();
+    registry.push_back(component);
+    componentGeneration += 1;
+    updateBatchesDirty = true;
+}
+
+void Scene::UnregisterComponent(Component* component)
+{
+    // swap with the last one, registries are unordered
+    auto& registry = *component->registry;
+    Component* last = registry.back();
+    registry[component->registryIndex] = last;
+    last->registryIndex = component->registryIndex;
+    registry.pop_back();
+    component->registeredScene = nullptr;
+    component->registry = nullptr;
+    componentGeneration += 1;
+
+    if (static_cast<Component*>(camera) == component)
+        camera = nullptr;
+
+    updateBatchesDirty = true;
+    if (!inUpdatePhase)
+        return;
+
+    // may be called from the component's destructor, where typeid doesn't give the concrete type anymore
+    for (auto& batches : updateBatches)
     {
-        TickGameObject(obj);
+        for (auto& batch : batches)
+        {
+            auto iter = std::find(batch.components.begin(), batch.components.end(), component);
+            if (iter != batch.components.end())
+                *iter = nullptr;
+        }
     }
 }
 
-void Scene::PrePhysicsTick()
+void Scene::RebuildUpdateBatches()
 {
-    for (auto obj : roots)
+    std::array<std::unordered_map<std::type_index, size_t>, 3> batchIndices;
+    for (auto& batches : updateBatches)
+        batches.clear();
+
+    for (GameObject* go : GetAllGameObjects())
     {
-        PrePhysicsTickGameObject(obj);
+        if (!go->IsEnabled())
+            continue;
+
+        for (auto& c : go->GetComponents())
+        {
+            UpdatePhaseFlags phases = c->GetUpdatePhases();
+            if (!c->IsEnabled() || phases == UpdatePhase::None)
+                continue;
+
+            std::type_index type = typeid(*c);
+            for (size_t p = 0; p < updateBatches.size(); ++p)
+            {
+                if ((phases & static_cast<UpdatePhase>(1 << p)) == UpdatePhase::None)
+                    continue;
+
+                auto [iter, inserted] = batchIndices[p].try_emplace(type, updateBatches[p].size());
+                if (inserted)
+                    updateBatches[p].push_back({type, c->IsTickThreadSafe(), {}});
+                updateBatches[p][iter->second].components.push_back(c.get());
+            }
+        }
+    }
+}
+
+void Scene::RunUpdatePhase(UpdatePhase phase, void (Component::*tick)())
+{
+    if (updateBatchesDirty)
+    {
+        RebuildUpdateBatches();
+        updateBatchesDirty = false;
+    }
+
+    // components added during the phase are picked up by the next one
+    inUpdatePhase = true;
+    for (auto& batch : updateBatches[std::countr_zero(static_cast<uint32_t>(phase))])
+    {
+        auto& components = batch.components;
+        if (batch.threadSafe)
+        {
+            // updates every world transform, the ticks read them without writing to the transform system
+            transformSystem.SetReadOnly(true);
+            JobSystem::GetSingleton().ParallelFor(
+                components.size(),
+                256,
+                [&components, tick](size_t begin, size_t end)
+                {
+                    for (size_t i = begin; i < end; ++i)
+                    {
+                        if (components[i])
+                            (components[i]->*tick)();
+                    }
+                }
+            );
+            transformSystem.SetReadOnly(false);
+        }
+        else
+        {
+            for (size_t i = 0; i < components.size(); ++i)
+            {
+                if (components[i])
+                    (components[i]->*tick)();
+            }
+        }
     }
+    inUpdatePhase = false;
 }
 
 void Scene::MoveGameObjectToRoot(GameObject* obj)
 {
     roots.push_back(obj);
+    HierarchyChanged();
 }
 
+
 static void GetAllGameObjects(GameObject* current, std::vector<GameObject*>& objs)
 {
     objs.push_back(current);
@@ -81,17 +224,20 @@ static void GetAllGameObjects(GameObject* current, std::vector<GameObject*>& obj
     }
 }
 
-std::vector<GameObject*> Scene::GetAllGameObjects()
+std::span<GameObject* const> Scene::GetAllGameObjects()
 {
-    std::vector<GameObject*> objs;
-    objs.reserve(256);
-
-    for (auto& obj : roots)
+    if (allGameObjectsGeneration != hierarchyGeneration)
     {
-        ::GetAllGameObjects(obj, objs);
+        // clear keeps the capacity, an unchanged scene doesn't allocate or traverse
+        allGameObjects.clear();
+        for (auto& obj : roots)
+        {
+            ::GetAllGameObjects(obj, allGameObjects);
+        }
+        allGameObjectsGeneration = hierarchyGeneration;
     }
 
-    return objs;
+    return allGameObjects;
 }
 
 GameObject* Scene::CopyGameObject(GameObject& gameObject)
@@ -101,6 +247,7 @@ GameObject* Scene::CopyGameObject(GameObject& gameObject)
 
     GameObject* top = newObj.get();
     gameObjects.push_back(std::move(newObj));
+    HierarchyChanged();
 
     if (gameObject.GetParent() == nullptr)
     {
@@ -145,6 +292,8 @@ void Scene::DestroyGameObject(GameObject* obj)
     auto iter = std::find_if(gameObjects.begin(), gameObjects.end(), [obj](auto& o) { return o.get() == obj; });
     if (iter != gameObjects.end())
         gameObjects.erase(iter);
+
+    HierarchyChanged();
 }
 
 void Scene::RemoveGameObjectFromRoot(GameObject* obj)
@@ -155,55 +304,34 @@ void Scene::RemoveGameObjectFromRoot(GameObject* obj)
         if (*it == obj)
         {
             roots.erase(it);
+            HierarchyChanged();
             return;
         }
         it += 1;
     }
 }
 
-void Scene::TickGameObject(GameObject* obj)
+std::span<Light* const> Scene::GetActiveLights()
 {
-    obj->Tick();
-
-    for (auto child : obj->GetChildren())
+    if (activeLightsGeneration != componentGeneration)
     {
-        TickGameObject(child);
+        auto lights = GetComponentsOfType<Light>();
+
+        // the registry is reordered by swap removes, sorting by uuid keeps the order (and with it the main light)
+        // from changing when an unrelated light is toggled
+        std::vector<std::pair<std::string, Light*>> sorted;
+        sorted.reserve(lights.size());
+        for (Light* light : lights)
+            sorted.emplace_back(light->GetUUID().ToString(), light);
+        std::sort(sorted.begin(), sorted.end());
+
+        activeLights.clear();
+        for (auto& [uuid, light] : sorted)
+            activeLights.push_back(light);
+        activeLightsGeneration = componentGeneration;
     }
-}
 
-void Scene::PrePhysicsTickGameObject(GameObject* obj)
-{
-    obj->PrePhysicsTick();
-
-    for (auto child : obj->GetChildren())
-    {
-        PrePhysicsTickGameObject(child);
-    }
-}
-
-void GetLights(GameObject* go, std::vector<Light*>& lights)
-{
-    for (auto& child : go->GetChildren())
-    {
-        GetLights(child, lights);
-    }
-
-    auto light = go->GetComponent<Light>();
-    if (light != nullptr)
-    {
-        lights.push_back(light);
-    }
-}
-
-std::vector<Light*> Scene::GetActiveLights()
-{
-    std::vector<Light*> lights;
-    for (auto child : roots)
-    {
-        GetLights(child, lights);
-    }
-
-    return lights;
+    return activeLights;
 }
 
 void Scene::AddGameObjects(std::vector<std::unique_ptr<GameObject>>&& gameObjects)
@@ -240,6 +368,7 @@ void Scene::Deserialize(Serializer* s)
     s->Deserialize("gameObjects", gameObjects);
     s->Deserialize("roots", roots);
     s->Deserialize("camera", camera);
+    HierarchyChanged();
 }
 
 void Scene::OnLoadingFinished()
@@ -253,4 +382,16 @@ void Scene::OnLoadingFinished()
     {
         g->SetScene(this);
     }
+
+    // pipelines compile in the background while the scene starts instead of each material being skipped the first
+    // time it's drawn
+    std::unordered_set<Material*> materials;
+    for (MeshRenderer* mr : GetComponentsOfType<MeshRenderer>())
+    {
+        for (Material* material : mr->GetMaterials())
+        {
+            if (material != nullptr && materials.insert(material).second)
+                material->PrewarmPipelines();
+        }
+    }
 }
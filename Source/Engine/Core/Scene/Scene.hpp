@@ -5,16 +5,25 @@
 #include "Core/Component/Light.hpp"
 #include "Core/GameObject.hpp"
 #include "Core/Scene/PhysicsScene.hpp"
+#include "Core/Scene/TransformSystem.hpp"
 #include "GfxDriver/ShaderResource.hpp"
 #include "RenderingScene.hpp"
 #include <SDL.h>
+#include <array>
+#include <ranges>
+#include <span>
+#include <typeindex>
+#include <unordered_map>
 
 class Scene : public Asset
 {
     DECLARE_ASSET();
+    friend class Component;
 
 public:
     Scene();
+    // scenes expecting a lot of physics bodies size their physics system up front
+    Scene(const PhysicsSceneSettings& physicsSettings);
     ~Scene();
     GameObject* CreateGameObject();
     GameObject* AddGameObject(std::unique_ptr<GameObject>&& newGameObject);
@@ -23,10 +32,52 @@ public:
 
     const std::vector<GameObject*>& GetRootObjects();
 
+    // each phase ticks its components type by type, types are ordered by where they first appear in the hierarchy and
+    // components of a type in hierarchy order. Thread safe types are split across the job system
     void Tick();
     void PrePhysicsTick();
+    void LateTick();
     void OnLoadingFinished() override;
 
+    // the component or its game object was enabled, disabled, or moved in or out of this scene. Updates the type
+    // registries, the update batches are rebuilt before the next phase and a running phase skips removed components
+    void ComponentStateChanged(Component* component);
+
+    // enabled components of exactly type T on enabled game objects, in no particular order
+    template <class T>
+    auto GetComponentsOfType()
+    {
+        static const std::vector<Component*> empty;
+        auto iter = componentRegistries.find(typeid(T));
+        const std::vector<Component*>& components = iter != componentRegistries.end() ? iter->second : empty;
+        return components | std::views::transform([](Component* c) { return static_cast<T*>(c); });
+    }
+
+    // refreshes the cached world transforms of dirty objects, run once per frame before rendering so that later
+    // queries don't walk up the hierarchy
+    void UpdateTransforms()
+    {
+        transformSystem.Update();
+    }
+
+    // called when objects are added, removed or reparented
+    void HierarchyChanged()
+    {
+        transformSystem.HierarchyChanged();
+        hierarchyGeneration += 1;
+    }
+
+    // changes whenever the hierarchy changes, callers holding on to GetAllGameObjects can compare it
+    uint64_t GetHierarchyGeneration() const
+    {
+        return hierarchyGeneration;
+    }
+
+    TransformSystem& GetTransformSystem()
+    {
+        return transformSystem;
+    }
+
     void MoveGameObjectToRoot(GameObject* obj);
     void RemoveGameObjectFromRoot(GameObject* obj);
     void RemoveGameObject(GameObject* obj);
@@ -36,9 +87,19 @@ public:
                  "AssetDatabse::CopyThroughSerialization instead")]]
     std::unique_ptr<Asset> Clone() override;
 
-    std::vector<GameObject*> GetAllGameObjects();
+    // every game object in hierarchy order. Cached until the hierarchy changes, the span is invalidated by the next
+    // call after a change
+    std::span<GameObject* const> GetAllGameObjects();
 
-    std::vector<Light*> GetActiveLights();
+    // enabled lights on enabled game objects, ordered by uuid so the order doesn't depend on enable history. Cached
+    // until a component is registered or unregistered, the span is invalidated by the next call after a change
+    std::span<Light* const> GetActiveLights();
+
+    // changes whenever the set of active components may have changed, which includes every change to GetActiveLights
+    uint64_t GetActiveLightsGeneration() const
+    {
+        return componentGeneration;
+    }
 
     void Serialize(Serializer* s) const override;
     void Deserialize(Serializer* s) override;
@@ -46,14 +107,10 @@ public:
     {
         if (camera == nullptr)
         {
-            for (auto go : GetAllGameObjects())
+            for (Camera* cam : GetComponentsOfType<Camera>())
             {
-                auto cam = go->GetComponent<Camera>();
-                if (cam)
-                {
-                    camera = cam;
-                    break;
-                }
+                camera = cam;
+                break;
             }
         }
         return camera;
@@ -79,12 +136,39 @@ protected:
     // this should be deleted after gameObjects
     RenderingScene renderingScene;
     PhysicsScene physicsScene;
+    // GameObjects remove their transforms when destroyed, so this outlives gameObjects
+    TransformSystem transformSystem;
 
     std::vector<std::unique_ptr<GameObject>> gameObjects;
     std::vector<GameObject*> roots;
 
     Camera* camera = nullptr;
 
-    void TickGameObject(GameObject* obj);
-    void PrePhysicsTickGameObject(GameObject* obj);
+    struct ComponentTypeBatch
+    {
+        std::type_index type;
+        bool threadSafe;
+        std::vector<Component*> components;
+    };
+
+    // active components by concrete type, unordered_map keeps the vectors in place so components can point to theirs
+    std::unordered_map<std::type_index, std::vector<Component*>> componentRegistries;
+    uint64_t componentGeneration = 1;
+
+    uint64_t hierarchyGeneration = 1;
+    // caches of GetAllGameObjects and GetActiveLights and the generation they were built at
+    std::vector<GameObject*> allGameObjects;
+    uint64_t allGameObjectsGeneration = 0;
+    std::vector<Light*> activeLights;
+    uint64_t activeLightsGeneration = 0;
+
+    // enabled components of enabled game objects, indexed by the bit of their UpdatePhase
+    std::array<std::vector<ComponentTypeBatch>, 3> updateBatches;
+    bool updateBatchesDirty = true;
+    bool inUpdatePhase = false;
+
+    void RegisterComponent(Component* component);
+    void UnregisterComponent(Component* component);
+    void RebuildUpdateBatches();
+    void RunUpdatePhase(UpdatePhase phase, void (Component::*tick)());
 };
@@ -0,0 +1,214 @@
+#include "TransformSystem.hpp"
+#include "Core/GameObject.hpp"
+#include <algorithm>
+#include <spdlog/spdlog.h>
+
+uint32_t TransformSystem::Add(GameObject* owner, const LocalTransform& local)
+{
+    // the object needs its slot now, this one can't wait
+    if (readOnly)
+    {
+        std::scoped_lock lock(deferredMutex);
+        ReportReadOnlyViolation("an object was added");
+    }
+    uint32_t slot = owners.size();
+    owners.push_back(owner);
+    locals.push_back(local);
+    worldMatrices.push_back(local.ToMatrix());
+    worldRotations.push_back(local.rotation);
+    parents.push_back(NoParent);
+    subtreeEnds.push_back(slot + 1);
+    dirty.push_back(1);
+    orderStale = true;
+    return slot;
+}
+
+void TransformSystem::Remove(uint32_t slot)
+{
+    if (readOnly)
+    {
+        std::scoped_lock lock(deferredMutex);
+        ReportReadOnlyViolation("an object was removed");
+        deferredRemoves.push_back(slot);
+        return;
+    }
+
+    // the slot is dropped by the next rebuild, until then other slots stay where they are
+    owners[slot] = nullptr;
+    orderStale = true;
+}
+
+void TransformSystem::MarkDirty(uint32_t slot)
+{
+    if (readOnly)
+    {
+        std::scoped_lock lock(deferredMutex);
+        ReportReadOnlyViolation("a transform changed");
+        deferredDirty.push_back(slot);
+        return;
+    }
+
+    // everything is dirty after a rebuild
+    if (orderStale || dirty[slot])
+        return;
+
+    std::fill(dirty.begin() + slot, dirty.begin() + subtreeEnds[slot], 1);
+}
+
+void TransformSystem::HierarchyChanged()
+{
+    if (readOnly)
+    {
+        std::scoped_lock lock(deferredMutex);
+        ReportReadOnlyViolation("the hierarchy changed");
+        deferredHierarchyChange = true;
+        return;
+    }
+
+    orderStale = true;
+}
+
+void TransformSystem::SetReadOnly(bool readOnly)
+{
+    if (readOnly == this->readOnly)
+        return;
+
+    if (readOnly)
+    {
+        // with nothing dirty queries don't write
+        Update();
+        violationReported = false;
+        this->readOnly = true;
+        return;
+    }
+
+    this->readOnly = false;
+    for (uint32_t slot : deferredRemoves)
+        Remove(slot);
+    for (uint32_t slot : deferredDirty)
+        MarkDirty(slot);
+    if (deferredHierarchyChange)
+        HierarchyChanged();
+    deferredRemoves.clear();
+    deferredDirty.clear();
+    deferredHierarchyChange = false;
+}
+
+void TransformSystem::ReportReadOnlyViolation(const char* change)
+{
+    if (violationReported)
+        return;
+
+    violationReported = true;
+    spdlog::error("TransformSystem: {} while transforms are read from several threads", change);
+}
+
+void TransformSystem::UpdateSlot(uint32_t slot)
+{
+    const LocalTransform& local = locals[slot];
+    uint32_t parent = parents[slot];
+    if (parent != NoParent)
+    {
+        worldMatrices[slot] = worldMatrices[parent] * local.ToMatrix();
+        worldRotations[slot] = local.rotation * worldRotations[parent];
+    }
+    else
+    {
+        worldMatrices[slot] = local.ToMatrix();
+        worldRotations[slot] = local.rotation;
+    }
+    dirty[slot] = 0;
+}
+
+void TransformSystem::Resolve(uint32_t slot)
+{
+    if (!dirty[slot])
+        return;
+
+    assert(!readOnly);
+    if (parents[slot] != NoParent)
+        Resolve(parents[slot]);
+    UpdateSlot(slot);
+}
+
+void TransformSystem::Update()
+{
+    if (readOnly)
+    {
+        std::scoped_lock lock(deferredMutex);
+        ReportReadOnlyViolation("Update was called");
+        return;
+    }
+
+    if (orderStale)
+        Rebuild();
+
+    // parents come first, their world transforms are up to date when a child reads them
+    for (uint32_t slot = 0; slot < owners.size(); ++slot)
+    {
+        if (dirty[slot])
+            UpdateSlot(slot);
+    }
+}
+
+void TransformSystem::Rebuild()
+{
+    std::vector<GameObject*> newOwners;
+    std::vector<LocalTransform> newLocals;
+    std::vector<uint32_t> newParents;
+    std::vector<uint32_t> newSubtreeEnds;
+    newOwners.reserve(owners.size());
+    newLocals.reserve(owners.size());
+    newParents.reserve(owners.size());
+    newSubtreeEnds.reserve(owners.size());
+
+    std::vector<uint8_t> visited(owners.size(), 0);
+    auto visit = [&](auto& self, GameObject* go, uint32_t parent) -> void
+    {
+        uint32_t oldSlot = go->transformSlot;
+        uint32_t newSlot = newOwners.size();
+        visited[oldSlot] = 1;
+        newOwners.push_back(go);
+        newLocals.push_back(locals[oldSlot]);
+        newParents.push_back(parent);
+        newSubtreeEnds.push_back(0);
+
+        for (GameObject* child : go->GetChildren())
+        {
+            if (child && child->transformSystem == this && !visited[child->transformSlot])
+                self(self, child, newSlot);
+        }
+        newSubtreeEnds[newSlot] = newOwners.size();
+    };
+
+    auto isRoot = [this](GameObject* go)
+    {
+        GameObject* parent = go->GetParent();
+        return parent == nullptr || parent->transformSystem != this;
+    };
+
+    for (uint32_t slot = 0; slot < owners.size(); ++slot)
+    {
+        if (owners[slot] && isRoot(owners[slot]))
+            visit(visit, owners[slot], NoParent);
+    }
+
+    // objects that aren't reachable from their parent (e.g. in the middle of a reparent) are kept as roots
+    for (uint32_t slot = 0; slot < owners.size(); ++slot)
+    {
+        if (owners[slot] && !visited[slot])
+            visit(visit, owners[slot], NoParent);
+    }
+
+    owners = std::move(newOwners);
+    locals = std::move(newLocals);
+    parents = std::move(newParents);
+    subtreeEnds = std::move(newSubtreeEnds);
+    for (uint32_t slot = 0; slot < owners.size(); ++slot)
+        owners[slot]->transformSlot = slot;
+
+    worldMatrices.resize(owners.size());
+    worldRotations.resize(owners.size());
+    dirty.assign(owners.size(), 1);
+    orderStale = false;
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <mutex>
+#include <span>
+#include <vector>
+
+class GameObject;
+
+// read and written together by the update sweep, so they are stored interleaved
+struct LocalTransform
+{
+    glm::vec3 position = glm::vec3(0);
+    glm::quat rotation = glm::quat(1, 0, 0, 0);
+    glm::vec3 scale = glm::vec3(1);
+
+    glm::mat4 ToMatrix() const
+    {
+        return glm::translate(glm::mat4(1), position) * glm::mat4_cast(rotation) * glm::scale(glm::mat4(1), scale);
+    }
+};
+
+// transforms of every GameObject in a scene stored in flat arrays, a GameObject only keeps its slot.
+// After a hierarchy change the arrays are reordered depth first: parents come before their children and a subtree is
+// a contiguous range, so marking a subtree dirty is a fill and the per frame update is one linear sweep
+class TransformSystem
+{
+public:
+    inline static const uint32_t NoParent = UINT32_MAX;
+
+    TransformSystem() = default;
+    TransformSystem(const TransformSystem& other) = delete;
+
+    uint32_t Add(GameObject* owner, const LocalTransform& local);
+    void Remove(uint32_t slot);
+    void SetOwner(uint32_t slot, GameObject* owner)
+    {
+        owners[slot] = owner;
+    }
+
+    LocalTransform& GetLocal(uint32_t slot)
+    {
+        return locals[slot];
+    }
+
+    const LocalTransform& GetLocal(uint32_t slot) const
+    {
+        return locals[slot];
+    }
+
+    // the local transform of slot changed, its subtree needs new world transforms
+    void MarkDirty(uint32_t slot);
+
+    // objects were reparented, slots and parents are rebuilt on the next Update
+    void HierarchyChanged();
+
+    // while the order is stale parents may be wrong, world transforms have to be computed through the GameObjects.
+    // Rebuilding on a query instead would make spawning objects that read their transforms quadratic
+    bool IsOrderStale() const
+    {
+        return orderStale;
+    }
+
+    // resolving a dirty slot writes its world transform and those of its dirty ancestors, so queries are main thread
+    // only. Inside SetReadOnly nothing is dirty and they are plain reads that any thread can make
+    const glm::mat4& GetWorldMatrix(uint32_t slot)
+    {
+        Resolve(slot);
+        return worldMatrices[slot];
+    }
+
+    const glm::quat& GetWorldRotation(uint32_t slot)
+    {
+        Resolve(slot);
+        return worldRotations[slot];
+    }
+
+    // brackets work that reads transforms from several threads, e.g. parallel ticks. Entering updates every world
+    // transform. A change in between is logged as an error and applied when it ends, world transforms don't move
+    // while they are read
+    void SetReadOnly(bool readOnly);
+
+    void Update();
+
+    // in hierarchy order, valid after Update
+    std::span<const glm::mat4> GetWorldMatrices() const
+    {
+        return worldMatrices;
+    }
+
+    std::span<GameObject* const> GetOwners() const
+    {
+        return owners;
+    }
+
+private:
+    std::vector<LocalTransform> locals;
+    std::vector<glm::mat4> worldMatrices;
+    std::vector<glm::quat> worldRotations;
+    std::vector<uint32_t> parents;
+    // one past the last slot of each subtree
+    std::vector<uint32_t> subtreeEnds;
+    // a dirty slot always has a dirty subtree, marking can stop at a slot that is already dirty
+    std::vector<uint8_t> dirty;
+    // nullptr for removed slots until the next rebuild
+    std::vector<GameObject*> owners;
+    bool orderStale = false;
+    bool readOnly = false;
+
+    // changes made while read only
+    std::mutex deferredMutex;
+    std::vector<uint32_t> deferredDirty;
+    std::vector<uint32_t> deferredRemoves;
+    bool deferredHierarchyChange = false;
+    bool violationReported = false;
+
+    // logs the first violation of a read only phase, deferredMutex is held
+    void ReportReadOnlyViolation(const char* change);
+    void Rebuild();
+    void Resolve(uint32_t slot);
+    void UpdateSlot(uint32_t slot);
+};
@@ -1,10 +1,17 @@
 #include "Texture.hpp"
+#include "AssetDatabase/Exporters/KtxExporter.hpp"
+#include "Core/TextureStreaming.hpp"
 #include "GfxDriver/GfxEnums.hpp"
 #include "GfxDriver/Vulkan/Internal/VKEnumMapper.hpp"
 #include "Libs/Image/ImageProcessing.hpp"
+#include "Libs/JobSystem.hpp"
+#include <algorithm>
+#include <chrono>
 #include <filesystem>
 #include <fstream>
 #include <sstream>
+#include <string_view>
+#include <utility>
 #define STB_IMAGE_IMPLEMENTATION
 #include "ThirdParty/stb/stb_image.h"
 #include <ktx.h>
@@ -47,6 +54,13 @@ Texture::~Texture()
     {
         delete[] desc.data;
     }
+
+    CancelTranscoding();
+    if (streamingSource != nullptr)
+    {
+        TextureStreaming::GetSingleton().Unregister(*this);
+        ktxTexture_Destroy(ktxTexture(streamingSource));
+    }
 }
 
 void Texture::CreateGfxImage(TextureDescription& texDesc)
@@ -85,18 +99,179 @@ Texture::Texture(KtxTexture texDesc, const UUID& uuid)
     SetUUID(uuid);
     ktx_uint8_t* imageData = texDesc.imageData;
     uint32_t imageByteSize = texDesc.byteSize;
-    LoadKtxTexture(imageData, imageByteSize);
+    LoadKtxTexture(imageData, imageByteSize, texDesc.streaming);
 }
 
 void Texture::Reload(Asset&& loaded)
 {
     Texture* newTex = static_cast<Texture*>(&loaded);
+    // a reload replaces the image right away instead of going through a placeholder again
+    newTex->FinishTranscoding(true);
+    CancelTranscoding();
+
     desc = newTex->desc;
     image = std::move(newTex->image);
+    imageVersion += 1;
+
+    auto& streaming = TextureStreaming::GetSingleton();
+    if (streamingSource != nullptr)
+    {
+        streaming.Unregister(*this);
+        ktxTexture_Destroy(ktxTexture(streamingSource));
+    }
+    streamingSource = std::exchange(newTex->streamingSource, nullptr);
+    residentMip = newTex->residentMip;
+    if (streamingSource != nullptr)
+    {
+        streaming.Unregister(*newTex);
+        streaming.Register(*this);
+    }
+
     Asset::Reload(std::move(loaded));
 }
 
-void Texture::LoadKtxTexture(ktxTexture2* texture, int gpuMipLevels)
+size_t Texture::GetMipChainByteSize(uint32_t firstMip)
+{
+    if (streamingSource == nullptr)
+        return 0;
+
+    size_t byteSize = 0;
+    for (uint32_t level = firstMip; level < streamingSource->numLevels; ++level)
+    {
+        byteSize += ktxTexture_GetImageSize(ktxTexture(streamingSource), level);
+    }
+    return byteSize;
+}
+
+size_t Texture::GetStreamingSourceByteSize()
+{
+    return streamingSource ? ktxTexture_GetDataSize(ktxTexture(streamingSource)) : 0;
+}
+
+bool Texture::SetResidentMip(uint32_t mip)
+{
+    if (streamingSource == nullptr)
+        return false;
+
+    mip = std::min(mip, streamingSource->numLevels - 1);
+    if (image != nullptr && mip == residentMip)
+        return true;
+
+    // the mips that are already resident are copied from the old image on the gpu, only the ones above them are
+    // uploaded from the ktx data. residentMip is the mip count while a placeholder is bound
+    uint32_t numLevels = streamingSource->numLevels;
+    uint32_t firstCopied = image != nullptr ? std::max(mip, residentMip) : numLevels;
+    std::vector<Gfx::ImageUploadRegion> regions;
+    for (uint32_t level = mip; level < firstCopied; ++level)
+    {
+        ktx_size_t offset = 0;
+        if (ktxTexture_GetImageOffset(ktxTexture(streamingSource), level, 0, 0, &offset) != KTX_SUCCESS)
+        {
+            spdlog::error("Texture-failed to get image offset of mip {}", level);
+            return false;
+        }
+        ktx_size_t byteSize = ktxTexture_GetImageSize(ktxTexture(streamingSource), level);
+        regions.push_back({offset, byteSize, level - mip, 0});
+    }
+
+    Gfx::ImageDescription imageDesc = desc.img;
+    imageDesc.width = std::max(desc.img.width >> mip, 1u);
+    imageDesc.height = std::max(desc.img.height >> mip, 1u);
+    imageDesc.mipLevels = numLevels - mip;
+    auto newImage = GetGfxDriver()->CreateImage(
+        imageDesc,
+        Gfx::ImageUsage::Texture | Gfx::ImageUsage::TransferSrc | Gfx::ImageUsage::TransferDst
+    );
+    newImage->SetName(GetName());
+
+    if (firstCopied < numLevels)
+    {
+        GetGfxDriver()->CopyImageMips(
+            *image,
+            *newImage,
+            firstCopied - residentMip,
+            firstCopied - mip,
+            numLevels - firstCopied
+        );
+    }
+    if (!regions.empty())
+        GetGfxDriver()->UploadImageRegions(*newImage, ktxTexture_GetData(ktxTexture(streamingSource)), regions);
+
+    // the old image is released through the driver's pending deletions, frames in flight can still sample it
+    image = std::move(newImage);
+    residentMip = mip;
+    imageVersion += 1;
+    return true;
+}
+
+bool Texture::FinishTranscoding(bool wait, size_t* uploadedBytes)
+{
+    if (transcodingSource == nullptr)
+        return true;
+
+    if (!wait && transcodeJob.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+        return false;
+
+    TextureStreaming::GetSingleton().RemoveTranscoding(*this);
+    ktxTexture2* texture = std::exchange(transcodingSource, nullptr);
+    try
+    {
+        transcodeJob.get();
+    }
+    catch (const std::exception& e)
+    {
+        // the placeholder stays
+        spdlog::error("Texture-failed to transcode {}: {}", GetName(), e.what());
+        ktxTexture_Destroy(ktxTexture(texture));
+        return true;
+    }
+
+    size_t byteSize = ktxTexture_GetDataSize(ktxTexture(texture));
+    FinishKtxTexture(texture, transcodingStreamed);
+    if (uploadedBytes != nullptr)
+        *uploadedBytes = IsStreamed() ? GetMipChainByteSize(residentMip) : byteSize;
+    return true;
+}
+
+void Texture::CancelTranscoding()
+{
+    if (transcodingSource == nullptr)
+        return;
+
+    TextureStreaming::GetSingleton().RemoveTranscoding(*this);
+    // the job writes into the ktx texture until it returns
+    transcodeJob.wait();
+    ktxTexture_Destroy(ktxTexture(std::exchange(transcodingSource, nullptr)));
+}
+
+void Texture::CreatePlaceholderImage()
+{
+    Gfx::ImageDescription placeholderDesc(
+        1,
+        1,
+        1,
+        Gfx::ImageFormat::R8G8B8A8_UNorm,
+        Gfx::MultiSampling::Sample_Count_1,
+        1,
+        desc.img.isCubemap
+    );
+    image = GetGfxDriver()->CreateImage(placeholderDesc, Gfx::ImageUsage::Texture | Gfx::ImageUsage::TransferDst);
+    image->SetName(GetName());
+
+    // mid gray, reads as a flat normal when only xy are used
+    uint8_t pixels[6][4];
+    std::vector<Gfx::ImageUploadRegion> regions;
+    for (uint32_t layer = 0; layer < placeholderDesc.GetLayer(); ++layer)
+    {
+        pixels[layer][0] = pixels[layer][1] = pixels[layer][2] = 128;
+        pixels[layer][3] = 255;
+        regions.push_back({layer * sizeof(pixels[0]), sizeof(pixels[0]), 0, layer});
+    }
+    GetGfxDriver()->UploadImageRegions(*image, (uint8_t*)pixels, regions);
+    imageVersion += 1;
+}
+
+void Texture::TranscodeKtxTexture(ktxTexture2* texture)
 {
     if (ktxTexture2_NeedsTranscoding(texture))
     {
@@ -114,13 +289,27 @@ void Texture::LoadKtxTexture(ktxTexture2* texture, int gpuMipLevels)
             throw std::runtime_error("Texture-failed to create ktx texture");
         }
 
+        // normal maps are stored as RRRG and only keep xy, BC5 takes its two channels from r and alpha and spends all
+        // of its bits on them
+        char* normalMap = nullptr;
+        unsigned int normalMapLen = 0;
+        bool isNormalMap =
+            ktxHashList_FindValue(
+                &texture->kvDataHead,
+                Exporters::KtxExporter::normalMapKey,
+                &normalMapLen,
+                (void**)&normalMap
+            ) == KTX_SUCCESS;
+
         ktx_texture_transcode_fmt_e tf;
         auto& gpuFeatures = GetGfxDriver()->GetGPUFeatures();
         switch (compressionMode)
         {
             case CompressionMode::ETC1S:
                 {
-                    if (gpuFeatures.textureCompressionETC2)
+                    if (isNormalMap && gpuFeatures.textureCompressionBC)
+                        tf = KTX_TTF_BC5_RG;
+                    else if (gpuFeatures.textureCompressionETC2)
                         tf = KTX_TTF_ETC2_RGBA;
                     else if (gpuFeatures.textureCompressionBC)
                         tf = KTX_TTF_BC3_RGBA;
@@ -133,7 +322,9 @@ void Texture::LoadKtxTexture(ktxTexture2* texture, int gpuMipLevels)
                 }
             case CompressionMode::UASTC:
                 {
-                    if (gpuFeatures.textureCompressionASTC4x4)
+                    if (isNormalMap && gpuFeatures.textureCompressionBC)
+                        tf = KTX_TTF_BC5_RG;
+                    else if (gpuFeatures.textureCompressionASTC4x4)
                         tf = KTX_TTF_ASTC_4x4_RGBA;
                     else if (gpuFeatures.textureCompressionBC)
                         tf = KTX_TTF_BC7_RGBA;
@@ -151,7 +342,10 @@ void Texture::LoadKtxTexture(ktxTexture2* texture, int gpuMipLevels)
             throw std::runtime_error("failed to transcode ktx texture");
         }
     }
+}
 
+void Texture::SetKtxDescription(ktxTexture2* texture, int gpuMipLevels)
+{
     desc.img.isCubemap = texture->isCubemap;
     desc.img.width = texture->baseWidth;
     desc.img.height = texture->baseHeight;
@@ -159,17 +353,48 @@ void Texture::LoadKtxTexture(ktxTexture2* texture, int gpuMipLevels)
     desc.img.format = Gfx::MapVKFormat(ktxTexture2_GetVkFormat(texture));
     desc.img.multiSampling = Gfx::MultiSampling::Sample_Count_1;
     desc.data = nullptr;
+}
+
+void Texture::LoadKtxTexture(ktxTexture2* texture, int gpuMipLevels)
+{
+    TranscodeKtxTexture(texture);
+    SetKtxDescription(texture, gpuMipLevels);
+    UploadKtxTexture(texture);
+}
+
+void Texture::FinishKtxTexture(ktxTexture2* texture, bool streamed)
+{
+    SetKtxDescription(texture, texture->numLevels);
+    if (streamed)
+    {
+        streamingSource = texture;
+        // a placeholder may be bound, it holds none of the mips
+        residentMip = texture->numLevels;
+
+        uint32_t minResidentMips = TextureStreaming::GetSingleton().GetMinResidentMips();
+        SetResidentMip(texture->numLevels > minResidentMips ? texture->numLevels - minResidentMips : 0);
+        TextureStreaming::GetSingleton().Register(*this);
+        return;
+    }
+
+    UploadKtxTexture(texture);
+    imageVersion += 1;
+    ktxTexture_Destroy(ktxTexture(texture)); // https://github.khronos.org/KTX-Software/libktx/index.html#readktx
+}
 
+void Texture::UploadKtxTexture(ktxTexture2* texture)
+{
     image = Gfx::GfxDriver::Instance()->CreateImage(desc.img, Gfx::ImageUsage::Texture | Gfx::ImageUsage::TransferDst);
 
     ktx_uint8_t* data = ktxTexture_GetData(ktxTexture(texture));
-    size_t byteSize = ktxTexture_GetDataSize(ktxTexture(texture));
     if (texture->numDimensions == 1)
     {
         throw std::runtime_error("Texture-numDimensions not implemented");
     }
     else if (texture->numDimensions == 2)
     {
+        // every level, layer and face goes into the staging buffer at once
+        std::vector<Gfx::ImageUploadRegion> regions;
         for (uint32_t level = 0; level < texture->numLevels; ++level)
         {
             for (uint32_t layer = 0; layer < texture->numLayers; ++layer)
@@ -181,10 +406,11 @@ void Texture::LoadKtxTexture(ktxTexture2* texture, int gpuMipLevels)
                         throw std::runtime_error("Texture-failed to get image offset");
                     ktx_size_t byteSize = ktxTexture_GetImageSize(ktxTexture(texture), level);
 
-                    GetGfxDriver()->UploadImage(*image, data + offset, byteSize, level, layer + face);
+                    regions.push_back({offset, byteSize, level, layer + face});
                 }
             }
         }
+        GetGfxDriver()->UploadImageRegions(*image, data, regions);
     }
     else
     {
@@ -192,7 +418,7 @@ void Texture::LoadKtxTexture(ktxTexture2* texture, int gpuMipLevels)
     }
 }
 
-void Texture::LoadKtxTexture(uint8_t* imageData, size_t imageByteSize)
+void Texture::LoadKtxTexture(uint8_t* imageData, size_t imageByteSize, bool streaming)
 {
     if (IsKTX2File(imageData))
     {
@@ -208,8 +434,29 @@ void Texture::LoadKtxTexture(uint8_t* imageData, size_t imageByteSize)
             throw std::runtime_error("Texture-Failed to create texture from memory");
         }
 
-        LoadKtxTexture(texture, texture->numLevels);
-        ktxTexture_Destroy(ktxTexture(texture)); // https://github.khronos.org/KTX-Software/libktx/index.html#readktx
+        // cubemaps and arrays are always fully resident
+        bool streamed = streaming && texture->numLevels > 1 && texture->numDimensions == 2 &&
+                        texture->numLayers == 1 && texture->numFaces == 1;
+
+        // basis transcoding is the slow part of loading, it runs on a worker and TextureStreaming uploads the result
+        // once it's done. Loading doesn't wait for it, textures that are drawn meanwhile sample a placeholder
+        if (ktxTexture2_NeedsTranscoding(texture) && texture->numDimensions == 2)
+        {
+            desc.img.isCubemap = texture->isCubemap;
+            desc.img.width = texture->baseWidth;
+            desc.img.height = texture->baseHeight;
+            desc.img.mipLevels = texture->numLevels;
+            CreatePlaceholderImage();
+
+            transcodingSource = texture;
+            transcodingStreamed = streamed;
+            transcodeJob = JobSystem::GetSingleton().Schedule([texture]() { TranscodeKtxTexture(texture); });
+            TextureStreaming::GetSingleton().AddTranscoding(*this);
+            return;
+        }
+
+        TranscodeKtxTexture(texture);
+        FinishKtxTexture(texture, streamed);
     }
 }
 
@@ -295,6 +542,10 @@ void Texture::LoadStbSupoprtedTexture(uint8_t* data, size_t byteSize, Gfx::Image
     {
         loaded = (stbi_uc*)stbi_loadf_from_memory(data, (int)byteSize, &width, &height, &channels, desiredChannels);
     }
+    else if (is16Bit)
+    {
+        loaded = (stbi_uc*)stbi_load_16_from_memory(data, (int)byteSize, &width, &height, &channels, desiredChannels);
+    }
     else
     {
         loaded = stbi_load_from_memory(data, (int)byteSize, &width, &height, &channels, desiredChannels);
@@ -309,39 +560,32 @@ void Texture::LoadStbSupoprtedTexture(uint8_t* data, size_t byteSize, Gfx::Image
     texDesc.img.isCubemap = false;
 
     size_t mippedDataByteSize = 0;
-    size_t elementSize = 0;
+    Libs::Image::ChannelType channelType = Libs::Image::ChannelType::UInt8;
     if (isHDR)
-    {
-        uint8_t* data;
-        elementSize = sizeof(float);
-        Libs::Image::GenerateBoxFilteredMipmap<
-            float>(loaded, width, height, 1, (int)texDesc.img.mipLevels, desiredChannels, data, mippedDataByteSize);
-        texDesc.data = data;
-        stbi_image_free(loaded);
-    }
+        channelType = Libs::Image::ChannelType::Float;
     else if (is16Bit)
-    {
-        throw std::exception("Not implemented");
-    }
-    else
-    {
-        uint8_t* data;
-        size_t s = texDesc.img.GetByteSize();
-
-        elementSize = sizeof(uint8_t);
-        Libs::Image::GenerateBoxFilteredMipmap<uint8_t>(
-            (uint8_t*)loaded,
-            width,
-            height,
-            1,
-            (int)texDesc.img.mipLevels,
-            desiredChannels,
-            data,
-            mippedDataByteSize
-        );
-        texDesc.data = (uint8_t*)data;
-        stbi_image_free(loaded);
-    }
+        channelType = Libs::Image::ChannelType::UInt16;
+    size_t elementSize = Libs::Image::GetChannelTypeByteSize(channelType);
+
+    // 8 bit textures default to srgb formats below
+    std::string_view formatName = format == Gfx::ImageFormat::Invalid ? "SRGB" : Gfx::MapImageFormatToString(format);
+    bool srgb = channelType == Libs::Image::ChannelType::UInt8 && formatName.find("SRGB") != std::string_view::npos;
+
+    uint8_t* mipData;
+    Libs::Image::GenerateBoxFilteredMipmap(
+        (uint8_t*)loaded,
+        width,
+        height,
+        1,
+        (int)texDesc.img.mipLevels,
+        desiredChannels,
+        channelType,
+        srgb,
+        mipData,
+        mippedDataByteSize
+    );
+    texDesc.data = mipData;
+    stbi_image_free(loaded);
 
     if (format == Gfx::ImageFormat::Invalid)
     {
@@ -350,7 +594,7 @@ void Texture::LoadStbSupoprtedTexture(uint8_t* data, size_t byteSize, Gfx::Image
             if (isHDR)
                 format = Gfx::ImageFormat::R32G32B32A32_SFloat;
             else if (is16Bit)
-                format = Gfx::ImageFormat::R16G16B16A16_SFloat;
+                format = Gfx::ImageFormat::R16G16B16A16_UNorm;
             else
                 format = Gfx::ImageFormat::R8G8B8A8_SRGB;
         }
@@ -359,7 +603,7 @@ void Texture::LoadStbSupoprtedTexture(uint8_t* data, size_t byteSize, Gfx::Image
             if (isHDR)
                 format = Gfx::ImageFormat::R32G32B32_SFloat;
             else if (is16Bit)
-                format = Gfx::ImageFormat::R16G16B16_SFloat;
+                format = Gfx::ImageFormat::R16G16B16_UNorm;
             else
                 format = Gfx::ImageFormat::R8G8B8_SRGB;
         }
@@ -368,7 +612,7 @@ void Texture::LoadStbSupoprtedTexture(uint8_t* data, size_t byteSize, Gfx::Image
             if (isHDR)
                 format = Gfx::ImageFormat::R32G32_SFloat;
             else if (is16Bit)
-                format = Gfx::ImageFormat::R16G16_SFloat;
+                format = Gfx::ImageFormat::R16G16_UNorm;
             else
                 format = Gfx::ImageFormat::R8G8_SRGB;
         }
@@ -377,7 +621,7 @@ void Texture::LoadStbSupoprtedTexture(uint8_t* data, size_t byteSize, Gfx::Image
             if (isHDR)
                 format = Gfx::ImageFormat::R32_SFloat;
             else if (is16Bit)
-                format = Gfx::ImageFormat::R16_SFloat;
+                format = Gfx::ImageFormat::R16_UNorm;
             else
                 format = Gfx::ImageFormat::R8_SRGB;
         }
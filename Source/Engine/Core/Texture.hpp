@@ -1,6 +1,7 @@
 #pragma once
 #include "Asset.hpp"
 #include "GfxDriver/GfxDriver.hpp"
+#include <future>
 #include <ktx.h>
 
 struct TextureDescription
@@ -18,6 +19,8 @@ struct KtxTexture
 {
     ktx_uint8_t* imageData;
     size_t byteSize;
+    // only the smallest mips are uploaded, TextureStreaming brings in the rest when the texture is drawn
+    bool streaming = false;
 };
 
 enum class ImageDataType
@@ -48,6 +51,37 @@ public:
     {
         return image.get();
     };
+    // changes every time the gfx image is replaced (reloads, streaming), users holding the image rebind on change
+    uint64_t GetImageVersion()
+    {
+        return imageVersion;
+    }
+    bool IsStreamed()
+    {
+        return streamingSource != nullptr;
+    }
+    // basis textures are transcoded on the job system, a 1x1 placeholder is bound until the transcode is finished
+    bool IsTranscoding()
+    {
+        return transcodingSource != nullptr;
+    }
+    // uploads the transcoded data if the job is done, wait blocks until it is. Returns false while still transcoding
+    bool FinishTranscoding(bool wait, size_t* uploadedBytes = nullptr);
+    uint32_t GetMipCount()
+    {
+        return streamingSource ? streamingSource->numLevels : desc.img.mipLevels;
+    }
+    // the highest mip on the gpu, the gfx image's mip 0 is this mip of the texture
+    uint32_t GetResidentMip()
+    {
+        return residentMip;
+    }
+    size_t GetMipChainByteSize(uint32_t firstMip);
+    // the ktx data of every mip a streamed texture keeps in ram to upload from
+    size_t GetStreamingSourceByteSize();
+    // recreates the gfx image with the mips from mip down to the smallest one, only for streamed textures. Mips that
+    // were resident are copied on the gpu, the others are uploaded
+    bool SetResidentMip(uint32_t mip);
     const TextureDescription& GetDescription()
     {
         return desc;
@@ -67,8 +101,26 @@ public:
 private:
     TextureDescription desc;
     std::unique_ptr<Gfx::Image> image;
-    void LoadKtxTexture(uint8_t* data, size_t byteSize);
+    uint64_t imageVersion = 0;
+
+    // transcoded ktx data of streamed textures
+    ktxTexture2* streamingSource = nullptr;
+    uint32_t residentMip = 0;
+
+    ktxTexture2* transcodingSource = nullptr;
+    bool transcodingStreamed = false;
+    std::future<void> transcodeJob;
+
+    void LoadKtxTexture(uint8_t* data, size_t byteSize, bool streaming = false);
     void LoadKtxTexture(ktxTexture2* texture, int gpuMipLevels);
+    // takes ownership of the transcoded texture
+    void FinishKtxTexture(ktxTexture2* texture, bool streamed);
+    void UploadKtxTexture(ktxTexture2* texture);
+    void CreatePlaceholderImage();
+    void CancelTranscoding();
+    void SetKtxDescription(ktxTexture2* texture, int gpuMipLevels);
+    // only touches texture, safe to call from worker threads
+    static void TranscodeKtxTexture(ktxTexture2* texture);
     void LoadStbSupoprtedTexture(uint8_t* data, size_t byteSize, Gfx::ImageFormat format);
     void ConvertRawImageToKtx(TextureDescription& desc);
     void CreateGfxImage(TextureDescription& texDesc);
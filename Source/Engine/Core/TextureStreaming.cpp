@@ -0,0 +1,256 @@
+#include "TextureStreaming.hpp"
+#include "Texture.hpp"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+TextureStreaming& TextureStreaming::GetSingleton()
+{
+    static TextureStreaming textureStreaming;
+    return textureStreaming;
+}
+
+void TextureStreaming::Register(Texture& texture)
+{
+    std::scoped_lock lock(mutex);
+    entries[&texture] = Entry{GetLowestMip(texture), frame};
+}
+
+void TextureStreaming::Unregister(Texture& texture)
+{
+    std::scoped_lock lock(mutex);
+    entries.erase(&texture);
+}
+
+void TextureStreaming::AddTranscoding(Texture& texture)
+{
+    std::scoped_lock lock(mutex);
+    transcoding[&texture] = 0;
+}
+
+void TextureStreaming::RemoveTranscoding(Texture& texture)
+{
+    std::scoped_lock lock(mutex);
+    transcoding.erase(&texture);
+}
+
+void TextureStreaming::RequestMip(Texture& texture, uint32_t mip)
+{
+    std::scoped_lock lock(mutex);
+    auto iter = entries.find(&texture);
+    if (iter == entries.end())
+    {
+        auto transcodingIter = transcoding.find(&texture);
+        if (transcodingIter != transcoding.end())
+            transcodingIter->second = frame;
+        return;
+    }
+
+    // several renderers can draw the same texture in a frame, the most detailed request wins
+    Entry& entry = iter->second;
+    if (entry.lastRequestedFrame == frame)
+        entry.requestedMip = std::min(entry.requestedMip, mip);
+    else
+        entry.requestedMip = mip;
+    entry.lastRequestedFrame = frame;
+}
+
+void TextureStreaming::RequestScreenSize(Texture& texture, float screenPixels)
+{
+    auto& desc = texture.GetDescription().img;
+    float textureSize = std::max(desc.width, desc.height);
+    float mip = std::floor(std::log2(textureSize / std::max(screenPixels, 1.0f)));
+    RequestMip(texture, mip > 0 ? (uint32_t)mip : 0);
+}
+
+uint32_t TextureStreaming::GetWantedMip(Texture& texture)
+{
+    std::scoped_lock lock(mutex);
+    auto iter = entries.find(&texture);
+    if (iter == entries.end())
+        return 0;
+
+    return GetWantedMip(texture, iter->second);
+}
+
+TextureStreamingStats TextureStreaming::GetStats()
+{
+    std::scoped_lock lock(mutex);
+    return stats;
+}
+
+uint32_t TextureStreaming::GetLowestMip(Texture& texture)
+{
+    uint32_t mipCount = texture.GetMipCount();
+    return mipCount > minResidentMips ? mipCount - minResidentMips : 0;
+}
+
+uint32_t TextureStreaming::GetWantedMip(Texture& texture, const Entry& entry)
+{
+    uint32_t lowest = GetLowestMip(texture);
+    if (frame - entry.lastRequestedFrame > requestTimeout)
+        return lowest;
+
+    return std::min(entry.requestedMip, lowest);
+}
+
+size_t TextureStreaming::FinishTranscodes()
+{
+    std::vector<std::pair<Texture*, uint64_t>> candidates;
+    {
+        std::scoped_lock lock(mutex);
+        candidates.assign(transcoding.begin(), transcoding.end());
+    }
+    std::sort(candidates.begin(), candidates.end(), [](auto& a, auto& b) { return a.second > b.second; });
+
+    // shares the upload limit with mip upgrades, the first one always goes through
+    size_t uploadedBytes = 0;
+    for (auto& [texture, lastRequestedFrame] : candidates)
+    {
+        if (uploadedBytes >= uploadLimitPerFrame)
+            break;
+
+        size_t bytes = 0;
+        if (texture->FinishTranscoding(false, &bytes))
+            uploadedBytes += bytes;
+    }
+
+    return uploadedBytes;
+}
+
+void TextureStreaming::Update()
+{
+    size_t transcodeUploadedBytes = FinishTranscodes();
+
+    std::scoped_lock lock(mutex);
+
+    // requests made while rendering the last frame are tagged with frame - 1 from here on
+    frame += 1;
+
+    struct Upgrade
+    {
+        Texture* texture;
+        uint64_t lastRequestedFrame;
+        uint32_t wantedMip;
+    };
+    std::vector<Upgrade> upgrades;
+    size_t residentBytes = 0;
+    size_t requestedBytes = 0;
+    size_t sourceBytes = 0;
+    for (auto& [texture, entry] : entries)
+    {
+        uint32_t wanted = GetWantedMip(*texture, entry);
+        uint32_t resident = texture->GetResidentMip();
+        residentBytes += texture->GetMipChainByteSize(resident);
+        requestedBytes += texture->GetMipChainByteSize(wanted);
+        sourceBytes += texture->GetStreamingSourceByteSize();
+        if (wanted < resident)
+            upgrades.push_back({texture, entry.lastRequestedFrame, wanted});
+    }
+
+    // recently requested textures go first, among them the ones furthest away from what they want
+    std::sort(
+        upgrades.begin(),
+        upgrades.end(),
+        [](const Upgrade& a, const Upgrade& b)
+        {
+            if (a.lastRequestedFrame != b.lastRequestedFrame)
+                return a.lastRequestedFrame > b.lastRequestedFrame;
+            return a.texture->GetResidentMip() - a.wantedMip > b.texture->GetResidentMip() - b.wantedMip;
+        }
+    );
+
+    stats.uploadedBytes = transcodeUploadedBytes;
+    stats.evictedTextures = 0;
+    stats.pendingTextures = 0;
+    for (auto& upgrade : upgrades)
+    {
+        Texture& texture = *upgrade.texture;
+        uint32_t resident = texture.GetResidentMip();
+        size_t residentChainBytes = texture.GetMipChainByteSize(resident);
+        size_t uploadLeft = uploadLimitPerFrame > stats.uploadedBytes ? uploadLimitPerFrame - stats.uploadedBytes : 0;
+
+        // only the mips above the resident ones are uploaded, a texture whose new mips don't fit in what is left of
+        // this frame's upload limit moves one mip closer instead
+        uint32_t target = upgrade.wantedMip;
+        while (target + 1 < resident && texture.GetMipChainByteSize(target) - residentChainBytes > uploadLeft)
+            target += 1;
+
+        // the first upload of a frame always goes through so that large textures can't stall forever
+        size_t extraBytes = texture.GetMipChainByteSize(target) - residentChainBytes;
+        if (extraBytes > uploadLeft && stats.uploadedBytes != 0)
+        {
+            stats.pendingTextures += 1;
+            continue;
+        }
+
+        if (residentBytes + extraBytes > budget)
+            residentBytes -= Evict(residentBytes + extraBytes - budget, upgrade.lastRequestedFrame, &texture);
+        if (residentBytes + extraBytes > budget || !texture.SetResidentMip(target))
+        {
+            stats.pendingTextures += 1;
+            continue;
+        }
+
+        residentBytes += extraBytes;
+        stats.uploadedBytes += extraBytes;
+        if (target != upgrade.wantedMip)
+            stats.pendingTextures += 1;
+    }
+
+    // the budget may have been lowered, only textures drawn in the last frame keep the mips they asked for
+    if (residentBytes > budget)
+        residentBytes -= Evict(residentBytes - budget, frame - 1, nullptr);
+
+    stats.streamedTextures = entries.size();
+    stats.transcodingTextures = transcoding.size();
+    stats.residentBytes = residentBytes;
+    stats.requestedBytes = requestedBytes;
+    stats.sourceBytes = sourceBytes;
+    stats.budgetBytes = budget;
+}
+
+size_t TextureStreaming::Evict(size_t bytes, uint64_t protectFrame, Texture* keep)
+{
+    std::vector<std::pair<Texture*, const Entry*>> candidates;
+    for (auto& [texture, entry] : entries)
+    {
+        if (texture != keep)
+            candidates.push_back({texture, &entry});
+    }
+
+    // least recently needed first
+    std::sort(
+        candidates.begin(),
+        candidates.end(),
+        [](auto& a, auto& b) { return a.second->lastRequestedFrame < b.second->lastRequestedFrame; }
+    );
+
+    size_t freed = 0;
+    for (auto& [texture, entry] : candidates)
+    {
+        if (freed >= bytes)
+            break;
+
+        uint32_t resident = texture->GetResidentMip();
+        uint32_t lowest = entry->lastRequestedFrame < protectFrame ? GetLowestMip(*texture)
+                                                                   : GetWantedMip(*texture, *entry);
+        if (resident >= lowest)
+            continue;
+
+        // only drop as many of the highest mips as needed
+        size_t residentBytes = texture->GetMipChainByteSize(resident);
+        uint32_t target = resident + 1;
+        while (target < lowest && residentBytes - texture->GetMipChainByteSize(target) < bytes - freed)
+            target += 1;
+
+        size_t targetBytes = texture->GetMipChainByteSize(target);
+        if (texture->SetResidentMip(target))
+        {
+            freed += residentBytes - targetBytes;
+            stats.evictedTextures += 1;
+        }
+    }
+
+    return freed;
+}
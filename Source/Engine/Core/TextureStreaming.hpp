@@ -0,0 +1,111 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+
+class Texture;
+
+struct TextureStreamingStats
+{
+    uint32_t streamedTextures = 0;
+    // bytes of the resident mips of streamed textures
+    size_t residentBytes = 0;
+    // bytes the streamed textures would use if every request was honored
+    size_t requestedBytes = 0;
+    size_t budgetBytes = 0;
+    // ram of the ktx data the streamed textures keep to upload mips from, it holds every mip and isn't in the budget
+    size_t sourceBytes = 0;
+    // textures that still wait for higher mips
+    uint32_t pendingTextures = 0;
+    // basis textures whose transcode job isn't finished yet
+    uint32_t transcodingTextures = 0;
+
+    // the last Update, mips that stay resident are copied on the gpu and don't count
+    size_t uploadedBytes = 0;
+    uint32_t evictedTextures = 0;
+};
+
+// decides which mips of the streamed textures are on the gpu. Streamed textures start with their smallest mips,
+// renderers request a mip every frame they draw a texture and Update uploads the missing mips a few textures per frame.
+// When the budget runs out the highest mips of the textures that were needed least recently are dropped
+class TextureStreaming
+{
+public:
+    static TextureStreaming& GetSingleton();
+
+    void Register(Texture& texture);
+    void Unregister(Texture& texture);
+
+    // textures that sample a placeholder until their transcode job is done, Update uploads the finished ones with the
+    // recently drawn first
+    void AddTranscoding(Texture& texture);
+    void RemoveTranscoding(Texture& texture);
+
+    void RequestMip(Texture& texture, uint32_t mip);
+    // requests the mip whose size is closest to how many pixels the texture covers on screen
+    void RequestScreenSize(Texture& texture, float screenPixels);
+
+    // called once per frame before rendering
+    void Update();
+
+    void SetBudget(size_t bytes)
+    {
+        budget = bytes;
+    }
+
+    size_t GetBudget()
+    {
+        return budget;
+    }
+
+    void SetUploadLimitPerFrame(size_t bytes)
+    {
+        uploadLimitPerFrame = bytes;
+    }
+
+    // streamed textures always keep this many of their smallest mips resident
+    void SetMinResidentMips(uint32_t count)
+    {
+        minResidentMips = count > 0 ? count : 1;
+    }
+
+    uint32_t GetMinResidentMips()
+    {
+        return minResidentMips;
+    }
+
+    // the mip the texture asked for recently, or its smallest resident mip if it hasn't been drawn for a while
+    uint32_t GetWantedMip(Texture& texture);
+
+    TextureStreamingStats GetStats();
+
+private:
+    struct Entry
+    {
+        uint32_t requestedMip = 0;
+        uint64_t lastRequestedFrame = 0;
+    };
+
+    std::mutex mutex;
+    std::unordered_map<Texture*, Entry> entries;
+    // last requested frame of the textures that are transcoding
+    std::unordered_map<Texture*, uint64_t> transcoding;
+    uint64_t frame = 0;
+
+    size_t budget = 512 * 1024 * 1024;
+    size_t uploadLimitPerFrame = 16 * 1024 * 1024;
+    uint32_t minResidentMips = 4;
+    // frames after the last request before a texture falls back to its smallest mips
+    uint64_t requestTimeout = 60;
+
+    TextureStreamingStats stats;
+
+    uint32_t GetWantedMip(Texture& texture, const Entry& entry);
+    uint32_t GetLowestMip(Texture& texture);
+    // returns the uploaded bytes, runs without the lock because finishing a texture registers it
+    size_t FinishTranscodes();
+    // drops mips until at least bytes are freed, textures requested at or after protectFrame only drop the mips they
+    // don't want
+    size_t Evict(size_t bytes, uint64_t protectFrame, Texture* keep);
+};
@@ -39,6 +39,10 @@ public:
     void Serialize(Serializer* s) const override;
     void Deserialize(Serializer* s) override;
     const std::string& GetName() override;
+    UpdatePhaseFlags GetUpdatePhases() override
+    {
+        return UpdatePhase::PrePhysics | UpdatePhase::Update;
+    }
     void PrePhysicsTick() override;
     void Tick() override;
 
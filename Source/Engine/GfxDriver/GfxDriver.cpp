@@ -32,6 +32,21 @@ GfxDriver*& GfxDriver::InstanceInternal()
     return gfxDriver;
 }
 
+const char* GPUMemoryCategoryToString(GPUMemoryCategory category)
+{
+    switch (category)
+    {
+        case GPUMemoryCategory::Texture: return "Texture";
+        case GPUMemoryCategory::RenderTarget: return "RenderTarget";
+        case GPUMemoryCategory::VertexIndex: return "VertexIndex";
+        case GPUMemoryCategory::Uniform: return "Uniform";
+        case GPUMemoryCategory::Storage: return "Storage";
+        case GPUMemoryCategory::Staging: return "Staging";
+        case GPUMemoryCategory::Other: return "Other";
+        default: return "Unknown";
+    }
+}
+
 std::unique_ptr<Buffer> GfxDriver::CreateBuffer(
     size_t size, BufferUsageFlags usages, bool visibleInCPU, bool gpuWrite, const char* debugName
 )
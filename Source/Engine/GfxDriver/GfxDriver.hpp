@@ -14,9 +14,12 @@
 #include "Window.hpp"
 
 #include <SDL.h>
+#include <array>
+#include <filesystem>
 #include <glm/glm.hpp>
 #include <memory>
 #include <span>
+#include <string>
 #include <unordered_map>
 #include <vector>
 #include <vulkan/vulkan.h>
@@ -52,6 +55,66 @@ enum class GfxEvent
     SwapchainRecreated
 };
 
+struct PipelineCompileStats
+{
+    // compiles that blocked the render thread, each one is a potential hitch
+    uint32_t stutterEvents = 0;
+    uint32_t asyncCompiles = 0;
+    // compiles that are still running on worker threads, loading screens can wait for this to reach 0
+    uint32_t pendingCompiles = 0;
+    // draws dropped because their pipeline wasn't ready yet
+    uint32_t skippedDraws = 0;
+};
+
+struct FrameScheduleStats
+{
+    // cpu time spent working out barriers and layouts for the last frame
+    float scheduleMs = 0;
+    // command buffers whose barriers were replayed from an earlier identical frame
+    uint32_t reusedPlans = 0;
+    uint32_t rebuiltPlans = 0;
+};
+
+// what a gpu allocation is used for, images with attachment or storage usage count as render targets
+enum class GPUMemoryCategory
+{
+    Texture,
+    RenderTarget,
+    VertexIndex,
+    Uniform,
+    Storage,
+    Staging,
+    Other,
+    Count
+};
+
+const char* GPUMemoryCategoryToString(GPUMemoryCategory category);
+
+struct GPUMemoryHeapBudget
+{
+    bool deviceLocal = false;
+    // bytes allocated from the heap by this process and how much it can allocate before the driver starts to evict
+    uint64_t usage = 0;
+    uint64_t budget = 0;
+};
+
+struct GPUMemoryStats
+{
+    std::array<uint64_t, (size_t)GPUMemoryCategory::Count> bytes{};
+    std::array<uint32_t, (size_t)GPUMemoryCategory::Count> allocations{};
+    uint64_t totalBytes = 0;
+    std::vector<GPUMemoryHeapBudget> heaps;
+};
+
+// one subresource of an UploadImageRegions call, offset is relative to the uploaded data
+struct ImageUploadRegion
+{
+    size_t offset;
+    size_t size;
+    uint32_t mipLevel;
+    uint32_t arrayLayer;
+};
+
 class GfxDriver
 {
 public:
@@ -59,6 +122,9 @@ public:
     {
         // the initial window size used to create sdl window
         SDL_Window* window;
+
+        // where compiled pipelines are persisted between runs, empty to disable
+        std::filesystem::path pipelineCachePath = "";
     };
 
     static RefPtr<GfxDriver> Instance();
@@ -126,8 +192,35 @@ public:
         uint32_t arayLayer = 0,
         Gfx::ImageAspect aspect = Gfx::ImageAspect::Color
     ) = 0;
+    // copies every region into the staging buffer at once so that the image is written by a single transfer instead
+    // of one per subresource
+    virtual void UploadImageRegions(
+        Gfx::Image& dst,
+        uint8_t* data,
+        std::span<const ImageUploadRegion> regions,
+        Gfx::ImageAspect aspect = Gfx::ImageAspect::Color
+    ) = 0;
+    // copies levelCount mips of src from srcMip on into dst from dstMip on without going through the cpu, recorded
+    // with the pending uploads. The mips need the same format and size in both images, src needs TransferSrc
+    virtual void CopyImageMips(
+        Gfx::Image& src, Gfx::Image& dst, uint32_t srcMip, uint32_t dstMip, uint32_t levelCount
+    ) = 0;
     virtual void GenerateMipmaps(Gfx::Image& image) = 0;
 
+    // starts compiling the pipelines of program with config on worker threads, for the render passes and subpasses
+    // program is drawn in, before anything draws with config. Called for the materials of a loaded scene,
+    // GetPipelineCompileStats().pendingCompiles tells when the work is done
+    virtual void PrewarmShaderProgram(Gfx::ShaderProgram& program, const Gfx::ShaderConfig& config) = 0;
+    virtual PipelineCompileStats GetPipelineCompileStats() = 0;
+    // when disabled every pipeline miss is compiled on the render thread
+    virtual void SetAsyncPipelineCompilation(bool enable) = 0;
+
+    virtual FrameScheduleStats GetFrameScheduleStats() = 0;
+
+    virtual GPUMemoryStats GetGPUMemoryStats() = 0;
+    // every live image and buffer grouped by category and debug name as json, two dumps can be diffed to find leaks
+    virtual std::string DumpGPUMemory() = 0;
+
     virtual Window* CreateExtraWindow(SDL_Window* window) = 0;
     virtual void DestroyExtraWindow(Window* window) = 0;
 
@@ -95,6 +95,8 @@ ImageFormat MapStringToImageFormat(std::string_view name)
         return ImageFormat::BC3_Unorm_Block;
     else if (name == "BC3_SRGB_Block")
         return ImageFormat::BC3_SRGB_Block;
+    else if (name == "BC5_UNorm_Block")
+        return ImageFormat::BC5_UNorm_Block;
     else if (name == "B10G11R11_UFloat_Pack32")
         return ImageFormat::B10G11R11_UFloat_Pack32;
     else if (name == "A2B10G10R10_UNorm")
@@ -115,6 +117,8 @@ ImageFormat MapStringToImageFormat(std::string_view name)
         return ImageFormat::R16G16B16_SFloat;
     else if (name == "R8_UNorm")
         return ImageFormat::R8_UNorm;
+    else if (name == "R16_UNorm")
+        return ImageFormat::R16_UNorm;
 
     return ImageFormat::Invalid;
 }
@@ -191,6 +195,8 @@ const char* MapImageFormatToString(ImageFormat format)
         return "BC3_Unorm_Block";
     else if (format == ImageFormat::BC3_SRGB_Block)
         return "BC3_SRGB_Block";
+    else if (format == ImageFormat::BC5_UNorm_Block)
+        return "BC5_UNorm_Block";
     else if (format == ImageFormat::B10G11R11_UFloat_Pack32)
         return "B10G11R11_UFloat_Pack32";
     else if (format == ImageFormat::A2B10G10R10_UNorm)
@@ -211,6 +217,8 @@ const char* MapImageFormatToString(ImageFormat format)
         return "R16G16B16_SFloat";
     else if (format == ImageFormat::R8_UNorm)
         return "R8_UNorm";
+    else if (format == ImageFormat::R16_UNorm)
+        return "R16_UNorm";
 
     return "Invalid";
 }
@@ -224,6 +232,7 @@ uint32_t MapImageFormatToByteSize(ImageFormat format)
         case ImageFormat::BC7_SRGB_UNorm_Block: return 16;
         case ImageFormat::BC3_Unorm_Block: return 16;
         case ImageFormat::BC3_SRGB_Block: return 16;
+        case ImageFormat::BC5_UNorm_Block: return 16;
         case ImageFormat::R16G16B16A16_SFloat: return 8;
         case ImageFormat::R32G32B32A32_SFloat: return 16;
         case ImageFormat::R16G16B16A16_UNorm: return 8;
@@ -237,6 +246,7 @@ uint32_t MapImageFormatToByteSize(ImageFormat format)
         case ImageFormat::R8_SRGB: return 1;
         case ImageFormat::R32_SFloat: return 4;
         case ImageFormat::R16_SFloat: return 2;
+        case ImageFormat::R16_UNorm: return 2;
         case ImageFormat::R16G16_UNorm: return 4;
         case ImageFormat::R16G16_SNorm: return 4;
         case ImageFormat::R16G16_UScaled: return 4;
@@ -310,16 +320,18 @@ ImageFormat GetImageFormat(int channelBits, int channels, bool linear)
         if (channelBits == 32 && linear)
             format = Gfx::ImageFormat::R32G32B32A32_SFloat;
         else if (channelBits == 16 && linear)
-            format = Gfx::ImageFormat::R16G16B16A16_SFloat;
+            format = Gfx::ImageFormat::R16G16B16A16_UNorm;
         else if (channelBits == 8 && !linear)
             format = Gfx::ImageFormat::R8G8B8A8_SRGB;
+        else if (channelBits == 8 && linear)
+            format = Gfx::ImageFormat::R8G8B8A8_UNorm;
     }
     else if (channels == 3)
     {
         if (channelBits == 32 && linear)
             format = Gfx::ImageFormat::R32G32B32_SFloat;
         else if (channelBits == 16 && linear)
-            format = Gfx::ImageFormat::R16G16B16_SFloat;
+            format = Gfx::ImageFormat::R16G16B16_UNorm;
         else if (channelBits == 8 && !linear)
             format = Gfx::ImageFormat::R8G8B8_SRGB;
         else if (channelBits == 8 && linear)
@@ -330,7 +342,7 @@ ImageFormat GetImageFormat(int channelBits, int channels, bool linear)
         if (channelBits == 32 && linear)
             format = Gfx::ImageFormat::R32G32_SFloat;
         else if (channelBits == 16 && linear)
-            format = Gfx::ImageFormat::R16G16_SFloat;
+            format = Gfx::ImageFormat::R16G16_UNorm;
         else if (channelBits == 8 && !linear)
             format = Gfx::ImageFormat::R8G8_SRGB;
     }
@@ -339,7 +351,7 @@ ImageFormat GetImageFormat(int channelBits, int channels, bool linear)
         if (channelBits == 32 && linear)
             format = Gfx::ImageFormat::R32_SFloat;
         else if (channelBits == 16 && linear)
-            format = Gfx::ImageFormat::R16_SFloat;
+            format = Gfx::ImageFormat::R16_UNorm;
         else if (channelBits == 8 && !linear)
             format = Gfx::ImageFormat::R8_SRGB;
         else if (channelBits == 8 && linear)
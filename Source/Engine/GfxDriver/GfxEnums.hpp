@@ -120,12 +120,15 @@ enum class ImageFormat
     BC7_SRGB_UNorm_Block,
     BC3_Unorm_Block,
     BC3_SRGB_Block,
+    BC5_UNorm_Block,
     B10G11R11_UFloat_Pack32,
     A2B10G10R10_UNorm,
     R8_UNorm,
+    R16_UNorm,
     Invalid
 };
 
+// 8 and 16 bit channels map to normalized formats, 32 bit channels to float formats
 ImageFormat GetImageFormat(int channelBits, int channels, bool linear);
 
 ImageFormat MapStringToImageFormat(std::string_view name);
@@ -0,0 +1,98 @@
+#include "ShaderConfig.hpp"
+#include "ThirdParty/xxHash/xxhash.h"
+
+namespace Gfx
+{
+namespace
+{
+template <class T>
+void Append(std::string& bytes, const T& value)
+{
+    bytes.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+void Append(std::string& bytes, const std::string& value)
+{
+    Append(bytes, value.size());
+    bytes += value;
+}
+
+void Append(std::string& bytes, const StencilOpState& s)
+{
+    Append(bytes, s.failOp);
+    Append(bytes, s.passOp);
+    Append(bytes, s.depthFailOp);
+    Append(bytes, s.compareOp);
+    Append(bytes, s.compareMask);
+    Append(bytes, s.writeMask);
+    Append(bytes, s.reference);
+}
+
+void Append(std::string& bytes, const std::vector<std::vector<std::string>>& features)
+{
+    Append(bytes, features.size());
+    for (auto& group : features)
+    {
+        Append(bytes, group.size());
+        for (auto& f : group)
+            Append(bytes, f);
+    }
+}
+} // namespace
+
+uint64_t ShaderConfig::ComputeHash() const
+{
+    // fields are appended one by one so that struct padding never leaks into the hash
+    std::string bytes;
+    bytes.reserve(256);
+
+    Append(bytes, vertexInterleaved);
+    Append(bytes, debug);
+    Append(bytes, cullMode);
+    Append(bytes, topology);
+    Append(bytes, polygonMode);
+
+    Append(bytes, depth.writeEnable);
+    Append(bytes, depth.testEnable);
+    Append(bytes, depth.compOp);
+    Append(bytes, depth.boundTestEnable);
+    Append(bytes, depth.minBounds);
+    Append(bytes, depth.maxBounds);
+
+    Append(bytes, stencil.testEnable);
+    Append(bytes, stencil.front);
+    Append(bytes, stencil.back);
+
+    Append(bytes, color.blends.size());
+    for (auto& b : color.blends)
+    {
+        Append(bytes, b.blendEnable);
+        Append(bytes, b.srcColorBlendFactor);
+        Append(bytes, b.dstColorBlendFactor);
+        Append(bytes, b.colorBlendOp);
+        Append(bytes, b.srcAlphaBlendFactor);
+        Append(bytes, b.dstAlphaBlendFactor);
+        Append(bytes, b.alphaBlendOp);
+        Append(bytes, b.colorWriteMask);
+    }
+    for (float c : color.blendConstants)
+        Append(bytes, c);
+
+    Append(bytes, features);
+    Append(bytes, vertFeatures);
+    Append(bytes, fragFeatures);
+
+    // unordered_map iteration order is unspecified, combine the entries order independently
+    uint64_t overrideHash = 0;
+    for (auto& [key, size] : shaderInfoInputBaseTypeSizeOverride)
+    {
+        std::string entry;
+        Append(entry, key);
+        Append(entry, size);
+        overrideHash ^= XXH3_64bits(entry.data(), entry.size());
+    }
+    Append(bytes, overrideHash);
+
+    return XXH3_64bits(bytes.data(), bytes.size());
+}
+} // namespace Gfx
@@ -1,5 +1,6 @@
 #pragma once
 #include "GfxDriver/GfxEnums.hpp"
+#include <cassert>
 #include <nlohmann/json.hpp>
 #include <string>
 #include <unordered_map>
@@ -76,6 +77,19 @@ struct ShaderConfig
 
     bool operator==(const ShaderConfig& other) const noexcept = default;
 
+    // 64 bit hash of every field that participates in operator==, used as the key of pipeline caches. It's computed
+    // on the first call and cached, so a config must not be edited once it's hashed. Copies start without a hash
+    uint64_t GetHash() const
+    {
+        if (!hashCache.valid)
+        {
+            hashCache.hash = ComputeHash();
+            hashCache.valid = true;
+        }
+        assert(hashCache.hash == ComputeHash() && "ShaderConfig edited after it was hashed");
+        return hashCache.hash;
+    }
+
     static ShaderConfig FromJson(const nlohmann::json& j)
     {
         ShaderConfig config;
@@ -260,5 +274,28 @@ struct ShaderConfig
 
         return j;
     }
+
+private:
+    // not part of the config, copies drop it and it always compares equal
+    struct HashCache
+    {
+        HashCache() = default;
+        HashCache(const HashCache&) {}
+        HashCache& operator=(const HashCache&)
+        {
+            valid = false;
+            return *this;
+        }
+        bool operator==(const HashCache&) const
+        {
+            return true;
+        }
+
+        uint64_t hash = 0;
+        bool valid = false;
+    };
+    mutable HashCache hashCache;
+
+    uint64_t ComputeHash() const;
 };
 } // namespace Gfx
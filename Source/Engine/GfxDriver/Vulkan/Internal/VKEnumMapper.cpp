@@ -9,6 +9,7 @@ VkFormat MapFormat(ImageFormat format)
     {
         case ImageFormat::BC3_SRGB_Block: return VK_FORMAT_BC3_SRGB_BLOCK;
         case ImageFormat::BC3_Unorm_Block: return VK_FORMAT_BC3_UNORM_BLOCK;
+        case ImageFormat::BC5_UNorm_Block: return VK_FORMAT_BC5_UNORM_BLOCK;
         case ImageFormat::BC7_SRGB_UNorm_Block: return VK_FORMAT_BC7_SRGB_BLOCK;
         case ImageFormat::BC7_UNorm_Block: return VK_FORMAT_BC7_UNORM_BLOCK;
         case ImageFormat::R16G16B16A16_SFloat: return VK_FORMAT_R16G16B16A16_SFLOAT;
@@ -53,6 +54,7 @@ VkFormat MapFormat(ImageFormat format)
         case ImageFormat::B10G11R11_UFloat_Pack32: return VK_FORMAT_B10G11R11_UFLOAT_PACK32;
         case ImageFormat::A2B10G10R10_UNorm: return VK_FORMAT_A2B10G10R10_UNORM_PACK32;
         case ImageFormat::R8_UNorm: return VK_FORMAT_R8_UNORM;
+        case ImageFormat::R16_UNorm: return VK_FORMAT_R16_UNORM;
         default: assert(0 && "Format map failed");
     }
 
@@ -66,6 +68,7 @@ ImageFormat MapVKFormat(VkFormat format)
     {
         case VK_FORMAT_BC3_UNORM_BLOCK: return ImageFormat::BC3_Unorm_Block;
         case VK_FORMAT_BC3_SRGB_BLOCK: return ImageFormat::BC3_SRGB_Block;
+        case VK_FORMAT_BC5_UNORM_BLOCK: return ImageFormat::BC5_UNorm_Block;
         case VK_FORMAT_BC7_SRGB_BLOCK: return ImageFormat::BC7_SRGB_UNorm_Block;
         case VK_FORMAT_BC7_UNORM_BLOCK: return ImageFormat::BC7_UNorm_Block;
         case VK_FORMAT_R16G16B16A16_SFLOAT: return ImageFormat::R16G16B16A16_SFloat;
@@ -110,6 +113,7 @@ ImageFormat MapVKFormat(VkFormat format)
         case VK_FORMAT_B10G11R11_UFLOAT_PACK32: return ImageFormat::B10G11R11_UFloat_Pack32;
         case VK_FORMAT_A2B10G10R10_UNORM_PACK32: return ImageFormat::A2B10G10R10_UNorm;
         case VK_FORMAT_R8_UNORM: return ImageFormat::R8_UNorm;
+        case VK_FORMAT_R16_UNORM: return ImageFormat::R16_UNorm;
         default: assert(0 && "VK format map failed");
     }
 
@@ -1,7 +1,9 @@
 #include "VKMemAllocator.hpp"
 #include "../VKBuffer.hpp"
 #include "../VKImage.hpp"
+#include <algorithm>
 #include <cassert>
+#include <nlohmann/json.hpp>
 #include <spdlog/spdlog.h>
 #define VK_CHECK(x)                                                                                                    \
     auto rlt_VK_CHECK = x;                                                                                             \
@@ -9,6 +11,26 @@
 
 namespace Gfx
 {
+static GPUMemoryCategory GetBufferCategory(VkBufferUsageFlags usage)
+{
+    if (usage & (VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT))
+        return GPUMemoryCategory::VertexIndex;
+    if (usage & VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT)
+        return GPUMemoryCategory::Uniform;
+    if (usage & (VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT))
+        return GPUMemoryCategory::Storage;
+    if (usage == VK_BUFFER_USAGE_TRANSFER_SRC_BIT)
+        return GPUMemoryCategory::Staging;
+    return GPUMemoryCategory::Other;
+}
+
+static GPUMemoryCategory GetImageCategory(VkImageUsageFlags usage)
+{
+    VkImageUsageFlags renderTargetUsages = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT |
+                                           VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_STORAGE_BIT;
+    return (usage & renderTargetUsages) ? GPUMemoryCategory::RenderTarget : GPUMemoryCategory::Texture;
+}
+
 VKMemAllocator::VKMemAllocator(
     VkInstance instance, VkDevice device, VkPhysicalDevice physicalDevice, uint32_t transferQueueIndex
 )
@@ -41,6 +63,7 @@ void VKMemAllocator::CreateBuffer(
     VK_CHECK(
         vmaCreateBuffer(allocator_vma, &bufferCreateInfo, &allocationCreateInfo, &buffer, &allocation, allocationInfo)
     );
+    TrackAllocation(allocation, GetBufferCategory(bufferCreateInfo.usage));
 }
 
 void VKMemAllocator::CreateBuffer(
@@ -53,6 +76,7 @@ void VKMemAllocator::CreateBuffer(
     VK_CHECK(
         vmaCreateBuffer(allocator_vma, &bufferCreateInfo, &allocationCreateInfo, &buffer, &allocation, allocationInfo)
     );
+    TrackAllocation(allocation, GetBufferCategory(bufferCreateInfo.usage));
 }
 
 void VKMemAllocator::CreateImage(
@@ -64,6 +88,7 @@ void VKMemAllocator::CreateImage(
 
     VK_CHECK(vmaCreateImage(allocator_vma, &imageCreateInfo, &allocationCreateInfo, &image, &allocation, allocationInfo)
     );
+    TrackAllocation(allocation, GetImageCategory(imageCreateInfo.usage));
 }
 
 VkBuffer VKMemAllocator::GetStageBuffer(uint32_t size, VmaAllocation& allocation, VmaAllocationInfo& allocationInfo)
@@ -86,6 +111,7 @@ VkBuffer VKMemAllocator::GetStageBuffer(uint32_t size, VmaAllocation& allocation
     VK_CHECK(
         vmaCreateBuffer(allocator_vma, &bufferCreateInfo, &allocationCreateInfo, &srcBuf, &allocation, &allocationInfo)
     );
+    TrackAllocation(allocation, GPUMemoryCategory::Staging);
     return srcBuf;
 }
 
@@ -104,14 +130,129 @@ void VKMemAllocator::DestroyPendingResources()
 
     for (auto& b : pendingBuffers)
     {
+        UntrackAllocation(b.second);
         vmaDestroyBuffer(allocator_vma, b.first, b.second);
     }
     for (auto& b : pendingImages)
     {
+        UntrackAllocation(b.second);
         vmaDestroyImage(allocator_vma, b.first, b.second);
     }
 
     pendingBuffers.clear();
     pendingImages.clear();
 }
+
+void VKMemAllocator::TrackAllocation(VmaAllocation allocation, GPUMemoryCategory category)
+{
+    VmaAllocationInfo info;
+    vmaGetAllocationInfo(allocator_vma, allocation, &info);
+
+    std::unique_lock lock(trackingMutex);
+    trackedAllocations[allocation] = {category, info.size, ""};
+    categoryBytes[(size_t)category] += info.size;
+    categoryAllocations[(size_t)category] += 1;
+}
+
+void VKMemAllocator::UntrackAllocation(VmaAllocation allocation)
+{
+    std::unique_lock lock(trackingMutex);
+    auto iter = trackedAllocations.find(allocation);
+    if (iter == trackedAllocations.end())
+        return;
+
+    categoryBytes[(size_t)iter->second.category] -= iter->second.size;
+    categoryAllocations[(size_t)iter->second.category] -= 1;
+    trackedAllocations.erase(iter);
+}
+
+void VKMemAllocator::SetAllocationName(VmaAllocation allocation, std::string_view name)
+{
+    std::unique_lock lock(trackingMutex);
+    auto iter = trackedAllocations.find(allocation);
+    if (iter != trackedAllocations.end())
+        iter->second.name = name;
+}
+
+GPUMemoryStats VKMemAllocator::GetMemoryStats()
+{
+    GPUMemoryStats stats;
+    {
+        std::unique_lock lock(trackingMutex);
+        stats.bytes = categoryBytes;
+        stats.allocations = categoryAllocations;
+    }
+    for (uint64_t bytes : stats.bytes)
+        stats.totalBytes += bytes;
+
+    // without VK_EXT_memory_budget vma estimates the budget from the heap size
+    const VkPhysicalDeviceMemoryProperties* memoryProperties;
+    vmaGetMemoryProperties(allocator_vma, &memoryProperties);
+    VmaBudget budgets[VK_MAX_MEMORY_HEAPS];
+    vmaGetHeapBudgets(allocator_vma, budgets);
+    for (uint32_t i = 0; i < memoryProperties->memoryHeapCount; ++i)
+    {
+        stats.heaps.push_back(
+            {(memoryProperties->memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0,
+             budgets[i].usage,
+             budgets[i].budget}
+        );
+    }
+
+    return stats;
+}
+
+std::string VKMemAllocator::DumpMemory()
+{
+    struct Resource
+    {
+        uint64_t bytes = 0;
+        uint32_t allocations = 0;
+    };
+
+    // allocations with the same name belong to the same asset, e.g. the vertex and index buffers of a mesh
+    std::array<std::unordered_map<std::string, Resource>, (size_t)GPUMemoryCategory::Count> resources;
+    {
+        std::unique_lock lock(trackingMutex);
+        for (auto& [allocation, tracked] : trackedAllocations)
+        {
+            auto& resource = resources[(size_t)tracked.category][tracked.name.empty() ? "Unnamed" : tracked.name];
+            resource.bytes += tracked.size;
+            resource.allocations += 1;
+        }
+    }
+
+    GPUMemoryStats stats = GetMemoryStats();
+    nlohmann::json j;
+    j["totalBytes"] = stats.totalBytes;
+    j["heaps"] = nlohmann::json::array();
+    for (auto& heap : stats.heaps)
+    {
+        j["heaps"].push_back({{"deviceLocal", heap.deviceLocal}, {"usage", heap.usage}, {"budget", heap.budget}});
+    }
+
+    for (size_t c = 0; c < (size_t)GPUMemoryCategory::Count; ++c)
+    {
+        std::vector<std::pair<std::string, Resource>> sorted(resources[c].begin(), resources[c].end());
+        std::sort(
+            sorted.begin(),
+            sorted.end(),
+            [](auto& left, auto& right) { return left.second.bytes > right.second.bytes; }
+        );
+
+        nlohmann::json category;
+        category["bytes"] = stats.bytes[c];
+        category["allocations"] = stats.allocations[c];
+        category["resources"] = nlohmann::json::array();
+        for (auto& [name, resource] : sorted)
+        {
+            category["resources"].push_back(
+                {{"name", name}, {"bytes", resource.bytes}, {"allocations", resource.allocations}}
+            );
+        }
+        j["categories"][GPUMemoryCategoryToString((GPUMemoryCategory)c)] = category;
+    }
+
+    return j.dump(4);
+}
 } // namespace Gfx
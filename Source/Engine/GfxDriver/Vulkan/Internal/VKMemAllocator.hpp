@@ -1,7 +1,11 @@
 #pragma once
 
+#include "GfxDriver/GfxDriver.hpp"
 #include "Libs/Ptr.hpp"
 #include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 #include <vk_mem_alloc.h>
@@ -53,6 +57,11 @@ public:
 
     void DestroyPendingResources();
 
+    // the name an allocation is reported under in GetMemoryStats and DumpMemory
+    void SetAllocationName(VmaAllocation allocation, std::string_view name);
+    GPUMemoryStats GetMemoryStats();
+    std::string DumpMemory();
+
     inline VmaAllocator GetHandle()
     {
         return allocator_vma;
@@ -65,7 +74,24 @@ public:
     VkBuffer GetStageBuffer(uint32_t size, VmaAllocation& allocation, VmaAllocationInfo& allocationInfo);
 
 private:
+    struct TrackedAllocation
+    {
+        GPUMemoryCategory category;
+        uint64_t size;
+        std::string name;
+    };
+
     std::vector<std::pair<VkBuffer, VmaAllocation>> pendingBuffers;
     std::vector<std::pair<VkImage, VmaAllocation>> pendingImages;
+
+    // every live allocation, resources are created from loading jobs so this is guarded by trackingMutex
+    std::mutex trackingMutex;
+    std::unordered_map<VmaAllocation, TrackedAllocation> trackedAllocations;
+    // running totals so the per frame stats don't walk every allocation
+    std::array<uint64_t, (size_t)GPUMemoryCategory::Count> categoryBytes{};
+    std::array<uint32_t, (size_t)GPUMemoryCategory::Count> categoryAllocations{};
+
+    void TrackAllocation(VmaAllocation allocation, GPUMemoryCategory category);
+    void UntrackAllocation(VmaAllocation allocation);
 };
 } // namespace Gfx
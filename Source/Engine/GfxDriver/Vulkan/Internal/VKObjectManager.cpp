@@ -59,12 +59,12 @@ void VKObjectManager::DestroyShaderModule(VkShaderModule module)
 
 void VKObjectManager::CreateGraphicsPipeline(VkGraphicsPipelineCreateInfo& createInfo, VkPipeline& pipeline)
 {
-    VK_CHECK(vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &createInfo, VK_NULL_HANDLE, &pipeline));
+    VK_CHECK(vkCreateGraphicsPipelines(device, pipelineCache, 1, &createInfo, VK_NULL_HANDLE, &pipeline));
 }
 
 void VKObjectManager::CreateComputePipeline(VkComputePipelineCreateInfo& createInfo, VkPipeline& pipeline)
 {
-    VK_CHECK(vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &createInfo, VK_NULL_HANDLE, &pipeline));
+    VK_CHECK(vkCreateComputePipelines(device, pipelineCache, 1, &createInfo, VK_NULL_HANDLE, &pipeline));
 }
 
 void VKObjectManager::DestroyPipeline(VkPipeline pipeline)
@@ -131,9 +131,12 @@ void VKObjectManager::DestroyPendingResources()
         vkDestroyImageView(device, v, VK_NULL_HANDLE);
     pendingImageViews.clear();
 
-    for (auto v : pendingRenderPasses)
-        vkDestroyRenderPass(device, v, VK_NULL_HANDLE);
-    pendingRenderPasses.clear();
+    if (asyncPipelineCompiles == 0)
+    {
+        for (auto v : pendingRenderPasses)
+            vkDestroyRenderPass(device, v, VK_NULL_HANDLE);
+        pendingRenderPasses.clear();
+    }
 
     for (auto v : pendingFramebuffers)
         vkDestroyFramebuffer(device, v, VK_NULL_HANDLE);
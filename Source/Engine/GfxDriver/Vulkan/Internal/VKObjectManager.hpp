@@ -1,4 +1,5 @@
 #pragma once
+#include <atomic>
 #include <vector>
 #include <vulkan/vulkan.h>
 #if defined(_WIN32) || defined(_WIN64)
@@ -38,11 +39,32 @@ public:
 
     void DestroyPendingResources();
 
+    // pipelines created after this call go through the given cache
+    void SetPipelineCache(VkPipelineCache cache)
+    {
+        pipelineCache = cache;
+    }
+
     VkDevice GetDevice()
     {
         return device;
     }
 
+    // pipelines compiled on worker threads reference render passes that may be destroyed in the meantime, pending
+    // render passes are kept alive until no compile is in flight
+    void BeginAsyncPipelineCompile()
+    {
+        asyncPipelineCompiles += 1;
+    }
+    void EndAsyncPipelineCompile()
+    {
+        asyncPipelineCompiles -= 1;
+    }
+    uint32_t GetAsyncPipelineCompileCount()
+    {
+        return asyncPipelineCompiles;
+    }
+
 private:
     std::vector<VkImageView> pendingImageViews;
     std::vector<VkRenderPass> pendingRenderPasses;
@@ -56,5 +78,7 @@ private:
     std::vector<VkSampler> pendingSamplers;
     std::vector<VkCommandPool> pendingCommandPools;
     VkDevice device;
+    VkPipelineCache pipelineCache = VK_NULL_HANDLE;
+    std::atomic<uint32_t> asyncPipelineCompiles = 0;
 };
 } // namespace Gfx
@@ -0,0 +1,102 @@
+#include "VKPipelineCache.hpp"
+#include <cstring>
+#include <fstream>
+#include <spdlog/spdlog.h>
+#include <vector>
+
+namespace Gfx
+{
+VKPipelineCache::VKPipelineCache(
+    VkDevice device, const VkPhysicalDeviceProperties& properties, const std::filesystem::path& cacheFile
+)
+    : device(device), properties(properties), cacheFile(cacheFile)
+{
+    std::vector<char> data;
+    if (!cacheFile.empty() && std::filesystem::exists(cacheFile))
+    {
+        std::ifstream f(cacheFile, std::ios::binary);
+        if (f.good())
+        {
+            data.resize(std::filesystem::file_size(cacheFile));
+            f.read(data.data(), data.size());
+        }
+
+        if (!IsCompatible(data))
+        {
+            SPDLOG_INFO("VKPipelineCache: {} is not created by this device, starting empty", cacheFile.string());
+            data.clear();
+        }
+    }
+
+    VkPipelineCacheCreateInfo createInfo{VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO};
+    createInfo.initialDataSize = data.size();
+    createInfo.pInitialData = data.empty() ? nullptr : data.data();
+    if (vkCreatePipelineCache(device, &createInfo, VK_NULL_HANDLE, &cache) != VK_SUCCESS && !data.empty())
+    {
+        // corrupted data, fallback to an empty cache
+        createInfo.initialDataSize = 0;
+        createInfo.pInitialData = nullptr;
+        data.clear();
+        vkCreatePipelineCache(device, &createInfo, VK_NULL_HANDLE, &cache);
+    }
+
+    loadedSize = data.size();
+}
+
+VKPipelineCache::~VKPipelineCache()
+{
+    if (cache != VK_NULL_HANDLE)
+        vkDestroyPipelineCache(device, cache, VK_NULL_HANDLE);
+}
+
+bool VKPipelineCache::IsCompatible(const std::vector<char>& data)
+{
+    if (data.size() < sizeof(VkPipelineCacheHeaderVersionOne))
+        return false;
+
+    VkPipelineCacheHeaderVersionOne header;
+    memcpy(&header, data.data(), sizeof(header));
+
+    return header.headerSize >= sizeof(VkPipelineCacheHeaderVersionOne) &&
+           header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE && header.vendorID == properties.vendorID &&
+           header.deviceID == properties.deviceID &&
+           memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
+
+bool VKPipelineCache::Save()
+{
+    if (cacheFile.empty() || cache == VK_NULL_HANDLE)
+        return false;
+
+    size_t size = 0;
+    if (vkGetPipelineCacheData(device, cache, &size, nullptr) != VK_SUCCESS || size == 0)
+        return false;
+
+    std::vector<char> data(size);
+    if (vkGetPipelineCacheData(device, cache, &size, data.data()) != VK_SUCCESS)
+        return false;
+
+    // write to a temporary file first so that a crash while saving doesn't leave a truncated cache behind
+    std::filesystem::path tmp = cacheFile;
+    tmp += ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        if (!out.good())
+        {
+            SPDLOG_WARN("VKPipelineCache: failed to write {}", tmp.string());
+            return false;
+        }
+        out.write(data.data(), size);
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tmp, cacheFile, ec);
+    if (ec)
+    {
+        SPDLOG_WARN("VKPipelineCache: failed to save {}: {}", cacheFile.string(), ec.message());
+        return false;
+    }
+
+    return true;
+}
+} // namespace Gfx
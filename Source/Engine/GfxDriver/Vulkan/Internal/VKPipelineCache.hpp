@@ -0,0 +1,86 @@
+#pragma once
+#include <atomic>
+#include <filesystem>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+namespace Gfx
+{
+// wraps a VkPipelineCache that is loaded from and saved to disk so that the driver doesn't have to compile every
+// pipeline from scratch on each run
+class VKPipelineCache
+{
+public:
+    // cacheFile can be empty, the cache then only lives for this run
+    VKPipelineCache(
+        VkDevice device, const VkPhysicalDeviceProperties& properties, const std::filesystem::path& cacheFile
+    );
+    VKPipelineCache(const VKPipelineCache& other) = delete;
+    ~VKPipelineCache();
+
+    VkPipelineCache GetHandle()
+    {
+        return cache;
+    }
+
+    // size of the data accepted from disk, 0 when the cache started empty
+    size_t GetLoadedSize()
+    {
+        return loadedSize;
+    }
+
+    // write the current cache content to the cache file
+    bool Save();
+
+    // when enabled, pipeline misses during rendering are compiled on worker threads and the draw is skipped
+    void SetAsyncCompilation(bool enable)
+    {
+        asyncCompilation = enable;
+    }
+    bool IsAsyncCompilationEnabled()
+    {
+        return asyncCompilation;
+    }
+
+    // a synchronous compile stalls the frame that requested it, each one is a stutter event
+    void RecordSyncCompile()
+    {
+        syncCompiles += 1;
+    }
+    void RecordAsyncCompile()
+    {
+        asyncCompiles += 1;
+    }
+    void RecordSkippedDraw()
+    {
+        skippedDraws += 1;
+    }
+
+    uint32_t GetSyncCompileCount()
+    {
+        return syncCompiles;
+    }
+    uint32_t GetAsyncCompileCount()
+    {
+        return asyncCompiles;
+    }
+    uint32_t GetSkippedDrawCount()
+    {
+        return skippedDraws;
+    }
+
+private:
+    VkDevice device;
+    VkPipelineCache cache = VK_NULL_HANDLE;
+    VkPhysicalDeviceProperties properties;
+    std::filesystem::path cacheFile;
+    size_t loadedSize = 0;
+    bool asyncCompilation = true;
+    std::atomic<uint32_t> syncCompiles = 0;
+    std::atomic<uint32_t> asyncCompiles = 0;
+    std::atomic<uint32_t> skippedDraws = 0;
+
+    // the driver may reject data produced by another device/driver, we check it ourselves to get a clear log
+    bool IsCompatible(const std::vector<char>& data);
+};
+} // namespace Gfx
@@ -1,7 +1,10 @@
 #include "VKDataUploader.hpp"
 #include "../VKBuffer.hpp"
+#include "../Internal/VKMemAllocator.hpp"
 #include "../VKDriver.hpp"
 #include "Profiler/Profiler.hpp"
+#include <algorithm>
+#include <numeric>
 #include <spdlog/spdlog.h>
 
 namespace Gfx
@@ -13,6 +16,7 @@ VKDataUploader::VKDataUploader(VKDriver* driver) : driver(driver)
         VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
         VMA_ALLOCATION_CREATE_MAPPED_BIT | VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT
     );
+    driver->memAllocator->SetAllocationName(stagingBuffer.allocation, "data uploader staging buffer");
 
     VkCommandBufferAllocateInfo rhiCmdAllocateInfo{VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO};
     rhiCmdAllocateInfo.commandPool = driver->mainCmdPool;
@@ -95,6 +99,90 @@ void VKDataUploader::UploadImage(
     offset += align + size;
 }
 
+void VKDataUploader::UploadImageRegions(
+    VKImage* dst,
+    uint8_t* data,
+    std::span<const ImageUploadRegion> regions,
+    VkImageAspectFlags aspect,
+    VkImageLayout finalLayout
+)
+{
+    if (regions.empty())
+        return;
+
+    size_t first = regions[0].offset;
+    size_t last = 0;
+    for (auto& r : regions)
+    {
+        first = std::min(first, r.offset);
+        last = std::max(last, r.offset + r.size);
+    }
+    size_t size = last - first;
+
+    // buffer offsets have to be a multiple of the texel block size, region offsets keep their alignment relative to
+    // the block
+    auto& desc = dst->GetDescription();
+    size_t blockAlign = std::lcm<size_t>(MapImageFormatToByteSize(desc.format), 16);
+    size_t align = (blockAlign - offset % blockAlign) % blockAlign;
+
+    if (size + blockAlign > stagingBufferSize)
+    {
+        // too large for one batch, fall back to a copy per region
+        for (auto& r : regions)
+            UploadImage(dst, data + r.offset, r.size, r.mipLevel, r.arrayLayer, aspect, finalLayout);
+        return;
+    }
+
+    if (offset + align + size > stagingBufferSize)
+    {
+        UploadAllPending(VK_NULL_HANDLE, VK_NULL_HANDLE, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
+        vkWaitForFences(driver->device.handle, 1, &fence, true, -1);
+        align = 0;
+    }
+
+    size_t base = offset + align;
+    memcpy((uint8_t*)stagingBuffer.allocationInfo.pMappedData + base, data + first, size);
+    for (auto& r : regions)
+    {
+        pendingImageUploads.push_back(PendingImageUpload{
+            dst->GetImage(),
+            std::max(desc.width >> r.mipLevel, 1u),
+            std::max(desc.height >> r.mipLevel, 1u),
+            base + r.offset - first,
+            r.size,
+            r.mipLevel,
+            r.arrayLayer,
+            aspect,
+            finalLayout
+        });
+    }
+
+    offset = base + size;
+}
+
+void VKDataUploader::CopyImageMips(
+    VKImage* src, VKImage* dst, uint32_t srcMip, uint32_t dstMip, uint32_t levelCount, VkImageLayout finalLayout
+)
+{
+    if (levelCount == 0)
+        return;
+
+    auto& desc = dst->GetDescription();
+    auto range = dst->GetDefaultSubresourceRange();
+    pendingImageCopies.push_back(PendingImageCopy{
+        src->GetImage(),
+        dst->GetImage(),
+        std::max(desc.width >> dstMip, 1u),
+        std::max(desc.height >> dstMip, 1u),
+        srcMip,
+        dstMip,
+        levelCount,
+        range.layerCount,
+        range.aspectMask,
+        finalLayout
+    });
+}
+
 void VKDataUploader::WaitForUploadFinish()
 {
     ENGINE_SCOPED_PROFILE("VKDataUploader::WaitForUploadFinish");
@@ -133,6 +221,84 @@ void VKDataUploader::UploadAllPending(
         }
     }
 
+    for (auto& p : pendingImageCopies)
+    {
+        imageCopies.clear();
+        for (uint32_t level = 0; level < p.levelCount; ++level)
+        {
+            VkImageCopy region;
+            region.srcSubresource = {p.aspect, p.srcMip + level, 0, p.layerCount};
+            region.srcOffset = VkOffset3D{0, 0, 0};
+            region.dstSubresource = {p.aspect, p.dstMip + level, 0, p.layerCount};
+            region.dstOffset = VkOffset3D{0, 0, 0};
+            region.extent = VkExtent3D{std::max(p.width >> level, 1u), std::max(p.height >> level, 1u), 1};
+            imageCopies.push_back(region);
+        }
+
+        VkImageMemoryBarrier copyBarriers[2];
+        for (VkImageMemoryBarrier& barrier : copyBarriers)
+        {
+            barrier = {VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER};
+            barrier.srcAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+            barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        }
+        copyBarriers[0].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        copyBarriers[0].oldLayout = p.finalLayout;
+        copyBarriers[0].newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        copyBarriers[0].image = p.src;
+        copyBarriers[0].subresourceRange = {p.aspect, p.srcMip, p.levelCount, 0, p.layerCount};
+        copyBarriers[1].dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        copyBarriers[1].oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        copyBarriers[1].newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        copyBarriers[1].image = p.dst;
+        copyBarriers[1].subresourceRange = {p.aspect, p.dstMip, p.levelCount, 0, p.layerCount};
+        vkCmdPipelineBarrier(
+            cmd,
+            VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            0,
+            0,
+            VK_NULL_HANDLE,
+            0,
+            VK_NULL_HANDLE,
+            2,
+            copyBarriers
+        );
+
+        vkCmdCopyImage(
+            cmd,
+            p.src,
+            VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+            p.dst,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            imageCopies.size(),
+            imageCopies.data()
+        );
+
+        // the source goes back to the layout it is sampled in, the frames in flight may still read it
+        copyBarriers[0].srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        copyBarriers[0].dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+        copyBarriers[0].oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        copyBarriers[0].newLayout = p.finalLayout;
+        copyBarriers[1].srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        copyBarriers[1].dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+        copyBarriers[1].oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        copyBarriers[1].newLayout = p.finalLayout;
+        vkCmdPipelineBarrier(
+            cmd,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_PIPELINE_STAGE_ALL_GRAPHICS_BIT,
+            0,
+            0,
+            VK_NULL_HANDLE,
+            0,
+            VK_NULL_HANDLE,
+            2,
+            copyBarriers
+        );
+    }
+
     for (size_t i = 0; i < pendingImageUploads.size(); ++i)
     {
         auto& p = pendingImageUploads[i];
@@ -224,6 +390,7 @@ void VKDataUploader::UploadAllPending(
     vkEndCommandBuffer(cmd);
     pendingBufferUploads.clear();
     pendingImageUploads.clear();
+    pendingImageCopies.clear();
     offset = 0;
 
     VkSubmitInfo submitInfo{VK_STRUCTURE_TYPE_SUBMIT_INFO};
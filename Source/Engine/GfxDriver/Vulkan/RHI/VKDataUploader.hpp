@@ -1,5 +1,6 @@
 #pragma once
 #include "Buffer.hpp"
+#include <span>
 #include <vector>
 #include <vulkan/vulkan.h>
 
@@ -8,6 +9,7 @@ namespace Gfx
 class VKDriver;
 class VKBuffer;
 class VKImage;
+struct ImageUploadRegion;
 class VKDataUploader
 {
 public:
@@ -24,6 +26,19 @@ public:
         VkImageAspectFlags aspect,
         VkImageLayout finalLayout
     );
+    // stages the data of all regions with one copy and keeps their copies next to each other so that they are
+    // recorded as a single vkCmdCopyBufferToImage
+    void UploadImageRegions(
+        VKImage* dst,
+        uint8_t* data,
+        std::span<const ImageUploadRegion> regions,
+        VkImageAspectFlags aspect,
+        VkImageLayout finalLayout
+    );
+    // src is expected in finalLayout, the copies are recorded before the uploads of the same submission
+    void CopyImageMips(
+        VKImage* src, VKImage* dst, uint32_t srcMip, uint32_t dstMip, uint32_t levelCount, VkImageLayout finalLayout
+    );
     void UploadAllPending(VkSemaphore signalSemaphore, VkSemaphore waitSemaphore, VkPipelineStageFlags waitStages);
     void WaitForUploadFinish();
 
@@ -49,6 +64,20 @@ private:
         VkImageLayout finalLayout;
     };
 
+    struct PendingImageCopy
+    {
+        VkImage src;
+        VkImage dst;
+        uint32_t width;
+        uint32_t height;
+        uint32_t srcMip;
+        uint32_t dstMip;
+        uint32_t levelCount;
+        uint32_t layerCount;
+        VkImageAspectFlags aspect;
+        VkImageLayout finalLayout;
+    };
+
     VKDriver* driver;
     VkCommandBuffer cmd = VK_NULL_HANDLE;
     VkFence fence;
@@ -56,6 +85,8 @@ private:
     size_t offset = 0;
     std::vector<PendingBufferUpload> pendingBufferUploads = {};
     std::vector<PendingImageUpload> pendingImageUploads = {};
+    std::vector<PendingImageCopy> pendingImageCopies = {};
+    std::vector<VkImageCopy> imageCopies = {};
     std::vector<VkBufferCopy> copyRegions = {};
     std::vector<VkImageMemoryBarrier> barriers = {};
     std::vector<VkBufferImageCopy> bufferImageCopies = {};
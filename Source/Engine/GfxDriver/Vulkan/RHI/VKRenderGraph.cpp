@@ -1,5 +1,7 @@
 #include "VKRenderGraph.hpp"
+#include "../Internal/VKPipelineCache.hpp"
 #include "../VKBuffer.hpp"
+#include "../VKContext.hpp"
 #include "../VKDriver.hpp"
 #include "../VKExtensionFunc.hpp"
 #include "../VKShaderProgram.hpp"
@@ -7,6 +9,10 @@
 #include "../VKUtils.hpp"
 #include "GfxDriver/Vulkan/Internal/VKEnumMapper.hpp"
 #include "Profiler/Profiler.hpp"
+// XXH3_state_t on the stack, other headers may have included xxhash.h without it already
+#define XXH_STATIC_LINKING_ONLY
+#include "ThirdParty/xxHash/xxhash.h"
+#include <chrono>
 
 namespace Gfx::VK::RenderGraph
 {
@@ -273,7 +279,9 @@ bool Graph::TrackResource(
         ResourceUsage usage{stages, access, range, layout};
         if (iter->second.currentFrameUsages.empty())
         {
+            RecordLayoutCheck(writableResource, range);
             iter->second.currentFrameUsages.push_back(usage);
+            RecordUsage(iter->first, iter->second);
             return true;
         }
         else
@@ -282,6 +290,7 @@ bool Graph::TrackResource(
             if (usage != lastUsage)
             {
                 iter->second.currentFrameUsages.push_back(usage);
+                RecordUsage(iter->first, iter->second);
                 return true;
             }
         }
@@ -293,7 +302,9 @@ bool Graph::TrackResource(
         track.res = writableResource->GetSRef();
         track.currentFrameUsages.push_back({stages, access, range, layout});
 
-        resourceUsageTracks[writableResource->GetUUID()] = track;
+        RecordLayoutCheck(writableResource, range);
+        auto& newTrack = resourceUsageTracks[writableResource->GetUUID()] = track;
+        RecordUsage(writableResource->GetUUID(), newTrack);
         return true;
     }
 
@@ -323,6 +334,7 @@ bool Graph::TrackResource(VKBuffer* writableResource, VkPipelineStageFlags stage
             iter->second.currentFrameUsages.push_back(
                 {stages, access, Gfx::ImageSubresourceRange{}, VK_IMAGE_LAYOUT_UNDEFINED}
             );
+            RecordUsage(iter->first, iter->second);
 
             return true;
         }
@@ -335,6 +347,7 @@ bool Graph::TrackResource(VKBuffer* writableResource, VkPipelineStageFlags stage
                 iter->second.currentFrameUsages.push_back(
                     {stages, access, Gfx::ImageSubresourceRange{}, VK_IMAGE_LAYOUT_UNDEFINED}
                 );
+                RecordUsage(iter->first, iter->second);
 
                 return true;
             }
@@ -347,7 +360,8 @@ bool Graph::TrackResource(VKBuffer* writableResource, VkPipelineStageFlags stage
         track.res = writableResource->GetSRef();
         track.currentFrameUsages.push_back({stages, access, Gfx::ImageSubresourceRange{}, VK_IMAGE_LAYOUT_UNDEFINED});
 
-        resourceUsageTracks[writableResource->GetUUID()] = track;
+        auto& newTrack = resourceUsageTracks[writableResource->GetUUID()] = track;
+        RecordUsage(writableResource->GetUUID(), newTrack);
         return true;
     }
 
@@ -448,6 +462,16 @@ void Graph::GoThroughRenderPass(
                  cmd.type == VKCmdType::DrawIndirect || cmd.type == VKCmdType::DrawIndexedIndirect)
         {
             FlushAllBindedSetUpdate(shaderImageSampleIgnoreList, barrierCount);
+
+            // indirect arguments are usually written by a compute pass earlier in the frame
+            if (cmd.type == VKCmdType::DrawIndirect || cmd.type == VKCmdType::DrawIndexedIndirect)
+            {
+                VKBuffer* buffer = static_cast<VKBuffer*>(cmd.drawIndirect.buffer);
+                if (TrackResource(buffer, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT))
+                {
+                    barrierCount += MakeBarrierForLastUsage(buffer, buffer->GetUUID());
+                }
+            }
         }
         else if (cmd.type == VKCmdType::PushDescriptorSet)
         {
@@ -577,6 +601,7 @@ int Graph::MakeBarrierForLastUsage(void* res, const UUID& uuid)
                         barrierCount += 1;
                         imageMemoryBarriers.push_back(imageBarrier);
                         image->SetLayout(subresourceRange, currentUsage.layout);
+                        RecordLayoutTransition(image, subresourceRange, currentUsage.layout);
                     }
 
                     auto remainings = currentRange.Subtract(preUsage.range);
@@ -624,6 +649,7 @@ int Graph::MakeBarrierForLastUsage(void* res, const UUID& uuid)
             barrierCount += 1;
             imageMemoryBarriers.push_back(imageBarrier);
             image->SetLayout(subresourceRange, currentUsage.layout);
+            RecordLayoutTransition(image, subresourceRange, currentUsage.layout);
         }
     }
     else if (iter->second.type == ResourceType::Buffer)
@@ -745,14 +771,48 @@ size_t Graph::TrackResourceForPushDescriptorSet(VKCmd& cmd, bool addBarrier)
 void Graph::Schedule(VKCommandBuffer& cmd)
 {
     ENGINE_SCOPED_PROFILE("VKRenderGraph: schedule");
+    auto scheduleBegin = std::chrono::high_resolution_clock::now();
 
     ENGINE_BEGIN_PROFILE("VKRenderGraph: insert cmds");
     int cmdIndexOffset = currentSchedulingCmds.size();
     currentSchedulingCmds.insert(currentSchedulingCmds.end(), cmd.GetCmds().begin(), cmd.GetCmds().end());
     ENGINE_END_PROFILE
 
+    uint64_t planKey = Fingerprint(cmdIndexOffset);
+    auto plan = schedulePlans.find(planKey);
+    if (plan != schedulePlans.end() && ReplayPlan(plan->second, cmdIndexOffset))
+    {
+        scheduleStats.reusedPlans += 1;
+    }
+    else
+    {
+        // a frame only needs a handful of plans, when there are many the graph has changed and old ones are dead
+        if (schedulePlans.size() >= 64)
+            schedulePlans.clear();
+
+        BarrierCounts begin{
+            barriers.size(),
+            imageMemoryBarriers.size(),
+            bufferMemoryBarriers.size(),
+            memoryBarriers.size()
+        };
+        SchedulePlan& newPlan = schedulePlans[planKey];
+        newPlan = SchedulePlan();
+        recordingPlan = &newPlan;
+        ScheduleCmds(cmdIndexOffset);
+        recordingPlan = nullptr;
+        RecordPlan(newPlan, cmdIndexOffset, begin);
+        scheduleStats.rebuiltPlans += 1;
+    }
+
+    auto elapsed = std::chrono::high_resolution_clock::now() - scheduleBegin;
+    scheduleStats.scheduleMs += std::chrono::duration<float, std::milli>(elapsed).count();
+}
+
+void Graph::ScheduleCmds(int cmdBegin)
+{
     // track where to put barriers
-    for (int visitIndex = cmdIndexOffset; visitIndex < currentSchedulingCmds.size(); visitIndex++)
+    for (int visitIndex = cmdBegin; visitIndex < currentSchedulingCmds.size(); visitIndex++)
     {
         auto& cmd = currentSchedulingCmds[visitIndex];
         if (cmd.type == VKCmdType::BeginRenderPass)
@@ -977,9 +1037,49 @@ void Graph::Schedule(VKCommandBuffer& cmd)
     }
 }
 
+void Graph::Prewarm(VKShaderProgram* program, const ShaderConfig& config)
+{
+    std::scoped_lock lock(prewarmMutex);
+    prewarmRequests.push_back({program, config, config.GetHash()});
+}
+
+void Graph::PrewarmPipelines(VKShaderProgram* program)
+{
+    auto iter = framePrewarms.find(program);
+    if (iter == framePrewarms.end() || exeState.renderPass == nullptr)
+        return;
+
+    ProgramPrewarms& prewarms = iter->second;
+    if (exeState.renderPass == prewarms.renderPass && exeState.subpassIndex == prewarms.subpassIndex)
+        return;
+
+    prewarms.renderPass = exeState.renderPass;
+    prewarms.subpassIndex = exeState.subpassIndex;
+    for (auto& request : prewarms.requests)
+    {
+        program->RequestGraphicsPipeline(
+            request.config,
+            request.configHash,
+            exeState.renderPass,
+            exeState.subpassIndex,
+            true
+        );
+    }
+}
+
 void Graph::Execute(VkCommandBuffer vkcmd)
 {
     ENGINE_SCOPED_PROFILE("VKRenderGraph::Execute");
+    {
+        std::scoped_lock lock(prewarmMutex);
+        for (auto& request : prewarmRequests)
+        {
+            if (!request.program->IsCompute())
+                framePrewarms[request.program].requests.push_back(std::move(request));
+        }
+        prewarmRequests.clear();
+    }
+
     for (size_t i = 0; i < currentSchedulingCmds.size(); ++i)
     {
         auto& cmd = currentSchedulingCmds[i];
@@ -992,7 +1092,8 @@ void Graph::Execute(VkCommandBuffer vkcmd)
                 }
             case VKCmdType::DrawIndexed:
                 {
-                    TryBindShader(vkcmd);
+                    if (!TryBindShader(vkcmd))
+                        break;
                     UpdateDescriptorSetBinding(vkcmd, VK_PIPELINE_BIND_POINT_GRAPHICS);
                     vkCmdDrawIndexed(
                         vkcmd,
@@ -1006,7 +1107,8 @@ void Graph::Execute(VkCommandBuffer vkcmd)
                 }
             case VKCmdType::Draw:
                 {
-                    TryBindShader(vkcmd);
+                    if (!TryBindShader(vkcmd))
+                        break;
                     UpdateDescriptorSetBinding(vkcmd, VK_PIPELINE_BIND_POINT_GRAPHICS);
                     vkCmdDraw(
                         vkcmd,
@@ -1019,7 +1121,8 @@ void Graph::Execute(VkCommandBuffer vkcmd)
                 }
             case VKCmdType::DrawIndirect:
                 {
-                    TryBindShader(vkcmd);
+                    if (!TryBindShader(vkcmd))
+                        break;
                     UpdateDescriptorSetBinding(vkcmd, VK_PIPELINE_BIND_POINT_GRAPHICS);
                     vkCmdDrawIndirect(
                         vkcmd,
@@ -1032,7 +1135,8 @@ void Graph::Execute(VkCommandBuffer vkcmd)
                 }
             case VKCmdType::DrawIndexedIndirect:
                 {
-                    TryBindShader(vkcmd);
+                    if (!TryBindShader(vkcmd))
+                        break;
                     UpdateDescriptorSetBinding(vkcmd, VK_PIPELINE_BIND_POINT_GRAPHICS);
                     vkCmdDrawIndexedIndirect(
                         vkcmd,
@@ -1188,8 +1292,11 @@ void Graph::Execute(VkCommandBuffer vkcmd)
                 {
                     exeState.lastBindedShader = cmd.bindShaderProgram.program;
                     exeState.shaderConfig = cmd.bindShaderProgram.config;
+                    exeState.shaderConfigHash = cmd.bindShaderProgram.configHash;
                     exeState.setResources[0].needUpdate = true;
                     exeState.setResources[0].resource = &globalResources[cmd.bindShaderProgram.program];
+                    if (!framePrewarms.empty())
+                        PrewarmPipelines(cmd.bindShaderProgram.program);
                     break;
                 }
             case VKCmdType::BindIndexBuffer:
@@ -1481,6 +1588,28 @@ void Graph::Execute(VkCommandBuffer vkcmd)
         std::swap(r.second.currentFrameUsages, r.second.previousFrameUsages);
         r.second.currentFrameUsages.clear();
     }
+    previousFrameFingerprint = frameFingerprint;
+    frameFingerprint = 0;
+    lastFrameScheduleStats = scheduleStats;
+    scheduleStats = ScheduleStats();
+    // a program drawn in this execution has been compiled for every pass it's drawn in, the requests of programs that
+    // weren't drawn (not visible yet, or an execution without graphics passes) wait for a later one
+    if (!framePrewarms.empty())
+    {
+        std::scoped_lock lock(prewarmMutex);
+        for (auto& kv : framePrewarms)
+        {
+            if (kv.second.renderPass != nullptr)
+                continue;
+
+            for (auto& request : kv.second.requests)
+            {
+                if (++request.unusedFrames < maxPrewarmFrames)
+                    prewarmRequests.push_back(std::move(request));
+            }
+        }
+    }
+    framePrewarms.clear();
     exeState = ExecutionState();
     recordState = RecordState();
 
@@ -1500,7 +1629,7 @@ void Graph::UpdateDescriptorSetBinding(VkCommandBuffer cmd, VkPipelineBindPoint
     UpdateDescriptorSetBinding(cmd, 3, bindPoint);
 }
 
-void Graph::TryBindShader(VkCommandBuffer cmd)
+bool Graph::TryBindShader(VkCommandBuffer cmd)
 {
     if (exeState.bindedShader != exeState.lastBindedShader && exeState.lastBindedShader != nullptr)
     {
@@ -1514,17 +1643,29 @@ void Graph::TryBindShader(VkCommandBuffer cmd)
         else
         {
             // binding pipeline
+            auto pipelineCache = VKContext::Instance()->pipelineCache;
             auto pipeline = exeState.lastBindedShader->RequestGraphicsPipeline(
                 *exeState.shaderConfig,
+                exeState.shaderConfigHash,
                 exeState.renderPass,
-                exeState.subpassIndex
+                exeState.subpassIndex,
+                pipelineCache->IsAsyncCompilationEnabled()
             );
 
+            // still compiling, leave bindedShader untouched so that the next draw asks again
+            if (pipeline == VK_NULL_HANDLE)
+            {
+                pipelineCache->RecordSkippedDraw();
+                return false;
+            }
+
             vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
         }
 
         exeState.bindedShader = exeState.lastBindedShader;
     }
+
+    return exeState.bindedShader != nullptr;
 }
 
 void Graph::UpdateDescriptorSetBinding(VkCommandBuffer cmd, uint32_t index, VkPipelineBindPoint bindPoint)
@@ -1667,6 +1808,349 @@ void Graph::ScheduleBindShaderProgram(VKCmd& cmd, int visitIndex)
     }
 }
 
+uint64_t Graph::Fingerprint(int cmdBegin)
+{
+    ENGINE_SCOPED_PROFILE("VKRenderGraph: fingerprint");
+    XXH3_state_t state;
+    XXH3_64bits_reset_withSeed(&state, frameFingerprint);
+    auto add = [&state](const auto& value) { XXH3_64bits_update(&state, &value, sizeof(value)); };
+    auto addResource = [&add](auto* resource) { add(resource ? std::hash<UUID>()(resource->GetUUID()) : 0); };
+    auto addRenderPass = [&add, &addResource](VKRenderPass& renderPass)
+    {
+        if (renderPass.GetSubpesses().empty())
+            return;
+
+        // same attachments GoThroughRenderPass tracks
+        auto& s = renderPass.GetSubpesses()[0];
+        for (auto& c : s.colors)
+        {
+            VKImage* image = static_cast<VKImage*>(&c.imageView->GetImage());
+            if (image->IsSwapchainProxy())
+            {
+                auto swapchainImage = static_cast<VKSwapChainImage*>(image);
+                image = swapchainImage->GetImage(swapchainImage->GetActiveIndex());
+            }
+            addResource(image);
+            add(c.imageView);
+            add(c.loadOp);
+            add(c.storeOp);
+        }
+        if (s.depth.has_value())
+        {
+            addResource(&s.depth->imageView->GetImage());
+            add(s.depth->imageView);
+            add(s.depth->loadOp);
+            add(s.depth->storeOp);
+        }
+    };
+
+    for (int i = cmdBegin; i < currentSchedulingCmds.size(); ++i)
+    {
+        auto& cmd = currentSchedulingCmds[i];
+        add(cmd.type);
+        switch (cmd.type)
+        {
+            case VKCmdType::BeginRenderPass: addRenderPass(*cmd.beginRenderPass.renderPass); break;
+            case VKCmdType::RGBeginRenderPass:
+                addRenderPass(*resourceAllocator->Request(*cmd.rgBeginRenderPass.renderPass));
+                break;
+            case VKCmdType::BindResource:
+                // the version changes whenever the resource's bindings do, which changes what it writes to
+                add(cmd.bindResource.set);
+                add(cmd.bindResource.resource);
+                add(cmd.bindResource.resource ? cmd.bindResource.resource->GetVersion() : 0);
+                break;
+            case VKCmdType::BindShaderProgram: add(cmd.bindShaderProgram.program); break;
+            case VKCmdType::DrawIndirect:
+            case VKCmdType::DrawIndexedIndirect: addResource(cmd.drawIndirect.buffer); break;
+            case VKCmdType::DispatchIndir: addResource(cmd.dispatchIndir.buffer); break;
+            case VKCmdType::PushDescriptorSet:
+                add(cmd.pushDescriptor.shader);
+                for (int b = 0; b < cmd.pushDescriptor.bindingCount; ++b)
+                {
+                    auto& binding = cmd.pushDescriptor.bindings[b];
+                    for (int j = 0; binding.imageView != nullptr && j < binding.descriptorCount; ++j)
+                        addResource(&static_cast<VKImageView*>(binding.imageView + j)->GetImage());
+                }
+                break;
+            case VKCmdType::SetTexture:
+                add(cmd.setTexture.handle);
+                add(cmd.setTexture.index);
+                addResource(cmd.setTexture.image);
+                add(cmd.setTexture.imageViewOption.value_or(ImageViewOption{-1, -1, -1, -1}));
+                break;
+            case VKCmdType::SetBuffer:
+                add(cmd.setBuffer.handle);
+                add(cmd.setBuffer.index);
+                addResource(cmd.setBuffer.buffer);
+                break;
+            case VKCmdType::CopyBuffer:
+                addResource(cmd.copyBuffer.src);
+                addResource(cmd.copyBuffer.dst);
+                break;
+            case VKCmdType::Blit:
+                addResource(cmd.blit.from);
+                addResource(cmd.blit.to);
+                add(cmd.blit.blitOp.srcMip.value_or(-1));
+                add(cmd.blit.blitOp.dstMip.value_or(-1));
+                break;
+            case VKCmdType::CopyImageToBuffer:
+                addResource(cmd.copyImageToBuffer.src);
+                addResource(cmd.copyImageToBuffer.dst);
+                for (int r = 0; r < cmd.copyImageToBuffer.regionsCount; ++r)
+                    add(cmd.copyImageToBuffer.regions[r].layers);
+                break;
+            case VKCmdType::CopyBufferToImage:
+                addResource(cmd.copyBufferToImage.src);
+                addResource(cmd.copyBufferToImage.dst);
+                for (int r = 0; r < cmd.copyBufferToImage.regionCount; ++r)
+                    add(cmd.copyBufferToImage.regions[r].imageSubresource);
+                break;
+            case VKCmdType::Present: addResource(cmd.present.image); break;
+            default: break;
+        }
+    }
+
+    frameFingerprint = XXH3_64bits_digest(&state);
+    return XXH3_64bits_withSeed(&frameFingerprint, sizeof(frameFingerprint), previousFrameFingerprint);
+}
+
+bool Graph::GetBarrierRange(VKCmd& cmd, int*& barrierOffset, int*& barrierCount)
+{
+    switch (cmd.type)
+    {
+        case VKCmdType::BeginRenderPass:
+            barrierOffset = &cmd.beginRenderPass.barrierOffset;
+            barrierCount = &cmd.beginRenderPass.barrierCount;
+            return true;
+        case VKCmdType::RGBeginRenderPass:
+            barrierOffset = &cmd.rgBeginRenderPass.barrierOffset;
+            barrierCount = &cmd.rgBeginRenderPass.barrierCount;
+            return true;
+        case VKCmdType::CopyBuffer:
+            barrierOffset = &cmd.copyBuffer.barrierOffset;
+            barrierCount = &cmd.copyBuffer.barrierCount;
+            return true;
+        case VKCmdType::Blit:
+            barrierOffset = &cmd.blit.barrierOffset;
+            barrierCount = &cmd.blit.barrierCount;
+            return true;
+        case VKCmdType::CopyImageToBuffer:
+            barrierOffset = &cmd.copyImageToBuffer.barrierOffset;
+            barrierCount = &cmd.copyImageToBuffer.barrierCount;
+            return true;
+        case VKCmdType::CopyBufferToImage:
+            barrierOffset = &cmd.copyBufferToImage.barrierOffset;
+            barrierCount = &cmd.copyBufferToImage.barrierCount;
+            return true;
+        case VKCmdType::Present:
+            barrierOffset = &cmd.present.barrierOffset;
+            barrierCount = &cmd.present.barrierCount;
+            return true;
+        case VKCmdType::Dispatch:
+            barrierOffset = &cmd.dispatch.barrierOffset;
+            barrierCount = &cmd.dispatch.barrierCount;
+            return true;
+        case VKCmdType::DispatchIndir:
+            barrierOffset = &cmd.dispatchIndir.barrierOffset;
+            barrierCount = &cmd.dispatchIndir.barrierCount;
+            return true;
+        default: return false;
+    }
+}
+
+void Graph::RecordUsage(const UUID& uuid, const ResourceUsageTrack& track)
+{
+    if (recordingPlan == nullptr)
+        return;
+
+    recordingPlan->usages.push_back({uuid, track.type, track.res, track.currentFrameUsages.size() - 1});
+}
+
+void Graph::RecordLayoutCheck(VKImage* image, const Gfx::ImageSubresourceRange& range)
+{
+    if (recordingPlan == nullptr)
+        return;
+
+    VkImageSubresourceRange subresourceRange = Gfx::MapVkImageSubresourceRange(range);
+    VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+    if (!image->QueryLayout(subresourceRange, layout))
+        layout = VK_IMAGE_LAYOUT_MAX_ENUM;
+    recordingPlan->layoutChecks.push_back({image->GetSRef(), subresourceRange, layout});
+}
+
+void Graph::RecordLayoutTransition(VKImage* image, const VkImageSubresourceRange& range, VkImageLayout layout)
+{
+    if (recordingPlan == nullptr)
+        return;
+
+    recordingPlan->layoutTransitions.push_back({image->GetSRef(), range, layout});
+}
+
+void Graph::RecordPlan(SchedulePlan& plan, int cmdBegin, const BarrierCounts& begin)
+{
+    ENGINE_SCOPED_PROFILE("VKRenderGraph: record plan");
+    for (int i = cmdBegin; i < currentSchedulingCmds.size(); ++i)
+    {
+        int* barrierOffset;
+        int* barrierCount;
+        if (GetBarrierRange(currentSchedulingCmds[i], barrierOffset, barrierCount) && *barrierCount != 0)
+        {
+            plan.cmdBarriers.push_back({i - cmdBegin, *barrierOffset - (int)begin.barriers, *barrierCount});
+        }
+    }
+
+    plan.barriers.assign(barriers.begin() + begin.barriers, barriers.end());
+    for (auto& barrier : plan.barriers)
+    {
+        if (barrier.imageMemorybarrierIndex != -1)
+            barrier.imageMemorybarrierIndex -= begin.imageMemoryBarriers;
+        if (barrier.bufferMemoryBarrierIndex != -1)
+            barrier.bufferMemoryBarrierIndex -= begin.bufferMemoryBarriers;
+        if (barrier.memoryBarrierIndex != -1)
+            barrier.memoryBarrierIndex -= begin.memoryBarriers;
+    }
+    plan.imageMemoryBarriers.assign(imageMemoryBarriers.begin() + begin.imageMemoryBarriers, imageMemoryBarriers.end());
+    plan.bufferMemoryBarriers.assign(
+        bufferMemoryBarriers.begin() + begin.bufferMemoryBarriers,
+        bufferMemoryBarriers.end()
+    );
+    plan.memoryBarriers.assign(memoryBarriers.begin() + begin.memoryBarriers, memoryBarriers.end());
+
+    // usages are read back now since later barriers may have updated them, garbage resources were already dropped
+    for (auto iter = plan.usages.begin(); iter != plan.usages.end();)
+    {
+        auto track = resourceUsageTracks.find(iter->uuid);
+        if (track == resourceUsageTracks.end() || iter->usageIndex >= track->second.currentFrameUsages.size())
+        {
+            iter = plan.usages.erase(iter);
+            continue;
+        }
+        iter->usage = track->second.currentFrameUsages[iter->usageIndex];
+        ++iter;
+    }
+}
+
+bool Graph::ReplayPlan(const SchedulePlan& plan, int cmdBegin)
+{
+    ENGINE_SCOPED_PROFILE("VKRenderGraph: replay plan");
+
+    // layouts can be changed outside the graph (e.g. uploads), the plan is only valid if they are what it started from
+    for (auto& check : plan.layoutChecks)
+    {
+        VKImage* image = static_cast<VKImage*>(check.image.Get());
+        if (image == nullptr)
+            return false;
+
+        VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+        if (!image->QueryLayout(check.range, layout))
+            layout = VK_IMAGE_LAYOUT_MAX_ENUM;
+        if (layout != check.layout)
+            return false;
+    }
+
+    int barrierBase = barriers.size();
+    int imageBarrierBase = imageMemoryBarriers.size();
+    int bufferBarrierBase = bufferMemoryBarriers.size();
+    int memoryBarrierBase = memoryBarriers.size();
+    for (auto barrier : plan.barriers)
+    {
+        if (barrier.imageMemorybarrierIndex != -1)
+            barrier.imageMemorybarrierIndex += imageBarrierBase;
+        if (barrier.bufferMemoryBarrierIndex != -1)
+            barrier.bufferMemoryBarrierIndex += bufferBarrierBase;
+        if (barrier.memoryBarrierIndex != -1)
+            barrier.memoryBarrierIndex += memoryBarrierBase;
+        barriers.push_back(barrier);
+    }
+    imageMemoryBarriers.insert(
+        imageMemoryBarriers.end(),
+        plan.imageMemoryBarriers.begin(),
+        plan.imageMemoryBarriers.end()
+    );
+    bufferMemoryBarriers.insert(
+        bufferMemoryBarriers.end(),
+        plan.bufferMemoryBarriers.begin(),
+        plan.bufferMemoryBarriers.end()
+    );
+    memoryBarriers.insert(memoryBarriers.end(), plan.memoryBarriers.begin(), plan.memoryBarriers.end());
+
+    // commands that don't have barriers in the plan still carry whatever was recorded into them
+    for (int i = cmdBegin; i < currentSchedulingCmds.size(); ++i)
+    {
+        int* barrierOffset;
+        int* barrierCount;
+        if (GetBarrierRange(currentSchedulingCmds[i], barrierOffset, barrierCount))
+        {
+            *barrierOffset = barrierBase;
+            *barrierCount = 0;
+        }
+    }
+    for (auto& cmdBarriers : plan.cmdBarriers)
+    {
+        int* barrierOffset;
+        int* barrierCount;
+        GetBarrierRange(currentSchedulingCmds[cmdBegin + cmdBarriers.cmdIndex], barrierOffset, barrierCount);
+        *barrierOffset = barrierBase + cmdBarriers.barrierOffset;
+        *barrierCount = cmdBarriers.barrierCount;
+    }
+
+    for (auto& usage : plan.usages)
+    {
+        auto [track, inserted] = resourceUsageTracks.try_emplace(usage.uuid);
+        if (inserted)
+        {
+            track->second.type = usage.type;
+            track->second.res = usage.res;
+        }
+        track->second.currentFrameUsages.push_back(usage.usage);
+    }
+
+    for (auto& transition : plan.layoutTransitions)
+    {
+        if (VKImage* image = static_cast<VKImage*>(transition.image.Get()))
+            image->SetLayout(transition.range, transition.layout);
+    }
+
+    // only the dynamic state is walked, global resources can point to different buffers and images every frame
+    for (int visitIndex = cmdBegin; visitIndex < currentSchedulingCmds.size(); ++visitIndex)
+    {
+        auto& cmd = currentSchedulingCmds[visitIndex];
+        switch (cmd.type)
+        {
+            case VKCmdType::BindResource:
+                recordState.bindSetCmdIndex[cmd.bindResource.set] = visitIndex;
+                recordState.bindedSetUpdateNeeded[cmd.bindResource.set] = true;
+                break;
+            case VKCmdType::BindShaderProgram: ScheduleBindShaderProgram(cmd, visitIndex); break;
+            case VKCmdType::Draw:
+            case VKCmdType::DrawIndexed:
+            case VKCmdType::DrawIndirect:
+            case VKCmdType::DrawIndexedIndirect:
+            case VKCmdType::Dispatch:
+            case VKCmdType::DispatchIndir:
+                for (bool& updateNeeded : recordState.bindedSetUpdateNeeded)
+                    updateNeeded = false;
+                break;
+            case VKCmdType::SetTexture:
+                globalResourcePool[cmd.setTexture.handle][cmd.setTexture.index] = {
+                    ResourceType::Image,
+                    cmd.setTexture.image != nullptr ? cmd.setTexture.image->GetSRef() : nullptr,
+                    cmd.setTexture.imageViewOption
+                };
+                break;
+            case VKCmdType::SetBuffer:
+                globalResourcePool[cmd.setBuffer.handle][cmd.setTexture.index] =
+                    {ResourceType::Buffer, cmd.setBuffer.buffer->GetSRef(), std::nullopt};
+                break;
+            case VKCmdType::AsyncReadback: asyncReadbacks.push_back(std::move(*cmd.asyncReadback.handle)); break;
+            default: break;
+        }
+    }
+
+    return true;
+}
+
 VKImage* Graph::GetImage(const UUID& hash)
 {
     return resourceAllocator->GetImage(hash);
@@ -1,5 +1,6 @@
 #pragma once
 #include "../VKCommandBuffer.hpp"
+#include <mutex>
 #include <variant>
 
 namespace
@@ -43,6 +44,14 @@ struct ResourceUsageTrack
     std::vector<ResourceUsage> currentFrameUsages;
 };
 
+struct ScheduleStats
+{
+    float scheduleMs = 0;
+    // Schedule calls that replayed a cached plan and ones that went through every command
+    uint32_t reusedPlans = 0;
+    uint32_t rebuiltPlans = 0;
+};
+
 class Graph
 {
 public:
@@ -52,6 +61,16 @@ public:
 
     void Execute(VkCommandBuffer cmd);
 
+    // compiles the graphics pipeline of program with config in the background for each render pass and subpass that
+    // program is drawn in, the passes a material will be drawn in aren't known before its program is drawn
+    void Prewarm(VKShaderProgram* program, const ShaderConfig& config);
+
+    // stats of the last executed frame
+    const ScheduleStats& GetScheduleStats()
+    {
+        return lastFrameScheduleStats;
+    }
+
     VKImage* GetImage(const UUID& id);
     VKImage* Request(RG::ImageIdentifier& id, RG::ImageDescription& desc);
     VKRenderPass* Request(RG::RenderPass& renderPass);
@@ -90,6 +109,7 @@ private:
         VKShaderProgram* lastBindedShader; // shader that is set to be binded
         VKShaderProgram* bindedShader;     // shader that is actually binded
         const ShaderConfig* shaderConfig;
+        uint64_t shaderConfigHash;
         VkDescriptorSet bindedDescriptorSets[4];
         int subpassIndex = -1;
         VKRenderPass* renderPass;
@@ -97,6 +117,28 @@ private:
         bool overrideScissor = false;
     } exeState;
 
+    struct PrewarmRequest
+    {
+        VKShaderProgram* program;
+        ShaderConfig config;
+        uint64_t configHash;
+        int unusedFrames = 0;
+    };
+    struct ProgramPrewarms
+    {
+        std::vector<PrewarmRequest> requests;
+        // the pass the requests were last compiled for, a program is bound many times in a pass
+        VKRenderPass* renderPass = nullptr;
+        int subpassIndex = -1;
+    };
+    // a request whose program isn't drawn for this many frames is dropped
+    int maxPrewarmFrames = 120;
+    std::mutex prewarmMutex;
+    std::vector<PrewarmRequest> prewarmRequests;
+    // requests taken when a frame starts executing, by the program they compile
+    std::unordered_map<VKShaderProgram*, ProgramPrewarms> framePrewarms;
+    void PrewarmPipelines(VKShaderProgram* program);
+
     std::vector<VKCmd> currentSchedulingCmds;
     size_t previousActiveSchedulingCmdsSize;
     std::unordered_map<UUID, ResourceUsageTrack> resourceUsageTracks;
@@ -115,6 +157,69 @@ private:
     //
     std::unique_ptr<ResourceAllocator> resourceAllocator;
 
+    // what scheduling one Schedule call produced, barrier and cmd indices are relative to where the call started
+    struct SchedulePlan
+    {
+        struct CmdBarriers
+        {
+            int cmdIndex;
+            int barrierOffset;
+            int barrierCount;
+        };
+
+        struct Usage
+        {
+            UUID uuid;
+            ResourceType type;
+            std::variant<SRef<Image>, SRef<Buffer>> res;
+            size_t usageIndex;
+            ResourceUsage usage;
+        };
+
+        struct ImageLayout
+        {
+            SRef<Image> image;
+            VkImageSubresourceRange range;
+            VkImageLayout layout;
+        };
+
+        std::vector<CmdBarriers> cmdBarriers;
+        std::vector<Barrier> barriers;
+        std::vector<VkImageMemoryBarrier> imageMemoryBarriers;
+        std::vector<VkBufferMemoryBarrier> bufferMemoryBarriers;
+        std::vector<VkMemoryBarrier> memoryBarriers;
+        std::vector<Usage> usages;
+        // layouts images are expected to be in when they are first used in the frame
+        std::vector<ImageLayout> layoutChecks;
+        std::vector<ImageLayout> layoutTransitions;
+    };
+
+    // plans are keyed by the fingerprint of the previous frame and everything scheduled so far in this frame, so the
+    // resource usages and layouts a plan starts from are the same as when it was recorded
+    std::unordered_map<uint64_t, SchedulePlan> schedulePlans;
+    SchedulePlan* recordingPlan = nullptr;
+    uint64_t frameFingerprint = 0;
+    uint64_t previousFrameFingerprint = 0;
+    ScheduleStats scheduleStats;
+    ScheduleStats lastFrameScheduleStats;
+
+    struct BarrierCounts
+    {
+        size_t barriers;
+        size_t imageMemoryBarriers;
+        size_t bufferMemoryBarriers;
+        size_t memoryBarriers;
+    };
+
+    uint64_t Fingerprint(int cmdBegin);
+    void ScheduleCmds(int cmdBegin);
+    void RecordPlan(SchedulePlan& plan, int cmdBegin, const BarrierCounts& begin);
+    bool ReplayPlan(const SchedulePlan& plan, int cmdBegin);
+    static bool GetBarrierRange(VKCmd& cmd, int*& barrierOffset, int*& barrierCount);
+    void RecordUsage(const UUID& uuid, const ResourceUsageTrack& track);
+    void RecordLayoutCheck(VKImage* image, const Gfx::ImageSubresourceRange& range);
+    void RecordLayoutTransition(VKImage* image, const VkImageSubresourceRange& range, VkImageLayout layout);
+
     void CreateRenderPassNode(int visitIndex);
     // scheduling
     void FlushAllBindedSetUpdate(std::vector<VKImage*>& shaderImageSampleIgnoreList, int& barrierCountAdded);
@@ -132,7 +237,8 @@ private:
     int MakeBarrierForLastUsage(void* res, const UUID& resUUID);
 
     void ScheduleBindShaderProgram(VKCmd& cmd, int visitIndex);
-    void TryBindShader(VkCommandBuffer cmd);
+    // return false when the graphics pipeline isn't ready yet and the draw should be skipped
+    bool TryBindShader(VkCommandBuffer cmd);
     void UpdateDescriptorSetBinding(VkCommandBuffer cmd, uint32_t index, VkPipelineBindPoint bindPoint);
     void UpdateDescriptorSetBinding(VkCommandBuffer cmd, VkPipelineBindPoint bindPoint);
     void PutBarrier(VkCommandBuffer cmd, int index);
@@ -84,6 +84,7 @@ void VKBuffer::SetDebugName(const char* name)
 {
     this->name = name;
     VKDebugUtils::SetDebugName(VK_OBJECT_TYPE_BUFFER, (uint64_t)buffer, name);
+    allocator->SetAllocationName(allocation, this->name);
 }
 
 void VKBuffer::FillMemoryBarrierIfNeeded(
@@ -100,6 +100,7 @@ void VKCommandBuffer::BindShaderProgram(RefPtr<Gfx::ShaderProgram> bProgram, con
     VKCmd cmd{VKCmdType::BindShaderProgram};
     cmd.bindShaderProgram.program = (VKShaderProgram*)bProgram.Get();
     cmd.bindShaderProgram.config = &config;
+    cmd.bindShaderProgram.configHash = config.GetHash();
 
     cmds.push_back(cmd);
 }
@@ -92,6 +92,7 @@ struct VKBindShaderProgramCmd
 {
     VKShaderProgram* program;
     const ShaderConfig* config;
+    uint64_t configHash;
 };
 
 struct VKBindVertexBufferCmd
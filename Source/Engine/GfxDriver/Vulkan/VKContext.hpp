@@ -10,6 +10,7 @@ namespace Gfx
 {
 class VKSwapChainImage;
 class VKDriver;
+class VKPipelineCache;
 
 struct Queue
 {
@@ -86,6 +87,7 @@ public:
     VKObjectManager* objManager;
     VKSharedResource* sharedResource;
     VKDescriptorPoolCache* descriptorPoolCache;
+    VKPipelineCache* pipelineCache;
 
 private:
     static VKContext* context;
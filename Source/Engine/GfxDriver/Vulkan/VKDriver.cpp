@@ -3,6 +3,7 @@
 #include "Internal/VKEnumMapper.hpp"
 #include "Internal/VKMemAllocator.hpp"
 #include "Internal/VKObjectManager.hpp"
+#include "Internal/VKPipelineCache.hpp"
 #include "Profiler/Profiler.hpp"
 #include "RHI/VKDataUploader.hpp"
 #include "VKBuffer.hpp"
@@ -59,6 +60,9 @@ VKDriver::VKDriver(const CreateInfo& createInfo)
     CreateDevice();
 
     objectManager = std::make_unique<VKObjectManager>(device.handle);
+    pipelineCache =
+        std::make_unique<VKPipelineCache>(device.handle, gpu.physicalDeviceProperties, createInfo.pipelineCachePath);
+    objectManager->SetPipelineCache(pipelineCache->GetHandle());
     memAllocator =
         std::make_unique<VKMemAllocator>(instance.handle, device.handle, gpu.handle, mainQueue.queueFamilyIndex);
     context = std::make_unique<VKContext>();
@@ -71,6 +75,7 @@ VKDriver::VKDriver(const CreateInfo& createInfo)
     context->gpu = &gpu;
     context->swapchain = &swapchain;
     context->mainQueue = &mainQueue;
+    context->pipelineCache = pipelineCache.get();
 
     swapchain.CreateOrOverrideSwapChain(surface, driverConfig.swapchainImageCount);
 
@@ -133,6 +138,9 @@ VKDriver::~VKDriver()
     dataUploader = nullptr;
     objectManager->DestroyPendingResources();
 
+    pipelineCache->Save();
+    pipelineCache = nullptr;
+
     swapchain.swapchainImage = nullptr;
 
     // destroy inflight data
@@ -477,6 +485,9 @@ std::unique_ptr<ShaderResource> VKDriver::CreateShaderResource()
 bool VKDriver::BeginFrame()
 {
     ENGINE_SCOPED_PROFILE("VKDriver - BeginFrame");
+    if (firstFrame)
+        firstFrameBegin = std::chrono::high_resolution_clock::now();
+
     // acquire next swapchain
     VkResult acquireResult = vkAcquireNextImageKHR(
         device.handle,
@@ -565,7 +576,6 @@ bool VKDriver::EndFrame()
         firstFrame ? VK_NULL_HANDLE : dataUploaderWaitSemaphore,
         VK_PIPELINE_STAGE_ALL_GRAPHICS_BIT
     );
-    firstFrame = false;
 
     VKCommandBuffer cmd2(renderGraph.get());
     cmd2.PresentImage(swapchain.swapchainImage->GetImage(inflightData[currentInflightIndex].swapchainIndex));
@@ -658,6 +668,19 @@ bool VKDriver::EndFrame()
     // uploads it
     dataUploader->WaitForUploadFinish();
 
+    if (firstFrame)
+    {
+        // the first frame compiles every pipeline it uses, this is where a warm pipeline cache pays off
+        auto elapsed = std::chrono::high_resolution_clock::now() - firstFrameBegin;
+        float firstFrameTime = std::chrono::duration<float, std::milli>(elapsed).count();
+        SPDLOG_INFO(
+            "VKDriver: first frame took {} ms, pipeline cache loaded {} bytes",
+            firstFrameTime,
+            pipelineCache->GetLoadedSize()
+        );
+        firstFrame = false;
+    }
+
     return swapchainRecreated;
 }
 
@@ -1163,6 +1186,34 @@ void VKDriver::UploadImage(
     dataUploader->UploadImage(&vkDst, data, size, mipLevel, arrayLayer, Gfx::MapImageAspect(aspect), finalLayout);
 }
 
+void VKDriver::UploadImageRegions(
+    Gfx::Image& dst, uint8_t* data, std::span<const ImageUploadRegion> regions, Gfx::ImageAspect aspect
+)
+{
+    std::scoped_lock lock(driverMutex);
+    auto& vkDst = static_cast<VKImage&>(dst);
+    dataUploader->UploadImageRegions(
+        &vkDst,
+        data,
+        regions,
+        Gfx::MapImageAspect(aspect),
+        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+    );
+}
+
+void VKDriver::CopyImageMips(Gfx::Image& src, Gfx::Image& dst, uint32_t srcMip, uint32_t dstMip, uint32_t levelCount)
+{
+    std::scoped_lock lock(driverMutex);
+    dataUploader->CopyImageMips(
+        &static_cast<VKImage&>(src),
+        &static_cast<VKImage&>(dst),
+        srcMip,
+        dstMip,
+        levelCount,
+        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+    );
+}
+
 void VKDriver::ExecuteCommandBuffer(Gfx::CommandBuffer& cmd)
 {
     renderGraph->Schedule((VKCommandBuffer&)cmd);
@@ -1229,6 +1280,46 @@ Window* VKDriver::CreateExtraWindow(SDL_Window* window)
     return tmp;
 }
 
+void VKDriver::PrewarmShaderProgram(Gfx::ShaderProgram& program, const Gfx::ShaderConfig& config)
+{
+    renderGraph->Prewarm(static_cast<VKShaderProgram*>(&program), config);
+}
+
+PipelineCompileStats VKDriver::GetPipelineCompileStats()
+{
+    PipelineCompileStats stats;
+    stats.stutterEvents = pipelineCache->GetSyncCompileCount();
+    stats.asyncCompiles = pipelineCache->GetAsyncCompileCount();
+    stats.pendingCompiles = objectManager->GetAsyncPipelineCompileCount();
+    stats.skippedDraws = pipelineCache->GetSkippedDrawCount();
+    return stats;
+}
+
+FrameScheduleStats VKDriver::GetFrameScheduleStats()
+{
+    auto& graphStats = renderGraph->GetScheduleStats();
+    FrameScheduleStats stats;
+    stats.scheduleMs = graphStats.scheduleMs;
+    stats.reusedPlans = graphStats.reusedPlans;
+    stats.rebuiltPlans = graphStats.rebuiltPlans;
+    return stats;
+}
+
+GPUMemoryStats VKDriver::GetGPUMemoryStats()
+{
+    return memAllocator->GetMemoryStats();
+}
+
+std::string VKDriver::DumpGPUMemory()
+{
+    return memAllocator->DumpMemory();
+}
+
+void VKDriver::SetAsyncPipelineCompilation(bool enable)
+{
+    pipelineCache->SetAsyncCompilation(enable);
+}
+
 void VKDriver::DestroyExtraWindow(Window* window)
 {
     auto iter = std::find_if(extraWindows.begin(), extraWindows.end(), [window](auto& w) { return w.get() == window; });
@@ -1,5 +1,6 @@
 #pragma once
 #include <SDL.h>
+#include <chrono>
 #include <glm/glm.hpp>
 #include <memory>
 #include <unordered_map>
@@ -34,6 +35,7 @@ class VKRenderPass;
 class VKSharedResource;
 class VKContext;
 class VKDataUploader;
+class VKPipelineCache;
 struct VKDescriptorPoolCache;
 
 class VKDriver : public Gfx::GfxDriver
@@ -79,6 +81,12 @@ public:
     UniPtr<Image> CreateImage(const ImageDescription& description, ImageUsageFlags usages) override;
     Window* CreateExtraWindow(SDL_Window* window) override;
     void DestroyExtraWindow(Window* window) override;
+    void PrewarmShaderProgram(Gfx::ShaderProgram& program, const Gfx::ShaderConfig& config) override;
+    PipelineCompileStats GetPipelineCompileStats() override;
+    FrameScheduleStats GetFrameScheduleStats() override;
+    GPUMemoryStats GetGPUMemoryStats() override;
+    std::string DumpGPUMemory() override;
+    void SetAsyncPipelineCompilation(bool enable) override;
     std::unique_ptr<CommandBuffer> CreateCommandBuffer() override;
 
     std::unique_ptr<ShaderProgram> CreateShaderProgram(
@@ -95,6 +103,12 @@ public:
     void UploadImage(
         Gfx::Image& dst, uint8_t* data, size_t size, uint32_t mipLevel, uint32_t arrayLayer, Gfx::ImageAspect aspect
     ) override;
+    void UploadImageRegions(
+        Gfx::Image& dst, uint8_t* data, std::span<const ImageUploadRegion> regions, Gfx::ImageAspect aspect
+    ) override;
+    void CopyImageMips(
+        Gfx::Image& src, Gfx::Image& dst, uint32_t srcMip, uint32_t dstMip, uint32_t levelCount
+    ) override;
 
     void UploadImage(
         Gfx::Image& dst,
@@ -127,6 +141,7 @@ public:
     std::unique_ptr<VKSharedResource> sharedResource;
     std::unique_ptr<VKDescriptorPoolCache> descriptorPoolCache;
     std::unique_ptr<VKDataUploader> dataUploader;
+    std::unique_ptr<VKPipelineCache> pipelineCache;
     VkCommandPool mainCmdPool;
 
     struct DriverConfig
@@ -171,6 +186,7 @@ public:
     VkSemaphore transferSignalSemaphore;
     VkSemaphore dataUploaderWaitSemaphore = VK_NULL_HANDLE;
     bool firstFrame = true;
+    std::chrono::high_resolution_clock::time_point firstFrameBegin;
     std::unique_ptr<VK::RenderGraph::Graph> renderGraph;
 
     VkCommandBuffer immediateCmd = VK_NULL_HANDLE;
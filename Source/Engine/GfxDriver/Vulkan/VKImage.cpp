@@ -156,6 +156,8 @@ void VKImage::SetName(std::string_view name)
     this->name = name;
 
     VKDebugUtils::SetDebugName(VK_OBJECT_TYPE_IMAGE, (uint64_t)image_vk, this->name.c_str());
+    if (allocation_vma != VK_NULL_HANDLE)
+        VKContext::Instance()->allocator->SetAllocationName(allocation_vma, this->name);
 }
 
 // TODO: this needs improvement. Cube and some others are not handled
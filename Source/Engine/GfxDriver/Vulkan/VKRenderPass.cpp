@@ -2,6 +2,7 @@
 #include "Internal/VKEnumMapper.hpp"
 #include "Internal/VKObjectManager.hpp"
 #include "Internal/VKUtils.hpp"
+#include "ThirdParty/xxHash/xxhash.h"
 #include "VKContext.hpp"
 #include "VKImage.hpp"
 #include "VKImageView.hpp"
@@ -210,6 +211,28 @@ void VKRenderPass::CreateRenderPass()
     createInfo.pDependencies = &externalDependency;
 
     VKContext::Instance()->objManager->CreateRenderPass(createInfo, renderPass);
+
+    // load/store ops and layouts don't affect render pass compatibility, only formats, samples and the attachment
+    // each subpass reference points at do
+    std::vector<uint32_t> keys;
+    keys.reserve(attachmentCount * 2 + refIndex + subpasses.size() * 3);
+    for (uint32_t i = 0; i < attachmentCount; ++i)
+    {
+        keys.push_back(attachmentDescriptions[i].format);
+        keys.push_back(attachmentDescriptions[i].samples);
+    }
+    for (uint32_t s = 0; s < createInfo.subpassCount; ++s)
+    {
+        const VkSubpassDescription& desc = subpassDescriptions[s];
+        keys.push_back(desc.inputAttachmentCount);
+        for (uint32_t i = 0; i < desc.inputAttachmentCount; ++i)
+            keys.push_back(desc.pInputAttachments[i].attachment);
+        keys.push_back(desc.colorAttachmentCount);
+        for (uint32_t i = 0; i < desc.colorAttachmentCount; ++i)
+            keys.push_back(desc.pColorAttachments[i].attachment);
+        keys.push_back(desc.pDepthStencilAttachment ? desc.pDepthStencilAttachment->attachment : VK_ATTACHMENT_UNUSED);
+    }
+    compatibilityHash = XXH3_64bits(keys.data(), keys.size() * sizeof(uint32_t));
 }
 
 Extent2D VKRenderPass::GetExtent()
@@ -34,6 +34,13 @@ public:
     VkRenderPass GetHandle();
     Extent2D GetExtent();
 
+    // render passes with the same hash are compatible (same attachment formats, sample counts and subpass layout), a
+    // pipeline created against one of them can be used with any other. Valid after GetHandle
+    uint64_t GetCompatibilityHash()
+    {
+        return compatibilityHash;
+    }
+
     const std::vector<Subpass>& GetSubpesses()
     {
         return subpasses;
@@ -44,6 +51,7 @@ protected:
     VkFramebuffer CreateFrameBuffer();
 
     VkRenderPass renderPass = VK_NULL_HANDLE;
+    uint64_t compatibilityHash = 0;
 
     // when one of the color attachment is a swap chain image proxy there will be multiple framebuffers, otherwise there
     // is only one
@@ -2,7 +2,9 @@
 
 #include "Internal/VKEnumMapper.hpp"
 #include "Internal/VKObjectManager.hpp"
+#include "Internal/VKPipelineCache.hpp"
 #include "Internal/VKSwapChain.hpp"
+#include "Libs/JobSystem.hpp"
 #include "ThirdParty/xxHash/xxhash.h"
 #include "VKContext.hpp"
 #include "VKDescriptorPool.hpp"
@@ -161,14 +163,20 @@ VKShaderProgram::VKShaderProgram(
 
 VKShaderProgram::~VKShaderProgram()
 {
+    // jobs reference this program, they have to finish before anything is destroyed
+    for (auto& pending : pendingCaches)
+    {
+        objManager->DestroyPipeline(pending.second.pipeline.get());
+    }
+
     if (pipelineLayout)
     {
         objManager->DestroyPipelineLayout(pipelineLayout);
     }
 
-    for (auto v : caches)
+    for (auto& v : caches)
     {
-        objManager->DestroyPipeline(v.pipeline);
+        objManager->DestroyPipeline(v.second.pipeline);
     }
 }
 
@@ -358,7 +366,7 @@ VkPipeline VKShaderProgram::RequestComputePipeline(const ShaderConfig& config)
     if (isCompute)
     {
         if (!caches.empty())
-            return caches.front().pipeline;
+            return caches.begin()->second.pipeline;
 
         VkComputePipelineCreateInfo createInfo{
             .sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
@@ -376,7 +384,7 @@ VkPipeline VKShaderProgram::RequestComputePipeline(const ShaderConfig& config)
         PipelineCache newCache;
         newCache.pipeline = pipeline;
         newCache.config = config;
-        caches.push_back(newCache);
+        caches[0] = newCache;
 
         return pipeline;
     }
@@ -388,15 +396,98 @@ VkPipeline VKShaderProgram::RequestComputePipeline(const ShaderConfig& config)
 }
 
 VkPipeline VKShaderProgram::RequestGraphicsPipeline(
-    const ShaderConfig& config, VKRenderPass* renderPass, uint32_t subpassIndex
+    const ShaderConfig& config, uint64_t configHash, VKRenderPass* renderPass, uint32_t subpassIndex, bool async
 )
 {
-    for (auto& cache : caches)
+    // GetHandle may recreate the render pass, which updates the compatibility hash
+    VkRenderPass renderPassHandle = renderPass->GetHandle();
+    uint64_t renderPassHash = renderPass->GetCompatibilityHash();
+    const uint64_t key[] = {configHash, renderPassHash, subpassIndex};
+    uint64_t pipelineHash = XXH3_64bits(key, sizeof(key));
+
+    // a different pipeline that collides with the hash probes on to the next key instead of being returned
+    auto pendingIter = pendingCaches.end();
+    for (;; ++pipelineHash)
+    {
+        auto iter = caches.find(pipelineHash);
+        if (iter != caches.end())
+        {
+            if (iter->second.renderPassCompatibilityHash == renderPassHash && iter->second.subpass == subpassIndex &&
+                iter->second.config == config)
+                return iter->second.pipeline;
+            continue;
+        }
+
+        pendingIter = pendingCaches.find(pipelineHash);
+        if (pendingIter == pendingCaches.end() ||
+            (pendingIter->second.renderPassCompatibilityHash == renderPassHash &&
+             pendingIter->second.subpass == subpassIndex && pendingIter->second.config == config))
+            break;
+    }
+
+    auto pipelineCache = VKContext::Instance()->pipelineCache;
+    if (pendingIter != pendingCaches.end())
     {
-        if (cache.config == config && cache.subpass == subpassIndex && cache.renderPass == renderPass->GetHandle())
-            return cache.pipeline;
+        // a synchronous request can't be skipped, wait for the worker instead of compiling it twice
+        if (async && pendingIter->second.pipeline.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+            return VK_NULL_HANDLE;
+
+        PipelineCache newCache;
+        newCache.pipeline = pendingIter->second.pipeline.get();
+        newCache.config = pendingIter->second.config;
+        newCache.renderPassCompatibilityHash = renderPassHash;
+        newCache.subpass = subpassIndex;
+        pendingCaches.erase(pendingIter);
+        caches[pipelineHash] = newCache;
+        return newCache.pipeline;
+    }
+
+    uint32_t colorAttachmentCount = renderPass->GetSubpesses()[subpassIndex].colors.size();
+    VkExtent2D extent = GetSwapchain()->extent;
+
+    if (async)
+    {
+        // the job holds a copy of the config, the caller's config may be gone by the time it runs
+        objManager->BeginAsyncPipelineCompile();
+        pipelineCache->RecordAsyncCompile();
+        PendingPipeline pending;
+        pending.renderPassCompatibilityHash = renderPassHash;
+        pending.subpass = subpassIndex;
+        pending.config = config;
+        pending.pipeline = JobSystem::GetSingleton().Schedule(
+            [this, config, renderPassHandle, subpassIndex, colorAttachmentCount, extent]()
+            {
+                VkPipeline pipeline =
+                    CreateGraphicsPipeline(config, renderPassHandle, subpassIndex, colorAttachmentCount, extent);
+                objManager->EndAsyncPipelineCompile();
+                return pipeline;
+            }
+        );
+        pendingCaches[pipelineHash] = std::move(pending);
+        return VK_NULL_HANDLE;
     }
 
+    pipelineCache->RecordSyncCompile();
+    VkPipeline pipeline = CreateGraphicsPipeline(config, renderPassHandle, subpassIndex, colorAttachmentCount, extent);
+
+    PipelineCache newCache;
+    newCache.pipeline = pipeline;
+    newCache.config = config;
+    newCache.renderPassCompatibilityHash = renderPassHash;
+    newCache.subpass = subpassIndex;
+    caches[pipelineHash] = newCache;
+
+    return pipeline;
+}
+
+VkPipeline VKShaderProgram::CreateGraphicsPipeline(
+    const ShaderConfig& config,
+    VkRenderPass renderPass,
+    uint32_t subpassIndex,
+    uint32_t colorAttachmentCount,
+    VkExtent2D extent
+)
+{
     VkGraphicsPipelineCreateInfo createInfo;
     createInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
     createInfo.pNext = VK_NULL_HANDLE;
@@ -434,8 +525,8 @@ VkPipeline VKShaderProgram::RequestGraphicsPipeline(
     VkViewport viewPort{};
     viewPort.x = 0;
     viewPort.y = 0;
-    viewPort.width = GetSwapchain()->extent.width;
-    viewPort.height = GetSwapchain()->extent.height;
+    viewPort.width = extent.width;
+    viewPort.height = extent.height;
     viewPort.minDepth = 0;
     viewPort.maxDepth = 1;
     pipelineViewportStateCreateInfo.pViewports = &viewPort;
@@ -443,7 +534,7 @@ VkPipeline VKShaderProgram::RequestGraphicsPipeline(
 
     VkRect2D scissor;
     pipelineViewportStateCreateInfo.scissorCount = 1;
-    scissor.extent = {GetSwapchain()->extent.width, GetSwapchain()->extent.height};
+    scissor.extent = extent;
     scissor.offset = {0, 0};
     pipelineViewportStateCreateInfo.pScissors = &scissor;
 
@@ -499,10 +590,8 @@ VkPipeline VKShaderProgram::RequestGraphicsPipeline(
     colorBlendStateCreateInfo.logicOp = VK_LOGIC_OP_AND;
 
     // protect unwritten output with color mask
-    auto& subpass = renderPass->GetSubpesses()[subpassIndex];
-    size_t subpassSize = subpass.colors.size();
-    std::vector<VkPipelineColorBlendAttachmentState> blendStates(subpassSize);
-    for (uint32_t i = 0; i < subpassSize; ++i)
+    std::vector<VkPipelineColorBlendAttachmentState> blendStates(colorAttachmentCount);
+    for (uint32_t i = 0; i < colorAttachmentCount; ++i)
     {
         if (i < config.color.blends.size())
         {
@@ -547,7 +636,7 @@ VkPipeline VKShaderProgram::RequestGraphicsPipeline(
     createInfo.pDynamicState = &dynamicStateCreateInfo;
 
     createInfo.layout = pipelineLayout;
-    createInfo.renderPass = renderPass->GetHandle();
+    createInfo.renderPass = renderPass;
     createInfo.subpass = subpassIndex;
     createInfo.basePipelineHandle = VK_NULL_HANDLE;
     createInfo.basePipelineIndex = 0;
@@ -555,13 +644,6 @@ VkPipeline VKShaderProgram::RequestGraphicsPipeline(
     VkPipeline pipeline;
     objManager->CreateGraphicsPipeline(createInfo, pipeline);
 
-    PipelineCache newCache;
-    newCache.pipeline = pipeline;
-    newCache.config = config;
-    newCache.renderPass = renderPass->GetHandle();
-    newCache.subpass = subpassIndex;
-    caches.push_back(newCache);
-
     return pipeline;
 }
 
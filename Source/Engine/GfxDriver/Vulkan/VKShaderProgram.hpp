@@ -3,6 +3,7 @@
 #include "../DescriptorSetSlot.hpp"
 #include "../ShaderProgram.hpp"
 #include "VKShaderInfo.hpp"
+#include <future>
 #include <memory>
 #include <unordered_map>
 #include <vector>
@@ -51,9 +52,13 @@ public:
         return GetLayoutHash(set) != 0;
     }
 
-    // request a pipeline object according to config
-    // we may have slightly different pipelines with different configs, VKShader should cache these pipelines(TODO)
-    VkPipeline RequestGraphicsPipeline(const ShaderConfig& config, VKRenderPass* renderPass, uint32_t subpass);
+    // request a pipeline object according to config, pipelines are cached by the hash of (config, render pass
+    // compatibility, subpass). configHash is config.GetHash(), it's computed once when the bind is recorded
+    // when async is true a missing pipeline is compiled on a worker thread and VK_NULL_HANDLE is returned until it's
+    // ready, the caller is expected to skip the draw
+    VkPipeline RequestGraphicsPipeline(
+        const ShaderConfig& config, uint64_t configHash, VKRenderPass* renderPass, uint32_t subpass, bool async = false
+    );
     VkPipeline RequestComputePipeline(const ShaderConfig& config);
     VKDescriptorPool& GetDescriptorPool(DescriptorSetSlot slot);
 
@@ -82,7 +87,15 @@ private:
     struct PipelineCache
     {
         VkPipeline pipeline;
-        VkRenderPass renderPass;
+        uint64_t renderPassCompatibilityHash;
+        uint32_t subpass;
+        ShaderConfig config;
+    };
+
+    struct PendingPipeline
+    {
+        std::future<VkPipeline> pipeline;
+        uint64_t renderPassCompatibilityHash;
         uint32_t subpass;
         ShaderConfig config;
     };
@@ -94,7 +107,8 @@ private:
     std::unique_ptr<VKShaderModule> fragShaderModule;
     std::unique_ptr<VKShaderModule> computeShaderModule;
     VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
-    std::vector<PipelineCache> caches = {};
+    std::unordered_map<uint64_t, PipelineCache> caches = {};
+    std::unordered_map<uint64_t, PendingPipeline> pendingCaches = {};
     std::vector<VkSampler> immutableSamplers = {};
     std::vector<size_t> layoutHash = {};
     std::vector<RefPtr<VKDescriptorPool>> descriptorPools = {};
@@ -106,6 +120,15 @@ private:
     void CreateShaderPipeline(std::shared_ptr<const ShaderConfig> config, VKShaderModule* fallbackConfigModule);
     void GeneratePipelineLayoutAndGetDescriptorPool(DescriptorSetBindings& combined);
 
+    // only reads immutable state of the program so it can run on a worker thread
+    VkPipeline CreateGraphicsPipeline(
+        const ShaderConfig& config,
+        VkRenderPass renderPass,
+        uint32_t subpassIndex,
+        uint32_t colorAttachmentCount,
+        VkExtent2D extent
+    );
+
     std::shared_ptr<const ShaderConfig> defaultShaderConfig = {};
 };
 } // namespace Gfx
@@ -6,6 +6,7 @@
 #include "VKDriver.hpp"
 #include "VKShaderProgram.hpp"
 #include "VKSharedResource.hpp"
+#include <atomic>
 #include <fmt/format.h>
 #include <spdlog/spdlog.h>
 
@@ -36,7 +37,15 @@ DescriptorSetSlot MapDescriptorSetSlot(ShaderResourceFrequency frequency)
     }
 }
 
-VKShaderResource::VKShaderResource() : sharedResource(VKContext::Instance()->sharedResource), sets(0) {}
+static uint64_t NextVersion()
+{
+    static std::atomic<uint64_t> version = 0;
+    return ++version;
+}
+
+VKShaderResource::VKShaderResource()
+    : sharedResource(VKContext::Instance()->sharedResource), sets(0), version(NextVersion())
+{}
 
 VKShaderResource::~VKShaderResource()
 {
@@ -52,6 +61,7 @@ void VKShaderResource::RebuildAll()
     {
         d.second.rebuild = true;
     }
+    version = NextVersion();
 }
 
 void VKShaderResource::SetBuffer(ShaderBindingHandle handle, int index, Gfx::Buffer* buffer)
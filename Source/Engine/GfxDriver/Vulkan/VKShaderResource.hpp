@@ -63,6 +63,12 @@ public:
     VkDescriptorSet GetDescriptorSet(uint32_t set, VKShaderProgram* shaderProgram);
     const std::vector<VKWritableGPUResource>& GetWritableResources(uint32_t set, VKShaderProgram* shaderProgram);
 
+    // changes whenever a binding changes, unique across all shader resources
+    uint64_t GetVersion()
+    {
+        return version;
+    }
+
     // ---------------------------- Old API ----------------------------------
 public:
     ~VKShaderResource() override;
@@ -121,6 +127,7 @@ protected:
     std::unordered_map<VKShaderProgram*, SetInfo> sets;
 
     std::unique_ptr<VKBuffer> defaultBuffer;
+    uint64_t version;
 
     void RebuildAll();
 };
@@ -6,12 +6,945 @@
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 #include "AssetDatabase/AssetDatabase.hpp"
 #include "AssetDatabase/Exporters/KtxExporter.hpp"
+#include "Libs/JobSystem.hpp"
 #include "ThirdParty/stb/stb_image_write.h"
+#include <glm/gtc/packing.hpp>
+#include <limits>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define IMAGE_PROCESSING_SSE2
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define IMAGE_PROCESSING_NEON
+#endif
 
 namespace Libs::Image
 {
+namespace
+{
+// lookup tables for the sRGB transfer function, encoding has enough entries that dark values still round to the
+// right 8 bit code
+struct SRGBTables
+{
+    static constexpr int encodeSize = 16384;
+    float decode[256];
+    uint8_t encode[encodeSize];
+
+    SRGBTables()
+    {
+        for (int i = 0; i < 256; ++i)
+        {
+            float c = i / 255.0f;
+            decode[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+        }
+        for (int i = 0; i < encodeSize; ++i)
+        {
+            float l = i / float(encodeSize - 1);
+            float c = l <= 0.0031308f ? l * 12.92f : 1.055f * std::pow(l, 1 / 2.4f) - 0.055f;
+            encode[i] = uint8_t(c * 255 + 0.5f);
+        }
+    }
+};
+
+const SRGBTables& GetSRGBTables()
+{
+    static SRGBTables tables;
+    return tables;
+}
+
+// every half value decoded up front, cheaper than converting per channel without F16C
+const float* GetHalfTable()
+{
+    static std::vector<float> table = []()
+    {
+        std::vector<float> t(65536);
+        for (uint32_t i = 0; i < t.size(); ++i)
+            t[i] = glm::unpackHalf1x16(uint16_t(i));
+        return t;
+    }();
+    return table.data();
+}
+
+// alpha is the last channel of gray + alpha and rgba images and isn't sRGB encoded, -1 when there is none
+constexpr int AlphaChannel(int channels)
+{
+    return channels == 2 || channels == 4 ? channels - 1 : -1;
+}
+
+// vertical pass, sum[i] = r0[i] + r1[i]. These carry most of the memory traffic so they are written with intrinsics,
+// the horizontal pass below has a compile time channel count and is left to the compiler
+void AddRows(const uint8_t* r0, const uint8_t* r1, uint16_t* sum, int n)
+{
+    int i = 0;
+#if defined(IMAGE_PROCESSING_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 16 <= n; i += 16)
+    {
+        __m128i a = _mm_loadu_si128((const __m128i*)(r0 + i));
+        __m128i b = _mm_loadu_si128((const __m128i*)(r1 + i));
+        _mm_storeu_si128((__m128i*)(sum + i), _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero)));
+        _mm_storeu_si128(
+            (__m128i*)(sum + i + 8),
+            _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero))
+        );
+    }
+#elif defined(IMAGE_PROCESSING_NEON)
+    for (; i + 16 <= n; i += 16)
+    {
+        uint8x16_t a = vld1q_u8(r0 + i);
+        uint8x16_t b = vld1q_u8(r1 + i);
+        vst1q_u16(sum + i, vaddl_u8(vget_low_u8(a), vget_low_u8(b)));
+        vst1q_u16(sum + i + 8, vaddl_u8(vget_high_u8(a), vget_high_u8(b)));
+    }
+#endif
+    for (; i < n; ++i)
+        sum[i] = r0[i] + r1[i];
+}
+
+void AddRows(const uint16_t* r0, const uint16_t* r1, float* sum, int n)
+{
+    int i = 0;
+#if defined(IMAGE_PROCESSING_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 8 <= n; i += 8)
+    {
+        __m128i a = _mm_loadu_si128((const __m128i*)(r0 + i));
+        __m128i b = _mm_loadu_si128((const __m128i*)(r1 + i));
+        __m128i lo = _mm_add_epi32(_mm_unpacklo_epi16(a, zero), _mm_unpacklo_epi16(b, zero));
+        __m128i hi = _mm_add_epi32(_mm_unpackhi_epi16(a, zero), _mm_unpackhi_epi16(b, zero));
+        _mm_storeu_ps(sum + i, _mm_cvtepi32_ps(lo));
+        _mm_storeu_ps(sum + i + 4, _mm_cvtepi32_ps(hi));
+    }
+#elif defined(IMAGE_PROCESSING_NEON)
+    for (; i + 8 <= n; i += 8)
+    {
+        uint16x8_t a = vld1q_u16(r0 + i);
+        uint16x8_t b = vld1q_u16(r1 + i);
+        vst1q_f32(sum + i, vcvtq_f32_u32(vaddl_u16(vget_low_u16(a), vget_low_u16(b))));
+        vst1q_f32(sum + i + 4, vcvtq_f32_u32(vaddl_u16(vget_high_u16(a), vget_high_u16(b))));
+    }
+#endif
+    for (; i < n; ++i)
+        sum[i] = float(r0[i] + r1[i]);
+}
+
+void AddRows(const float* r0, const float* r1, float* sum, int n)
+{
+    int i = 0;
+#if defined(IMAGE_PROCESSING_SSE2)
+    for (; i + 4 <= n; i += 4)
+        _mm_storeu_ps(sum + i, _mm_add_ps(_mm_loadu_ps(r0 + i), _mm_loadu_ps(r1 + i)));
+#elif defined(IMAGE_PROCESSING_NEON)
+    for (; i + 4 <= n; i += 4)
+        vst1q_f32(sum + i, vaddq_f32(vld1q_f32(r0 + i), vld1q_f32(r1 + i)));
+#endif
+    for (; i < n; ++i)
+        sum[i] = r0[i] + r1[i];
+}
+
+// horizontal pass, adds the two summed texels of each destination texel and encodes the result
+template <int C, class S, class T, class Encode>
+void CollapseRow(const S* sum, T* dst, int srcWidth, int dstWidth, Encode encode)
+{
+    for (int j = 0; j < dstWidth; ++j)
+    {
+        // a one texel wide source has nothing to the right
+        int x0 = 2 * j;
+        int x1 = glm::min(x0 + 1, srcWidth - 1);
+        for (int c = 0; c < C; ++c)
+            dst[j * C + c] = encode(sum[x0 * C + c] + sum[x1 * C + c], c);
+    }
+}
+
+template <int C>
+void ReduceRow(
+    ChannelType type,
+    bool srgb,
+    const uint8_t* r0,
+    const uint8_t* r1,
+    uint8_t* dst,
+    int srcWidth,
+    int dstWidth,
+    std::vector<float>& scratch
+)
+{
+    const int n = glm::min(srcWidth, dstWidth * 2) * C;
+    scratch.resize(n);
+    float* sum = scratch.data();
+    switch (type)
+    {
+        case ChannelType::UInt8:
+            {
+                if (srgb)
+                {
+                    const SRGBTables& tables = GetSRGBTables();
+                    for (int i = 0; i < n; i += C)
+                    {
+                        for (int c = 0; c < C; ++c)
+                        {
+                            sum[i + c] = c == AlphaChannel(C)
+                                             ? (r0[i + c] + r1[i + c]) / 255.0f
+                                             : tables.decode[r0[i + c]] + tables.decode[r1[i + c]];
+                        }
+                    }
+                    auto encode = [&tables](float v, int c) -> uint8_t
+                    {
+                        v = glm::min(v * 0.25f, 1.0f);
+                        return c == AlphaChannel(C) ? uint8_t(v * 255 + 0.5f)
+                                                    : tables.encode[int(v * (SRGBTables::encodeSize - 1) + 0.5f)];
+                    };
+                    CollapseRow<C>(sum, dst, srcWidth, dstWidth, encode);
+                }
+                else
+                {
+                    // two bytes per element fit in the float scratch
+                    uint16_t* sum16 = (uint16_t*)sum;
+                    AddRows(r0, r1, sum16, n);
+                    auto encode = [](int v, int) { return uint8_t((v + 2) >> 2); };
+                    CollapseRow<C>(sum16, dst, srcWidth, dstWidth, encode);
+                }
+                break;
+            }
+        case ChannelType::UInt16:
+            {
+                AddRows((const uint16_t*)r0, (const uint16_t*)r1, sum, n);
+                auto encode = [](float v, int) { return uint16_t(v * 0.25f + 0.5f); };
+                CollapseRow<C>(sum, (uint16_t*)dst, srcWidth, dstWidth, encode);
+                break;
+            }
+        case ChannelType::Half:
+            {
+                const float* halfTable = GetHalfTable();
+                const uint16_t* h0 = (const uint16_t*)r0;
+                const uint16_t* h1 = (const uint16_t*)r1;
+                for (int i = 0; i < n; ++i)
+                    sum[i] = halfTable[h0[i]] + halfTable[h1[i]];
+                auto encode = [](float v, int) { return uint16_t(glm::packHalf1x16(v * 0.25f)); };
+                CollapseRow<C>(sum, (uint16_t*)dst, srcWidth, dstWidth, encode);
+                break;
+            }
+        case ChannelType::Float:
+            {
+                AddRows((const float*)r0, (const float*)r1, sum, n);
+                auto encode = [](float v, int) { return v * 0.25f; };
+                CollapseRow<C>(sum, (float*)dst, srcWidth, dstWidth, encode);
+                break;
+            }
+    }
+}
+
+using ReduceRowFn =
+    void (*)(ChannelType, bool, const uint8_t*, const uint8_t*, uint8_t*, int, int, std::vector<float>&);
+
+// byte offset of every level in a [level [layer]] mip chain, the last entry is the total size
+std::vector<size_t> GetLevelOffsets(int width, int height, int layers, int levels, size_t texelSize)
+{
+    std::vector<size_t> levelOffsets(levels + 1);
+    for (int i = 0; i < levels; i++)
+    {
+        levelOffsets[i + 1] =
+            levelOffsets[i] + size_t(glm::max(width >> i, 1)) * glm::max(height >> i, 1) * layers * texelSize;
+    }
+    return levelOffsets;
+}
+
+ReduceRowFn GetReduceRow(int channels)
+{
+    const ReduceRowFn reduceRowFns[] = {ReduceRow<1>, ReduceRow<2>, ReduceRow<3>, ReduceRow<4>};
+    assert(channels >= 1 && channels <= 4);
+    return reduceRowFns[channels - 1];
+}
+
+// halves every layer of a pw x ph level into dst
+void BoxReduceLevel(
+    ReduceRowFn reduceRow,
+    ChannelType type,
+    bool srgb,
+    const uint8_t* src,
+    int pw,
+    int ph,
+    int layers,
+    size_t texelSize,
+    uint8_t* dst
+)
+{
+    const int lw = glm::max(pw >> 1, 1);
+    const int lh = glm::max(ph >> 1, 1);
+
+    // rows of every layer are independent, chunks of roughly 64k texels keep scheduling overhead low
+    size_t grainSize = glm::max(65536 / lw, 1);
+    JobSystem::GetSingleton().ParallelFor(
+        size_t(layers) * lh,
+        grainSize,
+        [=](size_t begin, size_t end)
+        {
+            std::vector<float> scratch;
+            for (size_t row = begin; row < end; ++row)
+            {
+                size_t layer = row / lh;
+                int k = row % lh;
+                const uint8_t* srcLayer = src + layer * pw * ph * texelSize;
+                const uint8_t* r0 = srcLayer + size_t(glm::min(2 * k, ph - 1)) * pw * texelSize;
+                const uint8_t* r1 = srcLayer + size_t(glm::min(2 * k + 1, ph - 1)) * pw * texelSize;
+                reduceRow(type, srgb, r0, r1, dst + row * lw * texelSize, pw, lw, scratch);
+            }
+        }
+    );
+}
+
+void DecodeToFloat(const uint8_t* src, float* dst, size_t texelCount, int channels, ChannelType type, bool srgb)
+{
+    const size_t n = texelCount * channels;
+    switch (type)
+    {
+        case ChannelType::UInt8:
+            {
+                const SRGBTables& tables = GetSRGBTables();
+                const int alphaChannel = AlphaChannel(channels);
+                for (size_t i = 0; i < n; ++i)
+                {
+                    bool alpha = int(i % channels) == alphaChannel;
+                    dst[i] = srgb && !alpha ? tables.decode[src[i]] : src[i] / 255.0f;
+                }
+                break;
+            }
+        case ChannelType::UInt16:
+            for (size_t i = 0; i < n; ++i)
+                dst[i] = ((const uint16_t*)src)[i] / 65535.0f;
+            break;
+        case ChannelType::Half:
+            {
+                const float* halfTable = GetHalfTable();
+                for (size_t i = 0; i < n; ++i)
+                    dst[i] = halfTable[((const uint16_t*)src)[i]];
+                break;
+            }
+        case ChannelType::Float: memcpy(dst, src, n * sizeof(float)); break;
+    }
+}
+
+// sinc filters ring below zero (and above one), values are clamped to what the format can hold and to >= 0 for float
+// formats
+void ClampToFormatRange(float* data, size_t n, ChannelType type)
+{
+    const bool normalized = type == ChannelType::UInt8 || type == ChannelType::UInt16;
+    const float maxValue = normalized ? 1.0f : std::numeric_limits<float>::max();
+    for (size_t i = 0; i < n; ++i)
+        data[i] = glm::clamp(data[i], 0.0f, maxValue);
+}
+
+void EncodeFromFloat(const float* src, uint8_t* dst, size_t texelCount, int channels, ChannelType type, bool srgb)
+{
+    const size_t n = texelCount * channels;
+    switch (type)
+    {
+        case ChannelType::UInt8:
+            {
+                const SRGBTables& tables = GetSRGBTables();
+                const int alphaChannel = AlphaChannel(channels);
+                for (size_t i = 0; i < n; ++i)
+                {
+                    bool alpha = int(i % channels) == alphaChannel;
+                    float v = glm::clamp(src[i], 0.0f, 1.0f);
+                    dst[i] = srgb && !alpha ? tables.encode[int(v * (SRGBTables::encodeSize - 1) + 0.5f)]
+                                            : uint8_t(v * 255 + 0.5f);
+                }
+                break;
+            }
+        case ChannelType::UInt16:
+            for (size_t i = 0; i < n; ++i)
+                ((uint16_t*)dst)[i] = uint16_t(glm::clamp(src[i], 0.0f, 1.0f) * 65535 + 0.5f);
+            break;
+        case ChannelType::Half:
+            for (size_t i = 0; i < n; ++i)
+                ((uint16_t*)dst)[i] = glm::packHalf1x16(glm::max(src[i], 0.0f));
+            break;
+        case ChannelType::Float:
+            for (size_t i = 0; i < n; ++i)
+                ((float*)dst)[i] = glm::max(src[i], 0.0f);
+            break;
+    }
+}
+} // namespace
+
+size_t GetChannelTypeByteSize(ChannelType type)
+{
+    switch (type)
+    {
+        case ChannelType::UInt8: return 1;
+        case ChannelType::UInt16: return 2;
+        case ChannelType::Half: return 2;
+        case ChannelType::Float: return 4;
+    }
+    return 0;
+}
+
+void GenerateBoxFilteredMipmap(
+    uint8_t* source,
+    int width,
+    int height,
+    int layers,
+    int levels,
+    int channels,
+    ChannelType type,
+    bool srgb,
+    uint8_t*& output,
+    size_t& outputByteSize
+)
+{
+    ReduceRowFn reduceRow = GetReduceRow(channels);
+    const size_t texelSize = GetChannelTypeByteSize(type) * channels;
+
+    std::vector<size_t> levelOffsets = GetLevelOffsets(width, height, layers, levels, texelSize);
+    outputByteSize = levelOffsets.back();
+    output = new uint8_t[outputByteSize];
+    memcpy(output, source, size_t(width) * height * layers * texelSize);
+
+    for (int i = 1; i < levels; i++)
+    {
+        const int pw = glm::max(width >> (i - 1), 1);
+        const int ph = glm::max(height >> (i - 1), 1);
+        BoxReduceLevel(
+            reduceRow, type, srgb, output + levelOffsets[i - 1], pw, ph, layers, texelSize, output + levelOffsets[i]
+        );
+    }
+}
+
+void GenerateFilteredMipmap(
+    uint8_t* source,
+    int width,
+    int height,
+    int layers,
+    int levels,
+    int channels,
+    ChannelType type,
+    bool srgb,
+    MipFilter filter,
+    EdgeMode edgeMode,
+    uint8_t*& output,
+    size_t& outputByteSize
+)
+{
+    if (filter == MipFilter::Box)
+    {
+        GenerateBoxFilteredMipmap(source, width, height, layers, levels, channels, type, srgb, output, outputByteSize);
+        return;
+    }
+
+    FilterFn filterFn = filter == MipFilter::Kaiser ? filterFn_Kaiser : filterFn_Lanczos;
+    // three lobes in target texels, 13 source taps per pass
+    const float filterRadius = 3;
+
+    const size_t texelSize = GetChannelTypeByteSize(type) * channels;
+    std::vector<size_t> levelOffsets = GetLevelOffsets(width, height, layers, levels, texelSize);
+    outputByteSize = levelOffsets.back();
+    output = new uint8_t[outputByteSize];
+    memcpy(output, source, size_t(width) * height * layers * texelSize);
+
+    Processor processor;
+    for (int layer = 0; layer < layers; ++layer)
+    {
+        // each level is filtered from the previous one without going through the storage format's precision, but
+        // clamped to its range so that the ringing of one level isn't filtered and amplified by the next
+        size_t layerByteSize = size_t(width) * height * texelSize;
+        auto level = std::make_unique<LinearImage>(width, height, channels, sizeof(float));
+        float* levelData = (float*)level->GetData();
+        DecodeToFloat(source + layer * layerByteSize, levelData, level->GetPixelCount(), channels, type, srgb);
+        for (int i = 1; i < levels; ++i)
+        {
+            level = processor.GenerateMipmap(level, filterFn, filterRadius, edgeMode);
+            levelData = (float*)level->GetData();
+            ClampToFormatRange(levelData, size_t(level->GetPixelCount()) * channels, type);
+            size_t levelLayerByteSize = size_t(level->GetPixelCount()) * texelSize;
+            uint8_t* dst = output + levelOffsets[i] + layer * levelLayerByteSize;
+            EncodeFromFloat(levelData, dst, level->GetPixelCount(), channels, type, srgb);
+        }
+    }
+}
+
+namespace
+{
+template <ChannelType type>
+float DecodeValue(const uint8_t* data, size_t i)
+{
+    if constexpr (type == ChannelType::UInt8)
+        return data[i];
+    else if constexpr (type == ChannelType::UInt16)
+        return ((const uint16_t*)data)[i];
+    else if constexpr (type == ChannelType::Half)
+        return GetHalfTable()[((const uint16_t*)data)[i]];
+    else
+        return ((const float*)data)[i];
+}
+
+template <ChannelType type>
+void EncodeValue(uint8_t* data, size_t i, float v)
+{
+    if constexpr (type == ChannelType::UInt8)
+        data[i] = uint8_t(glm::clamp(v + 0.5f, 0.0f, 255.0f));
+    else if constexpr (type == ChannelType::UInt16)
+        ((uint16_t*)data)[i] = uint16_t(glm::clamp(v + 0.5f, 0.0f, 65535.0f));
+    else if constexpr (type == ChannelType::Half)
+        ((uint16_t*)data)[i] = glm::packHalf1x16(v);
+    else
+        ((float*)data)[i] = v;
+}
+
+// bilinear lookup in one level of an equirectangular image, u wraps around and v clamps at the poles
+template <ChannelType type, int C>
+void SampleEquirectangular(const uint8_t* data, int width, int height, glm::vec2 uv, float* out)
+{
+    float x = uv.x * width - 0.5f;
+    float y = glm::clamp(uv.y * height - 0.5f, 0.0f, height - 1.0f);
+    int x0 = (int)glm::floor(x);
+    int y0 = (int)y;
+    float fx = x - x0;
+    float fy = y - y0;
+    int x1 = x0 + 1 >= width ? 0 : x0 + 1;
+    x0 = x0 < 0 ? width - 1 : x0;
+    int y1 = glm::min(y0 + 1, height - 1);
+
+    const size_t i00 = (size_t(y0) * width + x0) * C;
+    const size_t i01 = (size_t(y0) * width + x1) * C;
+    const size_t i10 = (size_t(y1) * width + x0) * C;
+    const size_t i11 = (size_t(y1) * width + x1) * C;
+    for (int c = 0; c < C; ++c)
+    {
+        float top = glm::mix(DecodeValue<type>(data, i00 + c), DecodeValue<type>(data, i01 + c), fx);
+        float bottom = glm::mix(DecodeValue<type>(data, i10 + c), DecodeValue<type>(data, i11 + c), fx);
+        out[c] = glm::mix(top, bottom, fy);
+    }
+}
+
+// GetDirFromCubeUV is linear in uv, so a face is fully described by its center and the steps along x and y
+struct CubeFaceTable
+{
+    glm::vec3 origin;
+    glm::vec3 dx;
+    glm::vec3 dy;
+};
+
+template <ChannelType type, int C>
+void ConvertToCubemapRows(
+    const uint8_t* source,
+    const std::vector<size_t>& levelOffsets,
+    int width,
+    int height,
+    float lod,
+    int outputSize,
+    const CubeFaceTable* faces,
+    uint8_t* output,
+    size_t begin,
+    size_t end
+)
+{
+    const int levels = levelOffsets.size() - 1;
+    const int l0 = glm::min((int)lod, levels - 1);
+    const int l1 = glm::min(l0 + 1, levels - 1);
+    const float levelBlend = glm::clamp(lod - l0, 0.0f, 1.0f);
+    const int w0 = glm::max(width >> l0, 1), h0 = glm::max(height >> l0, 1);
+    const int w1 = glm::max(width >> l1, 1), h1 = glm::max(height >> l1, 1);
+
+    float s0[C], s1[C];
+    for (size_t row = begin; row < end; ++row)
+    {
+        int face = row / outputSize;
+        int y = row % outputSize;
+        const CubeFaceTable& table = faces[face];
+        glm::vec3 rowOrigin = table.origin + table.dy * (y + 0.5f);
+        for (int x = 0; x < outputSize; ++x)
+        {
+            glm::vec2 uv = DirToEquirectangularUV(glm::normalize(rowOrigin + table.dx * (x + 0.5f)));
+            SampleEquirectangular<type, C>(source + levelOffsets[l0], w0, h0, uv, s0);
+            if (levelBlend > 0)
+            {
+                SampleEquirectangular<type, C>(source + levelOffsets[l1], w1, h1, uv, s1);
+                for (int c = 0; c < C; ++c)
+                    s0[c] = glm::mix(s0[c], s1[c], levelBlend);
+            }
+
+            size_t outIndex = ((size_t(face) * outputSize + y) * outputSize + x) * C;
+            for (int c = 0; c < C; ++c)
+                EncodeValue<type>(output, outIndex + c, s0[c]);
+        }
+    }
+}
+
+using ConvertToCubemapRowsFn = void (*)(
+    const uint8_t*, const std::vector<size_t>&, int, int, float, int, const CubeFaceTable*, uint8_t*, size_t, size_t
+);
+
+template <ChannelType type>
+ConvertToCubemapRowsFn GetConvertToCubemapRows(int channels)
+{
+    const ConvertToCubemapRowsFn fns[] = {
+        ConvertToCubemapRows<type, 1>,
+        ConvertToCubemapRows<type, 2>,
+        ConvertToCubemapRows<type, 3>,
+        ConvertToCubemapRows<type, 4>
+    };
+    return fns[channels - 1];
+}
+} // namespace
+
+void ConverToCubemap(
+    uint8_t* source, int width, int height, int outputSize, int channels, ChannelType type, uint8_t*& output
+)
+{
+    assert(channels >= 1 && channels <= 4);
+    const size_t texelSize = GetChannelTypeByteSize(type) * channels;
+    output = new uint8_t[size_t(outputSize) * outputSize * 6 * texelSize];
+
+    CubeFaceTable faces[6];
+    for (int face = 0; face < 6; ++face)
+    {
+        glm::vec3 origin = GetDirFromCubeUV({0, 0}, face);
+        faces[face].origin = origin;
+        faces[face].dx = (GetDirFromCubeUV({1, 0}, face) - origin) / (float)outputSize;
+        faces[face].dy = (GetDirFromCubeUV({0, 1}, face) - origin) / (float)outputSize;
+    }
+
+    // a face spans a quarter of the equirectangular width. Bilinear sampling covers up to two source texels per face
+    // texel, denser sources are sampled from a box filtered mip of matching density instead of aliasing. Building the
+    // chain below that costs more than it saves
+    float ratio = width / 4.0f / outputSize;
+    float lod = 0;
+    const uint8_t* levels = source;
+    int levelWidth = width;
+    int levelHeight = height;
+    std::vector<size_t> levelOffsets = {0, size_t(width) * height * texelSize};
+    std::vector<uint8_t> chain;
+    if (ratio > 2)
+    {
+        // only the two levels the lookup blends are kept, the ones in between are reduced in scratch buffers
+        lod = glm::log2(ratio);
+        int maxLevel = glm::floor(glm::log2((float)glm::min(width, height)));
+        int l0 = glm::min((int)lod, maxLevel);
+        int l1 = glm::min(l0 + 1, maxLevel);
+        levelWidth = glm::max(width >> l0, 1);
+        levelHeight = glm::max(height >> l0, 1);
+        levelOffsets = GetLevelOffsets(levelWidth, levelHeight, 1, l1 - l0 + 1, texelSize);
+        chain.resize(levelOffsets.back());
+
+        ReduceRowFn reduceRow = GetReduceRow(channels);
+        std::vector<uint8_t> scratch[2];
+        const uint8_t* src = source;
+        for (int i = 1; i <= l1; ++i)
+        {
+            const int pw = glm::max(width >> (i - 1), 1);
+            const int ph = glm::max(height >> (i - 1), 1);
+            uint8_t* dst;
+            if (i >= l0)
+            {
+                dst = chain.data() + levelOffsets[i - l0];
+            }
+            else
+            {
+                scratch[i % 2].resize(size_t(glm::max(pw >> 1, 1)) * glm::max(ph >> 1, 1) * texelSize);
+                dst = scratch[i % 2].data();
+            }
+            BoxReduceLevel(reduceRow, type, false, src, pw, ph, 1, texelSize, dst);
+            src = dst;
+        }
+        lod -= l0;
+        levels = chain.data();
+    }
+
+    ConvertToCubemapRowsFn convertRows = nullptr;
+    switch (type)
+    {
+        case ChannelType::UInt8: convertRows = GetConvertToCubemapRows<ChannelType::UInt8>(channels); break;
+        case ChannelType::UInt16: convertRows = GetConvertToCubemapRows<ChannelType::UInt16>(channels); break;
+        case ChannelType::Half: convertRows = GetConvertToCubemapRows<ChannelType::Half>(channels); break;
+        case ChannelType::Float: convertRows = GetConvertToCubemapRows<ChannelType::Float>(channels); break;
+    }
+
+    JobSystem::GetSingleton().ParallelFor(
+        size_t(6) * outputSize,
+        glm::max(16384 / outputSize, 1),
+        [&](size_t begin, size_t end)
+        { convertRows(levels, levelOffsets, levelWidth, levelHeight, lod, outputSize, faces, output, begin, end); }
+    );
+}
+
+namespace
+{
+// what the gpu bakes clamp hdr values to, a few very bright texels otherwise dominate the diffuse result
+const float maxEnvironmentRadiance = 20;
+
+void EvaluateSHBasis(glm::vec3 d, float basis[9])
+{
+    basis[0] = 0.282095f;
+    basis[1] = 0.488603f * d.y;
+    basis[2] = 0.488603f * d.z;
+    basis[3] = 0.488603f * d.x;
+    basis[4] = 1.092548f * d.x * d.y;
+    basis[5] = 1.092548f * d.y * d.z;
+    basis[6] = 0.315392f * (3 * d.z * d.z - 1);
+    basis[7] = 1.092548f * d.x * d.z;
+    basis[8] = 0.546274f * (d.x * d.x - d.y * d.y);
+}
+
+// inverse of DirToEquirectangularUV
+glm::vec3 EquirectangularUVToDir(glm::vec2 uv)
+{
+    float phi = uv.x * glm::two_pi<float>() - glm::pi<float>();
+    float theta = uv.y * glm::pi<float>();
+    return glm::vec3(glm::sin(theta) * glm::cos(phi), glm::cos(theta), glm::sin(theta) * glm::sin(phi));
+}
+
+// trilinear lookup in the box filtered mip chain of an RGBA32F equirectangular image, u wraps and v clamps
+struct EquirectangularChain
+{
+    std::vector<size_t> levelOffsets;
+    int width;
+    int height;
+    int levels;
+    uint8_t* data = nullptr;
+
+    EquirectangularChain(float* source, int width, int height) : width(width), height(height)
+    {
+        levels = glm::floor(glm::log2((float)glm::min(width, height))) + 1;
+        size_t byteSize;
+        GenerateBoxFilteredMipmap(
+            (uint8_t*)source,
+            width,
+            height,
+            1,
+            levels,
+            4,
+            ChannelType::Float,
+            false,
+            data,
+            byteSize
+        );
+        levelOffsets = GetLevelOffsets(width, height, 1, levels, 4 * sizeof(float));
+    }
+    EquirectangularChain(const EquirectangularChain& other) = delete;
+    ~EquirectangularChain()
+    {
+        delete[] data;
+    }
+
+    glm::vec3 SampleLevel(glm::vec2 uv, int level) const
+    {
+        int lw = glm::max(width >> level, 1);
+        int lh = glm::max(height >> level, 1);
+        const glm::vec4* texels = (const glm::vec4*)(data + levelOffsets[level]);
+        float x = uv.x * lw - 0.5f;
+        float y = glm::clamp(uv.y * lh - 0.5f, 0.0f, lh - 1.0f);
+        int x0 = (int)glm::floor(x);
+        int y0 = (int)y;
+        float fx = x - x0;
+        float fy = y - y0;
+        int x1 = (x0 + 1) % lw;
+        x0 = (x0 % lw + lw) % lw;
+        int y1 = glm::min(y0 + 1, lh - 1);
+        glm::vec4 top = glm::mix(texels[y0 * lw + x0], texels[y0 * lw + x1], fx);
+        glm::vec4 bottom = glm::mix(texels[y1 * lw + x0], texels[y1 * lw + x1], fx);
+        return glm::vec3(glm::mix(top, bottom, fy));
+    }
+
+    glm::vec3 Sample(glm::vec3 dir, float lod) const
+    {
+        glm::vec2 uv = DirToEquirectangularUV(dir);
+        lod = glm::clamp(lod, 0.0f, levels - 1.0f);
+        int l0 = (int)lod;
+        int l1 = glm::min(l0 + 1, levels - 1);
+        return glm::mix(SampleLevel(uv, l0), SampleLevel(uv, l1), lod - l0);
+    }
+};
+
+float RadicalInverseVdC(uint32_t bits)
+{
+    bits = (bits << 16u) | (bits >> 16u);
+    bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+    bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+    bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+    bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+    return float(bits) * 2.3283064365386963e-10f;
+}
+
+// runs fn(face, x, y, dir) for every texel of a cubemap face set in parallel, faces are laid out like the gpu bakes
+// read them back
+template <class F>
+void ForEachCubemapTexel(int size, F&& fn)
+{
+    JobSystem::GetSingleton().ParallelFor(
+        size_t(6) * size,
+        glm::max(4096 / size, 1),
+        [size, &fn](size_t begin, size_t end)
+        {
+            for (size_t row = begin; row < end; ++row)
+            {
+                int face = row / size;
+                int y = row % size;
+                for (int x = 0; x < size; ++x)
+                {
+                    glm::vec2 uv = {(x + 0.5f) / size, (y + 0.5f) / size};
+                    fn(face, x, y, glm::normalize(GetDirFromCubeUV(uv, face)));
+                }
+            }
+        }
+    );
+}
+} // namespace
+
+IrradianceSH ComputeIrradianceSH(const float* source, int width, int height)
+{
+    // each row of the equirectangular image projects into its own accumulator, summed in order afterwards so the
+    // result doesn't depend on scheduling
+    std::vector<glm::dvec3> rowSums(size_t(height) * 9, glm::dvec3(0));
+    JobSystem::GetSingleton().ParallelFor(
+        height,
+        glm::max(65536 / width, 1),
+        [&](size_t begin, size_t end)
+        {
+            float basis[9];
+            for (size_t y = begin; y < end; ++y)
+            {
+                float v = (y + 0.5f) / height;
+                float solidAngle = glm::two_pi<float>() / width * glm::pi<float>() / height *
+                                   glm::sin(v * glm::pi<float>());
+                glm::dvec3* sums = &rowSums[y * 9];
+                for (int x = 0; x < width; ++x)
+                {
+                    glm::vec3 dir = EquirectangularUVToDir({(x + 0.5f) / width, v});
+                    const float* texel = source + (y * width + x) * 4;
+                    glm::vec3 radiance =
+                        glm::min(glm::vec3(texel[0], texel[1], texel[2]), glm::vec3(maxEnvironmentRadiance));
+                    EvaluateSHBasis(dir, basis);
+                    for (int i = 0; i < 9; ++i)
+                        sums[i] += glm::dvec3(radiance * (basis[i] * solidAngle));
+                }
+            }
+        }
+    );
+
+    // convolution with the clamped cosine lobe divided by pi, matching the gpu bake which stores irradiance / pi
+    const float bandScale[9] = {1, 2 / 3.0f, 2 / 3.0f, 2 / 3.0f, 0.25f, 0.25f, 0.25f, 0.25f, 0.25f};
+    IrradianceSH sh;
+    for (int i = 0; i < 9; ++i)
+    {
+        glm::dvec3 sum(0);
+        for (int y = 0; y < height; ++y)
+            sum += rowSums[y * 9 + i];
+        sh.coefficients[i] = glm::vec3(sum) * bandScale[i];
+    }
+    return sh;
+}
+
+glm::vec3 EvaluateIrradianceSH(const IrradianceSH& sh, glm::vec3 dir)
+{
+    float basis[9];
+    EvaluateSHBasis(dir, basis);
+    glm::vec3 irradiance(0);
+    for (int i = 0; i < 9; ++i)
+        irradiance += sh.coefficients[i] * basis[i];
+    return glm::max(irradiance, glm::vec3(0));
+}
+
+void GenerateIrradianceCubemapCPU(float* source, int width, int height, int outputSize, uint8_t*& output)
+{
+    IrradianceSH sh = ComputeIrradianceSH(source, width, height);
+
+    output = new uint8_t[size_t(outputSize) * outputSize * 6 * sizeof(glm::vec4)];
+    glm::vec4* out = (glm::vec4*)output;
+    ForEachCubemapTexel(
+        outputSize,
+        [&](int face, int x, int y, glm::vec3 dir)
+        { out[(size_t(face) * outputSize + y) * outputSize + x] = glm::vec4(EvaluateIrradianceSH(sh, dir), 1); }
+    );
+}
+
+void GenerateReflectanceCubemapCPU(
+    float* source, int width, int height, int outputSize, uint8_t*& output, int& mipLevels
+)
+{
+    // same roughness per mip as IBLBRDF.comp
+    const float roughnesses[] = {0.001f, 0.2f, 0.5f, 0.8f, 1.0f};
+    mipLevels = 5;
+
+    // filtered importance sampling, each sample reads a mip of the environment that covers its solid angle so far
+    // fewer samples than the gpu's 8196 give a smooth result
+    const uint32_t sampleCount = 64;
+    EquirectangularChain environment(source, width, height);
+    const float texelSolidAngle = 4 * glm::pi<float>() / (float(width) * height);
+
+    struct Sample
+    {
+        glm::vec3 direction;
+        float weight;
+        float lod;
+    };
+
+    size_t byteSize = 0;
+    for (int mip = 0; mip < mipLevels; ++mip)
+        byteSize += size_t(outputSize >> mip) * (outputSize >> mip) * 6 * sizeof(glm::vec4);
+    output = new uint8_t[byteSize];
+
+    size_t mipOffset = 0;
+    for (int mip = 0; mip < mipLevels; ++mip)
+    {
+        int mipSize = outputSize >> mip;
+        glm::vec4* out = (glm::vec4*)(output + mipOffset);
+        mipOffset += size_t(mipSize) * mipSize * 6 * sizeof(glm::vec4);
+
+        // with N = V = R the samples only depend on roughness, so they are built once in tangent space
+        float a = roughnesses[mip] * roughnesses[mip];
+        float a2 = a * a;
+        std::vector<Sample> samples;
+        float totalWeight = 0;
+        // the first level is practically a mirror, one sample along n is enough
+        uint32_t count = mip == 0 ? 1 : sampleCount;
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            glm::vec2 xi = {float(i) / count, RadicalInverseVdC(i)};
+            float phi = glm::two_pi<float>() * xi.x;
+            float cosTheta = glm::sqrt((1 - xi.y) / (1 + (a2 - 1) * xi.y));
+            float sinTheta = glm::sqrt(1 - cosTheta * cosTheta);
+            glm::vec3 h = {sinTheta * glm::cos(phi), sinTheta * glm::sin(phi), cosTheta};
+            glm::vec3 l = 2 * h.z * h - glm::vec3(0, 0, 1);
+            if (l.z <= 0)
+                continue;
+
+            float d = cosTheta * cosTheta * (a2 - 1) + 1;
+            float pdf = a2 / (glm::pi<float>() * d * d) / 4;
+            float sampleSolidAngle = 1 / (count * pdf);
+            float lod = mip == 0 ? 0 : 0.5f * glm::log2(sampleSolidAngle / texelSolidAngle) + 1;
+            samples.push_back({l, l.z, lod});
+            totalWeight += l.z;
+        }
+
+        ForEachCubemapTexel(
+            mipSize,
+            [&](int face, int x, int y, glm::vec3 n)
+            {
+                glm::vec3 up = glm::abs(n.z) < 0.999f ? glm::vec3(0, 0, 1) : glm::vec3(1, 0, 0);
+                glm::vec3 tangentX = glm::normalize(glm::cross(up, n));
+                glm::vec3 tangentY = glm::cross(n, tangentX);
+                glm::vec3 color(0);
+                for (const Sample& s : samples)
+                {
+                    glm::vec3 l = tangentX * s.direction.x + tangentY * s.direction.y + n * s.direction.z;
+                    color += environment.Sample(glm::normalize(l), s.lod) * s.weight;
+                }
+                out[(size_t(face) * mipSize + y) * mipSize + x] = glm::vec4(color / totalWeight, 1);
+            }
+        );
+    }
+}
+
 void GenerateIrradianceCubemap(float* source, int width, int height, int outputSize, uint8_t*& output)
 {
+    if (GetGfxDriver() == nullptr)
+    {
+        GenerateIrradianceCubemapCPU(source, width, height, outputSize, output);
+        return;
+    }
+
     Gfx::ImageDescription imgDesc{};
     imgDesc.width = width;
     imgDesc.height = height;
@@ -77,6 +1010,12 @@ void GenerateIrradianceCubemap(float* source, int width, int height, int outputS
 
 void GenerateReflectanceCubemap(float* source, int width, int height, int outputSize, uint8_t*& output, int& mipLevels)
 {
+    if (GetGfxDriver() == nullptr)
+    {
+        GenerateReflectanceCubemapCPU(source, width, height, outputSize, output, mipLevels);
+        return;
+    }
+
     Gfx::ImageDescription imgDesc{};
     imgDesc.width = width;
     imgDesc.height = height;
@@ -1,4 +1,5 @@
 #pragma once
+#include "Processor.hpp"
 #include "glm/ext/scalar_constants.hpp"
 #include <cmath>
 #include <glm/glm.hpp>
@@ -6,7 +7,18 @@
 namespace Libs::Image
 {
 
-template <class T>
+enum class ChannelType
+{
+    UInt8,
+    UInt16,
+    Half,
+    Float
+};
+
+size_t GetChannelTypeByteSize(ChannelType type);
+
+// 2x2 box filtered mip chain of source. output is laid out as [level [layer]] and allocated with new[]. With srgb the
+// color channels of 8 bit images are filtered in linear space, alpha always stays linear
 void GenerateBoxFilteredMipmap(
     uint8_t* source,
     int width,
@@ -14,125 +26,64 @@ void GenerateBoxFilteredMipmap(
     int layers,
     int levels,
     int channels,
+    ChannelType type,
+    bool srgb,
     uint8_t*& output,
     size_t& outputByteSize
-)
-{
-    outputByteSize = 0;
-    for (int i = 0; i < levels; i++)
-    {
-        float scale = std::pow(0.5f, i);
-        int lw = width * scale;
-        int lh = height * scale;
-
-        outputByteSize += lw * lh;
-    }
-    int perLayerElementCount = outputByteSize * channels;
-    outputByteSize = layers * perLayerElementCount * sizeof(T);
-    output = (uint8_t*)(T*)new uint8_t[outputByteSize];
-    T* data = (T*)output;
-
-    int layerOffset = 0;
-    size_t firstLevelLayerSize = width * height * channels* sizeof(T);
-    for (int layer = 0; layer < layers; layer++)
-    {
-        memcpy(output + layerOffset, source + layer * firstLevelLayerSize , firstLevelLayerSize);
-        layerOffset += firstLevelLayerSize;
-    }
+);
 
-    int preLevelWidth = width;
-    int preLevelHeight = height;
-    int preLevelOffset = 0;
-    int curLevelOffset = 0;
-    for (int i = 1; i < levels; i++)
-    {
-        int lw = preLevelWidth * 0.5f;
-        int lh = preLevelHeight * 0.5f;
-        int preLayerSize = preLevelWidth * preLevelHeight * channels;
-        int curLayerSize = lw * lh * channels;
-
-        curLevelOffset = preLevelOffset + preLayerSize * layers;
-
-        int preLevelLayerOffset = 0;
-        int curLevelLayerOffset = 0;
-        for (int layer = 0; layer < layers; ++layer)
-        {
-            // 2x2 box filter
-            for (int k = 0; k < lh; k++)
-            {
-                for (int j = 0; j < lw; j++)
-                {
-                    for (int c = 0; c < channels; ++c)
-                    {
-                        int x = std::min(2 * j, preLevelWidth - 1);
-                        int y = std::min(2 * k, preLevelHeight - 1);
-                        int samples = 1;
+enum class MipFilter
+{
+    Box,
+    Kaiser,
+    Lanczos
+};
 
-                        T sum = data[preLevelLayerOffset + preLevelOffset + (y * preLevelWidth + x) * channels + c];
-                        if (y + 1 < preLevelHeight)
-                        {
-                            sum += data
-                                [preLevelLayerOffset + preLevelOffset + ((y + 1) * preLevelWidth + x) * channels + c];
-                            samples += 1;
-                        }
-                        if (x + 1 < preLevelWidth)
-                        {
-                            sum += data
-                                [preLevelLayerOffset + preLevelOffset + (y * preLevelWidth + (x + 1)) * channels + c];
-                            samples += 1;
-                        }
-                        if (x + 1 < preLevelWidth && y + 1 < preLevelHeight)
-                        {
-                            sum += data
-                                [preLevelLayerOffset + preLevelOffset + ((y + 1) * preLevelWidth + (x + 1)) * channels +
-                                 c];
-                            samples += 1;
-                        }
+// same layout as GenerateBoxFilteredMipmap. Kaiser and Lanczos run the separable filters of Processor in float
+// precision, Box forwards to GenerateBoxFilteredMipmap
+void GenerateFilteredMipmap(
+    uint8_t* source,
+    int width,
+    int height,
+    int layers,
+    int levels,
+    int channels,
+    ChannelType type,
+    bool srgb,
+    MipFilter filter,
+    EdgeMode edgeMode,
+    uint8_t*& output,
+    size_t& outputByteSize
+);
 
-                        data[curLevelLayerOffset + curLevelOffset + (k * lw + j) * channels + c] = sum / samples;
-                    }
-                }
-            }
+// 9 spherical harmonics coefficients of the diffuse irradiance / pi, the same quantity the irradiance cubemap stores.
+// The cosine lobe convolution is already applied, evaluating is a weighted sum of the basis
+struct IrradianceSH
+{
+    glm::vec3 coefficients[9];
+};
 
-            preLevelLayerOffset += preLayerSize;
-            curLevelLayerOffset += curLayerSize;
-        }
-        preLevelOffset = curLevelOffset;
-        preLevelWidth = lw;
-        preLevelHeight = lh;
-    }
-}
+// source is an RGBA32F equirectangular image
+IrradianceSH ComputeIrradianceSH(const float* source, int width, int height);
+glm::vec3 EvaluateIrradianceSH(const IrradianceSH& sh, glm::vec3 dir);
 
+// the bakes run on the gpu and fall back to the CPU versions when no GfxDriver is created
 void GenerateIrradianceCubemap(float* source, int width, int height, int outputSize, uint8_t*& output);
 void GenerateReflectanceCubemap(float* source, int width, int height, int outputSize, uint8_t*& output, int& mipLevels);
 
+// irradiance evaluated from SH9, within a few percent of the gpu's brute force integration
+void GenerateIrradianceCubemapCPU(float* source, int width, int height, int outputSize, uint8_t*& output);
+// GGX prefiltered with filtered importance sampling, same roughness per mip as the gpu bake
+void GenerateReflectanceCubemapCPU(
+    float* source, int width, int height, int outputSize, uint8_t*& output, int& mipLevels
+);
+
 glm::vec3 GetDirFromCubeUV(glm::vec2 uv, int faceIndex);
 glm::vec2 DirToEquirectangularUV(glm::vec3 dir);
 
-template <class T>
-void ConverToCubemap(T* source, int width, int height, int outputSize, int channels, uint8_t*& output)
-{
-    output = new uint8_t[channels * outputSize * outputSize * sizeof(T) * 6];
-    T* out = (T*)(output);
-
-    for (int layer = 0; layer < 6; ++layer)
-    {
-        int layerOffset = outputSize * outputSize * layer * channels;
-        for (int y = 0; y < outputSize; ++y)
-        {
-            for (int x = 0; x < outputSize; ++x)
-            {
-                glm::vec3 dir =
-                    glm::normalize(GetDirFromCubeUV({(x + 0.5) / outputSize, (y + 0.5) / outputSize}, layer));
-                glm::vec2 uv = DirToEquirectangularUV(dir);
-                glm::ivec2 pcoord = uv * glm::vec2(width, height);
-                for (int c = 0; c < channels; ++c)
-                {
-                    out[layerOffset + (x + y * outputSize) * channels + c] =
-                        source[(pcoord.x + pcoord.y * width) * channels + c];
-                }
-            }
-        }
-    }
-}
+// equirectangular to cubemap with faces laid out +X, -X, +Y, -Y, +Z, -Z. Sampling is bilinear, sources with more
+// texels than a face covers are read from a box filtered mip of matching density
+void ConverToCubemap(
+    uint8_t* source, int width, int height, int outputSize, int channels, ChannelType type, uint8_t*& output
+);
 } // namespace Libs::Image
@@ -1,6 +1,8 @@
 #pragma once
 #include <cinttypes>
+#include <cstring>
 #include <memory>
+#include <utility>
 
 namespace Libs::Image
 {
@@ -1,5 +1,8 @@
 #pragma once
+#include <cassert>
+#include <cmath>
 #include <functional>
+#include <vector>
 
 namespace Libs::Image
 {
@@ -1,47 +1,109 @@
 #include "Processor.hpp"
-#include <iostream>
+#include "Libs/JobSystem.hpp"
 namespace Libs::Image
 {
-std::unique_ptr<LinearImage> Processor::RowDownSample(RefPtr<LinearImage> sImage,
-                                                      FilterFn filterFn,
-                                                      const uint32_t sampleCount)
+namespace
 {
-    const auto sWidth = sImage->GetWidth();
-    const auto sHeight = sImage->GetHeight();
-    const auto channel = sImage->GetChannel();
-    auto tImage = std::make_unique<LinearImage>(sWidth / 2, sHeight, channel, sizeof(float));
-    const auto tWidth = tImage->GetWidth();
-
-    float* tData = (float*)tImage->GetData();
-    float* sData = (float*)sImage->GetData();
-    float sxDelta = 1.0f / sWidth;
-    for (uint32_t tj = 0; tj < sHeight; ++tj)
+// channel count is a template argument so the tap loop is unrolled per channel
+template <uint32_t C>
+void FilterRows(
+    const float* sData,
+    float* tData,
+    uint32_t sWidth,
+    uint32_t tWidth,
+    const FilterTable& table,
+    size_t begin,
+    size_t end
+)
+{
+    for (size_t tj = begin; tj < end; ++tj)
     {
+        const float* sRow = sData + tj * sWidth * C;
+        float* tRow = tData + tj * tWidth * C;
         for (uint32_t ti = 0; ti < tWidth; ++ti)
         {
-            uint32_t pixelIndex = ti + tj * tWidth;
-            float tx = (ti + 0.5) / (float)tWidth;
-            float siCenter = tx * sWidth;
-            float totalWeight = 0;
-            for (float s = -(int)sampleCount / 2.0f; s < sampleCount / 2.0f; s += 1.0f)
+            const uint32_t* indices = &table.indices[ti * table.taps];
+            const float* weights = &table.weights[ti * table.taps];
+            float sum[C] = {};
+            for (uint32_t k = 0; k < table.taps; ++k)
             {
-                float siSample = std::clamp(std::floorf((tx + sxDelta * s) * sWidth - 0.5), 0.0f, (float)sWidth);
-
-                float weight = filterFn(siSample - siCenter, sampleCount);
-                totalWeight += weight;
-                for (uint32_t n = 0; n < channel; ++n)
-                {
-                    tData[pixelIndex * channel + n] +=
-                        sData[(uint32_t)siSample * channel + n + tj * sWidth * channel] * weight;
-                }
-            }
-            for (uint32_t n = 0; n < channel; ++n)
-            {
-                tData[pixelIndex * channel + n] /= totalWeight;
-                assert(!isnan(tData[pixelIndex * channel + n]));
+                const float* s = sRow + indices[k] * C;
+                for (uint32_t n = 0; n < C; ++n)
+                    sum[n] += s[n] * weights[k];
             }
+            for (uint32_t n = 0; n < C; ++n)
+                tRow[ti * C + n] = sum[n];
         }
     }
+}
+} // namespace
+
+FilterTable Processor::CreateFilterTable(
+    uint32_t sWidth, uint32_t tWidth, FilterFn filterFn, float filterRadius, EdgeMode edgeMode
+)
+{
+    // the filter is stretched by the downsample ratio, so its support in source texels grows with it
+    const float scale = sWidth / (float)tWidth;
+    const float sRadius = filterRadius * scale;
+
+    FilterTable table;
+    table.taps = (uint32_t)std::ceil(sRadius * 2) + 1;
+    table.indices.resize(tWidth * table.taps);
+    table.weights.resize(tWidth * table.taps);
+    for (uint32_t ti = 0; ti < tWidth; ++ti)
+    {
+        float sCenter = (ti + 0.5f) * scale;
+        int first = (int)std::floor(sCenter - sRadius);
+        float totalWeight = 0;
+        for (uint32_t k = 0; k < table.taps; ++k)
+        {
+            int si = first + (int)k;
+            float weight = filterFn((si + 0.5f - sCenter) / scale, filterRadius);
+            if (edgeMode == EdgeMode::Wrap)
+                si = ((si % (int)sWidth) + (int)sWidth) % (int)sWidth;
+            else
+                si = std::clamp(si, 0, (int)sWidth - 1);
+
+            table.indices[ti * table.taps + k] = si;
+            table.weights[ti * table.taps + k] = weight;
+            totalWeight += weight;
+        }
+
+        for (uint32_t k = 0; k < table.taps; ++k)
+        {
+            float& weight = table.weights[ti * table.taps + k];
+            weight = totalWeight != 0 ? weight / totalWeight : 1.0f / table.taps;
+        }
+    }
+
+    return table;
+}
+
+std::unique_ptr<LinearImage> Processor::RowDownSample(
+    RefPtr<LinearImage> sImage, FilterFn filterFn, float filterRadius, EdgeMode edgeMode
+)
+{
+    const auto sWidth = sImage->GetWidth();
+    const auto sHeight = sImage->GetHeight();
+    const auto channel = sImage->GetChannel();
+    assert(channel >= 1 && channel <= 4);
+    auto tImage = std::make_unique<LinearImage>(std::max(sWidth / 2, 1u), sHeight, channel, sizeof(float));
+    const auto tWidth = tImage->GetWidth();
+
+    // every row uses the same taps, only computed once
+    const FilterTable table = CreateFilterTable(sWidth, tWidth, filterFn, filterRadius, edgeMode);
+
+    using FilterRowsFn = void (*)(const float*, float*, uint32_t, uint32_t, const FilterTable&, size_t, size_t);
+    const FilterRowsFn filterRowsFns[] = {FilterRows<1>, FilterRows<2>, FilterRows<3>, FilterRows<4>};
+    FilterRowsFn filterRows = filterRowsFns[channel - 1];
+
+    float* tData = (float*)tImage->GetData();
+    const float* sData = (const float*)sImage->GetData();
+    JobSystem::GetSingleton().ParallelFor(
+        sHeight,
+        std::max(16384u / sWidth, 1u),
+        [&](size_t begin, size_t end) { filterRows(sData, tData, sWidth, tWidth, table, begin, end); }
+    );
 
     return tImage;
 }
@@ -51,22 +113,43 @@ std::unique_ptr<LinearImage> Processor::Transpose(RefPtr<LinearImage> source)
     auto dst =
         std::make_unique<LinearImage>(source->GetHeight(), source->GetWidth(), source->GetChannel(), sizeof(float));
 
-    float* s = (float*)source->GetData();
+    const float* s = (const float*)source->GetData();
     float* d = (float*)dst->GetData();
 
     const uint32_t sWidth = source->GetWidth();
     const uint32_t sHeight = source->GetHeight();
     const uint32_t sChannel = source->GetChannel();
-    for (uint32_t i = 0; i < sWidth; ++i)
-    {
-        for (uint32_t j = 0; j < sHeight; ++j)
+
+    // walk in tiles so that both the rows read and the rows written stay in cache
+    const uint32_t tileSize = 32;
+    const uint32_t tileRows = (sHeight + tileSize - 1) / tileSize;
+    JobSystem::GetSingleton().ParallelFor(
+        tileRows,
+        1,
+        [&](size_t begin, size_t end)
         {
-            for (uint32_t n = 0; n < sChannel; ++n)
+            const uint32_t jStop = std::min<size_t>(end * tileSize, sHeight);
+            for (uint32_t tileJ = begin * tileSize; tileJ < jStop; tileJ += tileSize)
             {
-                d[i * sHeight * sChannel + j * sChannel + n] = s[i * sChannel + j * sWidth * sChannel + n];
+                const uint32_t jEnd = std::min(tileJ + tileSize, sHeight);
+                for (uint32_t tileI = 0; tileI < sWidth; tileI += tileSize)
+                {
+                    const uint32_t iEnd = std::min(tileI + tileSize, sWidth);
+                    for (uint32_t i = tileI; i < iEnd; ++i)
+                    {
+                        for (uint32_t j = tileJ; j < jEnd; ++j)
+                        {
+                            for (uint32_t n = 0; n < sChannel; ++n)
+                            {
+                                d[(size_t(i) * sHeight + j) * sChannel + n] =
+                                    s[(size_t(j) * sWidth + i) * sChannel + n];
+                            }
+                        }
+                    }
+                }
             }
         }
-    }
+    );
 
     return dst;
 }
@@ -5,6 +5,7 @@
 #include <algorithm>
 #include <cmath>
 #include <functional>
+#include <vector>
 
 namespace Libs::Image
 {
@@ -17,28 +18,90 @@ namespace Libs::Image
  * x = normalized row pixel coord
  */
 const float fPi = (float)Constants::Pi;
-using FilterFn = float (*)(float t, float distance);
+
+// t is the distance to the target texel center and a the filter radius, both measured in target texels
+using FilterFn = float (*)(float t, float a);
 inline float filterFn_Gaussian(float t, float a)
 {
     return 1 / (a * std::sqrt(2 * fPi)) * std::exp(-0.5f * ((t * t) / (a * a)));
 };
 
 inline float filterFn_Box(float t, float a) { return 1; }
+
+inline float Sinc(float x)
+{
+    if (std::abs(x) < 1e-5f)
+        return 1;
+    return std::sin(fPi * x) / (fPi * x);
+}
+
+// zeroth order modified bessel function of the first kind, power series
+inline float BesselI0(float x)
+{
+    float sum = 1;
+    float term = 1;
+    float halfX = x * 0.5f;
+    for (int k = 1; k < 32 && term > sum * 1e-7f; ++k)
+    {
+        term *= (halfX / k) * (halfX / k);
+        sum += term;
+    }
+    return sum;
+}
+
+// kaiser windowed sinc, alpha = 4 like most texture tools use
+inline float filterFn_Kaiser(float t, float a)
+{
+    const float alpha = 4;
+    float r = t / a;
+    if (std::abs(r) >= 1)
+        return 0;
+    return Sinc(t) * BesselI0(alpha * std::sqrt(1 - r * r)) / BesselI0(alpha);
+}
+
+inline float filterFn_Lanczos(float t, float a)
+{
+    if (std::abs(t) >= a)
+        return 0;
+    return Sinc(t) * Sinc(t / a);
+}
+
+enum class EdgeMode
+{
+    Clamp,
+    Wrap
+};
+
+// source texels and normalized weights of every target texel along one axis, edges are already resolved
+struct FilterTable
+{
+    uint32_t taps;
+    std::vector<uint32_t> indices;
+    std::vector<float> weights;
+};
+
 class Processor
 {
 public:
-    std::unique_ptr<LinearImage> GenerateMipmap(RefPtr<LinearImage> source, FilterFn filterFn, float sampleCount)
+    // halves both dimensions of a float image. filterRadius is in target texels
+    std::unique_ptr<LinearImage> GenerateMipmap(
+        RefPtr<LinearImage> source, FilterFn filterFn, float filterRadius, EdgeMode edgeMode = EdgeMode::Clamp
+    )
     {
-        auto r0 = Transpose(RowDownSample(source, filterFn, sampleCount));
-        auto r1 = Transpose(RowDownSample(r0, filterFn, sampleCount));
+        auto r0 = Transpose(RowDownSample(source, filterFn, filterRadius, edgeMode));
+        auto r1 = Transpose(RowDownSample(r0, filterFn, filterRadius, edgeMode));
 
         return r1;
     }
 
     std::unique_ptr<LinearImage> Transpose(RefPtr<LinearImage> source);
 
-    std::unique_ptr<LinearImage> RowDownSample(RefPtr<LinearImage> sImage,
-                                               FilterFn filterFn,
-                                               const uint32_t sampleDistance);
+    std::unique_ptr<LinearImage> RowDownSample(
+        RefPtr<LinearImage> sImage, FilterFn filterFn, float filterRadius, EdgeMode edgeMode = EdgeMode::Clamp
+    );
+
+    static FilterTable CreateFilterTable(
+        uint32_t sWidth, uint32_t tWidth, FilterFn filterFn, float filterRadius, EdgeMode edgeMode
+    );
 };
 } // namespace Libs::Image
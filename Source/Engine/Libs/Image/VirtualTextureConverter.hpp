@@ -1,70 +1,229 @@
 #pragma once
+#include "ImageProcessing.hpp"
 #include "LinearImage.hpp"
+#include "Libs/JobSystem.hpp"
 #include "ThirdParty/stb/stb_image.h"
 #include "ThirdParty/stb/stb_image_write.h"
 #include "Rendering/Structs.hpp"
 #include <filesystem>
-#include <format>
+#include <fstream>
+#include <spdlog/spdlog.h>
+#include <vector>
 namespace Libs::Image
 {
+enum class VirtualTexturePageCompression : uint32_t
+{
+    None,
+    // lossy, alpha is dropped and decodes as opaque
+    Jpeg
+};
+
+// page file layout: header, one entry per page, page data. Pages are ordered like the nodes of MipQuadTree, mip 0 row
+// by row first and then every coarser mip down to the one that is a single page wide
+struct VirtualTexturePageFileHeader
+{
+    static constexpr uint32_t Magic = 0x50545657; // WVTP
+    static constexpr uint32_t CurrentVersion = 1;
+
+    uint32_t magic = Magic;
+    uint32_t version = CurrentVersion;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t channels = 0;
+    uint32_t pageExtent = 0;
+    // pages of mip 0
+    uint32_t pageCountX = 0;
+    uint32_t pageCountY = 0;
+    uint32_t mipCount = 0;
+    uint32_t pageCount = 0;
+    VirtualTexturePageCompression compression = VirtualTexturePageCompression::None;
+};
+
+struct VirtualTexturePageEntry
+{
+    uint64_t offset;
+    uint32_t byteSize;
+    uint32_t reserved = 0;
+};
+
+inline uint32_t GetVirtualTexturePageID(const VirtualTexturePageFileHeader& header, int x, int y, int mip)
+{
+    uint32_t offset = 0;
+    for (int l = 0; l < mip; ++l)
+    {
+        offset += (header.pageCountX >> l) * (header.pageCountY >> l);
+    }
+    return offset + y * (header.pageCountX >> mip) + x;
+}
+
 class VirtualTextureConverter
 {
 public:
     // nomeclature
     // x, y: page space
     // w, h: pixel space
-    void Convert(
+    // writes every mip of srcImage into one page file, the page counts of mip 0 have to be powers of two
+    bool Convert(
         const std::filesystem::path& srcImage,
-        const std::filesystem::path& dstFolder,
-        int mip,
+        const std::filesystem::path& dstFile,
         int desiredChannels,
-        uint32_t pageExtent
+        uint32_t pageExtent,
+        VirtualTexturePageCompression compression,
+        int jpegQuality = 90
     )
     {
         int w, h, channels;
         stbi_uc* data = stbi_load(srcImage.string().c_str(), &w, &h, &channels, desiredChannels);
+        if (data == nullptr)
+        {
+            SPDLOG_ERROR("VirtualTextureConverter: failed to load {}", srcImage.string());
+            return false;
+        }
+        if (desiredChannels != 0)
+            channels = desiredChannels;
 
-        if (w % pageExtent != 0 || h % pageExtent != 0)
-            return;
-
-        int pageXCount = std::ceil(w / (float)pageExtent);
-        int pageYCount = std::ceil(h / (float)pageExtent);
+        VirtualTexturePageFileHeader header;
+        header.width = w;
+        header.height = h;
+        header.channels = channels;
+        header.pageExtent = pageExtent;
+        header.pageCountX = w / pageExtent;
+        header.pageCountY = h / pageExtent;
+        header.compression = compression;
 
-        Extent2D srcWh{(uint32_t)w, (uint32_t)h};
-        for (int i = 0; i < pageXCount; ++i)
+        auto isPowerOfTwo = [](uint32_t v) { return v >= 2 && (v & (v - 1)) == 0; };
+        if (w % pageExtent != 0 || h % pageExtent != 0 || !isPowerOfTwo(header.pageCountX) ||
+            !isPowerOfTwo(header.pageCountY))
         {
-            for (int j = 0; j < pageYCount; ++j)
+            SPDLOG_ERROR(
+                "VirtualTextureConverter: {}x{} is not a power of two number of pages of {}",
+                w,
+                h,
+                pageExtent
+            );
+            stbi_image_free(data);
+            return false;
+        }
+
+        // same levels as MipQuadTree, the last mip is a single page wide or tall
+        header.mipCount = std::log2(std::min(header.pageCountX, header.pageCountY)) + 1;
+        header.pageCount = GetVirtualTexturePageID(header, 0, 0, header.mipCount);
+
+        uint8_t* mips;
+        size_t mipsByteSize;
+        GenerateBoxFilteredMipmap(
+            data,
+            w,
+            h,
+            1,
+            header.mipCount,
+            channels,
+            ChannelType::UInt8,
+            true,
+            mips,
+            mipsByteSize
+        );
+        stbi_image_free(data);
+
+        // encoding dominates with jpeg, every page is encoded on its own job
+        std::vector<std::vector<uint8_t>> pages(header.pageCount);
+        std::vector<size_t> mipOffsets(header.mipCount, 0);
+        for (uint32_t mip = 1; mip < header.mipCount; ++mip)
+            mipOffsets[mip] = mipOffsets[mip - 1] + size_t(w >> (mip - 1)) * (h >> (mip - 1)) * channels * ElementSize;
+
+        JobSystem::GetSingleton().ParallelFor(
+            header.pageCount,
+            1,
+            [&](size_t begin, size_t end)
             {
-                Rect2D pageRect;
-                pageRect.offset = {i * (int32_t)pageExtent, j * (int32_t)pageExtent};
-                pageRect.extent = {pageExtent, pageExtent};
-                LinearImage page = ExtractPage(data, srcWh, pageRect, channels);
-
-                std::string name = fmt::format("{}_{}_{}.jpg", mip, i, j);
-                std::filesystem::path dstPath = dstFolder / name;
-                stbi_write_jpg(dstPath.string().c_str(), pageExtent, pageExtent, channels, page.GetData(), 100);
+                for (size_t id = begin; id < end; ++id)
+                {
+                    int mip = 0;
+                    uint32_t local = id;
+                    while (local >= (header.pageCountX >> mip) * (header.pageCountY >> mip))
+                    {
+                        local -= (header.pageCountX >> mip) * (header.pageCountY >> mip);
+                        mip += 1;
+                    }
+                    int x = local % (header.pageCountX >> mip);
+                    int y = local / (header.pageCountX >> mip);
+
+                    Extent2D srcWh{(uint32_t)w >> mip, (uint32_t)h >> mip};
+                    Rect2D pageRect;
+                    pageRect.offset = {x * (int32_t)pageExtent, y * (int32_t)pageExtent};
+                    pageRect.extent = {pageExtent, pageExtent};
+                    LinearImage page = ExtractPage(mips + mipOffsets[mip], srcWh, pageRect, channels);
+                    pages[id] = EncodePage(page, compression, jpegQuality);
+                }
             }
+        );
+        delete[] mips;
+
+        std::vector<VirtualTexturePageEntry> entries(header.pageCount);
+        uint64_t offset = sizeof(header) + entries.size() * sizeof(VirtualTexturePageEntry);
+        for (uint32_t id = 0; id < header.pageCount; ++id)
+        {
+            entries[id].offset = offset;
+            entries[id].byteSize = pages[id].size();
+            offset += pages[id].size();
         }
 
-        delete data;
+        std::ofstream out(dstFile, std::ios::binary | std::ios::trunc);
+        if (!out.is_open())
+        {
+            SPDLOG_ERROR("VirtualTextureConverter: failed to open {}", dstFile.string());
+            return false;
+        }
+        out.write((char*)&header, sizeof(header));
+        out.write((char*)entries.data(), entries.size() * sizeof(VirtualTexturePageEntry));
+        for (auto& page : pages)
+            out.write((char*)page.data(), page.size());
+
+        return out.good();
     }
 
 private:
-    const int ElementSize = 1; // expect 8 bit channel
+    static constexpr int ElementSize = 1; // expect 8 bit channel
+
+    static std::vector<uint8_t> EncodePage(LinearImage& page, VirtualTexturePageCompression compression, int quality)
+    {
+        std::vector<uint8_t> encoded;
+        if (compression == VirtualTexturePageCompression::Jpeg)
+        {
+            stbi_write_jpg_to_func(
+                [](void* context, void* data, int size)
+                {
+                    auto& encoded = *(std::vector<uint8_t>*)context;
+                    encoded.insert(encoded.end(), (uint8_t*)data, (uint8_t*)data + size);
+                },
+                &encoded,
+                page.GetWidth(),
+                page.GetHeight(),
+                page.GetChannel(),
+                page.GetData(),
+                quality
+            );
+        }
+        else
+        {
+            encoded.assign(page.GetData(), page.GetData() + page.GetSize());
+        }
+        return encoded;
+    }
 
-    LinearImage ExtractPage(unsigned char* src, Extent2D srcWh, Rect2D page, int channel)
+    static LinearImage ExtractPage(unsigned char* src, Extent2D srcWh, Rect2D page, int channel)
     {
         auto offset = page.offset;
         auto extent = page.extent;
 
-        uint32_t oriOffsetY = offset.y * srcWh.width * channel * ElementSize;
-        uint32_t oriOffsetX = offset.x * channel * ElementSize;
+        size_t oriOffsetY = size_t(offset.y) * srcWh.width * channel * ElementSize;
+        size_t oriOffsetX = size_t(offset.x) * channel * ElementSize;
         unsigned char* ori = src + oriOffsetY + oriOffsetX;
 
         LinearImage pageDst(extent.width, extent.height, channel, ElementSize);
         unsigned char* data = (unsigned char*)pageDst.GetData();
         uint32_t pixelSize = channel * ElementSize;
-        uint32_t srcByteWidth = pixelSize * srcWh.width;
+        size_t srcByteWidth = size_t(pixelSize) * srcWh.width;
         uint32_t pageByteWidth = pixelSize * extent.width;
 
         for (int j = 0; j < extent.height; ++j)
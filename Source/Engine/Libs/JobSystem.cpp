@@ -0,0 +1,113 @@
+#include "JobSystem.hpp"
+#include <algorithm>
+#include <atomic>
+
+JobSystem::JobSystem(uint32_t threadCount)
+{
+    if (threadCount == 0)
+        threadCount = std::max(2u, std::thread::hardware_concurrency()) - 1;
+
+    for (uint32_t i = 0; i < threadCount; ++i)
+    {
+        threads.emplace_back([this]() { WorkerLoop(); });
+    }
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::scoped_lock lock(jobsMutex);
+        stopping = true;
+    }
+    jobsCondition.notify_all();
+
+    for (auto& t : threads)
+        t.join();
+}
+
+JobSystem& JobSystem::GetSingleton()
+{
+    static JobSystem jobSystem;
+    return jobSystem;
+}
+
+void JobSystem::Push(std::function<void()>&& job)
+{
+    {
+        std::scoped_lock lock(jobsMutex);
+        jobs.push(std::move(job));
+    }
+    jobsCondition.notify_one();
+}
+
+void JobSystem::WorkerLoop()
+{
+    while (true)
+    {
+        std::function<void()> job;
+        {
+            std::unique_lock lock(jobsMutex);
+            jobsCondition.wait(lock, [this]() { return stopping || !jobs.empty(); });
+
+            // drain the queue before stopping so that no future is left without a value
+            if (jobs.empty())
+                return;
+
+            job = std::move(jobs.front());
+            jobs.pop();
+        }
+
+        job();
+    }
+}
+
+void JobSystem::ParallelFor(size_t count, size_t grainSize, const std::function<void(size_t begin, size_t end)>& fn)
+{
+    if (count == 0)
+        return;
+
+    grainSize = std::max<size_t>(grainSize, 1);
+    size_t chunkCount = (count + grainSize - 1) / grainSize;
+    if (chunkCount == 1 || threads.empty())
+    {
+        fn(0, count);
+        return;
+    }
+
+    struct State
+    {
+        std::atomic<size_t> next = 0;
+        std::atomic<size_t> done = 0;
+        std::mutex doneMutex;
+        std::condition_variable doneCondition;
+    };
+    auto state = std::make_shared<State>();
+
+    // helpers that start after every chunk is claimed return without touching fn, so capturing it by reference is
+    // fine even if they outlive this call
+    auto work = [state, &fn, count, grainSize, chunkCount]()
+    {
+        size_t chunk;
+        while ((chunk = state->next.fetch_add(1)) < chunkCount)
+        {
+            size_t begin = chunk * grainSize;
+            size_t end = std::min(begin + grainSize, count);
+            fn(begin, end);
+
+            if (state->done.fetch_add(1) + 1 == chunkCount)
+            {
+                std::scoped_lock lock(state->doneMutex);
+                state->doneCondition.notify_all();
+            }
+        }
+    };
+
+    size_t helperCount = std::min<size_t>(threads.size(), chunkCount - 1);
+    for (size_t i = 0; i < helperCount; ++i)
+        Push(work);
+
+    work();
+
+    std::unique_lock lock(state->doneMutex);
+    state->doneCondition.wait(lock, [&state, chunkCount]() { return state->done == chunkCount; });
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// a fixed size worker pool shared by engine systems that want to run work off the calling thread
+class JobSystem
+{
+public:
+    // threadCount == 0 uses hardware_concurrency - 1 workers
+    JobSystem(uint32_t threadCount = 0);
+    JobSystem(const JobSystem& other) = delete;
+    ~JobSystem();
+
+    static JobSystem& GetSingleton();
+
+    // run job on a worker thread, the returned future holds its result
+    template <class F>
+    auto Schedule(F&& job) -> std::future<std::invoke_result_t<F>>
+    {
+        using R = std::invoke_result_t<F>;
+        auto task = std::make_shared<std::packaged_task<R()>>(std::forward<F>(job));
+        auto future = task->get_future();
+        Push([task]() { (*task)(); });
+        return future;
+    }
+
+    // split [0, count) into chunks of at most grainSize and run fn(begin, end) on them in parallel. The calling thread
+    // works on chunks too and only returns when all of them are done, so it's safe to call from inside a job
+    void ParallelFor(size_t count, size_t grainSize, const std::function<void(size_t begin, size_t end)>& fn);
+
+    uint32_t GetThreadCount()
+    {
+        return threads.size();
+    }
+
+private:
+    std::vector<std::thread> threads;
+    std::queue<std::function<void()>> jobs;
+    std::mutex jobsMutex;
+    std::condition_variable jobsCondition;
+    bool stopping = false;
+
+    void Push(std::function<void()>&& job);
+    void WorkerLoop();
+};
@@ -0,0 +1,181 @@
+#include "MeshShapeCache.hpp"
+#include "AssetDatabase/AssetDatabase.hpp"
+#include "Core/Graphics/Mesh.hpp"
+#include "Profiler/Profiler.hpp"
+#include "ThirdParty/xxHash/xxhash.h"
+#include <Jolt/Core/StreamWrapper.h>
+#include <Jolt/Physics/Collision/Shape/MeshShape.h>
+#include <Jolt/Physics/Collision/Shape/ScaledShape.h>
+#include <chrono>
+#include <fstream>
+#include <spdlog/spdlog.h>
+
+MeshShapeCache& MeshShapeCache::GetSingleton()
+{
+    static MeshShapeCache cache;
+    return cache;
+}
+
+JPH::Ref<JPH::Shape> MeshShapeCache::GetShape(Mesh& mesh, const glm::vec3& scale)
+{
+    std::scoped_lock lock(mutex);
+    if (scale == glm::vec3(1))
+        return GetUnitShape(mesh);
+
+    // a hit doesn't touch the unit shape, so it's counted as shared once
+    auto& scaled = scaledShapes[mesh.GetGeometryHash()];
+    for (auto& [s, shape] : scaled)
+    {
+        if (s == scale)
+        {
+            stats.shared += 1;
+            return shape;
+        }
+    }
+
+    JPH::Ref<JPH::Shape> unitShape = GetUnitShape(mesh);
+    if (unitShape == nullptr)
+        return nullptr;
+
+    JPH::Ref<JPH::Shape> shape = new JPH::ScaledShape(unitShape, {scale.x, scale.y, scale.z});
+    scaled.emplace_back(scale, shape);
+    return shape;
+}
+
+void MeshShapeCache::EvictUnused()
+{
+    std::scoped_lock lock(mutex);
+
+    // scaled shapes hold a reference to their unit shape, they go first
+    for (auto iter = scaledShapes.begin(); iter != scaledShapes.end();)
+    {
+        auto& scaled = iter->second;
+        std::erase_if(scaled, [](auto& entry) { return entry.second->GetRefCount() == 1; });
+        if (scaled.empty())
+            iter = scaledShapes.erase(iter);
+        else
+            ++iter;
+    }
+
+    // meshes without triangles are cached as nullptr
+    std::erase_if(unitShapes, [](auto& entry) { return entry.second == nullptr || entry.second->GetRefCount() == 1; });
+}
+
+JPH::Ref<JPH::Shape> MeshShapeCache::GetUnitShape(Mesh& mesh)
+{
+    uint64_t geometryHash = mesh.GetGeometryHash();
+    auto iter = unitShapes.find(geometryHash);
+    if (iter != unitShapes.end())
+    {
+        stats.shared += 1;
+        return iter->second;
+    }
+
+    // the geometry and the cooking code decide the result, the asset the mesh comes from doesn't
+    uint64_t keys[2] = {geometryHash, CookVersion};
+    std::string artifact = ImportDatabase::KeyToString(XXH3_64bits(keys, sizeof(keys))) + ".jshape";
+
+    JPH::Ref<JPH::Shape> shape = Restore(artifact);
+    if (shape == nullptr)
+    {
+        shape = Cook(mesh);
+        if (shape != nullptr)
+            Save(*shape, artifact);
+    }
+
+    unitShapes[geometryHash] = shape;
+    return shape;
+}
+
+JPH::Ref<JPH::Shape> MeshShapeCache::Cook(Mesh& mesh)
+{
+    ENGINE_SCOPED_PROFILE("MeshShapeCache - Cook");
+    auto start = std::chrono::steady_clock::now();
+
+    // indexed, so shared vertices are only stored once
+    JPH::VertexList vertices;
+    JPH::IndexedTriangleList triangles;
+    for (auto& submesh : mesh.GetSubmeshes())
+    {
+        auto& indices = submesh.GetIndices();
+        auto& positions = submesh.GetPositions();
+        uint32_t base = vertices.size();
+        for (auto& p : positions)
+        {
+            vertices.push_back({p.x, p.y, p.z});
+        }
+
+        for (size_t i = 0; i + 2 < indices.size(); i += 3)
+        {
+            triangles.push_back({base + indices[i], base + indices[i + 1], base + indices[i + 2]});
+        }
+    }
+
+    if (triangles.empty())
+        return nullptr;
+
+    JPH::MeshShapeSettings settings(std::move(vertices), std::move(triangles));
+    auto result = settings.Create();
+    if (result.HasError())
+    {
+        spdlog::error("MeshShapeCache: cooking {} failed, {}", mesh.GetName(), result.GetError().c_str());
+        return nullptr;
+    }
+
+    stats.cooked += 1;
+    stats.cookMs += std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return result.Get();
+}
+
+ImportDatabase* MeshShapeCache::GetImportDatabase()
+{
+    if (importDatabase != nullptr)
+        return importDatabase;
+
+    AssetDatabase* assetDatabase = AssetDatabase::Singleton();
+    return assetDatabase ? &assetDatabase->GetImportDatabase() : nullptr;
+}
+
+JPH::Ref<JPH::Shape> MeshShapeCache::Restore(const std::string& artifact)
+{
+    ImportDatabase* database = GetImportDatabase();
+    if (database == nullptr)
+        return nullptr;
+
+    std::ifstream f(database->GetImportAssetPath(artifact), std::ios::binary);
+    if (!f.is_open())
+        return nullptr;
+
+    ENGINE_SCOPED_PROFILE("MeshShapeCache - Restore");
+    auto start = std::chrono::steady_clock::now();
+
+    JPH::StreamInWrapper in(f);
+    JPH::Shape::IDToShapeMap shapeMap;
+    JPH::Shape::IDToMaterialMap materialMap;
+    auto result = JPH::Shape::sRestoreWithChildren(in, shapeMap, materialMap);
+    if (in.IsFailed() || result.HasError())
+    {
+        spdlog::warn("MeshShapeCache: {} is unreadable, cooking again", artifact);
+        return nullptr;
+    }
+
+    stats.restored += 1;
+    stats.restoreMs += std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return result.Get();
+}
+
+void MeshShapeCache::Save(const JPH::Shape& shape, const std::string& artifact)
+{
+    ImportDatabase* database = GetImportDatabase();
+    if (database == nullptr)
+        return;
+
+    std::ofstream f(database->GetImportAssetPath(artifact), std::ios::binary | std::ios::trunc);
+    if (!f.is_open())
+        return;
+
+    JPH::StreamOutWrapper out(f);
+    JPH::Shape::ShapeToIDMap shapeMap;
+    JPH::Shape::MaterialToIDMap materialMap;
+    shape.SaveWithChildren(out, shapeMap, materialMap);
+}
@@ -0,0 +1,70 @@
+#pragma once
+// clang-format off
+#include <Jolt/Jolt.h>
+// clang-format on
+#include <Jolt/Physics/Collision/Shape/Shape.h>
+#include <glm/glm.hpp>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class Mesh;
+class ImportDatabase;
+
+// collision shapes of meshes, shared by every PhysicsBody that uses the same geometry. A mesh is cooked into a
+// JPH::MeshShape once at unit scale and the result is written to the import database in Jolt's binary shape format, so
+// later runs restore it instead of cooking again. Scaled instances share a ScaledShape per (mesh, scale)
+class MeshShapeCache
+{
+public:
+    static MeshShapeCache& GetSingleton();
+
+    // nullptr if the mesh has no triangles
+    JPH::Ref<JPH::Shape> GetShape(Mesh& mesh, const glm::vec3& scale);
+
+    // drops the shapes only the cache still references, called when a scene is unloaded. The cooked files stay, a mesh
+    // that is used again is restored from them
+    void EvictUnused();
+
+    // where cooked shapes are written and restored from, nullptr uses the asset database's
+    void SetImportDatabase(ImportDatabase* importDatabase)
+    {
+        std::scoped_lock lock(mutex);
+        this->importDatabase = importDatabase;
+    }
+
+    struct Stats
+    {
+        uint32_t cooked = 0;
+        uint32_t restored = 0;
+        // requests served from memory
+        uint32_t shared = 0;
+        float cookMs = 0;
+        float restoreMs = 0;
+    };
+
+    Stats GetStats()
+    {
+        std::scoped_lock lock(mutex);
+        return stats;
+    }
+
+private:
+    // bump when the cooked data changes, older files are ignored
+    static const uint64_t CookVersion = 1;
+
+    std::mutex mutex;
+    // by Mesh::GetGeometryHash
+    std::unordered_map<uint64_t, JPH::Ref<JPH::Shape>> unitShapes;
+    // few distinct scales per mesh, a linear search is enough
+    std::unordered_map<uint64_t, std::vector<std::pair<glm::vec3, JPH::Ref<JPH::Shape>>>> scaledShapes;
+    Stats stats;
+    ImportDatabase* importDatabase = nullptr;
+
+    ImportDatabase* GetImportDatabase();
+    JPH::Ref<JPH::Shape> GetUnitShape(Mesh& mesh);
+    JPH::Ref<JPH::Shape> Cook(Mesh& mesh);
+    JPH::Ref<JPH::Shape> Restore(const std::string& artifact);
+    void Save(const JPH::Shape& shape, const std::string& artifact);
+};
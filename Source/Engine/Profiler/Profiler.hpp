@@ -1,6 +1,7 @@
 #pragma once
 #include <chrono>
 #include <iostream>
+#include <map>
 #include <stack>
 #include <string>
 #include <vector>
@@ -120,6 +121,23 @@ public:
         return frameProfiles;
     }
 
+    // a value sampled once per frame (e.g. memory usage), each counter is a track indexed like the frame profiles
+    void SetCounter(std::string_view name, float value)
+    {
+        if (actuallyPaused)
+            return;
+
+        auto iter = counters.find(name);
+        if (iter == counters.end())
+            iter = counters.emplace(std::string(name), std::vector<float>(MAX_FRAME_TRACKED, 0)).first;
+        iter->second[currentFrame] = value;
+    }
+
+    const std::map<std::string, std::vector<float>, std::less<>>& GetCounters() const
+    {
+        return counters;
+    }
+
     int GetFrameIndex() const
     {
         return currentFrame;
@@ -138,6 +156,7 @@ private:
     bool inProfiling = false;
     std::stack<ProfileScope*> activeScopes;
     std::vector<ProfileScope> frameProfiles;
+    std::map<std::string, std::vector<float>, std::less<>> counters;
     int currentFrame = 0;
     int trackCycles = 0;
     std::chrono::high_resolution_clock::time_point currentFrameStart;
@@ -162,3 +181,4 @@ struct ScopedProfile
 
 #define ENGINE_BEGIN_FRAME_PROFILE Profiler::GetSingleton().BeginFrame();
 #define ENGINE_END_FRAME_PROFILE Profiler::GetSingleton().EndFrame();
+#define ENGINE_PROFILE_COUNTER(name, value) Profiler::GetSingleton().SetCounter(name, value);
@@ -1,8 +1,51 @@
 #include "DrawList.hpp"
 #include "Core/Component/MeshRenderer.hpp"
 #include "Core/GameObject.hpp"
+// XXH3_state_t on the stack, other headers may have included xxhash.h without it already
+#define XXH_STATIC_LINKING_ONLY
+#include "ThirdParty/xxHash/xxhash.h"
+#include <unordered_map>
 namespace Rendering
 {
+namespace
+{
+bool CanBatch(const SceneObjectDrawData& a, const SceneObjectDrawData& b, bool matchMaterial)
+{
+    if (a.indexBuffer != b.indexBuffer || a.indexBufferType != b.indexBufferType || a.indexCount != b.indexCount ||
+        a.vertexBufferBinding.size() != b.vertexBufferBinding.size())
+        return false;
+
+    if (matchMaterial && (a.material != b.material || a.shaderResource != b.shaderResource))
+        return false;
+
+    for (size_t i = 0; i < a.vertexBufferBinding.size(); ++i)
+    {
+        if (a.vertexBufferBinding[i].buffer != b.vertexBufferBinding[i].buffer ||
+            a.vertexBufferBinding[i].offset != b.vertexBufferBinding[i].offset)
+            return false;
+    }
+
+    return true;
+}
+
+uint64_t GetBatchKey(const SceneObjectDrawData& draw, bool matchMaterial)
+{
+    XXH3_state_t state;
+    XXH3_64bits_reset(&state);
+    XXH3_64bits_update(&state, &draw.indexBuffer, sizeof(draw.indexBuffer));
+    XXH3_64bits_update(&state, &draw.indexCount, sizeof(draw.indexCount));
+    for (auto& binding : draw.vertexBufferBinding)
+    {
+        XXH3_64bits_update(&state, &binding.buffer, sizeof(binding.buffer));
+        XXH3_64bits_update(&state, &binding.offset, sizeof(binding.offset));
+    }
+    if (matchMaterial)
+        XXH3_64bits_update(&state, &draw.material, sizeof(draw.material));
+
+    return XXH3_64bits_digest(&state);
+}
+} // namespace
+
 void swap(SceneObjectDrawData&& a, SceneObjectDrawData&& b)
 {
     SceneObjectDrawData c(std::move(a));
@@ -47,6 +90,8 @@ void DrawList::Add(MeshRenderer& meshRenderer)
                 drawData.pushConstant = modelMatrix;
                 drawData.indexCount = indexCount;
                 drawData.material = material;
+                drawData.aabb = submesh->GetAABB();
+                drawData.aabb.Transform(glm::mat3(modelMatrix), modelMatrix[3]);
 
                 push_back(std::move(drawData));
             }
@@ -84,6 +129,8 @@ void DrawList::Add(MeshRenderer& meshRenderer)
                     auto modelMatrix = meshRenderer.GetGameObject()->GetWorldMatrix();
                     drawData.pushConstant = modelMatrix;
                     drawData.indexCount = indexCount;
+                    drawData.aabb = submesh.GetAABB();
+                    drawData.aabb.Transform(glm::mat3(modelMatrix), modelMatrix[3]);
 
                     push_back(std::move(drawData));
                 }
@@ -129,6 +176,72 @@ void DrawList::Sort(const glm::vec3& cameraPos)
     this->opaqueIndex = 0;
 }
 
+void DrawList::Batch()
+{
+    materialBatches.clear();
+    geometryBatches.clear();
+    instanceTransforms.clear();
+    instanceDrawIndices.clear();
+    indirectCommands = nullptr;
+
+    Batch(opaqueIndex, alphaTestIndex, true, materialBatches);
+    alphaTestBatchIndex = materialBatches.size();
+    Batch(alphaTestIndex, transparentIndex, true, materialBatches);
+    transparentBatchIndex = materialBatches.size();
+    for (int i = transparentIndex; i < size(); ++i)
+    {
+        materialBatches.push_back({i, (uint32_t)instanceTransforms.size(), 1});
+        instanceTransforms.push_back(at(i).pushConstant);
+        instanceDrawIndices.push_back(i);
+    }
+
+    Batch(0, size(), false, geometryBatches);
+}
+
+void DrawList::Batch(int begin, int end, bool matchMaterial, std::vector<DrawBatch>& batches)
+{
+    // collect the members of each group first so that their transforms end up contiguous. Groups are kept in the
+    // order of their first draw, which is the closest one after Sort
+    std::vector<std::vector<int>> groups;
+    std::unordered_map<uint64_t, std::vector<size_t>> groupLookup;
+    for (int i = begin; i < end; ++i)
+    {
+        auto& draw = at(i);
+        auto& candidates = groupLookup[GetBatchKey(draw, matchMaterial)];
+        size_t groupIndex = groups.size();
+        for (size_t c : candidates)
+        {
+            if (CanBatch(at(groups[c][0]), draw, matchMaterial))
+            {
+                groupIndex = c;
+                break;
+            }
+        }
+
+        if (groupIndex == groups.size())
+        {
+            groups.emplace_back();
+            candidates.push_back(groupIndex);
+        }
+        groups[groupIndex].push_back(i);
+    }
+
+    for (auto& group : groups)
+    {
+        batches.push_back({group[0], (uint32_t)instanceTransforms.size(), (uint32_t)group.size()});
+        for (int i : group)
+        {
+            instanceTransforms.push_back(at(i).pushConstant);
+            instanceDrawIndices.push_back(i);
+        }
+    }
+}
+
+bool DrawList::IsInstancingSupported(Gfx::ShaderProgram* shaderProgram)
+{
+    return shaderProgram->GetShaderInfo().bindings.contains("InstanceTransforms");
+}
+
 void DrawList::Add(std::span<MeshRenderer*> meshRenderers)
 {
     for (auto r : meshRenderers)
@@ -21,17 +21,56 @@ struct SceneObjectDrawData
     std::vector<Gfx::VertexBufferBinding> vertexBufferBinding;
     glm::mat4 pushConstant;
     uint32_t indexCount;
+    // world space bounds
+    AABB aabb;
 };
 void swap(SceneObjectDrawData&& a, SceneObjectDrawData&& b);
 
+// a group of draws that can be issued as one instanced draw
+struct DrawBatch
+{
+    // the draw whose bindings are used for the whole batch
+    int drawIndex;
+    // offset of the batch's transforms in DrawList::instanceTransforms, passed as the draw's firstInstance
+    uint32_t firstInstance;
+    uint32_t instanceCount;
+};
+
 class DrawList : public std::vector<SceneObjectDrawData>
 {
 public:
     int opaqueIndex;
     int alphaTestIndex;
     int transparentIndex;
+
+    // filled by Batch()
+    // materialBatches merge draws that share geometry and material and follow the same partition as the draws
+    std::vector<DrawBatch> materialBatches;
+    int alphaTestBatchIndex;
+    int transparentBatchIndex;
+    // geometryBatches only need the same geometry, used by passes that don't care about materials (e.g. shadow)
+    std::vector<DrawBatch> geometryBatches;
+    std::vector<glm::mat4> instanceTransforms;
+    // the draw each instance transform comes from
+    std::vector<int> instanceDrawIndices;
+
+    // set by GPUCullingNode after Batch(). When not null, batches are drawn with DrawIndexedIndirect, the commands of
+    // materialBatches come first followed by the ones of geometryBatches
+    Gfx::Buffer* indirectCommands = nullptr;
+    // sizeof(VkDrawIndexedIndirectCommand)
+    static constexpr uint32_t indirectCommandStride = 20;
+
     void Add(std::span<MeshRenderer*> meshRenderers);
     void Add(MeshRenderer& meshRenderer);
     void Sort(const glm::vec3& cameraPos);
+
+    // group draws into batches, call it after Sort. Transparent draws are never merged so they keep their order
+    void Batch();
+
+    // whether a shader program reads its transform from the InstanceTransforms buffer instead of a push constant
+    static bool IsInstancingSupported(Gfx::ShaderProgram* shaderProgram);
+
+private:
+    void Batch(int begin, int end, bool matchMaterial, std::vector<DrawBatch>& batches);
 };
 } // namespace Rendering
@@ -230,10 +230,10 @@ void Graph::ProcessLights(Scene& gameScene, Light*& mainLight)
         {
             case LightType::Directional:
                 {
-                    mainLight = lights[i];
                     glm::vec3 pos = -glm::normalize(glm::vec3(model[2]));
                     sceneInfo.lights[i].position = {pos, 0};
 
+                    // the brightest directional light, ties go to the first one in the stable GetActiveLights order
                     if (mainLight == nullptr || mainLight->GetIntensity() < lights[i]->GetIntensity())
                     {
                         mainLight = lights[i];
@@ -110,7 +110,7 @@ class DeferredShadingNode : public Node
                 cmd.BindVertexBuffer(draw.vertexBufferBinding, 0);
                 cmd.BindIndexBuffer(draw.indexBuffer, 0, draw.indexBufferType);
                 cmd.BindResource(2, draw.shaderResource);
-                cmd.SetPushConstant(draw.shader->GetShaderProgram(0, 0), (void*)&draw.pushConstant);
+                cmd.SetPushConstant(gbufferPassShader->GetDefaultShaderProgram(), (void*)&draw.pushConstant);
                 cmd.DrawIndexed(draw.indexCount, 1, 0, 0, 0);
             }
         }
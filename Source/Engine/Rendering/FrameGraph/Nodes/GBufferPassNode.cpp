@@ -87,37 +87,11 @@ class GBufferPassNode : public Node
         if (drawList)
         {
             // draw opaque objects
-            for (int i = 0; i < drawList->alphaTestIndex; ++i)
-            {
-                auto& draw = drawList->at(i);
-                auto shaderProgram = draw.material->GetShaderProgram("GBuffer");
-                if (shaderProgram)
-                {
-                    cmd.BindVertexBuffer(draw.vertexBufferBinding, 0);
-                    cmd.BindIndexBuffer(draw.indexBuffer, 0, draw.indexBufferType);
-                    cmd.BindResource(2, draw.shaderResource);
-                    cmd.BindShaderProgram(shaderProgram, shaderProgram->GetDefaultShaderConfig());
-                    cmd.SetPushConstant(shaderProgram, (void*)&draw.pushConstant);
-                    cmd.DrawIndexed(draw.indexCount, 1, 0, 0, 0);
-                }
-            }
+            DrawBatches(cmd, 0, drawList->alphaTestBatchIndex);
 
             // draw alpha tested objects
             Shader::EnableFeature("_AlphaTest");
-            for (int i = drawList->alphaTestIndex; i < drawList->transparentIndex; ++i)
-            {
-                auto& draw = drawList->at(i);
-                auto shaderProgram = draw.material->GetShaderProgram("GBuffer");
-                if (shaderProgram)
-                {
-                    cmd.BindVertexBuffer(draw.vertexBufferBinding, 0);
-                    cmd.BindIndexBuffer(draw.indexBuffer, 0, draw.indexBufferType);
-                    cmd.BindResource(2, draw.shaderResource);
-                    cmd.BindShaderProgram(shaderProgram, shaderProgram->GetDefaultShaderConfig());
-                    cmd.SetPushConstant(shaderProgram, (void*)&draw.pushConstant);
-                    cmd.DrawIndexed(draw.indexCount, 1, 0, 0, 0);
-                }
-            }
+            DrawBatches(cmd, drawList->alphaTestBatchIndex, drawList->transparentBatchIndex);
             Shader::DisableFeature("_AlphaTest");
         }
         cmd.EndRenderPass();
@@ -132,6 +106,47 @@ class GBufferPassNode : public Node
 private:
     const DrawList* drawList;
 
+    void DrawBatches(Gfx::CommandBuffer& cmd, int begin, int end)
+    {
+        for (int i = begin; i < end; ++i)
+        {
+            auto& batch = drawList->materialBatches[i];
+            auto& draw = drawList->at(batch.drawIndex);
+            auto shaderProgram = draw.material->GetShaderProgram("GBuffer");
+            if (shaderProgram)
+            {
+                cmd.BindVertexBuffer(draw.vertexBufferBinding, 0);
+                cmd.BindIndexBuffer(draw.indexBuffer, 0, draw.indexBufferType);
+                cmd.BindResource(2, draw.shaderResource);
+                cmd.BindShaderProgram(shaderProgram, shaderProgram->GetDefaultShaderConfig());
+                if (drawList->indirectCommands && DrawList::IsInstancingSupported(shaderProgram))
+                {
+                    // instance count was filled in by GPUCullingNode
+                    cmd.DrawIndexedIndirect(
+                        drawList->indirectCommands,
+                        i * DrawList::indirectCommandStride,
+                        1,
+                        DrawList::indirectCommandStride
+                    );
+                }
+                else if (DrawList::IsInstancingSupported(shaderProgram))
+                {
+                    cmd.DrawIndexed(draw.indexCount, batch.instanceCount, 0, 0, batch.firstInstance);
+                }
+                else
+                {
+                    // shaders that don't read InstanceTransforms still take the model matrix as a push constant
+                    for (uint32_t j = 0; j < batch.instanceCount; ++j)
+                    {
+                        auto& transform = drawList->instanceTransforms[batch.firstInstance + j];
+                        cmd.SetPushConstant(shaderProgram, (void*)&transform);
+                        cmd.DrawIndexed(draw.indexCount, 1, 0, 0, 0);
+                    }
+                }
+            }
+        }
+    }
+
     glm::vec4* clearValuesVal;
 
     Gfx::RG::ImageIdentifier albedoRTID = Gfx::RG::ImageIdentifier("gbuffer albedo");
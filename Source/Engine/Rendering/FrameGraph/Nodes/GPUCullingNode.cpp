@@ -0,0 +1,222 @@
+#include "../NodeBlueprint.hpp"
+#include "AssetDatabase/AssetDatabase.hpp"
+#include "Rendering/Shader.hpp"
+#include <cstring>
+#include <glm/glm.hpp>
+
+namespace Rendering::FrameGraph
+{
+// culls the batched draw list in a compute shader and writes a DrawIndexedIndirect command for each batch, so that
+// GBuffer and shadow passes only submit one indirect draw per batch regardless of how many instances survive
+class GPUCullingNode : public Node
+{
+    DECLARE_FRAME_GRAPH_NODE(GPUCullingNode)
+    {
+        input.drawList = AddInputProperty("draw list", PropertyType::DrawListPointer);
+        output.drawList = AddOutputProperty("draw list", PropertyType::DrawListPointer);
+
+        // needs a HiZSetupNode with "max depth" enabled, which keeps its pyramid in persistent images so that the
+        // previous frame's one can be tested against
+        AddConfig<ConfigurableType::Bool>("occlusion culling", false);
+
+        paramsBuffer = GetGfxDriver()->CreateBuffer(Gfx::Buffer::CreateInfo{
+            .usages = Gfx::BufferUsage::Uniform | Gfx::BufferUsage::Transfer_Dst,
+            .size = sizeof(Params),
+            .visibleInCPU = false,
+            .debugName = "gpu culling params",
+            .gpuWrite = false});
+
+        cullingCompute = static_cast<ComputeShader*>(
+            AssetDatabase::Singleton()->LoadAsset("_engine_internal/Shaders/Game/GPUCulling.comp")
+        );
+    }
+
+public:
+    void Compile() override
+    {
+        occlusionCulling = GetConfigurableVal<bool>("occlusion culling");
+        hasPreviousFrame = false;
+    }
+
+    void Execute(RenderingContext& renderContext, RenderingData& renderingData) override
+    {
+        auto& cmd = *renderingData.cmd;
+        DrawList* drawList = input.drawList->GetValue<DrawList*>();
+        output.drawList->SetValue(drawList);
+
+        if (drawList == nullptr || cullingCompute == nullptr || drawList->empty())
+            return;
+
+        UploadObjects(*drawList);
+        UploadCommands(*drawList);
+
+        // same mip count HiZSetupNode generates
+        glm::vec2 screenSize = renderingData.screenSize;
+        // a resize recreates the pyramid, there's nothing in it until HiZSetupNode ran at the new size
+        if (glm::vec2(params.hiZSize) != screenSize)
+            hasPreviousFrame = false;
+        float mipCount = glm::min(glm::floor(glm::log2(glm::max(screenSize.x, screenSize.y))) + 1, 12.0f);
+        params.hiZSize = glm::vec4(screenSize, mipCount, 0);
+        params.objectCount = drawList->size();
+        params.materialBatchCount = drawList->materialBatches.size();
+        GetGfxDriver()->UploadBuffer(*paramsBuffer, (uint8_t*)&params, sizeof(Params));
+
+        cmd.SetBuffer("CullObjects", *objectBuffer);
+        cmd.SetBuffer("DrawCommands", *commandBuffer);
+        cmd.SetBuffer("CulledInstanceTransforms", *culledTransformBuffer);
+        cmd.SetBuffer("GPUCullingParams", *paramsBuffer);
+
+        // the first frame has no pyramid to test against
+        bool occlusion = occlusionCulling && hasPreviousFrame;
+        auto program = occlusion ? cullingCompute->GetShaderProgram({"_OcclusionCulling"})
+                                 : cullingCompute->GetDefaultShaderProgram();
+        cmd.BindShaderProgram(program, cullingCompute->GetDefaultShaderConfig());
+        cmd.Dispatch(glm::ceil(drawList->size() / 64.0f), 1, 1);
+
+        // batched passes after this node read the compacted transforms
+        cmd.SetBuffer("InstanceTransforms", *culledTransformBuffer);
+        drawList->indirectCommands = commandBuffer.get();
+
+        params.prevViewProjection = renderingData.sceneInfo->viewProjection;
+        hasPreviousFrame = true;
+    }
+
+private:
+    struct CullObject
+    {
+        glm::vec4 boundsMin;
+        glm::vec4 boundsMax;
+        // material batch, geometry batch, source instance
+        glm::uvec4 indices;
+    };
+
+    // matches VkDrawIndexedIndirectCommand
+    struct DrawCommand
+    {
+        uint32_t indexCount;
+        uint32_t instanceCount;
+        uint32_t firstIndex;
+        int32_t vertexOffset;
+        uint32_t firstInstance;
+    };
+    static_assert(sizeof(DrawCommand) == DrawList::indirectCommandStride);
+
+    struct Params
+    {
+        glm::mat4 prevViewProjection = glm::mat4(1);
+        glm::vec4 hiZSize;
+        uint32_t objectCount;
+        uint32_t materialBatchCount;
+    } params;
+
+    struct
+    {
+        PropertyHandle drawList;
+    } input;
+
+    struct
+    {
+        PropertyHandle drawList;
+    } output;
+
+    ComputeShader* cullingCompute;
+    bool occlusionCulling = false;
+    bool hasPreviousFrame = false;
+
+    std::unique_ptr<Gfx::Buffer> objectBuffer;
+    std::unique_ptr<Gfx::Buffer> commandBuffer;
+    std::unique_ptr<Gfx::Buffer> culledTransformBuffer;
+    std::unique_ptr<Gfx::Buffer> paramsBuffer;
+
+    // what objectBuffer holds, static scenes don't upload the object table again
+    std::vector<CullObject> uploadedObjects;
+    std::vector<CullObject> objects;
+    std::vector<DrawCommand> commands;
+
+    void EnsureSize(std::unique_ptr<Gfx::Buffer>& buffer, size_t size, Gfx::BufferUsageFlags usages, const char* name)
+    {
+        if (buffer == nullptr || buffer->GetSize() < size)
+        {
+            buffer = GetGfxDriver()->CreateBuffer(Gfx::Buffer::CreateInfo{
+                .usages = usages,
+                .size = size * 3 / 2,
+                .visibleInCPU = false,
+                .debugName = name,
+                .gpuWrite = true});
+
+            if (&buffer == &objectBuffer)
+                uploadedObjects.clear();
+        }
+    }
+
+    void UploadObjects(DrawList& drawList)
+    {
+        // each draw appears once in the material batches and once in the geometry batches
+        objects.resize(drawList.size());
+        auto assign = [this, &drawList](const std::vector<DrawBatch>& batches, int component)
+        {
+            for (uint32_t b = 0; b < batches.size(); ++b)
+            {
+                for (uint32_t i = 0; i < batches[b].instanceCount; ++i)
+                {
+                    uint32_t instance = batches[b].firstInstance + i;
+                    auto& object = objects[drawList.instanceDrawIndices[instance]];
+                    object.indices[component] = b;
+                    object.indices.z = instance;
+                }
+            }
+        };
+        assign(drawList.materialBatches, 0);
+        assign(drawList.geometryBatches, 1);
+        for (int i = 0; i < drawList.size(); ++i)
+        {
+            objects[i].boundsMin = glm::vec4(drawList[i].aabb.min, 0);
+            objects[i].boundsMax = glm::vec4(drawList[i].aabb.max, 0);
+        }
+
+        size_t size = objects.size() * sizeof(CullObject);
+        EnsureSize(
+            objectBuffer,
+            size,
+            Gfx::BufferUsage::Storage | Gfx::BufferUsage::Transfer_Dst,
+            "gpu culling objects"
+        );
+        EnsureSize(
+            culledTransformBuffer,
+            drawList.instanceTransforms.size() * sizeof(glm::mat4),
+            Gfx::BufferUsage::Storage,
+            "culled instance transforms"
+        );
+
+        if (uploadedObjects.size() != objects.size() || memcmp(uploadedObjects.data(), objects.data(), size) != 0)
+        {
+            GetGfxDriver()->UploadBuffer(*objectBuffer, (uint8_t*)objects.data(), size);
+            uploadedObjects = objects;
+        }
+    }
+
+    void UploadCommands(DrawList& drawList)
+    {
+        // instance counts start at 0 every frame, the compute shader increments them for visible instances
+        commands.clear();
+        for (auto batches : {&drawList.materialBatches, &drawList.geometryBatches})
+        {
+            for (auto& batch : *batches)
+            {
+                commands.push_back({drawList[batch.drawIndex].indexCount, 0, 0, 0, batch.firstInstance});
+            }
+        }
+
+        size_t size = commands.size() * sizeof(DrawCommand);
+        EnsureSize(
+            commandBuffer,
+            size,
+            Gfx::BufferUsage::Storage | Gfx::BufferUsage::Indirect | Gfx::BufferUsage::Transfer_Dst,
+            "gpu culling draw commands"
+        );
+        GetGfxDriver()->UploadBuffer(*commandBuffer, (uint8_t*)commands.data(), size);
+    }
+};
+
+DEFINE_FRAME_GRAPH_NODE(GPUCullingNode, "1CC181D1-F046-4992-97C7-45252B96449A");
+} // namespace Rendering::FrameGraph
@@ -1,4 +1,5 @@
 #include "../NodeBlueprint.hpp"
+#include "GfxDriver/Image.hpp"
 #include "Rendering/Shader.hpp"
 #include "AssetDatabase/AssetDatabase.hpp"
 #include <glm/glm.hpp>
@@ -12,6 +13,9 @@ class HiZSetupNode : public Node
         input.depth = AddInputProperty("source depth", PropertyType::Attachment);
         AddOutputProperty("HiZ *", PropertyType::GraphFlow);
 
+        // max depth pyramids are bound to hiZMaxBuffers for occlusion culling, the default min depth one is for SSR
+        AddConfig<ConfigurableType::Bool>("max depth", false);
+
         hizDescs.resize(MAX_MIP);
         hizIds.resize(MAX_MIP);
 
@@ -35,7 +39,14 @@ class HiZSetupNode : public Node
     }
 
 public:
-    void Compile() override {}
+    void Compile() override
+    {
+        maxDepth = GetConfigurableVal<bool>("max depth");
+        hizIds.assign(MAX_MIP, {});
+        persistentMips.clear();
+        if (maxDepth)
+            persistentMips.resize(MAX_MIP);
+    }
 
     void Execute(RenderingContext& renderContext, RenderingData& renderingData) override
     {
@@ -70,7 +81,23 @@ public:
             hizDescs[i].SetWidth(glm::ceil(srcDepth.desc.GetWidth() / mipScale));
             hizDescs[i].SetHeight(glm::ceil(srcDepth.desc.GetHeight() / mipScale));
             hizDescs[i].SetRandomWrite(true);
-            cmd.AllocateAttachment(hizIds[i], hizDescs[i]);
+            if (maxDepth)
+            {
+                auto& image = persistentMips[i];
+                if (image == nullptr || image->GetDescription().width != hizDescs[i].GetWidth() ||
+                    image->GetDescription().height != hizDescs[i].GetHeight())
+                {
+                    Gfx::ImageDescription desc(
+                        hizDescs[i].GetWidth(),
+                        hizDescs[i].GetHeight(),
+                        Gfx::ImageFormat::R32_SFloat
+                    );
+                    image = GetGfxDriver()->CreateImage(desc, Gfx::ImageUsage::Texture | Gfx::ImageUsage::Storage);
+                    hizIds[i] = *image;
+                }
+            }
+            else
+                cmd.AllocateAttachment(hizIds[i], hizDescs[i]);
             if (i == 6)
             {
                 cmd.SetTexture(srcMidMipBinding, hizIds[i]);
@@ -80,13 +107,17 @@ public:
                 cmd.SetTexture(srcMipBinding, i, hizIds[i]);
             }
         }
-        cmd.BindShaderProgram(hiZSetupCompute->GetDefaultShaderProgram(), hiZSetupCompute->GetDefaultShaderConfig());
+        auto program = maxDepth ? hiZSetupCompute->GetShaderProgram({"_MaxDepth"})
+                                : hiZSetupCompute->GetDefaultShaderProgram();
+        cmd.BindShaderProgram(program, hiZSetupCompute->GetDefaultShaderConfig());
         cmd.Dispatch(dispatchThreadGroupCountXY.x, dispatchThreadGroupCountXY.y, 1);
 
-        cmd.SetTexture(hizBuffers, 0, srcDepth.id);
+        auto& outputBinding = maxDepth ? hizMaxBuffers : hizBuffers;
+        // the depth attachment doesn't outlive the frame, culling never reads mip 0 of the max pyramid
+        cmd.SetTexture(outputBinding, 0, maxDepth && mipCount > 1 ? hizIds[1] : srcDepth.id);
         for (int i = 1; i < mipCount; ++i)
         {
-            cmd.SetTexture(hizBuffers, i, hizIds[i]);
+            cmd.SetTexture(outputBinding, i, hizIds[i]);
         }
     }
 
@@ -112,11 +143,15 @@ private:
 
     std::vector<Gfx::RG::ImageDescription> hizDescs;
     std::vector<Gfx::RG::ImageIdentifier> hizIds;
+    // the max depth pyramid is read by the next frame's culling, transient attachments aren't preserved across frames
+    std::vector<std::unique_ptr<Gfx::Image>> persistentMips;
     std::unique_ptr<Gfx::Buffer> spdAtomicCounter;
     std::unique_ptr<Gfx::Buffer> spdUbo;
     ComputeShader* hiZSetupCompute;
+    bool maxDepth = false;
 
     Gfx::ShaderBindingHandle hizBuffers = Gfx::ShaderBindingHandle("hiZBuffers");
+    Gfx::ShaderBindingHandle hizMaxBuffers = Gfx::ShaderBindingHandle("hiZMaxBuffers");
     Gfx::ShaderBindingHandle srcMipBinding = Gfx::ShaderBindingHandle("rw_input_downsample_src_mips");
     Gfx::ShaderBindingHandle srcMidMipBinding = Gfx::ShaderBindingHandle("rw_input_downsample_src_mid_mip");
     Gfx::ShaderBindingHandle inputSrcBinding = Gfx::ShaderBindingHandle("r_input_downsample_src");
@@ -3,6 +3,7 @@
 #include "Core/Component/MeshRenderer.hpp"
 #include "Core/GameObject.hpp"
 #include "Core/Scene/Scene.hpp"
+#include "GfxDriver/GfxDriver.hpp"
 #include "GfxDriver/GfxEnums.hpp"
 #include <glm/glm.hpp>
 #include <glm/gtx/norm.hpp>
@@ -37,6 +38,9 @@ public:
 
         drawList->Add(scene->GetRenderingScene().GetMeshRenderers());
         drawList->Sort(renderingData.mainCamera->GetGameObject()->GetPosition());
+        drawList->Batch();
+        UploadInstanceTransforms(*renderingData.cmd);
+        RequestTextureMips(renderingData);
 
         output.drawList->SetValue(drawList.get());
     }
@@ -49,6 +53,46 @@ public:
 private:
     std::unique_ptr<DrawList> drawList;
     DrawList* append;
+    std::unique_ptr<Gfx::Buffer> instanceTransformBuffer;
+
+    // every batched pass of the frame reads its transforms from this buffer, see Common/Instancing.glsl
+    void UploadInstanceTransforms(Gfx::CommandBuffer& cmd)
+    {
+        auto& transforms = drawList->instanceTransforms;
+        if (transforms.empty())
+            return;
+
+        size_t size = transforms.size() * sizeof(glm::mat4);
+        if (instanceTransformBuffer == nullptr || instanceTransformBuffer->GetSize() < size)
+        {
+            // grow with some headroom so that spawning a few objects doesn't recreate the buffer every frame
+            instanceTransformBuffer = GetGfxDriver()->CreateBuffer(
+                {.usages = Gfx::BufferUsage::Transfer_Dst | Gfx::BufferUsage::Storage,
+                 .size = size * 3 / 2,
+                 .visibleInCPU = false,
+                 .debugName = "Instance Transform Buffer",
+                 .gpuWrite = true}
+            );
+        }
+
+        GetGfxDriver()->UploadBuffer(*instanceTransformBuffer, (uint8_t*)transforms.data(), size);
+        cmd.SetBuffer("InstanceTransforms", *instanceTransformBuffer);
+    }
+
+    // streamed textures load the mips that match how large their objects appear on screen
+    void RequestTextureMips(RenderingData& renderingData)
+    {
+        Camera* camera = renderingData.mainCamera;
+        glm::vec3 cameraPos = camera->GetGameObject()->GetPosition();
+        float pixelsPerUnit = camera->GetProjectionMatrix()[1][1] * renderingData.screenSize.y * 0.5f;
+        for (auto& draw : *drawList)
+        {
+            float size = glm::length(draw.aabb.max - draw.aabb.min);
+            glm::vec3 center = (draw.aabb.max + draw.aabb.min) * 0.5f;
+            float distance = glm::max(glm::distance(cameraPos, center) - size * 0.5f, 0.01f);
+            draw.material->RequestTextureMips(size / distance * pixelsPerUnit);
+        }
+    }
 
     struct
     {
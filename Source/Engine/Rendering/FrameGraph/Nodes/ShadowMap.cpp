@@ -61,13 +61,26 @@ public:
             cmd.BeginRenderPass(shadowPass, shadowMapClears);
             auto program = shadowmapShader->GetShaderProgram(0);
 
-            for (auto& draw : *drawList)
+            cmd.BindShaderProgram(program, program->GetDefaultShaderConfig());
+            for (size_t i = 0; i < drawList->geometryBatches.size(); ++i)
             {
-                cmd.BindShaderProgram(program, program->GetDefaultShaderConfig());
+                auto& batch = drawList->geometryBatches[i];
+                auto& draw = drawList->at(batch.drawIndex);
                 cmd.BindVertexBuffer(draw.vertexBufferBinding, 0);
                 cmd.BindIndexBuffer(draw.indexBuffer, 0, draw.indexBufferType);
-                cmd.SetPushConstant(program, (void*)&draw.pushConstant);
-                cmd.DrawIndexed(draw.indexCount, 1, 0, 0, 0);
+                if (drawList->indirectCommands)
+                {
+                    // geometry batch commands follow the material batch ones
+                    size_t command = drawList->materialBatches.size() + i;
+                    cmd.DrawIndexedIndirect(
+                        drawList->indirectCommands,
+                        command * DrawList::indirectCommandStride,
+                        1,
+                        DrawList::indirectCommandStride
+                    );
+                }
+                else
+                    cmd.DrawIndexed(draw.indexCount, batch.instanceCount, 0, 0, batch.firstInstance);
             }
 
             cmd.EndRenderPass();
@@ -1,4 +1,5 @@
 #include "Material.hpp"
+#include "Core/TextureStreaming.hpp"
 #include "GfxDriver/GfxDriver.hpp"
 #include "GfxDriver/ShaderProgram.hpp"
 #include "GfxDriver/ShaderResource.hpp"
@@ -44,6 +45,7 @@ Material::~Material() {};
 void Material::SetTexture(const std::string& param, std::nullptr_t)
 {
     textureValues.erase(param);
+    boundTextures.erase(param);
     if (shaderResource != nullptr)
         shaderResource->Remove(param);
     SetDirty();
@@ -63,6 +65,7 @@ void Material::SetTexture(
 )
 {
     textureValues[param] = texture;
+    boundTextures[param] = {texture, texture->GetImageVersion(), imageViewOption};
     if (shaderResource != nullptr)
     {
         if (imageViewOption.has_value())
@@ -81,6 +84,7 @@ void Material::SetTexture(
     const std::string& param, Gfx::Image* image, std::optional<Gfx::ImageViewOption> imageViewOption
 )
 {
+    boundTextures.erase(param);
     if (shaderResource != nullptr)
     {
         if (imageViewOption.has_value())
@@ -214,8 +218,47 @@ std::unique_ptr<Asset> Material::Clone()
     // return std::unique_ptr<Material>(new Material(*this));
 }
 
+void Material::RequestTextureMips(float screenPixels)
+{
+    auto& streaming = TextureStreaming::GetSingleton();
+    for (auto& kv : textureValues)
+    {
+        if (kv.second != nullptr && (kv.second->IsStreamed() || kv.second->IsTranscoding()))
+            streaming.RequestScreenSize(*kv.second, screenPixels);
+    }
+}
+
+void Material::PrewarmPipelines()
+{
+    if (shader == nullptr)
+        return;
+
+    // the config the draw list binds, the driver compiles it for the passes each program is drawn in
+    const Gfx::ShaderConfig& config = GetShaderConfig();
+    for (int pass = 0; pass < shader->GetPassCount(); ++pass)
+    {
+        Gfx::ShaderProgram* program = GetShaderProgram(pass);
+        if (program != nullptr && !program->IsCompute())
+            GetGfxDriver()->PrewarmShaderProgram(*program, config);
+    }
+}
+
 Gfx::ShaderResource* Material::ValidateGetShaderResource()
 {
+    for (auto& kv : boundTextures)
+    {
+        BoundTexture& bound = kv.second;
+        if (shaderResource != nullptr && bound.imageVersion != bound.texture->GetImageVersion())
+        {
+            Gfx::Image* image = bound.texture->GetGfxImage();
+            if (bound.imageViewOption.has_value())
+                shaderResource->SetImage(kv.first, &image->GetImageView(*bound.imageViewOption));
+            else
+                shaderResource->SetImage(kv.first, image);
+            bound.imageVersion = bound.texture->GetImageVersion();
+        }
+    }
+
     return shaderResource.get();
 }
 
@@ -352,7 +395,8 @@ void Material::UploadDataToGPU(Gfx::ShaderProgram* shaderProgram)
                         .usages = Gfx::BufferUsage::Transfer_Dst | Gfx::BufferUsage::Uniform,
                         .size = size,
                         .visibleInCPU = false,
-                        .debugName = "Material Uniform Buffer",
+                        // named after the material so gpu memory dumps attribute it to the asset
+                        .debugName = GetName().empty() ? "Material Uniform Buffer" : GetName().c_str(),
                     });
 
                     shaderResource->SetBuffer(u.first, buffer.get());
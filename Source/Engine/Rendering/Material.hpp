@@ -62,6 +62,11 @@ public:
     );
     void SetBuffer(const std::string& param, Gfx::Buffer* buffer);
     void SetTexture(const std::string& param, std::nullptr_t);
+    // asks TextureStreaming for the mips of the streamed textures that match an object covering screenPixels
+    void RequestTextureMips(float screenPixels);
+    // queues the pipelines of every shader pass for background compilation, so the first frames that draw the
+    // material don't skip it
+    void PrewarmPipelines();
     void EnableFeature(const std::string& name);
     void DisableFeature(const std::string& name);
 
@@ -133,6 +138,14 @@ private:
         std::vector<ScheduledUpdate> updates;
     };
 
+    // the image version a texture had when it was bound, textures can swap their image (reload, streaming)
+    struct BoundTexture
+    {
+        Texture* texture;
+        uint64_t imageVersion;
+        std::optional<Gfx::ImageViewOption> imageViewOption;
+    };
+
     ShaderBase* shader = nullptr;
     uint32_t shaderContentHash = -1;
     std::unique_ptr<Gfx::ShaderResource> shaderResource = nullptr;
@@ -145,6 +158,7 @@ private:
 
     std::unordered_map<std::string, UBO> ubos;
     std::unordered_map<std::string, Texture*> textureValues;
+    std::unordered_map<std::string, BoundTexture> boundTextures;
     std::unordered_map<std::string, Gfx::Buffer*> bufferValues;
     std::unordered_set<std::string> enabledFeatures;
     std::unique_ptr<Gfx::Buffer> buffer;
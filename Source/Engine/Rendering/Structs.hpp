@@ -55,8 +55,9 @@ struct AABB
         for (int i = 0; i < 3; ++i)
             for (int j = 0; j < 3; ++j)
             {
-                float a = rs[i][j] * min[j];
-                float b = rs[i][j] * max[j];
+                // glm is column major, rs[j][i] is row i column j
+                float a = rs[j][i] * min[j];
+                float b = rs[j][i] * max[j];
                 nmin[i] += a < b ? a : b;
                 nmax[i] += a < b ? b : a;
             }
@@ -50,7 +50,7 @@ void GenerateBRDFResponseTexture(const char* path)
     uint8_t* output = new uint8_t[imgDesc.GetByteSize()];
     memcpy(output, readbackBuf->GetCPUVisibleAddress(), imgDesc.GetByteSize());
     Exporters::KtxExporter::
-        Export(path, output, imgDesc.width, imgDesc.height, 1, 2, 1, 1, false, false, imgDesc.format, false);
+        Export(path, output, imgDesc.width, imgDesc.height, 1, 2, 1, 1, false, false, imgDesc.format);
     delete[] output;
 }
 } // namespace Rendering
@@ -1,5 +1,6 @@
 #include "WeilanEngine.hpp"
 #include "Core/GameLoop.hpp"
+#include "Core/TextureStreaming.hpp"
 #include "Profiler/Profiler.hpp"
 #if ENGINE_EDITOR
 #include "ThirdParty/imgui/ImGuizmo.h"
@@ -51,6 +52,7 @@ void WeilanEngine::Init(const CreateInfo& createInfo)
     }
 
     Gfx::GfxDriver::CreateInfo gfxCreateInfo{mainWindow.handle};
+    gfxCreateInfo.pipelineCachePath = projectPath / "PipelineCache.bin";
     gfxDriver = Gfx::GfxDriver::CreateGfxDriver(Gfx::Backend::Vulkan, gfxCreateInfo);
     InitJoltPhysics();
     assetDatabase = std::make_unique<AssetDatabase>();
@@ -79,6 +81,15 @@ bool WeilanEngine::BeginFrame()
     if (!gfxDriver->BeginFrame())
         return false;
 
+    TextureStreaming::GetSingleton().Update();
+
+    auto memoryStats = gfxDriver->GetGPUMemoryStats();
+    for (size_t c = 0; c < (size_t)Gfx::GPUMemoryCategory::Count; ++c)
+    {
+        auto name = fmt::format("GPU {} (MB)", Gfx::GPUMemoryCategoryToString((Gfx::GPUMemoryCategory)c));
+        ENGINE_PROFILE_COUNTER(name, memoryStats.bytes[c] / (1024.0f * 1024.0f));
+    }
+
 #if ENGINE_EDITOR
     ImGui_ImplSDL2_NewFrame();
     ImGui::NewFrame();
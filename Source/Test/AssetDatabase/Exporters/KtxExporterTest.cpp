@@ -0,0 +1,166 @@
+#include "AssetDatabase/Exporters/KtxExporter.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <gtest/gtest.h>
+#include <ktx.h>
+#include <string>
+#include <vector>
+
+namespace
+{
+// a BC4 block is two endpoints and a 3 bit palette index for each of its 4x4 texels
+void DecodeBC4(const uint8_t* block, uint8_t* texels)
+{
+    int palette[8] = {block[0], block[1]};
+    if (block[0] > block[1])
+    {
+        for (int i = 1; i < 7; ++i)
+            palette[i + 1] = ((7 - i) * block[0] + i * block[1]) / 7;
+    }
+    else
+    {
+        for (int i = 1; i < 5; ++i)
+            palette[i + 1] = ((5 - i) * block[0] + i * block[1]) / 5;
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+
+    uint64_t indices = 0;
+    for (int i = 0; i < 6; ++i)
+        indices |= uint64_t(block[2 + i]) << (8 * i);
+    for (int t = 0; t < 16; ++t)
+        texels[t] = palette[(indices >> (3 * t)) & 7];
+}
+
+// unit normals of a bumpy surface packed to 0-255 like an authored normal map, z (and alpha) only with 4 channels
+std::vector<uint8_t> BumpyNormalMap(uint32_t size, uint32_t channels)
+{
+    std::vector<uint8_t> texels(size * size * channels);
+    for (uint32_t y = 0; y < size; ++y)
+    {
+        for (uint32_t x = 0; x < size; ++x)
+        {
+            float nx = 0.5f * std::sin(x * 6.2831853f / size);
+            float ny = 0.5f * std::cos(y * 6.2831853f / size);
+            float nz = std::sqrt(1 - nx * nx - ny * ny);
+            float packed[4] = {nx * 0.5f + 0.5f, ny * 0.5f + 0.5f, nz * 0.5f + 0.5f, 1};
+            for (uint32_t c = 0; c < channels; ++c)
+                texels[(y * size + x) * channels + c] = std::lround(packed[c] * 255);
+        }
+    }
+    return texels;
+}
+
+struct XYError
+{
+    double mean = 0;
+    int max = 0;
+};
+
+// transcodes the exported file to BC5 the way Texture does for normal maps and compares the decoded xy with the source
+XYError TranscodedXYError(const std::string& path, const std::vector<uint8_t>& src, uint32_t size, uint32_t channels)
+{
+    ktxTexture2* texture;
+    EXPECT_EQ(
+        ktxTexture2_CreateFromNamedFile(path.c_str(), KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT, &texture),
+        KTX_SUCCESS
+    );
+
+    char* normalMap = nullptr;
+    unsigned int normalMapLen = 0;
+    EXPECT_EQ(
+        ktxHashList_FindValue(
+            &texture->kvDataHead,
+            Exporters::KtxExporter::normalMapKey,
+            &normalMapLen,
+            (void**)&normalMap
+        ),
+        KTX_SUCCESS
+    );
+    EXPECT_TRUE(ktxTexture2_NeedsTranscoding(texture));
+    EXPECT_EQ(ktxTexture2_TranscodeBasis(texture, KTX_TTF_BC5_RG, 0), KTX_SUCCESS);
+
+    ktx_size_t offset = 0;
+    ktxTexture_GetImageOffset(ktxTexture(texture), 0, 0, 0, &offset);
+    const uint8_t* blocks = ktxTexture_GetData(ktxTexture(texture)) + offset;
+
+    XYError error;
+    uint32_t blocksPerRow = size / 4;
+    for (uint32_t b = 0; b < blocksPerRow * blocksPerRow; ++b)
+    {
+        // a BC5 block is a BC4 block for x followed by one for y
+        uint8_t decoded[2][16];
+        DecodeBC4(blocks + b * 16, decoded[0]);
+        DecodeBC4(blocks + b * 16 + 8, decoded[1]);
+        for (int t = 0; t < 16; ++t)
+        {
+            uint32_t x = (b % blocksPerRow) * 4 + t % 4;
+            uint32_t y = (b / blocksPerRow) * 4 + t / 4;
+            for (int c = 0; c < 2; ++c)
+            {
+                int diff = std::abs(int(decoded[c][t]) - src[(y * size + x) * channels + c]);
+                error.mean += diff;
+                error.max = std::max(error.max, diff);
+            }
+        }
+    }
+    error.mean /= size * size * 2;
+
+    ktxTexture_Destroy(ktxTexture(texture));
+    return error;
+}
+} // namespace
+
+// x has to end up in rgb and y in alpha, the two channels the BC5 transcoder reads. A normal map encoded with the
+// default swizzle came back with y = 1 everywhere
+TEST(KtxExporter, NormalMapRoundTripsXYThroughBC5)
+{
+    const uint32_t size = 64;
+    struct Case
+    {
+        Exporters::KtxCompression::Mode mode;
+        uint32_t channels;
+        Gfx::ImageFormat format;
+        double maxMeanError;
+        const char* name;
+    } cases[] = {
+        {Exporters::KtxCompression::Mode::UASTC, 4, Gfx::ImageFormat::R8G8B8A8_UNorm, 3, "normal_uastc_rgba"},
+        {Exporters::KtxCompression::Mode::UASTC, 2, Gfx::ImageFormat::R8G8_UNorm, 3, "normal_uastc_rg"},
+        {Exporters::KtxCompression::Mode::ETC1S, 4, Gfx::ImageFormat::R8G8B8A8_UNorm, 8, "normal_etc1s_rgba"},
+    };
+
+    for (const Case& c : cases)
+    {
+        SCOPED_TRACE(c.name);
+        std::vector<uint8_t> src = BumpyNormalMap(size, c.channels);
+        std::string path = std::string(TEMP_FILE_DIR) + "/" + c.name + ".ktx2";
+
+        Exporters::KtxCompression compression;
+        compression.mode = c.mode;
+        compression.normalMap = true;
+        Exporters::KtxExportReport report;
+        ASSERT_TRUE(Exporters::KtxExporter::Export(
+            path.c_str(),
+            src.data(),
+            size,
+            size,
+            1,
+            2,
+            1,
+            1,
+            false,
+            false,
+            c.format,
+            compression,
+            &report
+        ));
+        // block compressed, not only Zstd
+        EXPECT_LT(report.fileByteSize, report.uncompressedByteSize);
+        EXPECT_GT(report.psnr, 30);
+
+        XYError error = TranscodedXYError(path, src, size, c.channels);
+        EXPECT_LT(error.mean, c.maxMeanError);
+        EXPECT_LT(error.max, 64);
+    }
+}
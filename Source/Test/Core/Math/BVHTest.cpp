@@ -0,0 +1,196 @@
+#include "Core/Math/BVH.hpp"
+#include <algorithm>
+#include <chrono>
+#include <gtest/gtest.h>
+#include <limits>
+#include <random>
+#include <vector>
+
+namespace
+{
+// every triangle tested with the same two sided Moller-Trumbore as the BVH's leaves
+bool BruteForceIntersect(
+    std::span<const glm::vec3> vertices, glm::vec3 origin, glm::vec3 dir, float& distance, uint32_t& triangle
+)
+{
+    bool hit = false;
+    distance = std::numeric_limits<float>::max();
+    for (uint32_t i = 0; i < vertices.size() / 3; ++i)
+    {
+        glm::vec3 v0 = vertices[i * 3];
+        glm::vec3 e1 = vertices[i * 3 + 1] - v0;
+        glm::vec3 e2 = vertices[i * 3 + 2] - v0;
+        glm::vec3 p = glm::cross(dir, e2);
+        float det = glm::dot(e1, p);
+        if (glm::abs(det) <= 1e-30f)
+            continue;
+
+        float invDet = 1.0f / det;
+        glm::vec3 s = origin - v0;
+        float u = glm::dot(s, p) * invDet;
+        glm::vec3 q = glm::cross(s, e1);
+        float v = glm::dot(dir, q) * invDet;
+        float t = glm::dot(e2, q) * invDet;
+        if (u >= 0 && v >= 0 && u + v <= 1 && t > 0 && t < distance)
+        {
+            distance = t;
+            triangle = i;
+            hit = true;
+        }
+    }
+    return hit;
+}
+
+// small triangles scattered through a 20m cube
+std::vector<glm::vec3> RandomTriangles(size_t count, std::mt19937& random)
+{
+    std::uniform_real_distribution<float> center(-10, 10);
+    std::uniform_real_distribution<float> offset(-0.5f, 0.5f);
+    std::vector<glm::vec3> vertices;
+    vertices.reserve(count * 3);
+    for (size_t i = 0; i < count; ++i)
+    {
+        glm::vec3 c(center(random), center(random), center(random));
+        for (int v = 0; v < 3; ++v)
+            vertices.push_back(c + glm::vec3(offset(random), offset(random), offset(random)));
+    }
+    return vertices;
+}
+
+struct Ray
+{
+    glm::vec3 origin;
+    glm::vec3 dir;
+};
+
+// rays from outside the cube towards random points in it, every seventh one is axis parallel
+std::vector<Ray> RandomRays(size_t count, std::mt19937& random)
+{
+    std::uniform_real_distribution<float> point(-10, 10);
+    std::vector<Ray> rays(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        rays[i].origin = glm::vec3(point(random), point(random), point(random)) * 2.0f;
+        rays[i].dir = glm::vec3(point(random), point(random), point(random)) - rays[i].origin;
+        if (i % 7 == 0)
+            rays[i].dir = glm::vec3(0, 0, rays[i].origin.z < 0 ? 1 : -1);
+    }
+    return rays;
+}
+
+double ElapsedMs(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+} // namespace
+
+TEST(TriangleBVH, AgreesWithBruteForce)
+{
+    std::mt19937 random(1);
+    std::vector<glm::vec3> vertices = RandomTriangles(20000, random);
+    // triangles with the same centroid can't be split
+    for (int i = 0; i < 40; ++i)
+        vertices.insert(vertices.end(), {glm::vec3(0, 0, 0), glm::vec3(1, 0, 0), glm::vec3(0, 1, 0)});
+    TriangleBVH bvh(vertices);
+    ASSERT_EQ(bvh.GetTriangleCount(), vertices.size() / 3);
+
+    int hits = 0;
+    for (const Ray& ray : RandomRays(2000, random))
+    {
+        float expectedDistance, distance = 0;
+        uint32_t expectedTriangle, triangle = 0;
+        bool expected = BruteForceIntersect(vertices, ray.origin, ray.dir, expectedDistance, expectedTriangle);
+        ASSERT_EQ(bvh.Intersect(ray.origin, ray.dir, distance, triangle), expected);
+        if (expected)
+        {
+            // triangles at the same distance may be reported in a different order
+            ASSERT_NEAR(distance, expectedDistance, 1e-5f * std::max(1.0f, expectedDistance));
+            hits += 1;
+        }
+    }
+    // the rays aren't all missing
+    EXPECT_GT(hits, 100);
+}
+
+// an axis parallel ray that starts on a plane of a node's box makes the slab test compute 0 * inf
+TEST(TriangleBVH, AxisParallelRayOnBoxPlane)
+{
+    // a unit quad at z = 0 and a wall at x = 1
+    std::vector<glm::vec3> vertices = {
+        {0, 0, 0},
+        {1, 0, 0},
+        {0, 1, 0},
+        {1, 0, 0},
+        {1, 1, 0},
+        {0, 1, 0},
+        {1, 0, -1},
+        {1, 1, -1},
+        {1, 0, 1},
+    };
+    TriangleBVH bvh(vertices);
+
+    Ray rays[] = {
+        {{0, 0.5f, 1}, {0, 0, -1}},
+        {{0.5f, 0, 1}, {0, 0, -1}},
+        {{0, 0, 1}, {-0.0f, -0.0f, -1}},
+        {{1, 0.5f, -1}, {-0.0f, -0.0f, 1}},
+        {{0, 0.25f, 0.25f}, {1, 0, 0}},
+    };
+    for (const Ray& ray : rays)
+    {
+        float expectedDistance, distance = 0;
+        uint32_t expectedTriangle, triangle = 0;
+        ASSERT_TRUE(BruteForceIntersect(vertices, ray.origin, ray.dir, expectedDistance, expectedTriangle));
+        ASSERT_TRUE(bvh.Intersect(ray.origin, ray.dir, distance, triangle));
+        EXPECT_FLOAT_EQ(distance, expectedDistance);
+    }
+}
+
+TEST(TriangleBVH, DISABLED_MillionTriangleBenchmark)
+{
+    std::mt19937 random(2);
+    std::vector<glm::vec3> vertices = RandomTriangles(1000000, random);
+
+    auto start = std::chrono::steady_clock::now();
+    TriangleBVH bvh(vertices);
+    double buildMs = ElapsedMs(start);
+
+    std::vector<Ray> rays = RandomRays(100000, random);
+    int hits = 0;
+    start = std::chrono::steady_clock::now();
+    for (const Ray& ray : rays)
+    {
+        float distance;
+        uint32_t triangle;
+        hits += bvh.Intersect(ray.origin, ray.dir, distance, triangle);
+    }
+    double bvhMs = ElapsedMs(start) / rays.size();
+
+    // a brute force ray tests every triangle, a few are enough to time it and check the BVH against
+    const size_t bruteForceRays = 20;
+    double bruteForceMs = 0;
+    for (size_t i = 0; i < bruteForceRays; ++i)
+    {
+        float expectedDistance, distance = 0;
+        uint32_t expectedTriangle, triangle = 0;
+        start = std::chrono::steady_clock::now();
+        bool expected = BruteForceIntersect(vertices, rays[i].origin, rays[i].dir, expectedDistance, expectedTriangle);
+        bruteForceMs += ElapsedMs(start);
+        ASSERT_EQ(bvh.Intersect(rays[i].origin, rays[i].dir, distance, triangle), expected);
+        if (expected)
+            ASSERT_NEAR(distance, expectedDistance, 1e-5f * std::max(1.0f, expectedDistance));
+    }
+    bruteForceMs /= bruteForceRays;
+
+    printf(
+        "1M triangles: build %.1f ms, %.4f ms per ray (%d of %zu hit), brute force %.2f ms per ray\n",
+        buildMs,
+        bvhMs,
+        hits,
+        rays.size(),
+        bruteForceMs
+    );
+    RecordProperty("buildMs", std::to_string(buildMs));
+    RecordProperty("bvhRayMs", std::to_string(bvhMs));
+    RecordProperty("bruteForceRayMs", std::to_string(bruteForceMs));
+}
@@ -0,0 +1,380 @@
+#include "Core/Component/PhysicsBody.hpp"
+#include "Core/Scene/Scene.hpp"
+#include "Libs/JobSystem.hpp"
+#include "SceneTest.hpp"
+#include <algorithm>
+#include <chrono>
+
+namespace
+{
+class PhysicsSceneTest : public SceneTest
+{};
+
+double ElapsedMs(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// one fixed step per frame, the way GameLoop drives the physics scene
+void StepFrame(PhysicsScene& physics)
+{
+    physics.Tick(physics.DeltaTime);
+    physics.StartSimulation();
+    physics.WaitForSimulation();
+}
+
+PhysicsBody* AddBall(Scene& scene, glm::vec3 position)
+{
+    GameObject* go = scene.CreateGameObject();
+    go->SetPosition(position);
+    go->SetScale(glm::vec3(0.5f));
+    auto body = go->AddComponent<PhysicsBody>();
+    body->SetShape(PhysicsBodyShapes::Sphere);
+    body->SetMotionType(JPH::EMotionType::Dynamic);
+    body->SetLayer(PhysicsLayer::Moving);
+    body->SetGravityFactor(1.0f);
+    // bodies are created static and asleep, a velocity wakes them up
+    body->SetLinearVelocity(glm::vec3(0, -0.1f, 0));
+    return body;
+}
+
+// a static box, the game object's scale is its half extent
+PhysicsBody* AddBox(Scene& scene, glm::vec3 position, glm::vec3 halfExtent, PhysicsLayer layer = PhysicsLayer::Scene)
+{
+    GameObject* go = scene.CreateGameObject();
+    go->SetPosition(position);
+    go->SetScale(halfExtent);
+    auto body = go->AddComponent<PhysicsBody>();
+    body->SetShape(PhysicsBodyShapes::Box);
+    body->SetLayer(layer);
+    return body;
+}
+
+uint32_t LayerBit(PhysicsLayer layer)
+{
+    return 1u << static_cast<uint32_t>(layer);
+}
+
+bool Contains(const std::vector<PhysicsBody*>& bodies, PhysicsBody* body)
+{
+    return std::find(bodies.begin(), bodies.end(), body) != bodies.end();
+}
+} // namespace
+
+TEST_F(PhysicsSceneTest, RaycastHitsTheClosestBody)
+{
+    Scene scene;
+    PhysicsScene& physics = scene.GetPhysicsScene();
+    PhysicsBody* near = AddBox(scene, glm::vec3(0, 0, 5), glm::vec3(1));
+    PhysicsBody* far = AddBox(scene, glm::vec3(0, 0, 10), glm::vec3(1));
+
+    RaycastQuery query;
+    query.direction = glm::vec3(0, 0, 1);
+    RaycastHit hit = physics.Raycast(query);
+    ASSERT_EQ(hit.body, near);
+    EXPECT_NEAR(hit.distance, 4.0f, 1e-3f);
+    EXPECT_NEAR(glm::distance(hit.point, glm::vec3(0, 0, 4)), 0.0f, 1e-3f);
+    EXPECT_NEAR(glm::distance(hit.normal, glm::vec3(0, 0, -1)), 0.0f, 1e-3f);
+
+    // from between the boxes
+    query.origin = glm::vec3(0, 0, 7.5f);
+    hit = physics.Raycast(query);
+    ASSERT_EQ(hit.body, far);
+    EXPECT_NEAR(hit.distance, 1.5f, 1e-3f);
+}
+
+TEST_F(PhysicsSceneTest, RaycastMisses)
+{
+    Scene scene;
+    PhysicsScene& physics = scene.GetPhysicsScene();
+    AddBox(scene, glm::vec3(0, 0, 5), glm::vec3(1));
+
+    RaycastQuery away;
+    away.direction = glm::vec3(0, 0, -1);
+    RaycastQuery beside;
+    beside.origin = glm::vec3(3, 0, 0);
+    RaycastQuery tooShort;
+    tooShort.maxDistance = 3.0f;
+    RaycastQuery hitting;
+
+    RaycastQuery queries[] = {away, beside, tooShort, hitting};
+    std::vector<RaycastHit> hits;
+    physics.Raycast(queries, hits);
+    ASSERT_EQ(hits.size(), 4);
+    EXPECT_EQ(hits[0].body, nullptr);
+    EXPECT_EQ(hits[1].body, nullptr);
+    EXPECT_EQ(hits[2].body, nullptr);
+    EXPECT_NE(hits[3].body, nullptr);
+}
+
+TEST_F(PhysicsSceneTest, RaycastLayerMask)
+{
+    Scene scene;
+    PhysicsScene& physics = scene.GetPhysicsScene();
+    PhysicsBody* moving = AddBox(scene, glm::vec3(0, 0, 5), glm::vec3(1), PhysicsLayer::Moving);
+    PhysicsBody* still = AddBox(scene, glm::vec3(0, 0, 10), glm::vec3(1), PhysicsLayer::Scene);
+
+    RaycastQuery query;
+    EXPECT_EQ(physics.Raycast(query).body, moving);
+
+    query.layerMask = LayerBit(PhysicsLayer::Scene);
+    RaycastHit hit = physics.Raycast(query);
+    EXPECT_EQ(hit.body, still);
+    EXPECT_NEAR(hit.distance, 9.0f, 1e-3f);
+
+    query.layerMask = LayerBit(PhysicsLayer::Moving);
+    EXPECT_EQ(physics.Raycast(query).body, moving);
+
+    query.layerMask = 0;
+    EXPECT_EQ(physics.Raycast(query).body, nullptr);
+}
+
+TEST_F(PhysicsSceneTest, QueriesSkipDisabledBodies)
+{
+    Scene scene;
+    PhysicsScene& physics = scene.GetPhysicsScene();
+    PhysicsBody* near = AddBox(scene, glm::vec3(0, 0, 5), glm::vec3(1));
+    PhysicsBody* far = AddBox(scene, glm::vec3(0, 0, 10), glm::vec3(1));
+
+    RaycastQuery ray;
+    OverlapQuery overlap;
+    overlap.center = glm::vec3(0, 0, 5);
+    std::vector<std::vector<PhysicsBody*>> overlaps;
+
+    near->Disable();
+    EXPECT_EQ(physics.Raycast(ray).body, far);
+    physics.Overlap(std::span(&overlap, 1), overlaps);
+    ASSERT_EQ(overlaps.size(), 1);
+    EXPECT_TRUE(overlaps[0].empty());
+
+    near->Enable();
+    EXPECT_EQ(physics.Raycast(ray).body, near);
+    physics.Overlap(std::span(&overlap, 1), overlaps);
+    ASSERT_EQ(overlaps.size(), 1);
+    ASSERT_EQ(overlaps[0].size(), 1);
+    EXPECT_EQ(overlaps[0][0], near);
+}
+
+TEST_F(PhysicsSceneTest, SphereAndBoxOverlaps)
+{
+    Scene scene;
+    PhysicsScene& physics = scene.GetPhysicsScene();
+    // the boxes span x in [-0.5, 0.5] and [2.5, 3.5], the gap between them is empty
+    PhysicsBody* left = AddBox(scene, glm::vec3(0, 0, 0), glm::vec3(0.5f));
+    PhysicsBody* right = AddBox(scene, glm::vec3(3, 0, 0), glm::vec3(0.5f), PhysicsLayer::Moving);
+
+    OverlapQuery insideLeft;
+    insideLeft.size = glm::vec3(0.1f);
+    OverlapQuery inGap;
+    inGap.center = glm::vec3(1.5f, 0, 0);
+    OverlapQuery acrossGap;
+    acrossGap.center = glm::vec3(1.5f, 0, 0);
+    acrossGap.size = glm::vec3(1.2f);
+    OverlapQuery acrossGapMasked = acrossGap;
+    acrossGapMasked.layerMask = LayerBit(PhysicsLayer::Moving);
+
+    // a thin box along x reaches both boxes, turned to lie along z it reaches neither
+    OverlapQuery rod;
+    rod.shape = OverlapQuery::Shape::Box;
+    rod.center = glm::vec3(1.5f, 0, 0);
+    rod.size = glm::vec3(1.2f, 0.1f, 0.1f);
+    OverlapQuery turnedRod = rod;
+    turnedRod.rotation = glm::angleAxis(glm::radians(90.0f), glm::vec3(0, 1, 0));
+
+    // half extents below the default convex radius
+    OverlapQuery tinyBoxInsideRight;
+    tinyBoxInsideRight.shape = OverlapQuery::Shape::Box;
+    tinyBoxInsideRight.center = glm::vec3(3, 0.2f, 0);
+    tinyBoxInsideRight.size = glm::vec3(0.01f);
+    OverlapQuery tinyBoxInGap = tinyBoxInsideRight;
+    tinyBoxInGap.center = glm::vec3(1.5f, 0, 0);
+
+    OverlapQuery queries[] = {
+        insideLeft,
+        inGap,
+        acrossGap,
+        acrossGapMasked,
+        rod,
+        turnedRod,
+        tinyBoxInsideRight,
+        tinyBoxInGap,
+    };
+    std::vector<std::vector<PhysicsBody*>> results;
+    physics.Overlap(queries, results);
+    ASSERT_EQ(results.size(), std::size(queries));
+
+    ASSERT_EQ(results[0].size(), 1);
+    EXPECT_EQ(results[0][0], left);
+    EXPECT_TRUE(results[1].empty());
+    ASSERT_EQ(results[2].size(), 2);
+    EXPECT_TRUE(Contains(results[2], left));
+    EXPECT_TRUE(Contains(results[2], right));
+    ASSERT_EQ(results[3].size(), 1);
+    EXPECT_EQ(results[3][0], right);
+    ASSERT_EQ(results[4].size(), 2);
+    EXPECT_TRUE(Contains(results[4], left));
+    EXPECT_TRUE(Contains(results[4], right));
+    EXPECT_TRUE(results[5].empty());
+    ASSERT_EQ(results[6].size(), 1);
+    EXPECT_EQ(results[6][0], right);
+    EXPECT_TRUE(results[7].empty());
+}
+
+// 100k rays cast as one batch against a grid of boxes, against casting them one at a time
+TEST_F(PhysicsSceneTest, DISABLED_HundredThousandRaycastBenchmark)
+{
+    const int columns = 100;
+    const int rows = 100;
+    const int rayCount = 100000;
+
+    PhysicsSceneSettings settings;
+    settings.maxBodies = 65536;
+    settings.maxBodyPairs = 65536;
+    settings.maxContactConstraints = 65536;
+    settings.tempAllocatorSize = 64 * 1024 * 1024;
+    Scene scene(settings);
+    PhysicsScene& physics = scene.GetPhysicsScene();
+
+    // boxes of different heights on a 2m grid, the rays come down from above
+    for (int z = 0; z < rows; ++z)
+    {
+        for (int x = 0; x < columns; ++x)
+        {
+            float height = 0.5f + (x * 7 + z * 13) % 10 * 0.1f;
+            AddBox(scene, glm::vec3(x * 2.0f, height, z * 2.0f), glm::vec3(0.5f, height, 0.5f));
+        }
+    }
+    ASSERT_EQ(physics.GetBodyCount(), columns * rows);
+
+    std::vector<RaycastQuery> queries(rayCount);
+    for (int i = 0; i < rayCount; ++i)
+    {
+        float x = (i % 1000) * columns * 2.0f / 1000.0f;
+        float z = (i / 1000) * rows * 2.0f / (rayCount / 1000);
+        queries[i].origin = glm::vec3(x, 10.0f, z);
+        queries[i].direction = glm::normalize(glm::vec3(0.1f, -1.0f, 0.05f));
+    }
+
+    std::vector<RaycastHit> hits;
+    auto start = std::chrono::steady_clock::now();
+    physics.Raycast(queries, hits);
+    double batchedMs = ElapsedMs(start);
+    ASSERT_EQ(hits.size(), queries.size());
+
+    std::vector<RaycastHit> singleHits(queries.size());
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < queries.size(); ++i)
+        singleHits[i] = physics.Raycast(queries[i]);
+    double singleMs = ElapsedMs(start);
+
+    int hitCount = 0;
+    for (size_t i = 0; i < queries.size(); ++i)
+    {
+        ASSERT_EQ(hits[i].body, singleHits[i].body);
+        if (hits[i].body)
+        {
+            ASSERT_NEAR(hits[i].distance, singleHits[i].distance, 1e-4f);
+            hitCount += 1;
+        }
+    }
+
+    printf(
+        "%d rays against %d bodies, %u job system threads: batched %.2f ms, one at a time %.2f ms, %d hit\n",
+        rayCount,
+        columns * rows,
+        JobSystem::GetSingleton().GetThreadCount() + 1,
+        batchedMs,
+        singleMs,
+        hitCount
+    );
+    RecordProperty("batchedMs", std::to_string(batchedMs));
+    RecordProperty("singleMs", std::to_string(singleMs));
+}
+
+// 50k balls dropped on a floor: the frames while they fall and the frames after they went to sleep, against writing
+// every body back to its game object the way the physics scene did before it only synced active bodies
+TEST_F(PhysicsSceneTest, DISABLED_FiftyThousandBodiesBenchmark)
+{
+    const int columns = 250;
+    const int rows = 200;
+    const int bodyCount = columns * rows;
+
+    PhysicsSceneSettings settings;
+    settings.maxBodies = 65536;
+    settings.maxBodyPairs = 65536;
+    settings.maxContactConstraints = 65536;
+    settings.tempAllocatorSize = 64 * 1024 * 1024;
+    Scene scene(settings);
+    PhysicsScene& physics = scene.GetPhysicsScene();
+
+    // the floor's top is at y = 0, its scale is the box's half extent
+    GameObject* floor = scene.CreateGameObject();
+    floor->SetPosition(glm::vec3(columns, -0.5f, rows));
+    floor->SetScale(glm::vec3(columns + 10, 0.5f, rows + 10));
+    floor->AddComponent<PhysicsBody>();
+
+    std::vector<PhysicsBody*> balls;
+    balls.reserve(bodyCount);
+    auto start = std::chrono::steady_clock::now();
+    for (int z = 0; z < rows; ++z)
+    {
+        for (int x = 0; x < columns; ++x)
+            balls.push_back(AddBall(scene, glm::vec3(x * 2.0f, 1.0f, z * 2.0f)));
+    }
+    double createMs = ElapsedMs(start);
+    ASSERT_EQ(physics.GetBodyCount(), bodyCount + 1);
+
+    const int frames = 10;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < frames; ++i)
+        StepFrame(physics);
+    double awakeMs = ElapsedMs(start) / frames;
+
+    // jolt puts a body to sleep after it rested for half a second
+    JPH::BodyIDVector active;
+    int settleFrames = frames;
+    for (; settleFrames < 1000; ++settleFrames)
+    {
+        StepFrame(physics);
+        physics.GetPhysicsSystem().GetActiveBodies(active);
+        if (active.empty())
+            break;
+    }
+    ASSERT_TRUE(active.empty());
+    // applies the last job, the bodies that fell asleep in it get their final pose
+    StepFrame(physics);
+
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < frames; ++i)
+        StepFrame(physics);
+    double sleepingMs = ElapsedMs(start) / frames;
+
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < frames; ++i)
+    {
+        for (PhysicsBody* ball : balls)
+            ball->UpdateGameObject();
+    }
+    double syncAllMs = ElapsedMs(start) / frames;
+
+    printf(
+        "%d bodies, %u job system threads: create %.1f ms, awake frame %.2f ms, sleeping frame %.2f ms, "
+        "syncing every body %.2f ms, settled after %d frames\n",
+        bodyCount,
+        JobSystem::GetSingleton().GetThreadCount() + 1,
+        createMs,
+        awakeMs,
+        sleepingMs,
+        syncAllMs,
+        settleFrames
+    );
+    RecordProperty("awakeMs", std::to_string(awakeMs));
+    RecordProperty("sleepingMs", std::to_string(sleepingMs));
+    RecordProperty("syncAllMs", std::to_string(syncAllMs));
+
+    for (PhysicsBody* ball : balls)
+    {
+        glm::vec3 position = ball->GetGameObject()->GetPosition();
+        ASSERT_NEAR(position.y, 0.5f, 0.05f);
+    }
+}
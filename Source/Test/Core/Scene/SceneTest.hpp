@@ -0,0 +1,25 @@
+#pragma once
+#include <Jolt/Jolt.h>
+
+#include <Jolt/Core/Factory.h>
+#include <Jolt/RegisterTypes.h>
+#include <gtest/gtest.h>
+
+// every Scene owns a PhysicsScene, Jolt is set up the way WeilanEngine::InitJoltPhysics does before one is created
+class SceneTest : public ::testing::Test
+{
+protected:
+    static void SetUpTestSuite()
+    {
+        JPH::RegisterDefaultAllocator();
+        JPH::Factory::sInstance = new JPH::Factory();
+        JPH::RegisterTypes();
+    }
+
+    static void TearDownTestSuite()
+    {
+        JPH::UnregisterTypes();
+        delete JPH::Factory::sInstance;
+        JPH::Factory::sInstance = nullptr;
+    }
+};
@@ -0,0 +1,187 @@
+#include "Core/Scene/Scene.hpp"
+#include "Libs/JobSystem.hpp"
+#include "SceneTest.hpp"
+#include <chrono>
+
+namespace
+{
+class SceneTickTest : public SceneTest
+{};
+
+// a few hundred flops on its own state and a read of its transform, what a typical gameplay tick costs
+class Oscillator : public Component
+{
+    DECLARE_OBJECT();
+
+public:
+    Oscillator() : Component(nullptr) {}
+    Oscillator(GameObject* gameObject) : Component(gameObject) {}
+
+    UpdatePhaseFlags GetUpdatePhases() override
+    {
+        return UpdatePhase::Update;
+    }
+
+    bool IsTickThreadSafe() override
+    {
+        return true;
+    }
+
+    void Tick() override
+    {
+        glm::vec3 position = GetGameObject()->GetPosition();
+        for (int i = 0; i < 32; ++i)
+        {
+            phase += 0.01f;
+            value = value * 0.9f + glm::sin(phase + position.x) * 0.1f;
+        }
+        ticks += 1;
+    }
+
+    const std::string& GetName() override
+    {
+        static std::string name = "Oscillator";
+        return name;
+    }
+
+    std::unique_ptr<Component> Clone(GameObject& owner) override
+    {
+        return std::make_unique<Oscillator>(&owner);
+    }
+
+    float phase = 0;
+    float value = 0;
+    int ticks = 0;
+};
+DEFINE_OBJECT(Oscillator, "3C4E6F1A-8B2D-4E59-9A7C-0D1F2B3C4D5E");
+
+// records the order it is ticked in, not thread safe
+class TickRecorder : public Component
+{
+    DECLARE_OBJECT();
+
+public:
+    TickRecorder() : Component(nullptr) {}
+    TickRecorder(GameObject* gameObject, int id, std::vector<int>* order)
+        : Component(gameObject), id(id), order(order)
+    {}
+
+    UpdatePhaseFlags GetUpdatePhases() override
+    {
+        return UpdatePhase::Update | UpdatePhase::LateUpdate;
+    }
+
+    void Tick() override
+    {
+        order->push_back(id);
+    }
+
+    void LateTick() override
+    {
+        order->push_back(-id - 1);
+    }
+
+    const std::string& GetName() override
+    {
+        static std::string name = "TickRecorder";
+        return name;
+    }
+
+    std::unique_ptr<Component> Clone(GameObject& owner) override
+    {
+        return std::make_unique<TickRecorder>(&owner, id, order);
+    }
+
+    int id = 0;
+    std::vector<int>* order = nullptr;
+};
+DEFINE_OBJECT(TickRecorder, "7A1B2C3D-4E5F-4A6B-8C7D-9E0F1A2B3C4D");
+
+// how Scene::Tick ticked before components were batched: depth first through the hierarchy on one thread
+void TickDepthFirst(GameObject* go)
+{
+    go->Tick();
+    for (GameObject* child : go->GetChildren())
+        TickDepthFirst(child);
+}
+
+double ElapsedMs(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+} // namespace
+
+TEST_F(SceneTickTest, SerialTypesTickInHierarchyOrder)
+{
+    Scene scene;
+    std::vector<int> order;
+    std::vector<GameObject*> objects;
+    for (int i = 0; i < 6; ++i)
+    {
+        GameObject* go = scene.CreateGameObject();
+        if (i % 2 == 1)
+            go->SetParent(objects[i - 1]);
+        go->AddComponent<TickRecorder>(i, &order);
+        go->AddComponent<Oscillator>();
+        objects.push_back(go);
+    }
+
+    scene.Tick();
+    scene.LateTick();
+    EXPECT_EQ(order, std::vector<int>({0, 1, 2, 3, 4, 5, -1, -2, -3, -4, -5, -6}));
+
+    order.clear();
+    scene.Tick();
+    EXPECT_EQ(order, std::vector<int>({0, 1, 2, 3, 4, 5}));
+    for (GameObject* go : objects)
+        EXPECT_EQ(go->GetComponent<Oscillator>()->ticks, 2);
+}
+
+// 50k thread safe components on 5k objects in trees of 10
+TEST_F(SceneTickTest, DISABLED_TickBenchmark)
+{
+    Scene scene;
+    std::vector<GameObject*> objects;
+    for (int i = 0; i < 5000; ++i)
+    {
+        GameObject* go = scene.CreateGameObject();
+        if (i % 10 != 0)
+            go->SetParent(objects[i - 1]);
+        go->SetLocalPosition(glm::vec3(i % 10, 0, 0));
+        for (int c = 0; c < 10; ++c)
+            go->AddComponent<Oscillator>();
+        objects.push_back(go);
+    }
+    scene.UpdateTransforms();
+
+    const int frames = 20;
+    // the first tick builds the update batches
+    scene.Tick();
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < frames; ++i)
+        scene.Tick();
+    double batchedMs = ElapsedMs(start) / frames;
+
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < frames; ++i)
+    {
+        for (GameObject* root : scene.GetRootObjects())
+            TickDepthFirst(root);
+    }
+    double depthFirstMs = ElapsedMs(start) / frames;
+
+    printf(
+        "50000 components, %u job system threads: batched %.2f ms, depth first %.2f ms\n",
+        JobSystem::GetSingleton().GetThreadCount() + 1,
+        batchedMs,
+        depthFirstMs
+    );
+    RecordProperty("batchedMs", std::to_string(batchedMs));
+    RecordProperty("depthFirstMs", std::to_string(depthFirstMs));
+
+    for (GameObject* go : objects)
+    {
+        for (auto& c : go->GetComponents())
+            ASSERT_EQ(static_cast<Oscillator*>(c.get())->ticks, 2 * frames + 1);
+    }
+}
@@ -0,0 +1,231 @@
+#include "Core/Scene/Scene.hpp"
+#include "SceneTest.hpp"
+#include <chrono>
+
+namespace
+{
+class TransformSystemTest : public SceneTest
+{};
+
+// binary trees of depth 10, 1023 objects per root
+struct TestHierarchy
+{
+    static constexpr int depth = 10;
+    std::vector<GameObject*> objects;
+    std::vector<LocalTransform> locals;
+    std::vector<int> parents;
+
+    TestHierarchy(Scene& scene, int roots)
+    {
+        for (int i = 0; i < roots; ++i)
+            Add(scene, -1, 0);
+    }
+
+    void Add(Scene& scene, int parent, int level)
+    {
+        int index = objects.size();
+        LocalTransform local;
+        local.position = glm::vec3(index % 7, level, index % 5) * 0.1f;
+        local.rotation = glm::angleAxis(0.01f * (index % 13), glm::normalize(glm::vec3(1, 2, 3)));
+        local.scale = glm::vec3(1.01f);
+
+        GameObject* go = scene.CreateGameObject();
+        if (parent >= 0)
+            go->SetParent(objects[parent]);
+        go->SetLocalPosition(local.position);
+        go->SetLocalRotation(local.rotation);
+        go->SetLocalScale(local.scale);
+        objects.push_back(go);
+        locals.push_back(local);
+        parents.push_back(parent);
+
+        if (level + 1 < depth)
+        {
+            Add(scene, index, level + 1);
+            Add(scene, index, level + 1);
+        }
+    }
+
+    void SetLocalPosition(int index, glm::vec3 position)
+    {
+        locals[index].position = position;
+        objects[index]->SetLocalPosition(position);
+    }
+
+    // what GetWorldMatrix did before world transforms were cached: multiply up through every parent
+    glm::mat4 WalkWorldMatrix(int index) const
+    {
+        glm::mat4 matrix = locals[index].ToMatrix();
+        for (int parent = parents[index]; parent >= 0; parent = parents[parent])
+            matrix = locals[parent].ToMatrix() * matrix;
+        return matrix;
+    }
+
+    float MaxError()
+    {
+        float maxError = 0;
+        for (size_t i = 0; i < objects.size(); ++i)
+        {
+            glm::mat4 diff = objects[i]->GetWorldMatrix() - WalkWorldMatrix(i);
+            for (int c = 0; c < 4; ++c)
+            {
+                for (int r = 0; r < 4; ++r)
+                    maxError = glm::max(maxError, glm::abs(diff[c][r]));
+            }
+        }
+        return maxError;
+    }
+};
+
+// how world matrices were computed before they were stored in flat arrays: depth first through the GameObjects
+void TraverseWorldMatrices(GameObject* go, const glm::mat4& parentWorld, std::vector<glm::mat4>& worldMatrices)
+{
+    glm::mat4 local = glm::translate(glm::mat4(1), go->GetLocalPosition()) * glm::mat4_cast(go->GetLocalRotation()) *
+                      glm::scale(glm::mat4(1), go->GetScale());
+    glm::mat4 world = parentWorld * local;
+    worldMatrices.push_back(world);
+    for (GameObject* child : go->GetChildren())
+        TraverseWorldMatrices(child, world, worldMatrices);
+}
+
+double ElapsedMs(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+} // namespace
+
+TEST_F(TransformSystemTest, WorldMatricesFollowParents)
+{
+    Scene scene;
+    TestHierarchy hierarchy(scene, 2);
+    scene.UpdateTransforms();
+    EXPECT_LT(hierarchy.MaxError(), 1e-4f);
+
+    // a node in the middle of a tree, its subtree is marked dirty and resolved by the next query
+    hierarchy.SetLocalPosition(3, glm::vec3(1, 2, 3));
+    EXPECT_LT(hierarchy.MaxError(), 1e-4f);
+
+    hierarchy.SetLocalPosition(1, glm::vec3(-1, 0, 4));
+    scene.UpdateTransforms();
+    EXPECT_LT(hierarchy.MaxError(), 1e-4f);
+}
+
+// a change while transforms are read from several threads is logged and applied after the read only phase
+TEST_F(TransformSystemTest, ChangesWhileReadOnlyAreDeferred)
+{
+    Scene scene;
+    GameObject* parent = scene.CreateGameObject();
+    GameObject* child = scene.CreateGameObject();
+    child->SetParent(parent);
+    child->SetLocalPosition(glm::vec3(1, 0, 0));
+
+    TransformSystem& transforms = scene.GetTransformSystem();
+    transforms.SetReadOnly(true);
+    EXPECT_EQ(child->GetPosition(), glm::vec3(1, 0, 0));
+    parent->SetLocalPosition(glm::vec3(0, 2, 0));
+    EXPECT_EQ(child->GetPosition(), glm::vec3(1, 0, 0));
+    transforms.SetReadOnly(false);
+
+    EXPECT_EQ(child->GetPosition(), glm::vec3(1, 2, 0));
+    scene.UpdateTransforms();
+    EXPECT_EQ(child->GetPosition(), glm::vec3(1, 2, 0));
+}
+
+// 98 trees, about 100k objects
+TEST_F(TransformSystemTest, DISABLED_HierarchyUpdateBenchmark)
+{
+    Scene scene;
+    TestHierarchy hierarchy(scene, 98);
+    const int count = hierarchy.objects.size();
+
+    auto start = std::chrono::steady_clock::now();
+    scene.UpdateTransforms();
+    double rebuildMs = ElapsedMs(start);
+
+    // moving every root dirties the whole scene
+    for (int i = 0; i < count; ++i)
+    {
+        if (hierarchy.parents[i] < 0)
+            hierarchy.SetLocalPosition(i, hierarchy.locals[i].position + glm::vec3(1, 0, 0));
+    }
+    start = std::chrono::steady_clock::now();
+    scene.UpdateTransforms();
+    double fullUpdateMs = ElapsedMs(start);
+
+    for (int i = 0; i < count; i += 100)
+        hierarchy.SetLocalPosition(i, hierarchy.locals[i].position + glm::vec3(0, 1, 0));
+    start = std::chrono::steady_clock::now();
+    scene.UpdateTransforms();
+    double partialUpdateMs = ElapsedMs(start);
+
+    glm::vec3 sum(0);
+    start = std::chrono::steady_clock::now();
+    for (GameObject* go : hierarchy.objects)
+        sum += go->GetPosition();
+    double cachedQueryMs = ElapsedMs(start);
+
+    glm::vec3 walkedSum(0);
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < count; ++i)
+        walkedSum += glm::vec3(hierarchy.WalkWorldMatrix(i)[3]);
+    double walkedQueryMs = ElapsedMs(start);
+
+    printf("%d objects, depth %d\n", count, TestHierarchy::depth);
+    printf("rebuild: %.2f ms, all dirty: %.2f ms, 1%% dirty: %.2f ms\n", rebuildMs, fullUpdateMs, partialUpdateMs);
+    printf("position of every object: cached %.2f ms, walking the parents %.2f ms\n", cachedQueryMs, walkedQueryMs);
+    RecordProperty("fullUpdateMs", std::to_string(fullUpdateMs));
+    RecordProperty("partialUpdateMs", std::to_string(partialUpdateMs));
+    RecordProperty("cachedQueryMs", std::to_string(cachedQueryMs));
+    RecordProperty("walkedQueryMs", std::to_string(walkedQueryMs));
+
+    EXPECT_LT(glm::length(sum - walkedSum), 1e-2f * count);
+}
+
+// the same world matrices computed by the TransformSystem sweep and by walking the GameObjects. Only times are
+// measured, cache misses need a profiler
+TEST_F(TransformSystemTest, DISABLED_FlatSweepBenchmark)
+{
+    Scene scene;
+    TestHierarchy hierarchy(scene, 98);
+    scene.UpdateTransforms();
+
+    const int iterations = 10;
+    double sweepMs = 0;
+    for (int i = 0; i < iterations; ++i)
+    {
+        for (GameObject* root : scene.GetRootObjects())
+            root->SetLocalPosition(root->GetLocalPosition() + glm::vec3(0, 0, 1));
+        auto start = std::chrono::steady_clock::now();
+        scene.UpdateTransforms();
+        sweepMs += ElapsedMs(start);
+    }
+
+    std::vector<glm::mat4> traversed;
+    traversed.reserve(hierarchy.objects.size());
+    double traverseMs = 0;
+    for (int i = 0; i < iterations; ++i)
+    {
+        traversed.clear();
+        auto start = std::chrono::steady_clock::now();
+        for (GameObject* root : scene.GetRootObjects())
+            TraverseWorldMatrices(root, glm::mat4(1), traversed);
+        traverseMs += ElapsedMs(start);
+    }
+
+    printf(
+        "%zu objects: flat sweep %.2f ms, GameObject traversal %.2f ms\n",
+        hierarchy.objects.size(),
+        sweepMs / iterations,
+        traverseMs / iterations
+    );
+    RecordProperty("sweepMs", std::to_string(sweepMs / iterations));
+    RecordProperty("traverseMs", std::to_string(traverseMs / iterations));
+
+    // the sweep stores depth first too, both visit the same objects in the same order
+    auto worldMatrices = scene.GetTransformSystem().GetWorldMatrices();
+    ASSERT_EQ(worldMatrices.size(), traversed.size());
+    float maxError = 0;
+    for (size_t i = 0; i < traversed.size(); ++i)
+        maxError = glm::max(maxError, glm::length(glm::vec3(worldMatrices[i][3] - traversed[i][3])));
+    EXPECT_LT(maxError, 1e-3f);
+}
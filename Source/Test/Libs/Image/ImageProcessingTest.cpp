@@ -0,0 +1,764 @@
+#include "Libs/Image/ImageProcessing.hpp"
+#include "Libs/JobSystem.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <glm/gtc/packing.hpp>
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace Libs::Image;
+
+namespace
+{
+// 512x256 HDR sky: a vertical gradient with a sun patch brighter than the 20.0 the gpu bake clamps to
+struct TestSky
+{
+    static constexpr int width = 512;
+    static constexpr int height = 256;
+    std::vector<float> texels;
+
+    TestSky() : texels(width * height * 4)
+    {
+        for (int y = 0; y < height; ++y)
+        {
+            for (int x = 0; x < width; ++x)
+            {
+                float* t = &texels[(y * width + x) * 4];
+                float v = 1 - (y + 0.5f) / height;
+                t[0] = 0.2f + v;
+                t[1] = 0.3f + 0.5f * v;
+                t[2] = 0.1f + 0.8f * v;
+                t[3] = 1;
+                if (std::abs(x - 100) < 10 && std::abs(y - 60) < 10)
+                    t[0] = t[1] = t[2] = 50;
+            }
+        }
+    }
+
+    // point sampled like textureLod on mip 0 with nearest filtering
+    glm::vec3 Fetch(glm::vec2 uv) const
+    {
+        int x = std::min(int(uv.x * width), width - 1);
+        int y = std::min(int(uv.y * height), height - 1);
+        const float* t = &texels[(y * width + x) * 4];
+        return {t[0], t[1], t[2]};
+    }
+};
+
+// the loops of IrradianceMapGeneration.comp
+glm::vec3 GPUIrradiance(const TestSky& sky, glm::vec3 normal)
+{
+    glm::vec3 up = normal != glm::vec3(0, 1, 0) ? glm::vec3(0, 1, 0) : glm::vec3(0, 0, 1);
+    glm::vec3 tangent = glm::normalize(glm::cross(up, normal));
+    glm::vec3 binormal = glm::cross(tangent, normal);
+    glm::vec3 radiance(0);
+    int sampleCount = 0;
+    for (float p = 0; p < 1; p += 1 / 256.0f)
+    {
+        for (float t = 0; t < 1; t += 1 / 128.0f)
+        {
+            float phi = p * glm::two_pi<float>();
+            float theta = t * 0.5f * glm::pi<float>();
+            glm::vec3 tangentSample = {
+                glm::sin(theta) * glm::cos(phi),
+                glm::sin(theta) * glm::sin(phi),
+                glm::cos(theta)
+            };
+            glm::vec3 dir =
+                glm::normalize(tangentSample.x * tangent + tangentSample.y * binormal + tangentSample.z * normal);
+            radiance += glm::min(sky.Fetch(DirToEquirectangularUV(dir)), glm::vec3(20)) * glm::cos(theta) *
+                        glm::sin(theta);
+            sampleCount += 1;
+        }
+    }
+    return radiance * glm::pi<float>() / float(sampleCount);
+}
+
+float RadicalInverse(uint32_t bits)
+{
+    bits = (bits << 16u) | (bits >> 16u);
+    bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+    bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+    bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+    bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+    return float(bits) * 2.3283064365386963e-10f;
+}
+
+// PrefilterEnvMap of IBLBRDF.comp with N = V = R, point sampled without the filtered importance sampling
+glm::vec3 GPUPrefilter(const TestSky& sky, float roughness, glm::vec3 n)
+{
+    const uint32_t sampleCount = 8192;
+    float a = roughness * roughness;
+    glm::vec3 up = std::abs(n.z) < 0.999f ? glm::vec3(0, 0, 1) : glm::vec3(1, 0, 0);
+    glm::vec3 tangentX = glm::normalize(glm::cross(up, n));
+    glm::vec3 tangentY = glm::cross(n, tangentX);
+    glm::vec3 color(0);
+    float weight = 0;
+    for (uint32_t i = 0; i < sampleCount; ++i)
+    {
+        float phi = glm::two_pi<float>() * i / sampleCount;
+        float xi = RadicalInverse(i);
+        float cosTheta = glm::sqrt((1 - xi) / (1 + (a * a - 1) * xi));
+        float sinTheta = glm::sqrt(1 - cosTheta * cosTheta);
+        glm::vec3 h = glm::normalize(
+            tangentX * (sinTheta * glm::cos(phi)) + tangentY * (sinTheta * glm::sin(phi)) + n * cosTheta
+        );
+        glm::vec3 l = h * (2 * glm::dot(n, h)) - n;
+        float nol = glm::dot(n, l);
+        if (nol > 0)
+        {
+            color += sky.Fetch(DirToEquirectangularUV(glm::normalize(l))) * nol;
+            weight += nol;
+        }
+    }
+    return color / weight;
+}
+
+float MaxRelativeError(glm::vec3 expected, glm::vec3 actual)
+{
+    glm::vec3 rel = glm::abs(actual - expected) / expected;
+    return glm::max(rel.x, glm::max(rel.y, rel.z));
+}
+// the single threaded nearest lookup ConverToCubemap replaced, kept as the benchmark baseline
+void NearestConvertToCubemap(const float* source, int width, int height, int outputSize, int channels, uint8_t*& output)
+{
+    output = new uint8_t[size_t(outputSize) * outputSize * 6 * channels * sizeof(float)];
+    float* texels = (float*)output;
+    for (int face = 0; face < 6; ++face)
+    {
+        for (int y = 0; y < outputSize; ++y)
+        {
+            for (int x = 0; x < outputSize; ++x)
+            {
+                glm::vec3 dir =
+                    glm::normalize(GetDirFromCubeUV({(x + 0.5f) / outputSize, (y + 0.5f) / outputSize}, face));
+                glm::vec2 uv = DirToEquirectangularUV(dir);
+                int px = std::min(int(uv.x * width), width - 1);
+                int py = std::min(int(uv.y * height), height - 1);
+                for (int c = 0; c < channels; ++c)
+                {
+                    texels[((size_t(face) * outputSize + y) * outputSize + x) * channels + c] =
+                        source[(size_t(py) * width + px) * channels + c];
+                }
+            }
+        }
+    }
+}
+
+double ElapsedMs(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// the 2x2 box reduction written out per texel in double precision: texels past the right and bottom edge repeat the
+// last column and row, sRGB color channels are averaged in linear space and alpha (the last channel of gray + alpha and
+// rgba images) stays linear
+double DecodeTexel(const uint8_t* data, size_t i, ChannelType type, bool srgbColor)
+{
+    switch (type)
+    {
+        case ChannelType::UInt8:
+            {
+                double c = data[i] / 255.0;
+                if (!srgbColor)
+                    return c;
+                return c <= 0.04045 ? c / 12.92 : std::pow((c + 0.055) / 1.055, 2.4);
+            }
+        case ChannelType::UInt16: return ((const uint16_t*)data)[i] / 65535.0;
+        case ChannelType::Half: return glm::unpackHalf1x16(((const uint16_t*)data)[i]);
+        case ChannelType::Float: return ((const float*)data)[i];
+    }
+    return 0;
+}
+
+void EncodeTexel(uint8_t* data, size_t i, double v, ChannelType type, bool srgbColor)
+{
+    switch (type)
+    {
+        case ChannelType::UInt8:
+            if (srgbColor)
+                v = v <= 0.0031308 ? v * 12.92 : 1.055 * std::pow(v, 1 / 2.4) - 0.055;
+            data[i] = uint8_t(std::lround(v * 255));
+            break;
+        case ChannelType::UInt16: ((uint16_t*)data)[i] = uint16_t(std::lround(v * 65535)); break;
+        case ChannelType::Half: ((uint16_t*)data)[i] = glm::packHalf1x16(float(v)); break;
+        case ChannelType::Float: ((float*)data)[i] = float(v); break;
+    }
+}
+
+void ReferenceBoxReduce(const uint8_t* src, int pw, int ph, int channels, ChannelType type, bool srgb, uint8_t* dst)
+{
+    const int lw = std::max(pw >> 1, 1);
+    const int lh = std::max(ph >> 1, 1);
+    const int alpha = channels == 2 || channels == 4 ? channels - 1 : -1;
+    for (int y = 0; y < lh; ++y)
+    {
+        for (int x = 0; x < lw; ++x)
+        {
+            for (int c = 0; c < channels; ++c)
+            {
+                bool srgbColor = srgb && type == ChannelType::UInt8 && c != alpha;
+                double sum = 0;
+                for (int dy = 0; dy < 2; ++dy)
+                {
+                    for (int dx = 0; dx < 2; ++dx)
+                    {
+                        int sx = std::min(2 * x + dx, pw - 1);
+                        int sy = std::min(2 * y + dy, ph - 1);
+                        sum += DecodeTexel(src, (size_t(sy) * pw + sx) * channels + c, type, srgbColor);
+                    }
+                }
+                EncodeTexel(dst, (size_t(y) * lw + x) * channels + c, sum / 4, type, srgbColor);
+            }
+        }
+    }
+}
+
+// what a texel may differ by after rounding: one code for integer formats, the precision of the stored float
+double Tolerance(ChannelType type, double expected)
+{
+    switch (type)
+    {
+        case ChannelType::UInt8: return 1.0 / 255 + 1e-9;
+        case ChannelType::UInt16: return 1.0 / 65535 + 1e-12;
+        case ChannelType::Half: return std::max(std::abs(expected), 1e-4) * 1e-3;
+        case ChannelType::Float: return std::max(std::abs(expected), 1.0) * 1e-6;
+    }
+    return 0;
+}
+
+std::vector<uint8_t> RandomTexels(size_t count, ChannelType type, std::mt19937& random)
+{
+    std::vector<uint8_t> data(count * GetChannelTypeByteSize(type));
+    std::uniform_real_distribution<float> value(0, 4);
+    for (size_t i = 0; i < count; ++i)
+    {
+        switch (type)
+        {
+            case ChannelType::UInt8: data[i] = random() & 0xFF; break;
+            case ChannelType::UInt16: ((uint16_t*)data.data())[i] = random() & 0xFFFF; break;
+            case ChannelType::Half: ((uint16_t*)data.data())[i] = glm::packHalf1x16(value(random)); break;
+            case ChannelType::Float: ((float*)data.data())[i] = value(random); break;
+        }
+    }
+    return data;
+}
+
+int MipLevelCount(int width, int height)
+{
+    return int(std::floor(std::log2(std::max(width, height)))) + 1;
+}
+
+struct MipFormat
+{
+    ChannelType type;
+    bool srgb;
+    const char* name;
+};
+
+const MipFormat mipFormats[] = {
+    {ChannelType::UInt8, false, "8 bit"},
+    {ChannelType::UInt8, true, "8 bit sRGB"},
+    {ChannelType::UInt16, false, "16 bit"},
+    {ChannelType::Half, false, "half"},
+    {ChannelType::Float, false, "float"},
+};
+} // namespace
+
+// the cpu bakes replace the compute shaders when there is no GfxDriver, they have to agree within a few percent
+TEST(ImageProcessing, IrradianceSHMatchesGPUBake)
+{
+    TestSky sky;
+    IrradianceSH sh = ComputeIrradianceSH(sky.texels.data(), sky.width, sky.height);
+
+    float maxError = 0;
+    float errorSum = 0;
+    int count = 0;
+    for (int face = 0; face < 6; ++face)
+    {
+        for (int i = 0; i < 4; ++i)
+        {
+            for (int j = 0; j < 4; ++j)
+            {
+                glm::vec3 dir = glm::normalize(GetDirFromCubeUV({(i + 0.5f) / 4, (j + 0.5f) / 4}, face));
+                float error = MaxRelativeError(GPUIrradiance(sky, dir), EvaluateIrradianceSH(sh, dir));
+                maxError = glm::max(maxError, error);
+                errorSum += error;
+                count += 1;
+            }
+        }
+    }
+
+    EXPECT_LT(maxError, 0.06f);
+    EXPECT_LT(errorSum / count, 0.02f);
+}
+
+TEST(ImageProcessing, ReflectanceMatchesGPUBake)
+{
+    TestSky sky;
+    const int size = 256;
+    uint8_t* output;
+    int mipLevels;
+    GenerateReflectanceCubemapCPU(sky.texels.data(), sky.width, sky.height, size, output, mipLevels);
+    ASSERT_GE(mipLevels, 3);
+
+    // mip 2 is roughness 0.5, layout is [mip [face]] in RGBA32F
+    size_t offset = 0;
+    for (int mip = 0; mip < 2; ++mip)
+        offset += size_t(size >> mip) * (size >> mip) * 6;
+    const glm::vec4* mip2 = (const glm::vec4*)output + offset;
+    const int mipSize = size >> 2;
+
+    float maxError = 0;
+    for (int face = 0; face < 6; ++face)
+    {
+        int x = mipSize / 3;
+        int y = mipSize / 2;
+        glm::vec3 n = glm::normalize(GetDirFromCubeUV({(x + 0.5f) / mipSize, (y + 0.5f) / mipSize}, face));
+        glm::vec3 baked = glm::vec3(mip2[(size_t(face) * mipSize + y) * mipSize + x]);
+        maxError = glm::max(maxError, MaxRelativeError(GPUPrefilter(sky, 0.5f, n), baked));
+    }
+    delete[] output;
+
+    EXPECT_LT(maxError, 0.07f);
+}
+
+// a 4k RGBA32F sky at the face sizes the importer uses. Only 256 and 512 are dense enough for the mip chain, the
+// larger faces sample the source directly
+TEST(ImageProcessing, DISABLED_ConvertToCubemapBenchmark)
+{
+    const int width = 4096;
+    const int height = 2048;
+    std::vector<float> source(size_t(width) * height * 4);
+    for (size_t i = 0; i < source.size(); ++i)
+        source[i] = (i % 7) * 0.1f;
+
+    printf("ConverToCubemap, %u job system threads\n", JobSystem::GetSingleton().GetThreadCount() + 1);
+    for (int size : {256, 512, 1024, 2048})
+    {
+        uint8_t* output;
+        auto start = std::chrono::steady_clock::now();
+        NearestConvertToCubemap(source.data(), width, height, size, 4, output);
+        double nearestMs = ElapsedMs(start);
+        delete[] output;
+
+        start = std::chrono::steady_clock::now();
+        ConverToCubemap((uint8_t*)source.data(), width, height, size, 4, ChannelType::Float, output);
+        double filteredMs = ElapsedMs(start);
+        delete[] output;
+
+        printf("%5d: nearest %8.1f ms, filtered %8.1f ms\n", size, nearestMs, filteredMs);
+        RecordProperty("nearestMs" + std::to_string(size), std::to_string(nearestMs));
+        RecordProperty("filteredMs" + std::to_string(size), std::to_string(filteredMs));
+    }
+}
+
+TEST(ImageProcessing, ConvertToCubemapKeepsConstantImage)
+{
+    std::vector<uint8_t> source(64 * 32 * 3, 77);
+    for (int size : {4, 16, 64})
+    {
+        uint8_t* output;
+        ConverToCubemap(source.data(), 64, 32, size, 3, ChannelType::UInt8, output);
+        int mismatches = 0;
+        for (int i = 0; i < size * size * 6 * 3; ++i)
+            mismatches += output[i] != 77;
+        delete[] output;
+        EXPECT_EQ(mismatches, 0) << "face size " << size;
+    }
+}
+
+// odd sizes leave a last row or column that is averaged with itself and 1 texel wide levels only shrink in one
+// direction. Each level is checked against the reference reduction of the level the kernels produced before it
+TEST(ImageProcessing, BoxMipmapMatchesScalarReference)
+{
+    std::mt19937 random(3);
+    const int sizes[][2] = {{7, 5}, {33, 17}, {1, 9}, {9, 1}, {64, 3}, {2, 2}};
+    const int layers = 2;
+    for (const MipFormat& format : mipFormats)
+    {
+        for (int channels = 1; channels <= 4; ++channels)
+        {
+            for (auto size : sizes)
+            {
+                const int width = size[0];
+                const int height = size[1];
+                SCOPED_TRACE(
+                    std::string(format.name) + ", " + std::to_string(channels) + " channels, " +
+                    std::to_string(width) + "x" + std::to_string(height)
+                );
+                const int levels = MipLevelCount(width, height);
+                const size_t texelSize = GetChannelTypeByteSize(format.type) * channels;
+                std::vector<uint8_t> source =
+                    RandomTexels(size_t(width) * height * layers * channels, format.type, random);
+
+                uint8_t* output;
+                size_t outputByteSize;
+                GenerateBoxFilteredMipmap(
+                    source.data(),
+                    width,
+                    height,
+                    layers,
+                    levels,
+                    channels,
+                    format.type,
+                    format.srgb,
+                    output,
+                    outputByteSize
+                );
+                ASSERT_EQ(memcmp(output, source.data(), source.size()), 0);
+
+                int mismatches = 0;
+                size_t previousOffset = 0;
+                size_t offset = source.size();
+                std::vector<uint8_t> expected;
+                for (int i = 1; i < levels; ++i)
+                {
+                    const int pw = std::max(width >> (i - 1), 1);
+                    const int ph = std::max(height >> (i - 1), 1);
+                    const int lw = std::max(width >> i, 1);
+                    const int lh = std::max(height >> i, 1);
+                    expected.resize(size_t(lw) * lh * texelSize);
+                    for (int layer = 0; layer < layers; ++layer)
+                    {
+                        const uint8_t* previous = output + previousOffset + layer * size_t(pw) * ph * texelSize;
+                        ReferenceBoxReduce(previous, pw, ph, channels, format.type, format.srgb, expected.data());
+                        const uint8_t* actual = output + offset + layer * expected.size();
+                        for (size_t t = 0; t < size_t(lw) * lh * channels; ++t)
+                        {
+                            double e = DecodeTexel(expected.data(), t, format.type, false);
+                            double a = DecodeTexel(actual, t, format.type, false);
+                            mismatches += std::abs(a - e) > Tolerance(format.type, e);
+                        }
+                    }
+                    previousOffset = offset;
+                    offset += expected.size() * layers;
+                }
+                delete[] output;
+
+                EXPECT_EQ(offset, outputByteSize);
+                EXPECT_EQ(mismatches, 0);
+            }
+        }
+    }
+}
+
+// the second channel of a gray + alpha image is alpha, it's averaged without the sRGB curve
+TEST(ImageProcessing, BoxMipmapKeepsGrayAlphaLinear)
+{
+    uint8_t source[] = {0, 0, 255, 255};
+    uint8_t* output;
+    size_t outputByteSize;
+    GenerateBoxFilteredMipmap(source, 2, 1, 1, 2, 2, ChannelType::UInt8, true, output, outputByteSize);
+    ASSERT_EQ(outputByteSize, 6);
+
+    // half of the light is 188 in sRGB, half coverage is 128
+    EXPECT_NEAR(output[4], 188, 1);
+    EXPECT_EQ(output[5], 128);
+    delete[] output;
+}
+
+// full mip chains of a 4096x4096 RGBA image in megapixels of the source per second, against the scalar reference
+TEST(ImageProcessing, DISABLED_BoxMipmapBenchmark)
+{
+    const int size = 4096;
+    const int levels = MipLevelCount(size, size);
+    const double megapixels = double(size) * size / 1e6;
+    std::mt19937 random(4);
+
+    printf("GenerateBoxFilteredMipmap, %u job system threads\n", JobSystem::GetSingleton().GetThreadCount() + 1);
+    for (const MipFormat& format : mipFormats)
+    {
+        const size_t texelSize = GetChannelTypeByteSize(format.type) * 4;
+        std::vector<uint8_t> source = RandomTexels(size_t(size) * size * 4, format.type, random);
+
+        uint8_t* output;
+        size_t outputByteSize;
+        auto start = std::chrono::steady_clock::now();
+        GenerateBoxFilteredMipmap(
+            source.data(),
+            size,
+            size,
+            1,
+            levels,
+            4,
+            format.type,
+            format.srgb,
+            output,
+            outputByteSize
+        );
+        double kernelMs = ElapsedMs(start);
+
+        std::vector<uint8_t> reference(outputByteSize);
+        memcpy(reference.data(), source.data(), source.size());
+        start = std::chrono::steady_clock::now();
+        size_t offset = 0;
+        for (int i = 1; i < levels; ++i)
+        {
+            int pw = std::max(size >> (i - 1), 1);
+            uint8_t* level = &reference[offset];
+            ReferenceBoxReduce(level, pw, pw, 4, format.type, format.srgb, level + size_t(pw) * pw * texelSize);
+            offset += size_t(pw) * pw * texelSize;
+        }
+        double referenceMs = ElapsedMs(start);
+        delete[] output;
+
+        double kernelMPixPerSecond = megapixels / kernelMs * 1000;
+        double referenceMPixPerSecond = megapixels / referenceMs * 1000;
+        printf(
+            "%12s: %8.1f MPix/s, scalar reference %8.1f MPix/s\n",
+            format.name,
+            kernelMPixPerSecond,
+            referenceMPixPerSecond
+        );
+        RecordProperty(std::string(format.name) + " MPix/s", std::to_string(kernelMPixPerSecond));
+        RecordProperty(std::string(format.name) + " reference MPix/s", std::to_string(referenceMPixPerSecond));
+    }
+}
+
+// the taps of a 2:1 reduction with three lobes: normalized, symmetric around the target texel and resolved at the edges
+TEST(ImageProcessing, SincFilterTables)
+{
+    const uint32_t sWidth = 16;
+    const uint32_t tWidth = 8;
+    for (FilterFn filterFn : {filterFn_Kaiser, filterFn_Lanczos})
+    {
+        for (EdgeMode edgeMode : {EdgeMode::Clamp, EdgeMode::Wrap})
+        {
+            FilterTable table = Processor::CreateFilterTable(sWidth, tWidth, filterFn, 3, edgeMode);
+            ASSERT_EQ(table.taps, 13);
+            ASSERT_EQ(table.indices.size(), tWidth * table.taps);
+            for (uint32_t ti = 0; ti < tWidth; ++ti)
+            {
+                const uint32_t* indices = &table.indices[ti * table.taps];
+                const float* weights = &table.weights[ti * table.taps];
+                float sum = 0;
+                for (uint32_t k = 0; k < table.taps; ++k)
+                {
+                    EXPECT_LT(indices[k], sWidth);
+                    sum += weights[k];
+                }
+                EXPECT_NEAR(sum, 1, 1e-5f);
+
+                // taps start 5.5 source texels left of the center, the last one is outside the radius
+                for (uint32_t k = 0; k < 6; ++k)
+                    EXPECT_NEAR(weights[k], weights[11 - k], 1e-6f);
+                EXPECT_EQ(weights[12], 0);
+                EXPECT_EQ(indices[5], ti * 2);
+                EXPECT_GT(weights[5], 0.25f);
+                // the first lobe is negative
+                EXPECT_LT(weights[3], 0);
+            }
+
+            // the first target texel reaches 5 texels past the left edge
+            const uint32_t* first = &table.indices[0];
+            for (uint32_t k = 0; k < 5; ++k)
+                EXPECT_EQ(first[k], edgeMode == EdgeMode::Clamp ? 0 : sWidth - 5 + k);
+        }
+    }
+}
+
+TEST(ImageProcessing, SincMipmapKeepsConstantImage)
+{
+    const int sizes[][2] = {{33, 17}, {1, 9}, {8, 8}};
+    for (MipFilter filter : {MipFilter::Kaiser, MipFilter::Lanczos})
+    {
+        for (EdgeMode edgeMode : {EdgeMode::Clamp, EdgeMode::Wrap})
+        {
+            for (const MipFormat& format : mipFormats)
+            {
+                for (int channels : {1, 2, 4})
+                {
+                    for (auto size : sizes)
+                    {
+                        const int width = size[0];
+                        const int height = size[1];
+                        SCOPED_TRACE(
+                            std::string(format.name) + ", " + std::to_string(channels) + " channels, " +
+                            std::to_string(width) + "x" + std::to_string(height)
+                        );
+                        const int levels = MipLevelCount(width, height);
+                        const size_t count = size_t(width) * height * channels;
+                        std::vector<uint8_t> source(count * GetChannelTypeByteSize(format.type));
+                        for (size_t i = 0; i < count; ++i)
+                            EncodeTexel(source.data(), i, 0.8, format.type, false);
+
+                        uint8_t* output;
+                        size_t outputByteSize;
+                        GenerateFilteredMipmap(
+                            source.data(),
+                            width,
+                            height,
+                            1,
+                            levels,
+                            channels,
+                            format.type,
+                            format.srgb,
+                            filter,
+                            edgeMode,
+                            output,
+                            outputByteSize
+                        );
+
+                        const double expected = DecodeTexel(source.data(), 0, format.type, false);
+                        const size_t elementCount = outputByteSize / GetChannelTypeByteSize(format.type);
+                        int mismatches = 0;
+                        for (size_t i = 0; i < elementCount; ++i)
+                        {
+                            double actual = DecodeTexel(output, i, format.type, false);
+                            mismatches += std::abs(actual - expected) > Tolerance(format.type, expected);
+                        }
+                        delete[] output;
+                        EXPECT_EQ(mismatches, 0);
+                    }
+                }
+            }
+        }
+    }
+}
+
+// a bright square on black makes the sinc lobes ring below zero. Each level has to be the filtered previous level as
+// it's stored, the clamped ringing must not be carried into the next level and amplified there
+TEST(ImageProcessing, SincMipmapFiltersTheStoredLevel)
+{
+    const int size = 64;
+    const int levels = MipLevelCount(size, size);
+    std::vector<float> source(size * size, 0.0f);
+    for (int y = 20; y < 36; ++y)
+    {
+        for (int x = 20; x < 36; ++x)
+            source[y * size + x] = 1;
+    }
+
+    for (MipFilter filter : {MipFilter::Kaiser, MipFilter::Lanczos})
+    {
+        FilterFn filterFn = filter == MipFilter::Kaiser ? filterFn_Kaiser : filterFn_Lanczos;
+        uint8_t* output;
+        size_t outputByteSize;
+        GenerateFilteredMipmap(
+            (uint8_t*)source.data(),
+            size,
+            size,
+            1,
+            levels,
+            1,
+            ChannelType::Float,
+            false,
+            filter,
+            EdgeMode::Clamp,
+            output,
+            outputByteSize
+        );
+
+        Processor processor;
+        const float* previous = (const float*)output;
+        bool rings = false;
+        for (int i = 1; i < levels; ++i)
+        {
+            const int pw = size >> (i - 1);
+            auto level = std::make_unique<LinearImage>(pw, pw, 1, sizeof(float));
+            memcpy(level->GetData(), previous, size_t(pw) * pw * sizeof(float));
+            level = processor.GenerateMipmap(level, filterFn, 3, EdgeMode::Clamp);
+
+            const float* expected = (const float*)level->GetData();
+            const float* actual = previous + size_t(pw) * pw;
+            for (uint32_t t = 0; t < level->GetPixelCount(); ++t)
+            {
+                rings |= expected[t] < 0;
+                ASSERT_NEAR(actual[t], std::max(expected[t], 0.0f), 1e-6f) << "level " << i << " texel " << t;
+            }
+            previous = actual;
+        }
+        delete[] output;
+        EXPECT_TRUE(rings);
+    }
+}
+
+// a bright first column: wrapping carries it into the last texels of the next level, clamping doesn't
+TEST(ImageProcessing, SincMipmapEdgeModes)
+{
+    const int size = 64;
+    std::vector<float> source(size * size, 0.0f);
+    for (int y = 0; y < size; ++y)
+        source[y * size] = 1;
+
+    for (MipFilter filter : {MipFilter::Kaiser, MipFilter::Lanczos})
+    {
+        for (EdgeMode edgeMode : {EdgeMode::Clamp, EdgeMode::Wrap})
+        {
+            uint8_t* output;
+            size_t outputByteSize;
+            GenerateFilteredMipmap(
+                (uint8_t*)source.data(),
+                size,
+                size,
+                1,
+                2,
+                1,
+                ChannelType::Float,
+                false,
+                filter,
+                edgeMode,
+                output,
+                outputByteSize
+            );
+            const float* level1 = (const float*)output + size * size;
+            const int lw = size / 2;
+            for (int y = 0; y < lw; ++y)
+            {
+                EXPECT_GT(level1[y * lw], 0.4f);
+                if (edgeMode == EdgeMode::Wrap)
+                    EXPECT_GT(level1[y * lw + lw - 1], 0.05f);
+                else
+                    EXPECT_EQ(level1[y * lw + lw - 1], 0);
+            }
+            delete[] output;
+        }
+    }
+}
+
+// full 2048x2048 RGBA sRGB mip chains with each filter, in megapixels of the source per second
+TEST(ImageProcessing, DISABLED_FilteredMipmapBenchmark)
+{
+    const int size = 2048;
+    const int levels = MipLevelCount(size, size);
+    const double megapixels = double(size) * size / 1e6;
+    std::mt19937 random(5);
+    std::vector<uint8_t> source = RandomTexels(size_t(size) * size * 4, ChannelType::UInt8, random);
+
+    printf("GenerateFilteredMipmap, %u job system threads\n", JobSystem::GetSingleton().GetThreadCount() + 1);
+    const std::pair<MipFilter, const char*> filters[] = {
+        {MipFilter::Box, "box"},
+        {MipFilter::Kaiser, "kaiser"},
+        {MipFilter::Lanczos, "lanczos"},
+    };
+    for (auto [filter, name] : filters)
+    {
+        uint8_t* output;
+        size_t outputByteSize;
+        auto start = std::chrono::steady_clock::now();
+        GenerateFilteredMipmap(
+            source.data(),
+            size,
+            size,
+            1,
+            levels,
+            4,
+            ChannelType::UInt8,
+            true,
+            filter,
+            EdgeMode::Clamp,
+            output,
+            outputByteSize
+        );
+        double ms = ElapsedMs(start);
+        delete[] output;
+
+        double mpixPerSecond = megapixels / ms * 1000;
+        printf("%8s: %8.1f ms, %8.1f MPix/s\n", name, ms, mpixPerSecond);
+        RecordProperty(std::string(name) + " MPix/s", std::to_string(mpixPerSecond));
+    }
+}
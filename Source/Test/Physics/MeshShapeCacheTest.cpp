@@ -0,0 +1,122 @@
+#include "../Core/Scene/SceneTest.hpp"
+#include "AssetDatabase/Importers/AssetLoader.hpp"
+#include "Core/Graphics/Mesh.hpp"
+#include "Physics/MeshShapeCache.hpp"
+#include <Jolt/Physics/Collision/Shape/ScaledShape.h>
+#include <filesystem>
+
+namespace
+{
+class MeshShapeCacheTest : public SceneTest
+{
+protected:
+    // the import database a test sets is a local
+    void TearDown() override
+    {
+        MeshShapeCache::GetSingleton().SetImportDatabase(nullptr);
+    }
+};
+
+// two triangles in the xz plane
+std::unique_ptr<Mesh> CreateQuad(float size)
+{
+    std::vector<glm::vec3> positions = {{0, 0, 0}, {size, 0, 0}, {size, 0, size}, {0, 0, size}};
+    std::vector<uint32_t> indices = {0, 1, 2, 0, 2, 3};
+    std::vector<Submesh> submeshes(1);
+    submeshes[0].SetPositions(std::move(positions));
+    submeshes[0].SetIndices(std::move(indices));
+    auto mesh = std::make_unique<Mesh>();
+    mesh->SetSubmeshes(std::move(submeshes));
+    return mesh;
+}
+} // namespace
+
+// bodies with the same mesh share one cooked shape, once none uses it any more it's dropped and restored from the
+// cooked file instead of cooking again
+TEST_F(MeshShapeCacheTest, CooksEvictsAndRestores)
+{
+    std::filesystem::path directory = std::filesystem::path(TEMP_FILE_DIR) / "MeshShapeCacheTest";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+    ImportDatabase importDatabase;
+    importDatabase.Init(directory);
+
+    MeshShapeCache& cache = MeshShapeCache::GetSingleton();
+    cache.SetImportDatabase(&importDatabase);
+    auto mesh = CreateQuad(2.0f);
+    MeshShapeCache::Stats before = cache.GetStats();
+
+    JPH::Ref<JPH::Shape> first = cache.GetShape(*mesh, glm::vec3(1));
+    ASSERT_NE(first.GetPtr(), nullptr);
+    JPH::Ref<JPH::Shape> second = cache.GetShape(*mesh, glm::vec3(1));
+    EXPECT_EQ(first.GetPtr(), second.GetPtr());
+    // first, second and the cache
+    EXPECT_EQ(first->GetRefCount(), 3u);
+
+    JPH::Ref<JPH::Shape> scaled = cache.GetShape(*mesh, glm::vec3(2));
+    EXPECT_EQ(cache.GetShape(*mesh, glm::vec3(2)).GetPtr(), scaled.GetPtr());
+    EXPECT_EQ(static_cast<JPH::ScaledShape*>(scaled.GetPtr())->GetInnerShape(), first.GetPtr());
+    // the scaled shape holds the unit shape as well
+    EXPECT_EQ(first->GetRefCount(), 4u);
+    EXPECT_EQ(scaled->GetRefCount(), 2u);
+
+    MeshShapeCache::Stats stats = cache.GetStats();
+    EXPECT_EQ(stats.cooked - before.cooked, 1u);
+    EXPECT_EQ(stats.restored - before.restored, 0u);
+    // the second unit request, the unit shape of the first scaled request and the second scaled request
+    EXPECT_EQ(stats.shared - before.shared, 3u);
+
+    // shapes that are still used stay
+    cache.EvictUnused();
+    EXPECT_EQ(first->GetRefCount(), 4u);
+    EXPECT_EQ(scaled->GetRefCount(), 2u);
+
+    JPH::AABox bounds = first->GetLocalBounds();
+    first = nullptr;
+    second = nullptr;
+    scaled = nullptr;
+    cache.EvictUnused();
+
+    before = cache.GetStats();
+    JPH::Ref<JPH::Shape> restored = cache.GetShape(*mesh, glm::vec3(1));
+    ASSERT_NE(restored.GetPtr(), nullptr);
+    stats = cache.GetStats();
+    EXPECT_EQ(stats.cooked - before.cooked, 0u);
+    EXPECT_EQ(stats.restored - before.restored, 1u);
+    EXPECT_EQ(restored->GetRefCount(), 2u);
+    EXPECT_EQ(restored->GetSubType(), JPH::EShapeSubType::Mesh);
+    EXPECT_TRUE(restored->GetLocalBounds().mMin.IsClose(bounds.mMin));
+    EXPECT_TRUE(restored->GetLocalBounds().mMax.IsClose(bounds.mMax));
+
+    restored = nullptr;
+    cache.EvictUnused();
+    std::filesystem::remove_all(directory);
+}
+
+// submeshes edited through GetSubmesh must not keep the shape of their old geometry
+TEST_F(MeshShapeCacheTest, EditedSubmeshChangesTheGeometryHash)
+{
+    auto mesh = CreateQuad(1.0f);
+    uint64_t hash = mesh->GetGeometryHash();
+    EXPECT_EQ(mesh->GetGeometryHash(), hash);
+    EXPECT_EQ(CreateQuad(1.0f)->GetGeometryHash(), hash);
+
+    MeshShapeCache& cache = MeshShapeCache::GetSingleton();
+    JPH::Ref<JPH::Shape> flat = cache.GetShape(*mesh, glm::vec3(1));
+    ASSERT_NE(flat.GetPtr(), nullptr);
+
+    std::vector<glm::vec3> positions = mesh->GetSubmesh(0)->GetPositions();
+    positions[2].y = 1;
+    mesh->GetSubmesh(0)->SetPositions(std::move(positions));
+    EXPECT_NE(mesh->GetGeometryHash(), hash);
+
+    JPH::Ref<JPH::Shape> raised = cache.GetShape(*mesh, glm::vec3(1));
+    ASSERT_NE(raised.GetPtr(), nullptr);
+    EXPECT_NE(raised.GetPtr(), flat.GetPtr());
+    EXPECT_NEAR(raised->GetLocalBounds().mMax.GetY(), 1.0f, 1e-3f);
+    EXPECT_NEAR(flat->GetLocalBounds().mMax.GetY(), 0.0f, 1e-3f);
+
+    flat = nullptr;
+    raised = nullptr;
+    cache.EvictUnused();
+}